@@ -0,0 +1,370 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <csignal>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <new>
+
+#include <absl/strings/str_cat.h>
+#include <absl/strings/substitute.h>
+#include <unistd.h>
+#include <userver/components/component_config.hpp>
+#include <userver/components/component_context.hpp>
+#include <userver/engine/async.hpp>
+#include <userver/engine/sleep.hpp>
+#include <userver/formats/json.hpp>
+#include <userver/fs/write.hpp>
+#include <userver/http/content_type.hpp>
+#include <userver/logging/log.hpp>
+#include <userver/server/handlers/exceptions.hpp>
+#include <userver/server/http/http_request.hpp>
+#include <userver/yaml_config/merge_schemas.hpp>
+
+#include "benchmark.hpp"
+
+#ifdef BUILD_LPRS
+#include "lprs_workflow.hpp"
+#endif
+
+#ifdef BUILD_FRS
+#include "frs_workflow.hpp"
+#endif
+
+// Allocation counting: the replaced global operator new is used by the whole process (HTTP server and client, workflows, OpenCV),
+// array and nothrow forms go through it too; allocations made directly with malloc are not counted
+namespace
+{
+  std::atomic<uint64_t> allocation_count{0};
+}  // namespace
+
+void* operator new(const std::size_t size)
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size))
+    return ptr;
+
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+namespace Benchmark
+{
+  namespace
+  {
+    inline static constexpr auto SYSTEM_FRS = "frs";
+    inline static constexpr auto SYSTEM_LPRS = "lprs";
+
+    SystemConfig parseSystemConfig(const userver::yaml_config::YamlConfig& config)
+    {
+      return {
+        .id_group = config[ConfigParams::GROUP_ID].As<int32_t>(0),
+        .streams = config[ConfigParams::STREAMS].As<std::vector<std::string>>(std::vector<std::string>{})};
+    }
+
+    template <typename Timings, std::size_t StageCount>
+    userver::formats::json::ValueBuilder stagesReport(const std::shared_ptr<const Timings>& timings,
+      const std::array<std::string_view, StageCount>& stage_names)
+    {
+      userver::formats::json::ValueBuilder result(userver::formats::common::Type::kObject);
+      if (timings == nullptr)
+        return result;
+
+      for (std::size_t i = 0; i < StageCount; ++i)
+      {
+        const auto stage = timings->snapshot(i);
+        userver::formats::json::ValueBuilder stage_builder;
+        stage_builder["p50"] = stage.p50;
+        stage_builder["p90"] = stage.p90;
+        stage_builder["p99"] = stage.p99;
+        stage_builder["max"] = stage.max;
+        stage_builder["count"] = stage.count;
+        result[std::string{stage_names[i]}] = stage_builder.ExtractValue();
+      }
+
+      return result;
+    }
+
+    double perSecond(const uint64_t value, const double seconds)
+    {
+      return seconds > 0.0 ? static_cast<double>(value) / seconds : 0.0;
+    }
+  }  // namespace
+
+  uint64_t allocationCount()
+  {
+    return allocation_count.load(std::memory_order_relaxed);
+  }
+
+  FrameServer::FrameServer(const userver::components::ComponentConfig& config, const userver::components::ComponentContext& context)
+    : HttpHandlerBase(config, context)
+  {
+    const auto frames_dir = config[ConfigParams::FRAMES_DIR].As<std::string>();
+    std::vector<std::filesystem::path> file_names;
+    for (const auto& entry : std::filesystem::directory_iterator(frames_dir))
+    {
+      auto extension = entry.path().extension().string();
+      std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+      if (entry.is_regular_file() && (extension == ".jpg" || extension == ".jpeg"))
+        file_names.emplace_back(entry.path());
+    }
+    std::sort(file_names.begin(), file_names.end());
+
+    // frames are kept in memory, so reading files doesn't affect the measurements
+    frames_.reserve(file_names.size());
+    for (const auto& file_name : file_names)
+    {
+      std::ifstream f(file_name, std::ios::binary);
+      frames_.emplace_back(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    }
+    if (frames_.empty())
+      throw std::runtime_error(absl::StrCat("There are no JPEG frames in the directory ", frames_dir));
+  }
+
+  std::string FrameServer::HandleRequestThrow(const userver::server::http::HttpRequest& request,
+    userver::server::request::RequestContext&) const
+  {
+    const auto& system = request.GetPathArg("system");
+    if (system != SYSTEM_FRS && system != SYSTEM_LPRS)
+      throw userver::server::handlers::ResourceNotFound(
+        userver::server::handlers::ExternalBody{absl::StrCat("Unknown system: ", system)});
+
+    const auto position = positions_.findOrCreate(absl::StrCat(system, "/", request.GetPathArg("stream"))).first;
+    const auto frame_index = position->fetch_add(1, std::memory_order_relaxed) % frames_.size();
+    request.GetHttpResponse().SetContentType(userver::http::content_type::kImageJpeg);
+
+    return frames_[frame_index];
+  }
+
+  uint64_t FrameServer::servedFrames(const std::string& system, const std::string& stream_id) const
+  {
+    const auto position = positions_.find(absl::StrCat(system, "/", stream_id));
+    return position == nullptr ? 0 : position->load(std::memory_order_relaxed);
+  }
+
+  userver::yaml_config::Schema FrameServer::GetStaticConfigSchema()
+  {
+    return userver::yaml_config::MergeSchemas<HttpHandlerBase>(R"~(
+type: object
+description: Server of the recorded frames
+additionalProperties: false
+properties:
+    frames-dir:
+        type: string
+        description: Directory with JPEG frames, they are served in the order of the file names
+  )~");
+  }
+
+  Runner::Runner(const userver::components::ComponentConfig& config, const userver::components::ComponentContext& context)
+    : LoggableComponentBase(config, context),
+      task_processor_(context.GetTaskProcessor(config["task_processor"].As<std::string>())),
+      fs_task_processor_(context.GetTaskProcessor(config["fs-task-processor"].As<std::string>())),
+      frame_server_(context.FindComponent<FrameServer>())
+#ifdef BUILD_LPRS
+      , lprs_workflow_(context.FindComponent<Lprs::Workflow>())
+#endif
+#ifdef BUILD_FRS
+      , frs_workflow_(context.FindComponent<Frs::Workflow>())
+#endif
+  {
+    frs_config_ = parseSystemConfig(config[ConfigParams::FRS]);
+    lprs_config_ = parseSystemConfig(config[ConfigParams::LPRS]);
+    warmup_ = config[ConfigParams::WARMUP].As<decltype(warmup_)>(warmup_);
+    duration_ = config[ConfigParams::DURATION].As<decltype(duration_)>(duration_);
+    report_path_ = config[ConfigParams::REPORT_PATH].As<std::string>("");
+    exit_after_run_ = config[ConfigParams::EXIT_AFTER_RUN].As<bool>(exit_after_run_);
+  }
+
+  Runner::~Runner()
+  {
+    tasks_.CancelAndWait();
+  }
+
+  void Runner::OnAllComponentsLoaded()
+  {
+    tasks_.Detach(userver::engine::AsyncNoSpan(task_processor_, &Runner::run, this));
+  }
+
+  void Runner::run()
+  {
+    LOG_INFO() << "Benchmark: starting workflows";
+    startWorkflows();
+    userver::engine::InterruptibleSleepFor(warmup_);
+    if (userver::engine::current_task::ShouldCancel())
+      return;
+
+    const auto start = takeCounters();
+    userver::engine::InterruptibleSleepFor(duration_);
+    const auto finish = takeCounters();
+    stopWorkflows();
+    if (userver::engine::current_task::ShouldCancel())
+      return;
+
+    const auto report = ToString(makeReport(start, finish).ExtractValue());
+    LOG_INFO() << "Benchmark report: " << report;
+    if (!report_path_.empty())
+    {
+      try
+      {
+        userver::fs::RewriteFileContentsAtomically(fs_task_processor_, report_path_, report,
+          boost::filesystem::perms::owner_read | boost::filesystem::perms::owner_write | boost::filesystem::perms::group_read | boost::filesystem::perms::others_read);
+      } catch (const std::exception& e)
+      {
+        LOG_ERROR() << "Error! Unable to write the benchmark report to " << report_path_ << ": " << e.what();
+      }
+    }
+
+    if (exit_after_run_)
+      kill(getpid(), SIGTERM);
+  }
+
+  void Runner::startWorkflows()
+  {
+#ifdef BUILD_LPRS
+    for (const auto& stream_id : lprs_config_.streams)
+      lprs_workflow_.startWorkflow(absl::Substitute("$0_$1", lprs_config_.id_group, stream_id));
+#endif
+#ifdef BUILD_FRS
+    for (const auto& stream_id : frs_config_.streams)
+      frs_workflow_.startWorkflow(absl::Substitute("$0_$1", frs_config_.id_group, stream_id));
+#endif
+  }
+
+  void Runner::stopWorkflows()
+  {
+#ifdef BUILD_LPRS
+    for (const auto& stream_id : lprs_config_.streams)
+      lprs_workflow_.stopWorkflow(absl::Substitute("$0_$1", lprs_config_.id_group, stream_id), false);
+#endif
+#ifdef BUILD_FRS
+    for (const auto& stream_id : frs_config_.streams)
+      frs_workflow_.stopWorkflow(absl::Substitute("$0_$1", frs_config_.id_group, stream_id), false);
+#endif
+  }
+
+  Runner::Counters Runner::takeCounters() const
+  {
+    Counters counters{
+      .allocations = allocationCount(),
+      .time_point = std::chrono::steady_clock::now()};
+    for (const auto& stream_id : frs_config_.streams)
+      counters.frs_frames += frame_server_.servedFrames(SYSTEM_FRS, stream_id);
+    for (const auto& stream_id : lprs_config_.streams)
+      counters.lprs_frames += frame_server_.servedFrames(SYSTEM_LPRS, stream_id);
+
+    return counters;
+  }
+
+  userver::formats::json::ValueBuilder Runner::makeReport(const Counters& start, const Counters& finish) const
+  {
+    const auto seconds = std::chrono::duration<double>(finish.time_point - start.time_point).count();
+    const auto frs_frames = finish.frs_frames - start.frs_frames;
+    const auto lprs_frames = finish.lprs_frames - start.lprs_frames;
+    const auto frames = frs_frames + lprs_frames;
+    const auto allocations = finish.allocations - start.allocations;
+
+    userver::formats::json::ValueBuilder report;
+    report["duration"] = seconds;
+    report["frames"] = frames;
+    report["frames_per_second"] = perSecond(frames, seconds);
+    report["allocations"] = allocations;
+    report["allocations_per_frame"] = frames > 0 ? static_cast<double>(allocations) / static_cast<double>(frames) : 0.0;
+
+    // stage latencies are taken from the histograms of the last minute, so the measurement period should be at least a minute long
+#ifdef BUILD_LPRS
+    if (!lprs_config_.streams.empty())
+    {
+      userver::formats::json::ValueBuilder lprs_report;
+      lprs_report["streams"] = lprs_config_.streams.size();
+      lprs_report["frames"] = lprs_frames;
+      lprs_report["frames_per_second"] = perSecond(lprs_frames, seconds);
+      lprs_report["stages"] = stagesReport(lprs_workflow_.getPipelineTimings(lprs_config_.id_group), Lprs::PIPELINE_STAGE_NAMES);
+      report[SYSTEM_LPRS] = lprs_report.ExtractValue();
+    }
+#endif
+#ifdef BUILD_FRS
+    if (!frs_config_.streams.empty())
+    {
+      userver::formats::json::ValueBuilder frs_report;
+      frs_report["streams"] = frs_config_.streams.size();
+      frs_report["frames"] = frs_frames;
+      frs_report["frames_per_second"] = perSecond(frs_frames, seconds);
+      frs_report["stages"] = stagesReport(frs_workflow_.getPipelineTimings(frs_config_.id_group), Frs::PIPELINE_STAGE_NAMES);
+      report[SYSTEM_FRS] = frs_report.ExtractValue();
+    }
+#endif
+
+    return report;
+  }
+
+  userver::yaml_config::Schema Runner::GetStaticConfigSchema()
+  {
+    return userver::yaml_config::MergeSchemas<LoggableComponentBase>(R"~(
+type: object
+description: Frame replay benchmark of the pipelines
+additionalProperties: false
+properties:
+    task_processor:
+        type: string
+        description: main task processor
+    fs-task-processor:
+        type: string
+        description: task processor for writing the report
+    frs:
+        type: object
+        description: FRS video streams
+        additionalProperties: false
+        properties:
+            group-id:
+                type: integer
+                description: Group of the video streams
+            streams:
+                type: array
+                description: Identifiers of the video streams, their frame URL must be /benchmark/frames/frs/<stream identifier>
+                items:
+                    type: string
+                    description: Video stream identifier
+    lprs:
+        type: object
+        description: LPRS video streams
+        additionalProperties: false
+        properties:
+            group-id:
+                type: integer
+                description: Group of the video streams
+            streams:
+                type: array
+                description: Identifiers of the video streams, their screenshot URL must be /benchmark/frames/lprs/<stream identifier>
+                items:
+                    type: string
+                    description: Video stream identifier
+    warmup:
+        type: string
+        description: Time before the measurement
+        defaultDescription: 10s
+    duration:
+        type: string
+        description: Measurement time
+        defaultDescription: 60s
+    report-path:
+        type: string
+        description: File for the JSON report, the report is also written to the log
+        defaultDescription: ''
+    exit-after-run:
+        type: boolean
+        description: Stop the service after the report is written
+        defaultDescription: true
+  )~");
+  }
+}  // namespace Benchmark
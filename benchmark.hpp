@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <userver/components/loggable_component_base.hpp>
+#include <userver/concurrent/background_task_storage.hpp>
+#include <userver/formats/json/value_builder.hpp>
+#include <userver/server/handlers/http_handler_base.hpp>
+
+#include "sharded_registry.hpp"
+
+#ifdef BUILD_LPRS
+namespace Lprs
+{
+  class Workflow;
+}
+#endif
+
+#ifdef BUILD_FRS
+namespace Frs
+{
+  class Workflow;
+}
+#endif
+
+// Frame replay benchmark: recorded frames are served by a local image server to the real pipelines of LPRS and FRS,
+// and the throughput, per-stage latencies and allocations are reported in JSON
+namespace Benchmark
+{
+  namespace ConfigParams
+  {
+    inline static constexpr auto FRAMES_DIR = "frames-dir";
+    inline static constexpr auto FRS = "frs";
+    inline static constexpr auto LPRS = "lprs";
+    inline static constexpr auto GROUP_ID = "group-id";
+    inline static constexpr auto STREAMS = "streams";
+    inline static constexpr auto WARMUP = "warmup";
+    inline static constexpr auto DURATION = "duration";
+    inline static constexpr auto REPORT_PATH = "report-path";
+    inline static constexpr auto EXIT_AFTER_RUN = "exit-after-run";
+  }  // namespace ConfigParams
+
+  // number of allocations made by the process with the global operator new
+  uint64_t allocationCount();
+
+  // Serves JPEG frames of a directory in the order of the file names; every video stream
+  // has its own position, so each stream gets the same sequence of frames on every run
+  class FrameServer final : public userver::server::handlers::HttpHandlerBase
+  {
+  public:
+    static constexpr auto kName = "handler-benchmark-frames";
+
+    FrameServer(const userver::components::ComponentConfig& config, const userver::components::ComponentContext& context);
+    std::string HandleRequestThrow(const userver::server::http::HttpRequest& request,
+      userver::server::request::RequestContext& context) const override;
+    static userver::yaml_config::Schema GetStaticConfigSchema();
+
+    // number of frames served for the system (frs or lprs) and stream
+    [[nodiscard]] uint64_t servedFrames(const std::string& system, const std::string& stream_id) const;
+
+  private:
+    std::vector<std::string> frames_;
+    mutable ShardedRegistry<std::string, std::atomic<uint64_t>> positions_;  // key is system/stream_id
+  };
+
+  struct SystemConfig
+  {
+    int32_t id_group{0};
+    std::vector<std::string> streams;
+  };
+
+  // Starts the workflows of the configured video streams, waits for the warmup and the measurement period,
+  // stops the workflows and writes the report
+  class Runner final : public userver::components::LoggableComponentBase
+  {
+  public:
+    static constexpr auto kName = "benchmark-runner";
+
+    Runner(const userver::components::ComponentConfig& config, const userver::components::ComponentContext& context);
+    ~Runner() override;
+    static userver::yaml_config::Schema GetStaticConfigSchema();
+    void OnAllComponentsLoaded() override;
+
+  private:
+    struct Counters
+    {
+      uint64_t frs_frames{0};
+      uint64_t lprs_frames{0};
+      uint64_t allocations{0};
+      std::chrono::steady_clock::time_point time_point;
+    };
+
+    userver::engine::TaskProcessor& task_processor_;
+    userver::engine::TaskProcessor& fs_task_processor_;
+    userver::concurrent::BackgroundTaskStorageCore tasks_;
+    const FrameServer& frame_server_;
+#ifdef BUILD_LPRS
+    Lprs::Workflow& lprs_workflow_;
+#endif
+#ifdef BUILD_FRS
+    Frs::Workflow& frs_workflow_;
+#endif
+    SystemConfig frs_config_;
+    SystemConfig lprs_config_;
+    std::chrono::milliseconds warmup_{std::chrono::seconds{10}};
+    std::chrono::milliseconds duration_{std::chrono::seconds{60}};
+    std::string report_path_;
+    bool exit_after_run_{true};
+
+    void run();
+    void startWorkflows();
+    void stopWorkflows();
+    [[nodiscard]] Counters takeCounters() const;
+    [[nodiscard]] userver::formats::json::ValueBuilder makeReport(const Counters& start, const Counters& finish) const;
+  };
+}  // namespace Benchmark
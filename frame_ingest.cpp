@@ -0,0 +1,389 @@
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+#include <absl/strings/match.h>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/substitute.h>
+#include <userver/clients/http/streamed_response.hpp>
+#include <userver/concurrent/queue.hpp>
+#include <userver/engine/async.hpp>
+#include <userver/engine/sleep.hpp>
+#include <userver/engine/task/cancel.hpp>
+
+#include "frame_ingest.hpp"
+
+namespace Ingest
+{
+  namespace
+  {
+    // the timeout of a streaming request limits the whole session, so the connection is renewed with this period
+    constexpr std::chrono::hours SESSION_DURATION{1};
+
+    // headers of a part larger than this are considered a broken stream
+    constexpr size_t MAX_HEADERS_SIZE = 64 * 1024;
+
+    std::string_view trimLine(std::string_view line)
+    {
+      while (!line.empty() && std::isspace(static_cast<unsigned char>(line.back())))
+        line.remove_suffix(1);
+      while (!line.empty() && std::isspace(static_cast<unsigned char>(line.front())))
+        line.remove_prefix(1);
+      return line;
+    }
+  }  // namespace
+
+  void parseUrlCredentials(const std::string_view url, std::string& user, std::string& password)
+  {
+    user.clear();
+    password.clear();
+    if (auto char_alpha = url.find('@'); char_alpha != std::string_view::npos)
+    {
+      if (auto protocol_suffix = url.find("://"); protocol_suffix != std::string_view::npos && protocol_suffix < char_alpha)
+      {
+        if (auto char_colon = url.find(':', protocol_suffix + 3); char_colon != std::string_view::npos && char_colon < char_alpha)
+        {
+          auto char_slash = protocol_suffix + 2;
+          user = url.substr(char_slash + 1, char_colon - char_slash - 1);
+          password = url.substr(char_colon + 1, char_alpha - char_colon - 1);
+        }
+      }
+    }
+  }
+
+  MultipartParser::MultipartParser(const std::string_view boundary)
+  {
+    // some cameras put the leading dashes of the delimiter into the boundary parameter
+    if (!boundary.empty())
+      delimiter_ = boundary.starts_with("--") ? std::string(boundary) : absl::StrCat("--", boundary);
+  }
+
+  std::string MultipartParser::boundaryFromContentType(const std::string_view content_type)
+  {
+    constexpr std::string_view parameter = "boundary=";
+    const auto it = std::search(content_type.begin(), content_type.end(), parameter.begin(), parameter.end(),
+      [](const char a, const char b)
+      {
+        return std::tolower(static_cast<unsigned char>(a)) == b;
+      });
+    if (it == content_type.end())
+      return {};
+
+    auto value = content_type.substr(it - content_type.begin() + parameter.size());
+    value = trimLine(value.substr(0, value.find(';')));
+    if (value.size() >= 2 && value.front() == '"' && value.back() == '"')
+      value = value.substr(1, value.size() - 2);
+    return std::string(value);
+  }
+
+  void MultipartParser::feed(const std::string_view chunk, const std::function<void(std::string&& part)>& on_part)
+  {
+    buffer_.append(chunk);
+    bool has_progress = true;
+    while (has_progress)
+      switch (state_)
+      {
+        case State::DELIMITER:
+          has_progress = parseDelimiter();
+          break;
+        case State::HEADERS:
+          has_progress = parseHeaders();
+          break;
+        case State::BODY:
+          has_progress = parseBody(on_part);
+          break;
+      }
+  }
+
+  bool MultipartParser::parseDelimiter()
+  {
+    size_t pos = std::string::npos;
+    if (delimiter_.empty())
+    {
+      // the first line starting with dashes is the delimiter
+      for (size_t line_start = 0; line_start < buffer_.size();)
+      {
+        if (buffer_.compare(line_start, 2, "--") == 0)
+        {
+          pos = line_start;
+          break;
+        }
+        const auto eol = buffer_.find('\n', line_start);
+        if (eol == std::string::npos)
+          break;
+        line_start = eol + 1;
+      }
+    } else
+      pos = buffer_.find(delimiter_);
+
+    if (pos == std::string::npos)
+    {
+      // keep the tail that can be the beginning of the delimiter
+      const size_t keep = delimiter_.empty() ? MAX_HEADERS_SIZE : delimiter_.size();
+      if (buffer_.size() > keep)
+        buffer_.erase(0, buffer_.size() - keep);
+      return false;
+    }
+
+    const auto eol = buffer_.find('\n', pos);
+    if (eol == std::string::npos)
+      return false;
+
+    if (delimiter_.empty())
+    {
+      delimiter_ = trimLine(std::string_view(buffer_).substr(pos, eol - pos));
+      if (delimiter_.ends_with("--"))
+        delimiter_.resize(delimiter_.size() - 2);
+    }
+    buffer_.erase(0, eol + 1);
+    state_ = State::HEADERS;
+
+    return true;
+  }
+
+  bool MultipartParser::parseHeaders()
+  {
+    has_content_length_ = false;
+    content_length_ = 0;
+    for (size_t line_start = 0;;)
+    {
+      const auto eol = buffer_.find('\n', line_start);
+      if (eol == std::string::npos)
+      {
+        if (buffer_.size() > MAX_HEADERS_SIZE)
+        {
+          buffer_.clear();
+          state_ = State::DELIMITER;
+        }
+        return false;
+      }
+
+      const auto line = trimLine(std::string_view(buffer_).substr(line_start, eol - line_start));
+      line_start = eol + 1;
+      if (line.empty())
+      {
+        buffer_.erase(0, line_start);
+        state_ = State::BODY;
+        return true;
+      }
+
+      if (constexpr std::string_view header = "content-length:"; absl::StartsWithIgnoreCase(line, header))
+      {
+        const auto value = trimLine(line.substr(header.size()));
+        if (const auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), content_length_); ec == std::errc{}
+            && content_length_ <= MAX_PART_SIZE)
+          has_content_length_ = true;
+      }
+    }
+  }
+
+  bool MultipartParser::parseBody(const std::function<void(std::string&& part)>& on_part)
+  {
+    std::string part;
+    if (has_content_length_)
+    {
+      if (buffer_.size() < content_length_)
+        return false;
+
+      part = buffer_.substr(0, content_length_);
+      buffer_.erase(0, content_length_);
+    } else
+    {
+      // without Content-Length the part lasts until the next delimiter
+      const auto pos = buffer_.find(delimiter_, scan_from_);
+      if (pos == std::string::npos)
+      {
+        // the next chunk continues the search where this one can contain the beginning of the delimiter
+        scan_from_ = buffer_.size() > delimiter_.size() ? buffer_.size() - delimiter_.size() : 0;
+        if (buffer_.size() > MAX_PART_SIZE)
+        {
+          buffer_.clear();
+          scan_from_ = 0;
+          state_ = State::DELIMITER;
+        }
+        return false;
+      }
+      scan_from_ = 0;
+
+      auto end = pos;
+      if (end > 0 && buffer_[end - 1] == '\n')
+        --end;
+      if (end > 0 && buffer_[end - 1] == '\r')
+        --end;
+      part = buffer_.substr(0, end);
+      buffer_.erase(0, pos);
+    }
+
+    state_ = State::DELIMITER;
+    if (!part.empty())
+      on_part(std::move(part));
+
+    return true;
+  }
+
+  MjpegReader::MjpegReader(userver::clients::http::Client& http_client, userver::engine::TaskProcessor& task_processor, Options options)
+    : http_client_(http_client),
+      options_(std::move(options)),
+      last_take_tp_(std::chrono::steady_clock::now())
+  {
+    task_ = userver::engine::AsyncNoSpan(task_processor, [this]
+      {
+        run();
+      });
+  }
+
+  MjpegReader::~MjpegReader()
+  {
+    if (task_.IsValid())
+      task_.SyncCancel();
+  }
+
+  bool MjpegReader::takeFrame(std::string& frame, const std::chrono::milliseconds timeout, std::string& error)
+  {
+    std::unique_lock lock(mutex_);
+    last_take_tp_ = std::chrono::steady_clock::now();
+    if (!frame_ready_.WaitFor(lock, timeout, [this]
+          {
+            return sequence_ > taken_sequence_;
+          }))
+    {
+      error = error_.empty() ? "no frame from the MJPEG stream within the capture timeout" : error_;
+      return false;
+    }
+
+    frame = std::move(frame_);
+    frame_.clear();
+    taken_sequence_ = sequence_;
+
+    return true;
+  }
+
+  bool MjpegReader::isRunning() const
+  {
+    return task_.IsValid() && !task_.IsFinished();
+  }
+
+  const MjpegReader::Options& MjpegReader::options() const
+  {
+    return options_;
+  }
+
+  uint64_t MjpegReader::receivedFrames() const
+  {
+    std::lock_guard lock(mutex_);
+    return sequence_;
+  }
+
+  uint64_t MjpegReader::droppedFrames() const
+  {
+    std::lock_guard lock(mutex_);
+    return dropped_frames_;
+  }
+
+  void MjpegReader::run()
+  {
+    while (!userver::engine::current_task::ShouldCancel() && !isIdle())
+    {
+      try
+      {
+        readStream();
+      } catch (const std::exception& e)
+      {
+        setError(e.what());
+      }
+
+      if (!isIdle())
+        userver::engine::InterruptibleSleepFor(options_.reconnect_delay);
+    }
+  }
+
+  void MjpegReader::readStream()
+  {
+    std::string auth_user;
+    std::string auth_password;
+    parseUrlCredentials(options_.url, auth_user, auth_password);
+
+    auto queue = userver::concurrent::StringStreamQueue::Create();
+    // clang-format off
+    auto response = http_client_.CreateRequest()
+      .get(options_.url)
+      .http_auth_type(userver::clients::http::HttpAuthType::kAnySafe, false, auth_user, auth_password)
+      .timeout(SESSION_DURATION)
+      .async_perform_stream_body(queue);
+    // clang-format on
+    if (const auto status_code = response.StatusCode(); status_code != userver::clients::http::Status::OK)
+    {
+      setError(absl::Substitute("MJPEG stream: status_code = $0", static_cast<int>(status_code)));
+      return;
+    }
+
+    MultipartParser parser(MultipartParser::boundaryFromContentType(response.GetHeader("Content-Type")));
+    std::string chunk;
+    while (response.ReadChunk(chunk, userver::engine::Deadline::FromDuration(options_.read_timeout)))
+    {
+      parser.feed(chunk, [this](std::string&& frame)
+        {
+          publish(std::move(frame));
+        });
+      if (isIdle())
+        return;
+    }
+
+    setError("MJPEG stream: the connection is closed by the camera");
+  }
+
+  void MjpegReader::publish(std::string&& frame)
+  {
+    {
+      std::lock_guard lock(mutex_);
+
+      // the previous frame hasn't been taken, so it's stale now
+      if (sequence_ > taken_sequence_)
+        ++dropped_frames_;
+      frame_ = std::move(frame);
+      ++sequence_;
+      error_.clear();
+    }
+    frame_ready_.NotifyAll();
+  }
+
+  void MjpegReader::setError(std::string error)
+  {
+    std::lock_guard lock(mutex_);
+    error_ = std::move(error);
+  }
+
+  bool MjpegReader::isIdle()
+  {
+    std::lock_guard lock(mutex_);
+    return std::chrono::steady_clock::now() - last_take_tp_ > options_.idle_timeout;
+  }
+
+  bool takeMjpegFrame(std::unique_ptr<MjpegReader>& reader, userver::clients::http::Client& http_client,
+    userver::engine::TaskProcessor& task_processor, const MjpegReader::Options& options, std::string& frame, std::string& error)
+  {
+    if (!reader || !reader->isRunning() || reader->options().url != options.url)
+    {
+      reader.reset();
+      reader = std::make_unique<MjpegReader>(http_client, task_processor, options);
+    }
+
+    return reader->takeFrame(frame, options.read_timeout, error);
+  }
+
+  bool DuplicateDetector::isDuplicate(const std::string_view image_data)
+  {
+    // a 64-bit hash together with the size makes a false match practically impossible, and the image doesn't have to be kept
+    const auto hash = std::hash<std::string_view>{}(image_data);
+    if (hash == hash_ && image_data.size() == size_)
+      return true;
+
+    hash_ = hash;
+    size_ = image_data.size();
+
+    return false;
+  }
+}  // namespace Ingest
@@ -6,9 +6,31 @@
 
 #include "converters.hpp"
 #include "frs_api.hpp"
+#include "similarity.hpp"
 
 namespace Frs
 {
+  static_assert(sizeof(EventRecordHeader) % sizeof(float) == 0);
+
+  // reads the face descriptor records of a data file of events or logs into the buffer (float storage keeps the descriptors aligned);
+  // a trailing incomplete record is ignored
+  Similarity::StridedRows readDescriptorRecords(const std::filesystem::path& path, const size_t dim, std::vector<float>& buffer)
+  {
+    const size_t stride = sizeof(EventRecordHeader) / sizeof(float) + dim;
+    std::error_code ec;
+    const auto f_size = std::filesystem::file_size(path, ec);
+    if (ec || f_size < stride * sizeof(float))
+      return {};
+
+    const size_t count = f_size / (stride * sizeof(float));
+    buffer.resize(count * stride);
+    std::ifstream fr_data(path, std::ios::in | std::ios::binary);
+    fr_data.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size() * sizeof(float)));
+    const auto read_count = static_cast<size_t>(fr_data.gcount()) / (stride * sizeof(float));
+
+    return {.data = buffer.data() + sizeof(EventRecordHeader) / sizeof(float), .count = read_count, .stride = stride};
+  }
+
   Api::Api(const userver::components::ComponentConfig& config,
     const userver::components::ComponentContext& context)
     : HttpHandlerJsonBase(config, context),
@@ -346,13 +368,17 @@ namespace Frs
           ConfigParams::FACE_CONFIDENCE_THRESHOLD,
           ConfigParams::FACE_ENLARGE_SCALE,
           ConfigParams::FACE_CLASS_CONFIDENCE_THRESHOLD,
-          ConfigParams::MARGIN};
+          ConfigParams::MARGIN,
+          ConfigParams::FACE_TRACK_QUALITY_MARGIN};
 
         HashSet<std::string> string_params = {
           ConfigParams::CONF_OSD_DT_FORMAT,
           ConfigParams::DNN_FD_INFERENCE_SERVER,
           ConfigParams::DNN_FC_INFERENCE_SERVER,
           ConfigParams::DNN_FR_INFERENCE_SERVER,
+          ConfigParams::DNN_FD_INFERENCE_BACKEND,
+          ConfigParams::DNN_FC_INFERENCE_BACKEND,
+          ConfigParams::DNN_FR_INFERENCE_BACKEND,
           ConfigParams::TITLE};
 
         HashSet<std::string> time_params = {
@@ -363,10 +389,12 @@ namespace Frs
           ConfigParams::DELAY_BETWEEN_FRAMES,
           ConfigParams::OPEN_DOOR_DURATION,
           ConfigParams::WORKFLOW_TIMEOUT,
-          ConfigParams::UNKNOWN_DESCRIPTOR_TTL};
+          ConfigParams::UNKNOWN_DESCRIPTOR_TTL,
+          ConfigParams::FACE_TRACK_RECOGNIZE_INTERVAL};
 
         HashSet<std::string> bool_params = {
-          ConfigParams::FLAG_SPAWNED_DESCRIPTORS};
+          ConfigParams::FLAG_SPAWNED_DESCRIPTORS,
+          ConfigParams::FLAG_FACE_TRACKING};
 
         // build video stream config
         userver::formats::json::ValueBuilder config_builder;
@@ -1239,7 +1267,17 @@ namespace Frs
       throw userver::server::handlers::ClientError(ExternalBody{e.what()});
     }
 
-    HashMap<int32_t, DescriptorData> descriptors;
+    decltype(CommonConfig::dnn_fr_output_size) dnn_fr_output_size = 512;
+    // scope for accessing cache
+    {
+      if (const auto cache = config_cache_.Get(); cache->getCommonConfig().contains(id_group))
+        dnn_fr_output_size = cache->getCommonConfig().at(id_group).dnn_fr_output_size;
+    }
+    const auto dim = static_cast<size_t>(dnn_fr_output_size);
+
+    // descriptors of the faces one after another
+    std::vector<int32_t> descriptor_ids;
+    std::vector<float> descriptors;
     try
     {
       auto result = pg_cluster_->Execute(userver::storages::postgres::ClusterHostType::kMaster,
@@ -1249,8 +1287,14 @@ namespace Frs
         auto id_descriptor = row[DatabaseFields::ID_DESCRIPTOR].As<int32_t>();
         std::string descriptor_data;
         row[DatabaseFields::DESCRIPTOR_DATA].To(userver::storages::postgres::Bytea(descriptor_data));
-        descriptors[id_descriptor] = {};
-        std::memmove(descriptors[id_descriptor].data, descriptor_data.data(), descriptor_data.size());
+
+        // skip descriptors of another face recognition model
+        if (descriptor_data.size() != dim * sizeof(float))
+          continue;
+
+        descriptor_ids.push_back(id_descriptor);
+        descriptors.resize(descriptors.size() + dim);
+        std::memcpy(descriptors.data() + descriptors.size() - dim, descriptor_data.data(), descriptor_data.size());
       }
     } catch (const std::exception& e)
     {
@@ -1258,6 +1302,20 @@ namespace Frs
       throw userver::server::handlers::ClientError(HandlerErrorCode::kServerSideError);
     }
 
+    const Similarity::StridedRows queries{.data = descriptors.data(), .count = descriptor_ids.size(), .stride = dim};
+    std::vector<float> records;
+    std::vector<float> similarities;
+
+    // similarities[q * rows.count + r] is the similarity of the q-th face and the r-th record of a data file
+    const auto compare = [&](const Similarity::StridedRows& rows)
+    {
+      similarities.resize(queries.count * rows.count);
+      Similarity::withDim(dim, [&]<size_t Dim>()
+        {
+          Similarity::manyToMany<Dim>(queries, rows, Similarity::Metric::COSINE, similarities, dim);
+        });
+    };
+
     std::vector<ResultItem> search_results;
     HashSet<std::string> event_ids;
 
@@ -1273,56 +1331,51 @@ namespace Frs
           // for test
           // cout << dir_entry.path().filename().string() << "\n";
 
+          const auto rows = readDescriptorRecords(dir_entry.path(), dim, records);
+          if (rows.count == 0)
+            continue;
+
+          compare(rows);
           std::error_code ec;
-          const auto f_size = std::filesystem::file_size(dir_entry.path(), ec);
-          EventData data{};
-          if (!ec && f_size > 0)
-          {
-            std::string s_data(f_size, '\0');
-            std::ifstream fr_data(dir_entry.path(), std::ios::in | std::ios::binary);
-            while (fr_data.good())
+          for (size_t r = 0; r < rows.count; ++r)
+            for (size_t q = 0; q < queries.count; ++q)
             {
-              fr_data.read(reinterpret_cast<char*>(&data), sizeof(data));
-              if (fr_data.gcount() == sizeof(data))
-                for (auto& [fst, snd] : descriptors)
+              if (double cosine_distance = similarities[q * rows.count + r]; cosine_distance > similarity_threshold)
+              {
+                const auto* header = reinterpret_cast<const EventRecordHeader*>(records.data() + r * rows.stride);
+                auto event_id = std::string(header->event_id, sizeof(header->event_id));
+                event_ids.insert(event_id);
+
+                // open a JSON file with event identifier
+                std::string json_filename = absl::Substitute("$0group_$1/$2/$3/$4/$5/$6.json", workflow_.getLocalConfig().events_path,
+                  id_group, event_id[0], event_id[1], event_id[2], event_id[3], event_id);
+                if (!std::filesystem::exists(json_filename, ec))
                 {
-                  if (double cosine_distance = cosineDistanceSIMD(snd.data, data.data); cosine_distance > similarity_threshold)
+                  // trying the shorter path for compatibility with the old project
+                  json_filename = absl::Substitute("$0group_$1/$2/$3/$4/$5.json", workflow_.getLocalConfig().events_path,
+                  id_group, event_id[0], event_id[1], event_id[2], event_id);
+                }
+                if (auto json_size = std::filesystem::file_size(json_filename, ec); !ec && json_size > 0)
+                {
+                  std::ifstream f_json(json_filename, std::ios::binary);
+                  auto event_json = userver::formats::json::FromStream(f_json);
+                  auto uuid = event_json["event_uuid"].As<std::string>("");
+                  std::string image_url;
+                  if (uuid.empty())
                   {
-                    auto event_id = std::string(data.event_id, sizeof(data.event_id));
-                    event_ids.insert(event_id);
-
-                    // open a JSON file with event identifier
-                    std::string json_filename = absl::Substitute("$0group_$1/$2/$3/$4/$5/$6.json", workflow_.getLocalConfig().events_path,
+                    image_url = absl::Substitute("$0group_$1/$2/$3/$4/$5/$6.jpg", workflow_.getLocalConfig().screenshots_url_prefix,
                       id_group, event_id[0], event_id[1], event_id[2], event_id[3], event_id);
-                    if (!std::filesystem::exists(json_filename, ec))
-                    {
-                      // trying the shorter path for compatibility with the old project
-                      json_filename = absl::Substitute("$0group_$1/$2/$3/$4/$5.json", workflow_.getLocalConfig().events_path,
-                      id_group, event_id[0], event_id[1], event_id[2], event_id);
-                    }
-                    if (auto json_size = std::filesystem::file_size(json_filename, ec); !ec && json_size > 0)
-                    {
-                      std::ifstream f_json(json_filename, std::ios::binary);
-                      auto event_json = userver::formats::json::FromStream(f_json);
-                      auto uuid = event_json["event_uuid"].As<std::string>("");
-                      std::string image_url;
-                      if (uuid.empty())
-                      {
-                        image_url = absl::Substitute("$0group_$1/$2/$3/$4/$5/$6.jpg", workflow_.getLocalConfig().screenshots_url_prefix,
-                          id_group, event_id[0], event_id[1], event_id[2], event_id[3], event_id);
-                      }
-                      auto event_date = event_json["event_date"].As<std::string>(dir_entry.path().filename().stem().string());
-                      search_results.push_back({event_date,
-                        event_id,
-                        uuid,
-                        image_url,
-                        fst,
-                        cosine_distance});
-                    }
                   }
+                  auto event_date = event_json["event_date"].As<std::string>(dir_entry.path().filename().stem().string());
+                  search_results.push_back({event_date,
+                    event_id,
+                    uuid,
+                    image_url,
+                    descriptor_ids[q],
+                    cosine_distance});
                 }
+              }
             }
-          }
         }
     }
 
@@ -1332,50 +1385,45 @@ namespace Frs
             && std::chrono::file_clock::to_sys(dir_entry.last_write_time()) >= absl::ToChronoTime(date_start)
             && std::chrono::file_clock::to_sys(dir_entry.last_write_time()) < absl::ToChronoTime(date_end))
         {
+          const auto rows = readDescriptorRecords(dir_entry.path(), dim, records);
+          if (rows.count == 0)
+            continue;
+
+          compare(rows);
           std::error_code ec;
-          const auto f_size = std::filesystem::file_size(dir_entry.path(), ec);
-          EventData data{};
-          if (!ec && f_size > 0)
-          {
-            std::string s_data(f_size, '\0');
-            std::ifstream fr_data(dir_entry.path(), std::ios::in | std::ios::binary);
-            while (fr_data.good())
+          for (size_t r = 0; r < rows.count; ++r)
+            for (size_t q = 0; q < queries.count; ++q)
             {
-              fr_data.read(reinterpret_cast<char*>(&data), sizeof(data));
-              if (fr_data.gcount() == sizeof(data))
-                for (auto& [fst, snd] : descriptors)
+              if (double cosine_distance = similarities[q * rows.count + r]; cosine_distance > similarity_threshold)
+              {
+                const auto* header = reinterpret_cast<const EventRecordHeader*>(records.data() + r * rows.stride);
+                auto event_id = std::string(header->event_id, sizeof(header->event_id));
+
+                // if a log entry is included in the events, then we ignore it
+                if (event_ids.find(event_id) != event_ids.end())
+                  continue;
+
+                // open a JSON log file
+                std::string f_name = dir_entry.path().stem();
+                std::string json_filename = dir_entry.path().parent_path() / (f_name + std::string(Workflow::JSON_SUFFIX));
+                if (auto json_size = std::filesystem::file_size(json_filename, ec); !ec && json_size > 0)
                 {
-                  if (double cosine_distance = cosineDistanceSIMD(snd.data, data.data); cosine_distance > similarity_threshold)
+                  std::ifstream f_json(json_filename, std::ios::binary);
+                  if (auto event_json = userver::formats::json::FromStream(f_json); event_json.HasMember("event_date"))
                   {
-                    auto event_id = std::string(data.event_id, sizeof(data.event_id));
-
-                    // if a log entry is included in the events, then we ignore it
-                    if (event_ids.find(event_id) != event_ids.end())
-                      continue;
-
-                    // open a JSON log file
-                    std::string f_name = dir_entry.path().stem();
-                    std::string json_filename = dir_entry.path().parent_path() / (f_name + std::string(Workflow::JSON_SUFFIX));
-                    if (auto json_size = std::filesystem::file_size(json_filename, ec); !ec && json_size > 0)
-                    {
-                      std::ifstream f_json(json_filename, std::ios::binary);
-                      if (auto event_json = userver::formats::json::FromStream(f_json); event_json.HasMember("event_date"))
-                      {
-                        auto event_date = event_json["event_date"].As<std::string>();
-                        std::string image_url = absl::Substitute("$0group_$1/$2/$3/$4/$5/$6.jpg", workflow_.getLocalConfig().screenshots_url_prefix,
-                          id_group, f_name[0], f_name[1], f_name[2], f_name[3], f_name);
-                        search_results.push_back({event_date,
-                          event_id,
-                          "",
-                          image_url,
-                          fst,
-                          cosine_distance});
-                      }
-                    }
+                    auto event_date = event_json["event_date"].As<std::string>();
+                    std::string image_url = absl::Substitute("$0group_$1/$2/$3/$4/$5/$6.jpg", workflow_.getLocalConfig().screenshots_url_prefix,
+                      id_group, f_name[0], f_name[1], f_name[2], f_name[3], f_name);
+                    search_results.push_back({event_date,
+                      event_id,
+                      "",
+                      image_url,
+                      descriptor_ids[q],
+                      cosine_distance});
                   }
                 }
+              }
             }
-          }
         }
 
     std::ranges::sort(search_results, std::greater());
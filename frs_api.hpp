@@ -2,7 +2,6 @@
 
 #include <absl/strings/string_view.h>
 #include <absl/strings/substitute.h>
-#include <immintrin.h>
 #include <userver/server/handlers/http_handler_json_base.hpp>
 #include <userver/storages/postgres/cluster.hpp>
 
@@ -11,20 +10,12 @@
 
 namespace Frs
 {
-  constexpr int DESCRIPTOR_SIZE = 512;
-  typedef float Data[DESCRIPTOR_SIZE];
-
-  // binary event data
-  struct EventData
+  // binary event data: the header of a face descriptor record in the data files of events and logs,
+  // it is followed by the descriptor data of dnn_fr_output_size floats of the group
+  struct EventRecordHeader
   {
     char event_id[32];  // internal event identifier
     int32_t position;   // descriptor position (numbering starts from zero)
-    Data data;          // descriptor data
-  } __attribute__((packed));
-
-  struct DescriptorData
-  {
-    Data data;  // descriptor data
   } __attribute__((packed));
 
   struct ResultItem
@@ -42,69 +33,6 @@ namespace Frs
     }
   };
 
-  inline float reduceSum(const __m256& a)
-  {
-    __m256 s0 = _mm256_hadd_ps(a, a);
-    s0 = _mm256_hadd_ps(s0, s0);
-    auto s1 = _mm256_extractf128_ps(s0, 1);
-    s1 = _mm_add_ps(_mm256_castps256_ps128(s0), s1);
-    return _mm_cvtss_f32(s1);
-  }
-
-  inline double cosineDistanceSIMD(const Data& d1, const Data& d2)
-  {
-    constexpr int step = 8;
-    __m256 sum0 = _mm256_setzero_ps();
-    __m256 sum1 = _mm256_setzero_ps();
-    __m256 sum2 = _mm256_setzero_ps();
-    __m256 sum3 = _mm256_setzero_ps();
-    __m256 sum0_sqr1 = _mm256_setzero_ps();
-    __m256 sum1_sqr1 = _mm256_setzero_ps();
-    __m256 sum2_sqr1 = _mm256_setzero_ps();
-    __m256 sum3_sqr1 = _mm256_setzero_ps();
-    __m256 sum0_sqr2 = _mm256_setzero_ps();
-    __m256 sum1_sqr2 = _mm256_setzero_ps();
-    __m256 sum2_sqr2 = _mm256_setzero_ps();
-    __m256 sum3_sqr2 = _mm256_setzero_ps();
-
-    for (int i = 0; i < DESCRIPTOR_SIZE; i += 4 * step)
-    {
-      __m256 a0 = _mm256_loadu_ps(d1 + i + 0 * step);
-      __m256 b0 = _mm256_loadu_ps(d2 + i + 0 * step);
-      sum0 = _mm256_add_ps(sum0, _mm256_mul_ps(a0, b0));
-      sum0_sqr1 = _mm256_add_ps(sum0_sqr1, _mm256_mul_ps(a0, a0));
-      sum0_sqr2 = _mm256_add_ps(sum0_sqr2, _mm256_mul_ps(b0, b0));
-
-      a0 = _mm256_loadu_ps(d1 + i + 1 * step);
-      b0 = _mm256_loadu_ps(d2 + i + 1 * step);
-      sum1 = _mm256_add_ps(sum1, _mm256_mul_ps(a0, b0));
-      sum1_sqr1 = _mm256_add_ps(sum1_sqr1, _mm256_mul_ps(a0, a0));
-      sum1_sqr2 = _mm256_add_ps(sum1_sqr2, _mm256_mul_ps(b0, b0));
-
-      a0 = _mm256_loadu_ps(d1 + i + 2 * step);
-      b0 = _mm256_loadu_ps(d2 + i + 2 * step);
-      sum2 = _mm256_add_ps(sum2, _mm256_mul_ps(a0, b0));
-      sum2_sqr1 = _mm256_add_ps(sum2_sqr1, _mm256_mul_ps(a0, a0));
-      sum2_sqr2 = _mm256_add_ps(sum2_sqr2, _mm256_mul_ps(b0, b0));
-
-      a0 = _mm256_loadu_ps(d1 + i + 3 * step);
-      b0 = _mm256_loadu_ps(d2 + i + 3 * step);
-      sum3 = _mm256_add_ps(sum3, _mm256_mul_ps(a0, b0));
-      sum3_sqr1 = _mm256_add_ps(sum3_sqr1, _mm256_mul_ps(a0, a0));
-      sum3_sqr2 = _mm256_add_ps(sum3_sqr2, _mm256_mul_ps(b0, b0));
-    }
-    sum0 = _mm256_add_ps(sum0, sum1);
-    sum2 = _mm256_add_ps(sum2, sum3);
-    sum0 = _mm256_add_ps(sum0, sum2);
-    sum0_sqr1 = _mm256_add_ps(sum0_sqr1, sum1_sqr1);
-    sum2_sqr1 = _mm256_add_ps(sum2_sqr1, sum3_sqr1);
-    sum0_sqr1 = _mm256_add_ps(sum0_sqr1, sum2_sqr1);
-    sum0_sqr2 = _mm256_add_ps(sum0_sqr2, sum1_sqr2);
-    sum2_sqr2 = _mm256_add_ps(sum2_sqr2, sum3_sqr2);
-    sum0_sqr2 = _mm256_add_ps(sum0_sqr2, sum2_sqr2);
-    return reduceSum(sum0) / sqrt(reduceSum(sum0_sqr1)) / sqrt(reduceSum(sum0_sqr2));
-  }
-
   class Api final : public userver::server::handlers::HttpHandlerJsonBase
   {
   public:
@@ -413,9 +341,9 @@ namespace Frs
         and flag_deleted = false
     )_SQL_";
 
-    static constexpr auto SQL_SET_COMMON_CONFIG_PARAMS = "update common_config set config = coalesce(config, $2) || $2 where id_group = $1";
+    static constexpr auto SQL_SET_COMMON_CONFIG_PARAMS = "update common_config set config = coalesce(config, $2) || $2, last_updated = now() where id_group = $1";
     static constexpr auto SQL_GET_COMMON_CONFIG_PARAMS = "select config from common_config where id_group = $1";
-    static constexpr auto SQL_SET_STREAM_DEFAULT_CONFIG_PARAMS = "update default_vstream_config set config = coalesce(config, $2) || $2 where id_group = $1";
+    static constexpr auto SQL_SET_STREAM_DEFAULT_CONFIG_PARAMS = "update default_vstream_config set config = coalesce(config, $2) || $2, last_updated = now() where id_group = $1";
     static constexpr auto SQL_GET_STREAM_DEFAULT_CONFIG_PARAMS = "select config from default_vstream_config where id_group = $1";
 
     // do not delete row from a database, just mark for deletion
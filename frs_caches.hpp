@@ -35,6 +35,11 @@ namespace Frs
     inline static constexpr auto LOG_FACES_TTL = "log-faces-ttl";
     inline static constexpr auto FLAG_DELETED_TTL = "flag-deleted-ttl";
     inline static constexpr auto EVENTS_TTL = "events-ttl";
+    inline static constexpr auto DNN_STATS_PATH = "dnn-stats-path";
+    inline static constexpr auto DNN_STATS_SAVE_INTERVAL = "dnn-stats-save-interval";
+    inline static constexpr auto ONNXRUNTIME_INTRA_OP_THREADS = "onnxruntime-intra-op-threads";
+    inline static constexpr auto ONNXRUNTIME_SESSION_POOL_SIZE = "onnxruntime-session-pool-size";
+    inline static constexpr auto RTSP_DECODER_POOL_SIZE = "rtsp-decoder-pool-size";
 
     // Common
     inline static constexpr auto CALLBACK_TIMEOUT = "callback-timeout";
@@ -72,12 +77,21 @@ namespace Frs
     inline static constexpr auto BEST_QUALITY_INTERVAL_BEFORE = "best-quality-interval-before";
     inline static constexpr auto BLUR = "blur";
     inline static constexpr auto BLUR_MAX = "blur-max";
+    inline static constexpr auto BRIGHTNESS_MIN = "brightness-min";
+    inline static constexpr auto BRIGHTNESS_MAX = "brightness-max";
+    inline static constexpr auto CONTRAST_MIN = "contrast-min";
+    inline static constexpr auto SATURATION_MAX = "saturation-max";
     inline static constexpr auto CAPTURE_TIMEOUT = "capture-timeout";
+    inline static constexpr auto CAPTURE_MODE = "capture-mode";
+    inline static constexpr auto MOTION_THRESHOLD = "motion-threshold";
     inline static constexpr auto DELAY_AFTER_ERROR = "delay-after-error";
     inline static constexpr auto DELAY_BETWEEN_FRAMES = "delay-between-frames";
     inline static constexpr auto DNN_FD_INFERENCE_SERVER = "dnn-fd-inference-server";
+    inline static constexpr auto DNN_FD_INFERENCE_BACKEND = "dnn-fd-inference-backend";
     inline static constexpr auto DNN_FC_INFERENCE_SERVER = "dnn-fc-inference-server";
+    inline static constexpr auto DNN_FC_INFERENCE_BACKEND = "dnn-fc-inference-backend";
     inline static constexpr auto DNN_FR_INFERENCE_SERVER = "dnn-fr-inference-server";
+    inline static constexpr auto DNN_FR_INFERENCE_BACKEND = "dnn-fr-inference-backend";
     inline static constexpr auto FACE_CLASS_CONFIDENCE_THRESHOLD = "face-class-confidence";
     inline static constexpr auto FACE_CONFIDENCE_THRESHOLD = "face-confidence";
     inline static constexpr auto FACE_ENLARGE_SCALE = "face-enlarge-scale";
@@ -91,6 +105,9 @@ namespace Frs
     inline static constexpr auto WORKFLOW_TIMEOUT = "workflow-timeout";
     inline static constexpr auto FLAG_SPAWNED_DESCRIPTORS = "flag-spawned-descriptors";
     inline static constexpr auto UNKNOWN_DESCRIPTOR_TTL = "unknown-descriptor-ttl";
+    inline static constexpr auto FLAG_FACE_TRACKING = "flag-face-tracking";
+    inline static constexpr auto FACE_TRACK_QUALITY_MARGIN = "face-track-quality-margin";
+    inline static constexpr auto FACE_TRACK_RECOGNIZE_INTERVAL = "face-track-recognize-interval";
 
     // Video stream specific params
     inline static constexpr auto TITLE = "title";
@@ -136,12 +153,21 @@ namespace Frs
     std::chrono::milliseconds best_quality_interval_before{std::chrono::seconds{5}};
     float blur{300.0};
     float blur_max{13'000};
+    float brightness_min{0.0f};
+    float brightness_max{255.0f};
+    float contrast_min{0.0f};
+    float saturation_max{1.0f};  // 1 - the share of the saturated pixels isn't checked
     std::chrono::milliseconds capture_timeout{std::chrono::seconds{2}};
+    std::string capture_mode{"snapshot"};
+    float motion_threshold{0.0f};  // 0 - the scene prefilter is off
     std::chrono::milliseconds delay_after_error{std::chrono::seconds{30}};
     std::chrono::milliseconds delay_between_frames{std::chrono::seconds{1}};
     std::string dnn_fd_inference_server{"127.0.0.1:8000"};
+    std::string dnn_fd_inference_backend{"triton"};
     std::string dnn_fc_inference_server{"127.0.0.1:8000"};
+    std::string dnn_fc_inference_backend{"triton"};
     std::string dnn_fr_inference_server{"127.0.0.1:8000"};
+    std::string dnn_fr_inference_backend{"triton"};
     float face_class_confidence{0.7};
     float face_confidence{0.7};
     float face_enlarge_scale{1.5};
@@ -157,6 +183,9 @@ namespace Frs
     std::chrono::milliseconds workflow_timeout{std::chrono::seconds{0}};
     bool flag_spawned_descriptors{false};
     std::chrono::milliseconds unknown_descriptor_ttl{std::chrono::seconds{5}};
+    bool flag_face_tracking{false};
+    float face_track_quality_margin{0.2f};
+    std::chrono::milliseconds face_track_recognize_interval{std::chrono::seconds{5}};
 
     // additional data
     int32_t id_group{};
@@ -166,37 +195,94 @@ namespace Frs
     std::string callback_url;
   };
 
+  inline std::vector<float> convertToWorkArea(const userver::formats::json::Value& value, const std::vector<float>& default_value)
+  {
+    if (!value.IsArray())
+      return default_value;
+
+    try
+    {
+      return value.As<std::vector<float>>();
+    } catch (const std::exception&)
+    {
+    }
+
+    return default_value;
+  }
+
+  inline constexpr ConfigSchema COMMON_CONFIG_SCHEMA{std::array{
+    bindParam<&CommonConfig::callback_timeout>(ConfigParams::CALLBACK_TIMEOUT),
+    bindParam<&CommonConfig::flag_copy_event_data>(ConfigParams::FLAG_COPY_EVENT_DATA),
+    bindParam<&CommonConfig::dnn_fd_model_name>(ConfigParams::DNN_FD_MODEL_NAME),
+    bindParam<&CommonConfig::dnn_fd_input_width>(ConfigParams::DNN_FD_INPUT_WIDTH),
+    bindParam<&CommonConfig::dnn_fd_input_height>(ConfigParams::DNN_FD_INPUT_HEIGHT),
+    bindParam<&CommonConfig::dnn_fd_input_tensor_name>(ConfigParams::DNN_FD_INPUT_TENSOR_NAME),
+    bindParam<&CommonConfig::dnn_fc_model_name>(ConfigParams::DNN_FC_MODEL_NAME),
+    bindParam<&CommonConfig::dnn_fc_input_width>(ConfigParams::DNN_FC_INPUT_WIDTH),
+    bindParam<&CommonConfig::dnn_fc_input_height>(ConfigParams::DNN_FC_INPUT_HEIGHT),
+    bindParam<&CommonConfig::dnn_fc_input_tensor_name>(ConfigParams::DNN_FC_INPUT_TENSOR_NAME),
+    bindParam<&CommonConfig::dnn_fc_output_tensor_name>(ConfigParams::DNN_FC_OUTPUT_TENSOR_NAME),
+    bindParam<&CommonConfig::dnn_fc_output_size>(ConfigParams::DNN_FC_OUTPUT_SIZE),
+    bindParam<&CommonConfig::dnn_fr_model_name>(ConfigParams::DNN_FR_MODEL_NAME),
+    bindParam<&CommonConfig::dnn_fr_input_width>(ConfigParams::DNN_FR_INPUT_WIDTH),
+    bindParam<&CommonConfig::dnn_fr_input_height>(ConfigParams::DNN_FR_INPUT_HEIGHT),
+    bindParam<&CommonConfig::dnn_fr_input_tensor_name>(ConfigParams::DNN_FR_INPUT_TENSOR_NAME),
+    bindParam<&CommonConfig::dnn_fr_output_tensor_name>(ConfigParams::DNN_FR_OUTPUT_TENSOR_NAME),
+    bindParam<&CommonConfig::dnn_fr_output_size>(ConfigParams::DNN_FR_OUTPUT_SIZE),
+    bindParam<&CommonConfig::comments_blurry_face>(ConfigParams::COMMENTS_BLURRY_FACE),
+    bindParam<&CommonConfig::comments_descriptor_creation_error>(ConfigParams::COMMENTS_DESCRIPTOR_CREATION_ERROR),
+    bindParam<&CommonConfig::comments_descriptor_exists>(ConfigParams::COMMENTS_DESCRIPTOR_EXISTS),
+    bindParam<&CommonConfig::comments_inference_error>(ConfigParams::COMMENTS_INFERENCE_ERROR),
+    bindParam<&CommonConfig::comments_new_descriptor>(ConfigParams::COMMENTS_NEW_DESCRIPTOR),
+    bindParam<&CommonConfig::comments_no_faces>(ConfigParams::COMMENTS_NO_FACES),
+    bindParam<&CommonConfig::comments_non_frontal_face>(ConfigParams::COMMENTS_NON_FRONTAL_FACE),
+    bindParam<&CommonConfig::comments_non_normal_face_class>(ConfigParams::COMMENTS_NON_NORMAL_FACE_CLASS),
+    bindParam<&CommonConfig::comments_partial_face>(ConfigParams::COMMENTS_PARTIAL_FACE),
+    bindParam<&CommonConfig::comments_url_image_error>(ConfigParams::COMMENTS_URL_IMAGE_ERROR),
+    bindParam<&CommonConfig::sg_max_descriptor_count>(ConfigParams::SG_MAX_DESCRIPTOR_COUNT)}};
+
+  inline constexpr ConfigSchema VSTREAM_CONFIG_SCHEMA{std::array{
+    bindParam<&VStreamConfig::best_quality_interval_after>(ConfigParams::BEST_QUALITY_INTERVAL_AFTER),
+    bindParam<&VStreamConfig::best_quality_interval_before>(ConfigParams::BEST_QUALITY_INTERVAL_BEFORE),
+    bindParam<&VStreamConfig::blur>(ConfigParams::BLUR),
+    bindParam<&VStreamConfig::blur_max>(ConfigParams::BLUR_MAX),
+    bindParam<&VStreamConfig::brightness_min>(ConfigParams::BRIGHTNESS_MIN),
+    bindParam<&VStreamConfig::brightness_max>(ConfigParams::BRIGHTNESS_MAX),
+    bindParam<&VStreamConfig::contrast_min>(ConfigParams::CONTRAST_MIN),
+    bindParam<&VStreamConfig::saturation_max>(ConfigParams::SATURATION_MAX),
+    bindParam<&VStreamConfig::capture_timeout>(ConfigParams::CAPTURE_TIMEOUT),
+    bindParam<&VStreamConfig::capture_mode>(ConfigParams::CAPTURE_MODE),
+    bindParam<&VStreamConfig::motion_threshold>(ConfigParams::MOTION_THRESHOLD),
+    bindParam<&VStreamConfig::delay_after_error>(ConfigParams::DELAY_AFTER_ERROR),
+    bindParam<&VStreamConfig::delay_between_frames>(ConfigParams::DELAY_BETWEEN_FRAMES),
+    bindParam<&VStreamConfig::dnn_fd_inference_server>(ConfigParams::DNN_FD_INFERENCE_SERVER),
+    bindParam<&VStreamConfig::dnn_fd_inference_backend>(ConfigParams::DNN_FD_INFERENCE_BACKEND),
+    bindParam<&VStreamConfig::dnn_fc_inference_server>(ConfigParams::DNN_FC_INFERENCE_SERVER),
+    bindParam<&VStreamConfig::dnn_fc_inference_backend>(ConfigParams::DNN_FC_INFERENCE_BACKEND),
+    bindParam<&VStreamConfig::dnn_fr_inference_server>(ConfigParams::DNN_FR_INFERENCE_SERVER),
+    bindParam<&VStreamConfig::dnn_fr_inference_backend>(ConfigParams::DNN_FR_INFERENCE_BACKEND),
+    bindParam<&VStreamConfig::face_class_confidence>(ConfigParams::FACE_CLASS_CONFIDENCE_THRESHOLD),
+    bindParam<&VStreamConfig::face_confidence>(ConfigParams::FACE_CONFIDENCE_THRESHOLD),
+    bindParam<&VStreamConfig::face_enlarge_scale>(ConfigParams::FACE_ENLARGE_SCALE),
+    bindParam<&VStreamConfig::logs_level>(ConfigParams::LOGS_LEVEL),
+    bindParam<&VStreamConfig::margin>(ConfigParams::MARGIN),
+    bindParam<&VStreamConfig::max_capture_error_count>(ConfigParams::MAX_CAPTURE_ERROR_COUNT),
+    bindParam<&VStreamConfig::open_door_duration>(ConfigParams::OPEN_DOOR_DURATION),
+    bindParam<&VStreamConfig::tolerance>(ConfigParams::TOLERANCE),
+    bindParam<&VStreamConfig::title>(ConfigParams::TITLE),
+    bindParam<&VStreamConfig::title_height_ratio>(ConfigParams::TITLE_HEIGHT_RATIO),
+    bindParam<&VStreamConfig::osd_dt_format>(ConfigParams::CONF_OSD_DT_FORMAT),
+    bindParam<&VStreamConfig::work_area, convertToWorkArea>(ConfigParams::WORK_AREA),
+    bindParam<&VStreamConfig::workflow_timeout>(ConfigParams::WORKFLOW_TIMEOUT),
+    bindParam<&VStreamConfig::flag_spawned_descriptors>(ConfigParams::FLAG_SPAWNED_DESCRIPTORS),
+    bindParam<&VStreamConfig::unknown_descriptor_ttl>(ConfigParams::UNKNOWN_DESCRIPTOR_TTL),
+    bindParam<&VStreamConfig::flag_face_tracking>(ConfigParams::FLAG_FACE_TRACKING),
+    bindParam<&VStreamConfig::face_track_quality_margin>(ConfigParams::FACE_TRACK_QUALITY_MARGIN),
+    bindParam<&VStreamConfig::face_track_recognize_interval>(ConfigParams::FACE_TRACK_RECOGNIZE_INTERVAL)}};
+
   static VStreamConfig updateVStreamConfig(const userver::formats::json::Value& json)
   {
-    VStreamConfig config{};
-    config.best_quality_interval_after = convertToDuration(json[ConfigParams::BEST_QUALITY_INTERVAL_AFTER], config.best_quality_interval_after);
-    config.best_quality_interval_before = convertToDuration(json[ConfigParams::BEST_QUALITY_INTERVAL_BEFORE], config.best_quality_interval_before);
-    config.blur = convertToNumber(json[ConfigParams::BLUR], config.blur);
-    config.blur_max = convertToNumber(json[ConfigParams::BLUR_MAX], config.blur_max);
-    config.capture_timeout = convertToDuration(json[ConfigParams::CAPTURE_TIMEOUT], config.capture_timeout);
-    config.delay_after_error = convertToDuration(json[ConfigParams::DELAY_AFTER_ERROR], config.delay_after_error);
-    config.delay_between_frames = convertToDuration(json[ConfigParams::DELAY_BETWEEN_FRAMES], config.delay_between_frames);
-    config.dnn_fd_inference_server = convertToString(json[ConfigParams::DNN_FD_INFERENCE_SERVER], config.dnn_fd_inference_server);
-    config.dnn_fc_inference_server = convertToString(json[ConfigParams::DNN_FC_INFERENCE_SERVER], config.dnn_fc_inference_server);
-    config.dnn_fr_inference_server = convertToString(json[ConfigParams::DNN_FR_INFERENCE_SERVER], config.dnn_fr_inference_server);
-    config.face_class_confidence = convertToNumber(json[ConfigParams::FACE_CLASS_CONFIDENCE_THRESHOLD], config.face_class_confidence);
-    config.face_confidence = convertToNumber(json[ConfigParams::FACE_CONFIDENCE_THRESHOLD], config.face_confidence);
-    config.face_enlarge_scale = convertToNumber(json[ConfigParams::FACE_ENLARGE_SCALE], config.face_enlarge_scale);
-    config.logs_level = convertToLevel(json[ConfigParams::LOGS_LEVEL], config.logs_level);
-    config.margin = convertToNumber(json[ConfigParams::MARGIN], config.margin);
-    config.max_capture_error_count = convertToNumber(json[ConfigParams::MAX_CAPTURE_ERROR_COUNT], config.max_capture_error_count);
-    config.open_door_duration = convertToDuration(json[ConfigParams::OPEN_DOOR_DURATION], config.open_door_duration);
-    config.tolerance = convertToNumber(json[ConfigParams::TOLERANCE], config.tolerance);
-    config.title = convertToString(json[ConfigParams::TITLE], config.title);
-    config.title_height_ratio = convertToNumber(json[ConfigParams::TITLE_HEIGHT_RATIO], config.title_height_ratio);
-    config.osd_dt_format = convertToString(json[ConfigParams::CONF_OSD_DT_FORMAT], config.osd_dt_format);
-    if (json.HasMember(ConfigParams::WORK_AREA) && json[ConfigParams::WORK_AREA].IsArray())
-      config.work_area = json[ConfigParams::WORK_AREA].As<decltype(config.work_area)>();
-    config.workflow_timeout = convertToDuration(json[ConfigParams::WORKFLOW_TIMEOUT], config.workflow_timeout);
-    config.flag_spawned_descriptors = convertToBool(json[ConfigParams::FLAG_SPAWNED_DESCRIPTORS], config.flag_spawned_descriptors);
-    config.unknown_descriptor_ttl = convertToDuration(json[ConfigParams::UNKNOWN_DESCRIPTOR_TTL], config.unknown_descriptor_ttl);
-
-    return config;
+    return VSTREAM_CONFIG_SCHEMA.parse(json);
   }
 
   // Video stream groups' cache
@@ -234,47 +320,13 @@ namespace Frs
     {
       if (item.config)
       {
-        // common config
-        common_config_[item.id_group].callback_timeout = item.config->HasMember(ConfigParams::CALLBACK_TIMEOUT)
-                                                           ? userver::utils::StringToDuration((*item.config)[ConfigParams::CALLBACK_TIMEOUT].As<std::string>())
-                                                           : common_config_[item.id_group].callback_timeout;
-        common_config_[item.id_group].flag_copy_event_data = (*item.config)[ConfigParams::FLAG_COPY_EVENT_DATA].As<decltype(common_config_[item.id_group].flag_copy_event_data)>(common_config_[item.id_group].flag_copy_event_data);
-
-        common_config_[item.id_group].dnn_fd_model_name = (*item.config)[ConfigParams::DNN_FD_MODEL_NAME].As<decltype(common_config_[item.id_group].dnn_fd_model_name)>(common_config_[item.id_group].dnn_fd_model_name);
-        common_config_[item.id_group].dnn_fd_input_width = (*item.config)[ConfigParams::DNN_FD_INPUT_WIDTH].As<decltype(common_config_[item.id_group].dnn_fd_input_width)>(common_config_[item.id_group].dnn_fd_input_width);
-        common_config_[item.id_group].dnn_fd_input_height = (*item.config)[ConfigParams::DNN_FD_INPUT_HEIGHT].As<decltype(common_config_[item.id_group].dnn_fd_input_height)>(common_config_[item.id_group].dnn_fd_input_height);
-        common_config_[item.id_group].dnn_fd_input_tensor_name = (*item.config)[ConfigParams::DNN_FD_INPUT_TENSOR_NAME].As<decltype(common_config_[item.id_group].dnn_fd_input_tensor_name)>(common_config_[item.id_group].dnn_fd_input_tensor_name);
-
-        common_config_[item.id_group].dnn_fc_model_name = (*item.config)[ConfigParams::DNN_FC_MODEL_NAME].As<decltype(common_config_[item.id_group].dnn_fc_model_name)>(common_config_[item.id_group].dnn_fc_model_name);
-        common_config_[item.id_group].dnn_fc_input_width = (*item.config)[ConfigParams::DNN_FC_INPUT_WIDTH].As<decltype(common_config_[item.id_group].dnn_fc_input_width)>(common_config_[item.id_group].dnn_fc_input_width);
-        common_config_[item.id_group].dnn_fc_input_height = (*item.config)[ConfigParams::DNN_FC_INPUT_HEIGHT].As<decltype(common_config_[item.id_group].dnn_fc_input_height)>(common_config_[item.id_group].dnn_fc_input_height);
-        common_config_[item.id_group].dnn_fc_input_tensor_name = (*item.config)[ConfigParams::DNN_FC_INPUT_TENSOR_NAME].As<decltype(common_config_[item.id_group].dnn_fc_input_tensor_name)>(common_config_[item.id_group].dnn_fc_input_tensor_name);
-        common_config_[item.id_group].dnn_fc_output_tensor_name = (*item.config)[ConfigParams::DNN_FC_OUTPUT_TENSOR_NAME].As<decltype(common_config_[item.id_group].dnn_fc_output_tensor_name)>(common_config_[item.id_group].dnn_fc_output_tensor_name);
-        common_config_[item.id_group].dnn_fc_output_size = (*item.config)[ConfigParams::DNN_FC_OUTPUT_SIZE].As<decltype(common_config_[item.id_group].dnn_fc_output_size)>(common_config_[item.id_group].dnn_fc_output_size);
-
-        common_config_[item.id_group].dnn_fr_model_name = (*item.config)[ConfigParams::DNN_FR_MODEL_NAME].As<decltype(common_config_[item.id_group].dnn_fr_model_name)>(common_config_[item.id_group].dnn_fr_model_name);
-        common_config_[item.id_group].dnn_fr_input_width = (*item.config)[ConfigParams::DNN_FR_INPUT_WIDTH].As<decltype(common_config_[item.id_group].dnn_fr_input_width)>(common_config_[item.id_group].dnn_fr_input_width);
-        common_config_[item.id_group].dnn_fr_input_height = (*item.config)[ConfigParams::DNN_FR_INPUT_HEIGHT].As<decltype(common_config_[item.id_group].dnn_fr_input_height)>(common_config_[item.id_group].dnn_fr_input_height);
-        common_config_[item.id_group].dnn_fr_input_tensor_name = (*item.config)[ConfigParams::DNN_FR_INPUT_TENSOR_NAME].As<decltype(common_config_[item.id_group].dnn_fr_input_tensor_name)>(common_config_[item.id_group].dnn_fr_input_tensor_name);
-        common_config_[item.id_group].dnn_fr_output_tensor_name = (*item.config)[ConfigParams::DNN_FR_OUTPUT_TENSOR_NAME].As<decltype(common_config_[item.id_group].dnn_fr_output_tensor_name)>(common_config_[item.id_group].dnn_fr_output_tensor_name);
-        common_config_[item.id_group].dnn_fr_output_size = (*item.config)[ConfigParams::DNN_FR_OUTPUT_SIZE].As<decltype(common_config_[item.id_group].dnn_fr_output_size)>(common_config_[item.id_group].dnn_fr_output_size);
-
-        common_config_[item.id_group].comments_blurry_face = (*item.config)[ConfigParams::COMMENTS_BLURRY_FACE].As<decltype(common_config_[item.id_group].comments_blurry_face)>(common_config_[item.id_group].comments_blurry_face);
-        common_config_[item.id_group].comments_descriptor_creation_error = (*item.config)[ConfigParams::COMMENTS_DESCRIPTOR_CREATION_ERROR].As<decltype(common_config_[item.id_group].comments_descriptor_creation_error)>(common_config_[item.id_group].comments_descriptor_creation_error);
-        common_config_[item.id_group].comments_descriptor_exists = (*item.config)[ConfigParams::COMMENTS_DESCRIPTOR_EXISTS].As<decltype(common_config_[item.id_group].comments_descriptor_exists)>(common_config_[item.id_group].comments_descriptor_exists);
-        common_config_[item.id_group].comments_inference_error = (*item.config)[ConfigParams::COMMENTS_INFERENCE_ERROR].As<decltype(common_config_[item.id_group].comments_inference_error)>(common_config_[item.id_group].comments_inference_error);
-        common_config_[item.id_group].comments_new_descriptor = (*item.config)[ConfigParams::COMMENTS_NEW_DESCRIPTOR].As<decltype(common_config_[item.id_group].comments_new_descriptor)>(common_config_[item.id_group].comments_new_descriptor);
-        common_config_[item.id_group].comments_no_faces = (*item.config)[ConfigParams::COMMENTS_NO_FACES].As<decltype(common_config_[item.id_group].comments_no_faces)>(common_config_[item.id_group].comments_no_faces);
-        common_config_[item.id_group].comments_non_frontal_face = (*item.config)[ConfigParams::COMMENTS_NON_FRONTAL_FACE].As<decltype(common_config_[item.id_group].comments_non_frontal_face)>(common_config_[item.id_group].comments_non_frontal_face);
-        common_config_[item.id_group].comments_non_normal_face_class = (*item.config)[ConfigParams::COMMENTS_NON_NORMAL_FACE_CLASS].As<decltype(common_config_[item.id_group].comments_non_normal_face_class)>(common_config_[item.id_group].comments_non_normal_face_class);
-        common_config_[item.id_group].comments_partial_face = (*item.config)[ConfigParams::COMMENTS_PARTIAL_FACE].As<decltype(common_config_[item.id_group].comments_partial_face)>(common_config_[item.id_group].comments_partial_face);
-        common_config_[item.id_group].comments_url_image_error = (*item.config)[ConfigParams::COMMENTS_URL_IMAGE_ERROR].As<decltype(common_config_[item.id_group].comments_url_image_error)>(common_config_[item.id_group].comments_url_image_error);
-
-        common_config_[item.id_group].sg_max_descriptor_count = (*item.config)[ConfigParams::SG_MAX_DESCRIPTOR_COUNT].As<decltype(common_config_[item.id_group].sg_max_descriptor_count)>(common_config_[item.id_group].sg_max_descriptor_count);
+        // parse from scratch: an incremental update works on a copy of the previous data
+        common_config_[item.id_group] = COMMON_CONFIG_SCHEMA.parse(*item.config);
 
         // default video stream config
-        default_vstream_config_[item.id_group] = updateVStreamConfig(*item.config);
-        default_vstream_config_[item.id_group].id_group = item.id_group;
+        auto& default_vstream_config = default_vstream_config_[item.id_group];
+        default_vstream_config = updateVStreamConfig(*item.config);
+        default_vstream_config.id_group = item.id_group;
       }
     }
 
@@ -315,7 +367,9 @@ namespace Frs
         left join default_vstream_config dvc
           on dvc.id_group = vg.id_group
     )__SQL__";
-    static constexpr const char* kUpdatedField = nullptr;
+    // the timestamp of a group without configs is -infinity instead of null: it is loaded by the full updates only
+    static constexpr auto kUpdatedField = "greatest(coalesce(cc.last_updated, '-infinity'), coalesce(dvc.last_updated, '-infinity'))";
+    using UpdatedFieldType = userver::storages::postgres::TimePointTz;
     using CacheContainer = ConfigContainer;
     static constexpr auto kClusterHostType = userver::storages::postgres::ClusterHostType::kMaster;
   };
@@ -394,7 +448,8 @@ namespace Frs
         left join default_vstream_config d
           on d.id_group = vs.id_group
     )__SQL__";
-    static constexpr auto kUpdatedField = "last_updated";
+    // a change of the group's default config also refreshes all video streams of the group
+    static constexpr auto kUpdatedField = "greatest(vs.last_updated, coalesce(d.last_updated, '-infinity'))";
     using UpdatedFieldType = userver::storages::postgres::TimePointTz;
     using CacheContainer = VStreamConfigContainer;
     static constexpr auto kClusterHostType = userver::storages::postgres::ClusterHostType::kMaster;
@@ -0,0 +1,109 @@
+#include <algorithm>
+
+#include "frs_face_tracker.hpp"
+#include "tracking.hpp"
+
+namespace Frs
+{
+  std::array<cv::Point2f, 5> FaceTracker::relativeLandmarks(const Observation& face)
+  {
+    std::array<cv::Point2f, 5> result;
+    const float scale = face.box.width > 0.0f ? 1.0f / face.box.width : 0.0f;
+    for (size_t i = 0; i < result.size(); ++i)
+      result[i] = (face.landmarks[i] - face.box.tl()) * scale;
+
+    return result;
+  }
+
+  std::vector<size_t> FaceTracker::observe(const std::vector<Observation>& faces, const Options& options, const std::chrono::steady_clock::time_point now)
+  {
+    std::erase_if(tracks_, [&options, now](const Track& track)
+      {
+        return now - track.last_seen_tp > options.ttl;
+      });
+
+    std::vector<cv::Rect2f> predicted_boxes;
+    predicted_boxes.reserve(tracks_.size());
+    for (const auto& track : tracks_)
+      predicted_boxes.push_back(Tracking::predict(track.box, track.velocity));
+    std::vector<cv::Rect2f> boxes;
+    std::vector<std::array<cv::Point2f, 5>> landmarks;
+    boxes.reserve(faces.size());
+    landmarks.reserve(faces.size());
+    for (const auto& face : faces)
+    {
+      boxes.push_back(face.box);
+      landmarks.push_back(relativeLandmarks(face));
+    }
+
+    const auto matches = Tracking::associate(predicted_boxes, boxes, MIN_IOU,
+      [this, &landmarks](const size_t t, const size_t d)
+      {
+        float displacement = 0.0f;
+        for (size_t i = 0; i < landmarks[d].size(); ++i)
+          displacement += static_cast<float>(cv::norm(landmarks[d][i] - tracks_[t].landmarks[i]));
+        return displacement / static_cast<float>(landmarks[d].size()) <= MAX_LANDMARK_DISPLACEMENT;
+      });
+
+    std::vector<size_t> result(faces.size());
+    for (size_t d = 0; d < faces.size(); ++d)
+    {
+      if (matches[d] >= 0)
+      {
+        auto& track = tracks_[matches[d]];
+        track.velocity = faces[d].box.tl() - track.box.tl();
+        track.box = faces[d].box;
+        track.landmarks = landmarks[d];
+        track.last_seen_tp = now;
+        result[d] = matches[d];
+      } else
+      {
+        result[d] = tracks_.size();
+        auto& track = tracks_.emplace_back();
+        track.box = faces[d].box;
+        track.landmarks = landmarks[d];
+        track.last_seen_tp = now;
+      }
+    }
+
+    return result;
+  }
+
+  FaceTracker::Recognition FaceTracker::decide(const size_t track, const double quality, const Options& options, const std::chrono::steady_clock::time_point now) const
+  {
+    const auto& t = tracks_[track];
+    if (!t.is_recognized)
+      return Recognition::NEW_TRACK;
+    if (quality > t.best_quality * (1.0 + options.quality_margin))
+      return Recognition::BETTER_QUALITY;
+    if (options.recognize_interval.count() > 0 && now - t.recognized_tp >= options.recognize_interval)
+      return Recognition::RECHECK;
+
+    return Recognition::SKIP;
+  }
+
+  const cv::Mat& FaceTracker::descriptor(const size_t track) const
+  {
+    return tracks_[track].descriptor;
+  }
+
+  int FaceTracker::idDescriptor(const size_t track) const
+  {
+    return tracks_[track].id_descriptor;
+  }
+
+  void FaceTracker::setRecognized(const size_t track, const cv::Mat& descriptor, const int id_descriptor, const double quality,
+    const std::chrono::steady_clock::time_point now)
+  {
+    auto& t = tracks_[track];
+
+    // another identity starts the quality over
+    if (!t.is_recognized || t.id_descriptor != id_descriptor)
+      t.best_quality = 0.0;
+    t.is_recognized = true;
+    t.best_quality = std::max(t.best_quality, quality);
+    t.recognized_tp = now;
+    t.descriptor = descriptor.clone();
+    t.id_descriptor = id_descriptor;
+  }
+}  // namespace Frs
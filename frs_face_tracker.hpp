@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace Frs
+{
+  // Keeps the identities of the faces in front of the camera of a stream between the frames, so that a face is recognized
+  // when it appears, when its quality noticeably improves and periodically, instead of on every frame.
+  // Tracks are matched by the IoU of the boxes moved by their last displacement, and the landmarks relative to the box
+  // must keep their places, so that two people swapping places don't swap the tracks.
+  class FaceTracker
+  {
+  public:
+    enum class Recognition
+    {
+      SKIP,            // the track has been recognized recently, and the face isn't better
+      NEW_TRACK,       // the face hasn't been recognized yet
+      BETTER_QUALITY,  // the face is noticeably sharper than the best recognized one of the track
+      RECHECK          // the recognition interval has passed, the identity should be verified by the descriptor
+    };
+
+    struct Options
+    {
+      float quality_margin{0.2f};  // relative growth of the quality to recognize the face again
+      std::chrono::milliseconds recognize_interval{std::chrono::seconds{5}};  // 0 - no periodic recognition
+      std::chrono::milliseconds ttl{std::chrono::seconds{3}};  // a track not seen for this long is dropped
+    };
+
+    struct Observation
+    {
+      cv::Rect2f box;
+      std::array<cv::Point2f, 5> landmarks;
+    };
+
+    // the minimum IoU of a face with the predicted box of its track
+    static constexpr float MIN_IOU = 0.3f;
+
+    // the maximum mean displacement of the landmarks relative to the box, in face widths
+    static constexpr float MAX_LANDMARK_DISPLACEMENT = 0.25f;
+
+    // matches the faces of the frame with the tracks, creates tracks for the new faces and drops the lost ones;
+    // returns the track index of every face, the indices are valid until the next call
+    std::vector<size_t> observe(const std::vector<Observation>& faces, const Options& options, std::chrono::steady_clock::time_point now);
+
+    [[nodiscard]] Recognition decide(size_t track, double quality, const Options& options, std::chrono::steady_clock::time_point now) const;
+
+    // the normalized descriptor and the identifier (zero if the face is unknown) of the last recognition of the track
+    [[nodiscard]] const cv::Mat& descriptor(size_t track) const;
+    [[nodiscard]] int idDescriptor(size_t track) const;
+
+    void setRecognized(size_t track, const cv::Mat& descriptor, int id_descriptor, double quality, std::chrono::steady_clock::time_point now);
+
+  private:
+    struct Track
+    {
+      cv::Rect2f box;
+      cv::Point2f velocity;
+      std::array<cv::Point2f, 5> landmarks;  // relative to the box, in box widths
+      std::chrono::steady_clock::time_point last_seen_tp;
+      bool is_recognized{false};
+      double best_quality{0.0};
+      std::chrono::steady_clock::time_point recognized_tp;
+      cv::Mat descriptor;
+      int id_descriptor{0};
+    };
+
+    std::vector<Track> tracks_;
+
+    static std::array<cv::Point2f, 5> relativeLandmarks(const Observation& face);
+  };
+}  // namespace Frs
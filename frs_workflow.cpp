@@ -1,22 +1,26 @@
+#include <array>
 #include <filesystem>
 #include <fstream>
+#include <limits>
+#include <mutex>
+#include <tuple>
 
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
-#include <http_client.h>
-#include <opencv2/core/simd_intrinsics.hpp>
 #include <userver/clients/http/component.hpp>
+#include <userver/components/statistics_storage.hpp>
 #include <userver/engine/sleep.hpp>
 #include <userver/formats/serialize/common_containers.hpp>
 #include <userver/fs/write.hpp>
 #include <userver/http/common_headers.hpp>
 #include <userver/http/content_type.hpp>
+#include <userver/utils/statistics/writer.hpp>
 #include <userver/yaml_config/merge_schemas.hpp>
 
 #include "frs_api.hpp"
 #include "frs_workflow.hpp"
-
-namespace tc = triton::client;
+#include "similarity.hpp"
+#include "simd_kernels.hpp"
 
 namespace Frs
 {
@@ -25,48 +29,65 @@ namespace Frs
     if (fd1.cols != fd2.cols || fd1.cols == 0)
       return -1.0;
 
-    constexpr int step = cv::v_float32::nlanes;
-    cv::v_float32 sum0 = cv::vx_setzero_f32();
-    cv::v_float32 sum1 = cv::vx_setzero_f32();
-    cv::v_float32 sum2 = cv::vx_setzero_f32();
-    cv::v_float32 sum3 = cv::vx_setzero_f32();
-    const auto ptr1 = fd1.ptr<float>(0);
-    const auto ptr2 = fd2.ptr<float>(0);
-    for (int i = 0; i < fd1.cols; i += 4 * step)
-    {
-      cv::v_float32 v1 = cv::vx_load(ptr1 + i + 0 * step);
-      cv::v_float32 v2 = cv::vx_load(ptr2 + i + 0 * step);
-      sum0 += v1 * v2;
+    // descriptors are L2-normalized, so the dot product is the cosine
+    return Similarity::similarity(fd1.ptr<float>(0), fd2.ptr<float>(0), Similarity::Metric::DOT, fd1.cols);
+  }
 
-      v1 = cv::vx_load(ptr1 + i + 1 * step);
-      v2 = cv::vx_load(ptr2 + i + 1 * step);
-      sum1 += v1 * v2;
+  // the most similar of the descriptors to the face descriptor, all of them are of its size
+  std::optional<Similarity::Match> mostSimilarRow(const FaceDescriptor& fd, const std::vector<const float*>& rows,
+    const Similarity::Metric metric)
+  {
+    return Similarity::withDim(fd.cols, [&]<size_t Dim>()
+      {
+        return Similarity::best<Dim>(fd.ptr<float>(0), Similarity::GatheredRows{rows}, metric, fd.cols);
+      });
+  }
+
+  // identifier and similarity of the most similar of the cached descriptors with the identifiers (zero and -2.0 if there is none);
+  // descriptors of another size, e.g. left from a previous face recognition model, are skipped
+  template <typename Ids, typename Descriptors>
+  std::pair<int32_t, double> findMostSimilar(const FaceDescriptor& fd, const Ids& ids, const Descriptors& descriptors)
+  {
+    std::vector<int32_t> row_ids;
+    std::vector<const float*> rows;
+    row_ids.reserve(ids.size());
+    rows.reserve(ids.size());
+    for (const auto& id : ids)
+      if (const auto it = descriptors.find(id); it != descriptors.end() && it->second.cols == fd.cols)
+      {
+        row_ids.push_back(id);
+        rows.push_back(it->second.template ptr<float>(0));
+      }
 
-      v1 = cv::vx_load(ptr1 + i + 2 * step);
-      v2 = cv::vx_load(ptr2 + i + 2 * step);
-      sum2 += v1 * v2;
+    if (const auto match = mostSimilarRow(fd, rows, Similarity::Metric::DOT))
+      return {row_ids[match->index], match->similarity};
 
-      v1 = cv::vx_load(ptr1 + i + 3 * step);
-      v2 = cv::vx_load(ptr2 + i + 3 * step);
-      sum3 += v1 * v2;
-    }
-    sum0 += sum1 + sum2 + sum3;
-    return v_reduce_sum(sum0);
+    return {0, -2.0};
   }
 
-  // OpenCV port of 'LAPV' algorithm (Pech2000)
-  double varianceOfLaplacian(const cv::Mat& src)
+  // 'LAPV' algorithm (Pech2000) of the first channel and the luma statistics in one pass over the pixels, without intermediate images
+  FaceQuality faceQuality(const cv::Mat& face)
   {
-    cv::Mat lap;
-    Laplacian(src, lap, CV_64F);
-    constexpr int mrg = 3;  // cut off the border
-    lap = lap(cv::Rect(mrg, mrg, lap.cols - 2 * mrg, lap.rows - 2 * mrg));
-
-    cv::Scalar mu, sigma;
-    meanStdDev(lap, mu, sigma);
+    cv::Mat bgr = face;
+    if (face.type() == CV_8UC1)
+      cv::cvtColor(face, bgr, cv::COLOR_GRAY2BGR);
+    if (bgr.type() != CV_8UC3)
+      return {};
 
-    const double focusMeasure = sigma.val[0] * sigma.val[0];
-    return focusMeasure;
+    constexpr int mrg = 3;  // cut off the border
+    Simd::QualitySums sums;
+    Simd::kernels().qualitySums(bgr.data, bgr.step, bgr.cols, bgr.rows, mrg, sums);
+    if (sums.count == 0)
+      return {};
+
+    const auto count = static_cast<double>(sums.count);
+    const double laplacian_mean = static_cast<double>(sums.laplacian_sum) / count;
+    const double luma_mean = static_cast<double>(sums.luma_sum) / count;
+    return {
+      .laplacian = std::max(0.0, static_cast<double>(sums.laplacian_sq_sum) / count - laplacian_mean * laplacian_mean),
+      .brightness = luma_mean,
+      .contrast = std::sqrt(std::max(0.0, static_cast<double>(sums.luma_sq_sum) / count - luma_mean * luma_mean)),
+      .saturation = static_cast<double>(sums.saturated_count) / count};
   }
 
   double dist(const double x1, const double y1, const double x2, const double y2)
@@ -153,7 +174,7 @@ namespace Frs
   }
 
   // non maximum suppression algorithm
-  inline void nms(std::vector<FaceDetection>& dets, const float nms_thresh = 0.4)
+  void nms(std::vector<FaceDetection>& dets, const float nms_thresh)
   {
     std::ranges::sort(dets, [](const auto& a, const auto& b)
       { return a.face_confidence > b.face_confidence; });
@@ -171,18 +192,86 @@ namespace Frs
     }
   }
 
-  // face detection area alignment
-  cv::Mat alignFaceAffineTransform(const cv::Mat& frame, const cv::Mat& src, const int face_width, const int face_height)
+  // positions of the five landmarks in the aligned face image of the template size
+  constexpr double FACE_TEMPLATE_SIZE = 112.0;
+  constexpr double FACE_TEMPLATE[5][2] = {
+    {38.2946, 51.6963},
+    {73.5318, 51.5014},
+    {56.0252, 71.7366},
+    {41.5493, 92.3655},
+    {70.7299, 92.2041}};
+
+  // face detection area alignment: the least squares similarity of the landmarks to the template (Umeyama, closed form)
+  cv::Mat alignFaceTransform(const cv::Mat& landmarks)
   {
-    const cv::Mat dst = (cv::Mat_<double>(5, 2) << 38.2946 / 112.0 * face_width, 51.6963 / 112.0 * face_height,
-      73.5318 / 112.0 * face_width, 51.5014 / 112.0 * face_height,
-      56.0252 / 112.0 * face_width, 71.7366 / 112.0 * face_height,
-      41.5493 / 112.0 * face_width, 92.3655 / 112.0 * face_height,
-      70.7299 / 112.0 * face_width, 92.2041 / 112.0 * face_height);
-    cv::Mat inliers;
-    const cv::Mat mm = cv::estimateAffinePartial2D(src, dst, inliers, cv::LMEDS);
+    if (landmarks.rows != 5 || landmarks.cols != 2 || landmarks.type() != CV_32F)
+      return {};
+
+    double src_mean[2] = {0.0, 0.0};
+    double dst_mean[2] = {0.0, 0.0};
+    for (int i = 0; i < 5; ++i)
+      for (int c = 0; c < 2; ++c)
+      {
+        src_mean[c] += landmarks.at<float>(i, c) / 5.0;
+        dst_mean[c] += FACE_TEMPLATE[i][c] / 5.0;
+      }
+
+    // in complex numbers, the rotation with the scale is sum(conj(src) * dst) / sum(|src|^2) of the centered points
+    double re = 0.0;
+    double im = 0.0;
+    double src_norm = 0.0;
+    for (int i = 0; i < 5; ++i)
+    {
+      const double sx = landmarks.at<float>(i, 0) - src_mean[0];
+      const double sy = landmarks.at<float>(i, 1) - src_mean[1];
+      const double dx = FACE_TEMPLATE[i][0] - dst_mean[0];
+      const double dy = FACE_TEMPLATE[i][1] - dst_mean[1];
+      re += sx * dx + sy * dy;
+      im += sx * dy - sy * dx;
+      src_norm += sx * sx + sy * sy;
+    }
+    if (src_norm <= std::numeric_limits<double>::epsilon())
+      return {};
+
+    const double a = re / src_norm;
+    const double b = im / src_norm;
+    return (cv::Mat_<double>(2, 3) << a, -b, dst_mean[0] - a * src_mean[0] + b * src_mean[1],
+      b, a, dst_mean[1] - b * src_mean[0] - a * src_mean[1]);
+  }
+
+  // the face of the model input size: the transform is scaled from the template size and applied to the frame area it reads only
+  cv::Mat warpAlignedFace(const cv::Mat& frame, const cv::Mat& transform, const int face_width, const int face_height)
+  {
+    if (transform.empty() || face_width <= 0 || face_height <= 0)
+      return {};
+
+    cv::Mat m = transform.clone();
+    for (int c = 0; c < 3; ++c)
+    {
+      m.at<double>(0, c) *= face_width / FACE_TEMPLATE_SIZE;
+      m.at<double>(1, c) *= face_height / FACE_TEMPLATE_SIZE;
+    }
+
+    cv::Mat inverse;
+    cv::invertAffineTransform(m, inverse);
+    std::vector<cv::Point2f> corners = {{0.0f, 0.0f}, {static_cast<float>(face_width), 0.0f},
+      {0.0f, static_cast<float>(face_height)}, {static_cast<float>(face_width), static_cast<float>(face_height)}};
+    cv::transform(corners, corners, inverse);
+
+    // a margin for the interpolation
+    constexpr int mrg = 2;
+    auto roi = cv::boundingRect(corners);
+    roi = cv::Rect(roi.x - mrg, roi.y - mrg, roi.width + 2 * mrg, roi.height + 2 * mrg) & cv::Rect(0, 0, frame.cols, frame.rows);
+
+    // the face is out of the frame
+    if (roi.empty())
+      return cv::Mat::zeros(face_height, face_width, frame.type());
+
+    // the frame point p is the ROI point p - tl
+    m.at<double>(0, 2) += m.at<double>(0, 0) * roi.x + m.at<double>(0, 1) * roi.y;
+    m.at<double>(1, 2) += m.at<double>(1, 0) * roi.x + m.at<double>(1, 1) * roi.y;
     cv::Mat r;
-    warpAffine(frame, r, mm, cv::Size(face_width, face_height));
+    warpAffine(frame(roi), r, m, cv::Size(face_width, face_height));
     return r;
   }
 
@@ -218,10 +307,34 @@ namespace Frs
       });
   }
 
+  // output tensors of the face detection model (scores, bboxes and keypoints for strides 8, 16 and 32)
+  constexpr std::array DNN_FD_OUTPUT_TENSORS = {"448", "471", "494", "451", "474", "497", "454", "477", "500"};
+
+  bool ResolvedConfig::isActual(const std::shared_ptr<const ConfigContainer>& common_cache,
+    const std::shared_ptr<const VStreamConfigContainer>& vstreams_cache) const
+  {
+    // the owner comparison does not suffer from address reuse: a weak pointer keeps the control block alive
+    return !common_config_revision.owner_before(common_cache) && !common_cache.owner_before(common_config_revision)
+      && !vstreams_config_revision.owner_before(vstreams_cache) && !vstreams_cache.owner_before(vstreams_config_revision);
+  }
+
+  cv::Rect ResolvedConfig::getWorkArea(const int width, const int height) const
+  {
+    if (work_area.empty())
+      return {};
+
+    return {
+      static_cast<int>(work_area.x * static_cast<float>(width) / 100.0f),
+      static_cast<int>(work_area.y * static_cast<float>(height) / 100.0f),
+      static_cast<int>(work_area.width * static_cast<float>(width) / 100.0f),
+      static_cast<int>(work_area.height * static_cast<float>(height) / 100.0f)};
+  }
+
   Workflow::Workflow(const userver::components::ComponentConfig& config, const userver::components::ComponentContext& context)
     : LoggableComponentBase(config, context),
       task_processor_(context.GetTaskProcessor(config["task_processor"].As<std::string>())),
       fs_task_processor_(context.GetTaskProcessor(config["fs-task-processor"].As<std::string>())),
+      rtsp_task_processor_(context.GetTaskProcessor(config["rtsp-task-processor"].As<std::string>())),
       http_client_(context.FindComponent<userver::components::HttpClient>().GetHttpClient()),
       logger_(context.FindComponent<userver::components::Logging>().GetLogger(std::string(kLogger))),
       pg_cluster_(context.FindComponent<userver::components::Postgres>(kDatabase).GetCluster()),
@@ -256,9 +369,38 @@ namespace Frs
     local_config_.copy_events_maintenance_interval = config[ConfigParams::SECTION_NAME][ConfigParams::COPY_EVENTS_MAINTENANCE_INTERVAL].As<decltype(local_config_.copy_events_maintenance_interval)>();
     local_config_.clear_old_events = config[ConfigParams::SECTION_NAME][ConfigParams::CLEAR_OLD_EVENTS].As<decltype(local_config_.clear_old_events)>();
     local_config_.events_ttl = config[ConfigParams::SECTION_NAME][ConfigParams::EVENTS_TTL].As<decltype(local_config_.events_ttl)>();
+    local_config_.dnn_stats_path = config[ConfigParams::SECTION_NAME][ConfigParams::DNN_STATS_PATH].As<decltype(local_config_.dnn_stats_path)>(
+      std::filesystem::current_path().string() + "/dnn_stats_data.json");
+    local_config_.dnn_stats_save_interval = config[ConfigParams::SECTION_NAME][ConfigParams::DNN_STATS_SAVE_INTERVAL].As<decltype(local_config_.dnn_stats_save_interval)>(
+      local_config_.dnn_stats_save_interval);
+    local_config_.onnxruntime_options.intra_op_threads = config[ConfigParams::SECTION_NAME][ConfigParams::ONNXRUNTIME_INTRA_OP_THREADS].As<decltype(local_config_.onnxruntime_options.intra_op_threads)>(
+      local_config_.onnxruntime_options.intra_op_threads);
+    local_config_.onnxruntime_options.session_pool_size = config[ConfigParams::SECTION_NAME][ConfigParams::ONNXRUNTIME_SESSION_POOL_SIZE].As<decltype(local_config_.onnxruntime_options.session_pool_size)>(
+      local_config_.onnxruntime_options.session_pool_size);
+    inference_clients_ = std::make_unique<Inference::ClientFactory>(local_config_.onnxruntime_options);
+    local_config_.rtsp_decoder_pool_size = config[ConfigParams::SECTION_NAME][ConfigParams::RTSP_DECODER_POOL_SIZE].As<decltype(local_config_.rtsp_decoder_pool_size)>(
+      local_config_.rtsp_decoder_pool_size);
+    rtsp_decoders_ = std::make_unique<Ingest::DecoderPool>(local_config_.rtsp_decoder_pool_size);
+    LOG_INFO_TO(logger_, "SIMD kernels: {}", Simd::isaName(Simd::activeIsa()));
 
     loadDNNStatsData();
 
+    // inference and pipeline statistics are available through the monitor listener
+    statistics_holder_ = context.FindComponent<userver::components::StatisticsStorage>().GetStorage().RegisterWriter(
+      "frs", [this](userver::utils::statistics::Writer& writer)
+      {
+        writeStatistics(writer);
+      });
+
+    // periodic saving of inference statistics so that they survive a crash
+    if (local_config_.dnn_stats_save_interval.count() > 0)
+      dnn_stats_save_task_.Start(kDNNStatsSave,
+        {local_config_.dnn_stats_save_interval, {userver::utils::PeriodicTask::Flags::kStrong}},
+        [this]
+        {
+          saveDNNStatsData();
+        });
+
     // Periodic maintenance
     if (local_config_.clear_old_log_faces.count() > 0)
       old_logs_maintenance_task_.Start(kOldLogsMaintenance,
@@ -295,6 +437,8 @@ namespace Frs
 
   Workflow::~Workflow()
   {
+    statistics_holder_.Unregister();
+    dnn_stats_save_task_.Stop();
     saveDNNStatsData();
   }
 
@@ -312,6 +456,9 @@ properties:
     fs-task-processor:
         type: string
         description: task processor to process filesystem bound tasks
+    rtsp-task-processor:
+        type: string
+        description: task processor for reading the RTSP streams, every stream in the RTSP capture mode keeps one of its threads
     config:
         type: object
         description: default configuration parameters
@@ -361,6 +508,26 @@ properties:
                 type: string
                 description: TTL of the copied events
                 defaultDescription: 30d
+            dnn-stats-path:
+                type: string
+                description: Local path of the file for saving inference statistics
+                defaultDescription: dnn_stats_data.json in the current working directory
+            dnn-stats-save-interval:
+                type: string
+                description: Period for saving inference statistics to the file (0 - only on shutdown)
+                defaultDescription: 1m
+            onnxruntime-intra-op-threads:
+                type: integer
+                description: Number of threads used by one inference request of the ONNX Runtime backend
+                defaultDescription: 1
+            onnxruntime-session-pool-size:
+                type: integer
+                description: Number of ONNX Runtime sessions per model, i.e. the limit of concurrent inference requests to the model
+                defaultDescription: 2
+            rtsp-decoder-pool-size:
+                type: integer
+                description: Number of video decoders shared by the streams in the RTSP capture mode, i.e. the limit of frames decoded at once
+                defaultDescription: 4
   )~");
   }
 
@@ -374,6 +541,11 @@ properties:
     return local_config_;
   }
 
+  std::shared_ptr<const PipelineTimings> Workflow::getPipelineTimings(const int32_t id_group) const
+  {
+    return pipeline_timings.find(id_group);
+  }
+
   void Workflow::startWorkflow(std::string&& vstream_key)
   {
     int32_t id_group = -1;
@@ -389,19 +561,17 @@ properties:
     if (id_group <= 0)
       return;
 
+    auto [runtime, is_created] = stream_runtimes.findOrCreate(vstream_key);
     bool do_pipeline = false;
     // scope for accessing concurrent variable
     {
-      auto data_ptr = being_processed_vstreams.Lock();
-      if (!data_ptr->contains(vstream_key))
+      auto state_ptr = runtime->pipeline_state.Lock();
+      if (!state_ptr->is_running)
         do_pipeline = true;
-      (*data_ptr)[vstream_key] = true;
-    }
-
-    if (workflow_timeout.count() > 0)
-    {
-      auto data_ptr = vstream_timeouts.Lock();
-      (*data_ptr)[vstream_key] = std::chrono::steady_clock::now() + workflow_timeout;
+      state_ptr->is_running = true;
+      state_ptr->is_active = true;
+      if (workflow_timeout.count() > 0)
+        state_ptr->timeout = std::chrono::steady_clock::now() + workflow_timeout;
     }
 
     if (do_pipeline)
@@ -410,7 +580,8 @@ properties:
         .id_group = id_group,
         .vstream_key = std::move(vstream_key),
         .task_type = TASK_RECOGNIZE,
-        .frame_url = {}
+        .frame_url = {},
+        .runtime = std::move(runtime)
       };
       tasks_.Detach(AsyncNoSpan(task_processor_, &Workflow::processPipeline, this, std::move(task_data)));
     }
@@ -418,62 +589,107 @@ properties:
 
   void Workflow::stopWorkflow(std::string&& vstream_key, const bool is_internal)
   {
-    // scope for accessing concurrent variable
-    {
-      auto data_ptr = being_processed_vstreams.Lock();
-      if (data_ptr->contains(vstream_key))
-      {
-        if (is_internal)
-          data_ptr->erase(vstream_key);
-        else
-          (*data_ptr)[vstream_key] = false;
-      }
-    }
+    const auto runtime = stream_runtimes.find(vstream_key);
+    if (runtime == nullptr)
+      return;
 
-    // scope for accessing concurrent variable
+    auto state_ptr = runtime->pipeline_state.Lock();
+    if (is_internal)
+      state_ptr->is_running = false;
+    state_ptr->is_active = false;
+    state_ptr->timeout.reset();
+  }
+
+  ResolvedConfigPtr Workflow::resolveConfig(const TaskData& task_data)
+  {
+    auto common_cache = common_config_cache_.Get();
+    auto vstreams_cache = vstreams_config_cache_.Get();
+    if (!task_data.vstream_key.empty() && !vstreams_cache->getData().contains(task_data.vstream_key))
+      return nullptr;
+
+    // one-off tasks without a video stream workflow are not cached
+    if (task_data.runtime == nullptr)
+      return buildResolvedConfig(task_data, std::move(common_cache), std::move(vstreams_cache));
+
+    auto& resolved_config = task_data.runtime->resolved_config;
+    if (resolved_config == nullptr || !resolved_config->isActual(common_cache, vstreams_cache))
+      resolved_config = buildResolvedConfig(task_data, std::move(common_cache), std::move(vstreams_cache));
+
+    return resolved_config;
+  }
+
+  ResolvedConfigPtr Workflow::buildResolvedConfig(const TaskData& task_data, std::shared_ptr<const ConfigContainer> common_cache,
+    std::shared_ptr<const VStreamConfigContainer> vstreams_cache) const
+  {
+    auto resolved_config = std::make_shared<ResolvedConfig>();
+    auto& common_config = resolved_config->common_config;
+    auto& config = resolved_config->config;
+    if (common_cache->getCommonConfig().contains(task_data.id_group))
+      common_config = common_cache->getCommonConfig().at(task_data.id_group);
+    if (common_cache->getDefaultVStreamConfig().contains(task_data.id_group))
+      config = common_cache->getDefaultVStreamConfig().at(task_data.id_group);
+    if (!task_data.vstream_key.empty() && vstreams_cache->getData().contains(task_data.vstream_key))
+      config = vstreams_cache->getData().at(task_data.vstream_key);
+    resolved_config->common_config_revision = common_cache;
+    resolved_config->vstreams_config_revision = vstreams_cache;
+
+    constexpr int64_t channels = 3;
+    resolved_config->dnn_fd_input_shape = {1, channels, common_config.dnn_fd_input_height, common_config.dnn_fd_input_width};
+    resolved_config->dnn_fc_input_shape = {1, channels, common_config.dnn_fc_input_height, common_config.dnn_fc_input_width};
+    resolved_config->dnn_fr_input_shape = {1, channels, common_config.dnn_fr_input_height, common_config.dnn_fr_input_width};
+
+    if (config.work_area.size() == 4)
+      resolved_config->work_area = {config.work_area[0], config.work_area[1], config.work_area[2], config.work_area[3]};
+
+    resolved_config->dnn_fd_outputs.assign(DNN_FD_OUTPUT_TENSORS.begin(), DNN_FD_OUTPUT_TENSORS.end());
+    resolved_config->dnn_fc_outputs = {common_config.dnn_fc_output_tensor_name};
+    resolved_config->dnn_fr_outputs = {common_config.dnn_fr_output_tensor_name};
+
+    // clients are shared between all video streams with the same inference backend and server
+    auto get_client = [&](const std::string& backend, const std::string& server) -> std::shared_ptr<Inference::Client>
     {
-      auto data_ptr = vstream_timeouts.Lock();
-      if (data_ptr->contains(vstream_key))
-        data_ptr->erase(vstream_key);
-    }
+      std::string error;
+      auto client = inference_clients_->getClient(backend, server, error);
+      if (client == nullptr && (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST))
+        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
+          "Error! {}",
+          error);
+      return client;
+    };
+    resolved_config->dnn_fd_client = get_client(config.dnn_fd_inference_backend, config.dnn_fd_inference_server);
+    resolved_config->dnn_fc_client = get_client(config.dnn_fc_inference_backend, config.dnn_fc_inference_server);
+    resolved_config->dnn_fr_client = get_client(config.dnn_fr_inference_backend, config.dnn_fr_inference_server);
+
+    return resolved_config;
   }
 
   DescriptorRegistrationResult Workflow::processPipeline(TaskData&& task_data)
   {
     std::string url;
-    CommonConfig common_config{};
-    VStreamConfig config{};
     DescriptorRegistrationResult result;
 
-    // scope for accessing cache
+    const auto resolved_config = resolveConfig(task_data);
+    if (!resolved_config)
     {
-      auto cache = common_config_cache_.Get();
-      if (cache->getCommonConfig().contains(task_data.id_group))
-        common_config = cache->getCommonConfig().at(task_data.id_group);
-      if (cache->getDefaultVStreamConfig().contains(task_data.id_group))
-        config = cache->getDefaultVStreamConfig().at(task_data.id_group);
+      auto comments = absl::Substitute("Invalid video stream key: $0", task_data.vstream_key);
+      stopWorkflow(std::move(task_data.vstream_key));
+      return {
+        .comments = std::move(comments),
+        .face_image = {},
+        .id_descriptors = {}
+      };
     }
 
-    // scope for accessing cache
-    {
-      auto cache = vstreams_config_cache_.Get();
-      if (!task_data.vstream_key.empty() && !cache->getData().contains(task_data.vstream_key))
-      {
-        stopWorkflow(std::move(task_data.vstream_key));
-        return {
-          .comments = absl::Substitute("Invalid video stream key: $0", task_data.vstream_key),
-          .face_image = {},
-          .id_descriptors = {}
-        };
-      }
+    if (task_data.timings == nullptr)
+      task_data.timings = pipeline_timings.findOrCreate(task_data.id_group).first;
+    auto& timings = *task_data.timings;
 
-      if (!task_data.vstream_key.empty() && cache->getData().contains(task_data.vstream_key))
-        config = cache->getData().at(task_data.vstream_key);
-      if (task_data.task_type == TASK_RECOGNIZE)
-        url = config.url;
-      else
-        url = task_data.frame_url;
-    }
+    const auto& common_config = resolved_config->common_config;
+    const auto& config = resolved_config->config;
+    if (task_data.task_type == TASK_RECOGNIZE)
+      url = config.url;
+    else
+      url = task_data.frame_url;
 
     auto delay_between_frames = config.delay_between_frames;
 
@@ -488,6 +704,7 @@ properties:
     try
     {
       std::string image_data;
+      cv::Mat frame;  // decoded right away in the RTSP capture mode
       if (url.starts_with("data:"))
       {
         if (auto pos_comma = url.find(','); pos_comma != std::string::npos)
@@ -511,22 +728,49 @@ properties:
           USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
             "vstream_key = {};  before image acquisition",
             task_data.vstream_key);
-        auto capture_response = http_client_.CreateRequest()
-          .get(url)
-          .retry(config.max_capture_error_count)
-          .timeout(config.capture_timeout)
-          .perform();
+        std::string capture_error;
+        const auto stream_idle_timeout = std::max(std::chrono::milliseconds{std::chrono::minutes{1}}, 3 * (delay_between_frames + config.delay_after_error));
+        auto capture_timer = timings.measure(STAGE_CAPTURE);
+        if (task_data.task_type == TASK_RECOGNIZE && config.capture_mode == Ingest::CAPTURE_MODE_MJPEG)
+        {
+          // the latest frame of the stream kept open between the frames
+          const Ingest::MjpegReader::Options mjpeg_options{
+            .url = url,
+            .read_timeout = config.capture_timeout,
+            .idle_timeout = stream_idle_timeout};
+          Ingest::takeMjpegFrame(task_data.runtime->mjpeg_reader, http_client_, task_processor_, mjpeg_options, image_data, capture_error);
+        } else if (task_data.task_type == TASK_RECOGNIZE && config.capture_mode == Ingest::CAPTURE_MODE_RTSP)
+        {
+          const Ingest::RtspReader::Options rtsp_options{
+            .url = url,
+            .read_timeout = config.capture_timeout,
+            .idle_timeout = stream_idle_timeout,
+            .frame_interval = delay_between_frames};
+          Ingest::takeRtspFrame(task_data.runtime->rtsp_reader, *rtsp_decoders_, rtsp_task_processor_, fs_task_processor_, rtsp_options, frame, capture_error);
+        } else
+        {
+          auto capture_response = http_client_.CreateRequest()
+            .get(url)
+            .retry(config.max_capture_error_count)
+            .timeout(config.capture_timeout)
+            .perform();
+          if (capture_response->status_code() != userver::clients::http::Status::OK || capture_response->body_view().empty())
+            capture_error = absl::Substitute("status_code = $0", static_cast<int>(capture_response->status_code()));
+          else
+            image_data = capture_response->body();
+        }
+        capture_timer.stop();
         if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
           USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
             "vstream_key = {};  after image acquisition",
             task_data.vstream_key);
 
-        if (capture_response->status_code() != userver::clients::http::Status::OK || capture_response->body_view().empty())
+        if (image_data.empty() && frame.empty())
         {
           if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
             USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-              "vstream_key = {};  url = {};  status_code = {}",
-              task_data.vstream_key, url, capture_response->status_code());
+              "vstream_key = {};  url = {};  {}",
+              task_data.vstream_key, url, capture_error);
           if (config.delay_after_error.count() > 0)
           {
             if (task_data.task_type == TASK_RECOGNIZE)
@@ -547,7 +791,21 @@ properties:
           };
         }
 
-        image_data = capture_response->body();
+        // a camera polled faster than its snapshot rate returns the same image again
+        if (task_data.task_type == TASK_RECOGNIZE && !image_data.empty())
+        {
+          const bool is_duplicate = task_data.runtime->duplicate_detector.isDuplicate(image_data);
+          duplicate_frame_stats.findOrCreate(config.id_vstream).first->add(is_duplicate);
+          if (is_duplicate)
+          {
+            if (config.logs_level <= userver::logging::Level::kDebug)
+              USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kDebug,
+                "vstream_key = {};  the image is the same as the previous one",
+                task_data.vstream_key);
+            nextPipeline(std::move(task_data), delay_between_frames);
+            return result;
+          }
+        }
       }
 
       if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
@@ -559,20 +817,16 @@ properties:
           "vstream_key = {};  before decoding the image",
           task_data.vstream_key);
       }
-      cv::Mat frame = imdecode(std::vector<char>(image_data.begin(), image_data.end()), cv::IMREAD_COLOR);
+      auto decode_timer = timings.measure(STAGE_DECODE);
+      if (frame.empty())
+        frame = imdecode(std::vector<char>(image_data.begin(), image_data.end()), cv::IMREAD_COLOR);
+      decode_timer.stop();
       if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
           "vstream_key = {};  after decoding the image",
           task_data.vstream_key);
 
-      cv::Rect work_area{};
-      if (config.work_area.size() == 4)
-      {
-        work_area.x = static_cast<int>(config.work_area[0] * frame.cols / 100.0f);
-        work_area.y = static_cast<int>(config.work_area[1] * frame.rows / 100.0f);
-        work_area.width = static_cast<int>(config.work_area[2] * frame.cols / 100.0f);
-        work_area.height = static_cast<int>(config.work_area[3] * frame.rows / 100.0f);
-      }
+      const cv::Rect work_area = resolved_config->getWorkArea(frame.cols, frame.rows);
 
       if (task_data.task_type == TASK_REGISTER_DESCRIPTOR)
       {
@@ -583,8 +837,20 @@ properties:
           task_data.face_height = frame.rows;
       }
 
+      // a static scene in the work area is skipped before the inference
+      bool is_scene_changed = true;
+      if (task_data.task_type == TASK_RECOGNIZE && config.motion_threshold > 0.0f)
+      {
+        is_scene_changed = task_data.runtime->scene_filter.isChanged(frame, work_area, {}, config.motion_threshold);
+        scene_filter_stats.findOrCreate(config.id_vstream).first->add(!is_scene_changed);
+        if (!is_scene_changed && config.logs_level <= userver::logging::Level::kDebug)
+          USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kDebug,
+            "vstream_key = {};  the scene hasn't changed, difference = {}",
+            task_data.vstream_key, task_data.runtime->scene_filter.lastDifference());
+      }
+
       // looking for faces
-      if (std::vector<FaceDetection> detected_faces; detectFaces(task_data, frame, config, detected_faces))
+      if (std::vector<FaceDetection> detected_faces; is_scene_changed && detectFaces(task_data, frame, *resolved_config, detected_faces))
       {
         DNNStatsData stats_data;
         ++stats_data.fd_count;
@@ -597,23 +863,46 @@ properties:
         int best_register_index = -1;
         bool has_sgroup_events = false;
 
+        // the faces of a stream are tracked between the frames to recognize them only when necessary
+        const bool is_tracking = task_data.task_type == TASK_RECOGNIZE && config.flag_face_tracking;
+        const FaceTracker::Options track_options{
+          .quality_margin = config.face_track_quality_margin,
+          .recognize_interval = config.face_track_recognize_interval,
+          .ttl = std::max(std::chrono::milliseconds{std::chrono::seconds{3}}, 3 * delay_between_frames)};
+        const auto track_tp = std::chrono::steady_clock::now();
+        std::vector<size_t> face_tracks;
+        if (is_tracking)
+        {
+          std::vector<FaceTracker::Observation> observations;
+          observations.reserve(detected_faces.size());
+          for (const auto& [bbox, face_confidence, landmark] : detected_faces)
+          {
+            auto& observation = observations.emplace_back();
+            observation.box = cv::Rect2f(cv::Point2f{bbox[0], bbox[1]}, cv::Point2f{bbox[2], bbox[3]});
+            for (size_t i = 0; i < observation.landmarks.size(); ++i)
+              observation.landmarks[i] = {landmark[2 * i], landmark[2 * i + 1]};
+          }
+          face_tracks = task_data.runtime->face_tracker.observe(observations, track_options, track_tp);
+        }
+
         if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
           USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
             "vstream_key = {};  process the found faces, quantity: {}",
             task_data.vstream_key, detected_faces.size());
+        // the region of the frame, where a face must be completely, is the same for all faces of the frame
+        auto work_region = cv::Rect(
+          static_cast<int>(config.margin / 100.0 * frame.cols),
+          static_cast<int>(config.margin / 100.0 * frame.rows),
+          static_cast<int>(frame.cols - 2.0 * frame.cols * config.margin / 100.0),
+          static_cast<int>(frame.rows - 2.0 * frame.rows * config.margin / 100.0));
+        if (!work_area.empty())
+          work_region = work_region & work_area;
         for (auto& [bbox, face_confidence, landmark] : detected_faces)
         {
           if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
             USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
               "vstream_key = {};  face probability: {:.3f}",
               task_data.vstream_key, face_confidence);
-          auto work_region = cv::Rect(
-            static_cast<int>(config.margin / 100.0 * frame.cols),
-            static_cast<int>(config.margin / 100.0 * frame.rows),
-            static_cast<int>(frame.cols - 2.0 * frame.cols * config.margin / 100.0),
-            static_cast<int>(frame.rows - 2.0 * frame.rows * config.margin / 100.0));
-          if (!work_area.empty())
-            work_region = work_region & work_area;
           auto face_rect = cv::Rect(
             static_cast<int>(bbox[0]),
             static_cast<int>(bbox[1]),
@@ -652,8 +941,11 @@ properties:
             continue;
           }
 
-          // face "alignment" for face recognition inference
-          cv::Mat aligned_face = alignFaceAffineTransform(frame, landmarks5, common_config.dnn_fr_input_width, common_config.dnn_fr_input_height);
+          // face "alignment" for face recognition inference, the transform is shared by the inputs of all models
+          auto alignment_timer = timings.measure(STAGE_FACE_ALIGNMENT);
+          const cv::Mat alignment = alignFaceTransform(landmarks5);
+          cv::Mat aligned_face = warpAlignedFace(frame, alignment, common_config.dnn_fr_input_width, common_config.dnn_fr_input_height);
+          alignment_timer.stop();
           if (aligned_face.cols != common_config.dnn_fr_input_width || aligned_face.rows != common_config.dnn_fr_input_height)
           {
             if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
@@ -672,13 +964,14 @@ properties:
 
           face_data.back().is_frontal = true;
 
-          // check for blur
-          auto laplacian = varianceOfLaplacian(aligned_face);
+          // check for blur and exposure
+          const auto quality = faceQuality(aligned_face);
+          const auto laplacian = quality.laplacian;
           face_data.back().laplacian = laplacian;
           if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
             USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
-              "vstream_key = {};  laplacian = {:.2f}",
-              task_data.vstream_key, laplacian);
+              "vstream_key = {};  laplacian = {:.2f};  brightness = {:.2f};  contrast = {:.2f};  saturation = {:.3f}",
+              task_data.vstream_key, laplacian, quality.brightness, quality.contrast, quality.saturation);
           if (laplacian < config.blur || laplacian > config.blur_max)
           {
             if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
@@ -688,14 +981,41 @@ properties:
 
             continue;
           }
+          if (quality.brightness < config.brightness_min || quality.brightness > config.brightness_max || quality.contrast < config.contrast_min
+              || quality.saturation > config.saturation_max)
+          {
+            if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
+              USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
+                "vstream_key = {};  the face is too dark, over-exposed or of low contrast",
+                task_data.vstream_key);
+
+            continue;
+          }
           face_data.back().is_non_blurry = true;
           if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
             USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
               "vstream_key = {};  the face is not blurry",
               task_data.vstream_key);
 
+          // a tracked face is recognized again only if it's noticeably sharper or the recognition interval has passed
+          auto track_recognition = FaceTracker::Recognition::NEW_TRACK;
+          if (is_tracking)
+          {
+            track_recognition = task_data.runtime->face_tracker.decide(face_tracks[face_data.size() - 1], laplacian, track_options, track_tp);
+            if (track_recognition == FaceTracker::Recognition::SKIP)
+            {
+              if (config.logs_level <= userver::logging::Level::kTrace)
+                USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
+                  "vstream_key = {};  the tracked face has already been recognized",
+                  task_data.vstream_key);
+              continue;
+            }
+          }
+
           // face "alignment" for face class inference
-          auto aligned_face_class = alignFaceAffineTransform(frame, landmarks5, common_config.dnn_fc_input_width, common_config.dnn_fc_input_height);
+          auto alignment_class_timer = timings.measure(STAGE_FACE_ALIGNMENT_FC);
+          auto aligned_face_class = warpAlignedFace(frame, alignment, common_config.dnn_fc_input_width, common_config.dnn_fc_input_height);
+          alignment_class_timer.stop();
           if (aligned_face_class.cols != common_config.dnn_fc_input_width || aligned_face_class.rows != common_config.dnn_fc_input_height)
           {
             if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
@@ -713,7 +1033,7 @@ properties:
               }).Get();
 
           // checking the class of the face (normal, wearing a mask, wearing sunglasses)
-          if (std::vector<FaceClass> face_classes; inferFaceClass(task_data, aligned_face_class, config, face_classes))
+          if (std::vector<FaceClass> face_classes; inferFaceClass(task_data, aligned_face_class, *resolved_config, face_classes))
           {
             ++stats_data.fc_count;
             face_data.back().face_class_index = static_cast<FaceClassIndexes>(face_classes[0].class_index);
@@ -739,7 +1059,7 @@ properties:
           }
 
           // get a facial descriptor (biometric template)
-          if (bool infer_face_descriptor_result = extractFaceDescriptor(task_data, aligned_face, config, face_data.back().fd); !infer_face_descriptor_result)
+          if (bool infer_face_descriptor_result = extractFaceDescriptor(task_data, aligned_face, *resolved_config, face_data.back().fd); !infer_face_descriptor_result)
             continue;
           ++stats_data.fr_count;
           auto face_descriptor = face_data.back().fd.clone();
@@ -748,6 +1068,23 @@ properties:
             norm_l2 = 1.0;
           face_descriptor = face_descriptor / norm_l2;
 
+          // the identity of a tracked face is verified by the descriptor of its last recognition instead of the search
+          if (track_recognition == FaceTracker::Recognition::RECHECK)
+          {
+            auto& face_tracker = task_data.runtime->face_tracker;
+            const auto track = face_tracks[face_data.size() - 1];
+            if (const int id_track_descriptor = face_tracker.idDescriptor(track);
+                id_track_descriptor > 0 && cosineDistance(face_descriptor, face_tracker.descriptor(track)) >= config.tolerance)
+            {
+              face_tracker.setRecognized(track, face_descriptor, id_track_descriptor, laplacian, track_tp);
+              if (config.logs_level <= userver::logging::Level::kTrace)
+                USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
+                  "vstream_key = {};  the identity of the tracked face is confirmed: id_descriptor = {}",
+                  task_data.vstream_key, id_track_descriptor);
+              continue;
+            }
+          }
+
           // recognize the face
           if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
             USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
@@ -758,21 +1095,14 @@ properties:
 
           // scope for accessing cache
           {
+            auto matching_timer = timings.measure(STAGE_MATCHING);
             auto vd_cache = vstream_descriptors_cache_.Get();
             auto fd_cache = face_descriptor_cache_.Get();
             auto sgc_cache = sg_config_cache_.Get();
             auto sgd_cache = sg_descriptors_cache_.Get();
 
             if (config.id_vstream > 0 && vd_cache->getData().contains(config.id_vstream))
-              for (const auto& item : vd_cache->getData().at(config.id_vstream))
-                if (fd_cache->getData().contains(item))
-                {
-                  if (double cos_distance = cosineDistance(face_descriptor, fd_cache->getData().at(item)); cos_distance > max_cos_distance)
-                  {
-                    max_cos_distance = cos_distance;
-                    id_descriptor = item;
-                  }
-                }
+              std::tie(id_descriptor, max_cos_distance) = findMostSimilar(face_descriptor, vd_cache->getData().at(config.id_vstream), fd_cache->getData());
             if (fd_cache->getSpawned().contains(id_descriptor))
             {
               auto id_parent = fd_cache->getSpawned().at(id_descriptor);
@@ -787,32 +1117,19 @@ properties:
             if (task_data.id_sgroup > 0)
             {
               if (sgd_cache->getData().contains(task_data.id_sgroup))
-                for (const auto& id_sg_descriptor : sgd_cache->getData().at(task_data.id_sgroup))
-                  if (fd_cache->getData().contains(id_sg_descriptor))
-                  {
-                    if (double cos_distance = cosineDistance(face_descriptor, fd_cache->getData().at(id_sg_descriptor)); cos_distance > max_cos_distance)
-                    {
-                      max_cos_distance = cos_distance;
-                      id_descriptor = id_sg_descriptor;
-                    }
-                  }
+                if (const auto [id_sg_descriptor, cos_distance] = findMostSimilar(face_descriptor, sgd_cache->getData().at(task_data.id_sgroup), fd_cache->getData());
+                    cos_distance > max_cos_distance)
+                {
+                  max_cos_distance = cos_distance;
+                  id_descriptor = id_sg_descriptor;
+                }
             } else
             {
               if (sgc_cache->getMappedSG().contains(config.id_group))
                 for (const auto& id_sgroup : sgc_cache->getMappedSG().at(config.id_group))
                   if (sgd_cache->getData().contains(id_sgroup))
                   {
-                    double sg_max_cos_distance = -2.0;
-                    int id_sg_best_descriptor{};
-                    for (const auto& id_sg_descriptor : sgd_cache->getData().at(id_sgroup))
-                      if (fd_cache->getData().contains(id_sg_descriptor))
-                      {
-                        if (double cos_distance = cosineDistance(face_descriptor, fd_cache->getData().at(id_sg_descriptor)); cos_distance > sg_max_cos_distance)
-                        {
-                          sg_max_cos_distance = cos_distance;
-                          id_sg_best_descriptor = id_sg_descriptor;
-                        }
-                      }
+                    const auto [id_sg_best_descriptor, sg_max_cos_distance] = findMostSimilar(face_descriptor, sgd_cache->getData().at(id_sgroup), fd_cache->getData());
                     if (id_sg_best_descriptor > 0 && sg_max_cos_distance >= config.tolerance)
                     {
                       face_data.back().sg_descriptors[id_sgroup] = {sg_max_cos_distance, id_sg_best_descriptor};
@@ -834,6 +1151,10 @@ properties:
               "vstream_key = {};  most similar data: cosine_distance = {:.3f};  id_descriptor = {}",
               task_data.vstream_key, max_cos_distance, id_descriptor);
 
+          if (is_tracking)
+            task_data.runtime->face_tracker.setRecognized(face_tracks[face_data.size() - 1], face_descriptor,
+              id_descriptor == 0 || max_cos_distance < config.tolerance ? 0 : id_descriptor, laplacian, track_tp);
+
           if (id_descriptor == 0 || max_cos_distance < config.tolerance)
           {
             // face isn't recognized
@@ -850,15 +1171,13 @@ properties:
                   "vstream_key = {};  add an unknown descriptor",
                   task_data.vstream_key);
 
-              auto ud_ptr = unknown_descriptors.Lock();
-              removeExpiredUnknownDescriptors((*ud_ptr)[config.id_vstream]);
+              auto& unknown_descriptors = task_data.runtime->unknown_descriptors;
+              removeExpiredUnknownDescriptors(unknown_descriptors);
 
               // add an unknown descriptor
-              if (!ud_ptr->contains(config.id_vstream))
-                (*ud_ptr)[config.id_vstream] = {};
               cv::Rect r = enlargeFaceRect(face_data.back().face_rect, config.face_enlarge_scale);
               r = r & cv::Rect(0, 0, frame.cols, frame.rows);
-              (*ud_ptr)[config.id_vstream].emplace_back(std::chrono::steady_clock::now() + config.unknown_descriptor_ttl,
+              unknown_descriptors.emplace_back(std::chrono::steady_clock::now() + config.unknown_descriptor_ttl,
                 face_data.back().fd.clone(), frame(r).clone());
             }
           } else
@@ -881,45 +1200,46 @@ properties:
               FaceDescriptor fd_spawned;
               cv::Mat face_image_spawned;
 
-              // scope for accessing concurrent variable
+              // scope for accessing unknown descriptors
               {
-                auto ud_ptr = unknown_descriptors.Lock();
-                removeExpiredUnknownDescriptors((*ud_ptr)[config.id_vstream]);
+                auto& unknown_descriptors = task_data.runtime->unknown_descriptors;
+                removeExpiredUnknownDescriptors(unknown_descriptors);
 
-                // find and create a spawned descriptor among the unknowns if necessary
+                // find and create a spawned descriptor among the unknowns if necessary;
+                // the unknown descriptors aren't normalized, so the norms are taken into account by the metric
                 double max_cd = -2.0;
-                auto k = (*ud_ptr)[config.id_vstream].size();
-                for (size_t i = 0; i < (*ud_ptr)[config.id_vstream].size(); ++i)
-                {
-                  auto fd = (*ud_ptr)[config.id_vstream][i].fd.clone();
-                  double n_l2 = cv::norm(fd, cv::NORM_L2);
-                  if (n_l2 <= 0.0)
-                    n_l2 = 1.0;
-                  fd = fd / n_l2;
-                  if (double cos_distance = cosineDistance(face_descriptor, fd); cos_distance > max_cd)
+                auto k = unknown_descriptors.size();
+                std::vector<size_t> row_indices;
+                std::vector<const float*> rows;
+                for (size_t i = 0; i < unknown_descriptors.size(); ++i)
+                  if (unknown_descriptors[i].fd.cols == face_descriptor.cols)
                   {
-                    max_cd = cos_distance;
-                    k = i;
+                    row_indices.push_back(i);
+                    rows.push_back(unknown_descriptors[i].fd.ptr<float>(0));
                   }
+                if (const auto match = mostSimilarRow(face_descriptor, rows, Similarity::Metric::COSINE))
+                {
+                  max_cd = match->similarity;
+                  k = row_indices[match->index];
                 }
 
-                if (k < (*ud_ptr)[config.id_vstream].size() && max_cd > config.tolerance)
+                if (k < unknown_descriptors.size() && max_cd > config.tolerance)
                 {
                   if (config.logs_level <= userver::logging::Level::kTrace)
                     USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
                       "vstream_key = {};  unknown descriptors cosine distance = {:.3f};  index = {};  size = {}",
-                      task_data.vstream_key, max_cd, k, (*ud_ptr)[config.id_vstream].size());
-                  fd_spawned = std::move((*ud_ptr)[config.id_vstream][k].fd);
-                  face_image_spawned = std::move((*ud_ptr)[config.id_vstream][k].face_image);
+                      task_data.vstream_key, max_cd, k, unknown_descriptors.size());
+                  fd_spawned = std::move(unknown_descriptors[k].fd);
+                  face_image_spawned = std::move(unknown_descriptors[k].face_image);
                 }
 
                 // clear the unknown descriptors anyway
-                (*ud_ptr)[config.id_vstream].clear();
+                unknown_descriptors.clear();
               }
 
               if (!fd_spawned.empty())
               {
-                auto id_spawned = addFaceDescriptor(config.id_group, config.id_vstream, fd_spawned, face_image_spawned, id_descriptor);
+                auto id_spawned = addFaceDescriptor(*resolved_config, fd_spawned, face_image_spawned, id_descriptor);
                 if (config.logs_level <= userver::logging::Level::kTrace)
                   USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
                     "vstream_key = {};  created spawned descriptor with id = {};  id_parent = {}",
@@ -944,11 +1264,14 @@ properties:
         }  // end of the detected faces loop
 
         // to collect inference statistics
+        dnn_stats_data.findOrCreate(config.id_vstream).first->add(stats_data);
+
+        // a frame decoded from the RTSP stream is encoded for the screenshots before the OSD is drawn on it
+        if (image_data.empty() && task_data.task_type == TASK_RECOGNIZE && (best_face_index >= 0 || has_sgroup_events))
         {
-          auto dnn_stats_ptr = dnn_stats_data.Lock();
-          (*dnn_stats_ptr)[config.id_vstream].fd_count += stats_data.fd_count;
-          (*dnn_stats_ptr)[config.id_vstream].fc_count += stats_data.fc_count;
-          (*dnn_stats_ptr)[config.id_vstream].fr_count += stats_data.fr_count;
+          std::vector<uchar> buffer;
+          imencode(".jpg", frame, buffer);
+          image_data.assign(buffer.begin(), buffer.end());
         }
 
         std::string frame_with_osd;
@@ -994,17 +1317,21 @@ properties:
           auto screenshot_extension = ".jpg";
 
           auto log_date = userver::storages::postgres::TimePointTz{std::chrono::system_clock::now()};
+          auto db_timer = timings.measure(STAGE_DB_INSERT);
           auto id_log = addLogFace(config.id_vstream, log_date, face_data[best_face_index].id_descriptor,
             face_data[best_face_index].laplacian, face_data[best_face_index].face_rect,
             absl::StrCat(local_config_.screenshots_url_prefix, path_suffix, s_uuid, screenshot_extension), log_uuid);
+          db_timer.stop();
 
           // write a screenshot to a file
+          auto file_timer = timings.measure(STAGE_FILE_WRITE);
           auto path_prefix = absl::StrCat(local_config_.screenshots_path, path_suffix);
           userver::fs::CreateDirectories(fs_task_processor_, path_prefix);
           auto path = absl::StrCat(path_prefix, s_uuid, screenshot_extension);
           userver::fs::RewriteFileContents(fs_task_processor_, path, frame_with_osd.empty() ? image_data : frame_with_osd);
           userver::fs::Chmod(fs_task_processor_, path,
             boost::filesystem::perms::owner_read | boost::filesystem::perms::owner_write | boost::filesystem::perms::others_read | boost::filesystem::perms::others_write);
+          file_timer.stop();
 
           if (id_log > 0 && face_data[best_face_index].id_descriptor > 0 && !config.callback_url.empty())
           {
@@ -1015,6 +1342,7 @@ properties:
             DeliveryEventResult delivery_result = ERROR;
             try
             {
+              auto callback_timer = timings.measure(STAGE_CALLBACK);
               auto delivery_response = http_client_.CreateRequest()
                .post(config.callback_url)
                .headers({{userver::http::headers::kContentType, userver::http::content_type::kApplicationJson.ToString()}})
@@ -1041,6 +1369,7 @@ properties:
           }
 
           // write event's data to files
+          auto data_timer = timings.measure(STAGE_FILE_WRITE_DATA);
           AsyncNoSpan(fs_task_processor_,
             [&]
             {
@@ -1088,6 +1417,7 @@ properties:
               std::ofstream f_json(absl::StrCat(path_prefix, s_uuid, JSON_SUFFIX));
               f_json << ToString(json_data.ExtractValue());
             }).Get();
+          data_timer.stop();
         }
 
         // send events about face recognition from special groups
@@ -1102,15 +1432,19 @@ properties:
               auto screenshot_url = absl::StrCat(local_config_.screenshots_url_prefix, path_suffix, s_uuid, screenshot_extension);
 
               auto log_date = userver::storages::postgres::TimePointTz{std::chrono::system_clock::now()};
+              auto db_timer = timings.measure(STAGE_DB_INSERT);
               auto id_log = addLogFace(config.id_vstream, log_date, snd.id_descriptor, laplacian, face_rect, screenshot_url, log_uuid, DISABLED);
+              db_timer.stop();
 
               // write a screenshot to a file
+              auto file_timer = timings.measure(STAGE_FILE_WRITE);
               auto path_prefix = absl::StrCat(local_config_.screenshots_path, path_suffix);
               userver::fs::CreateDirectories(fs_task_processor_, path_prefix);
               auto path = absl::StrCat(path_prefix, s_uuid, screenshot_extension);
               userver::fs::RewriteFileContents(fs_task_processor_, path, frame_with_osd.empty() ? image_data : frame_with_osd);
               userver::fs::Chmod(fs_task_processor_, path,
                 boost::filesystem::perms::owner_read | boost::filesystem::perms::owner_write | boost::filesystem::perms::others_read | boost::filesystem::perms::others_write);
+              file_timer.stop();
 
               std::string sg_group_callback_url;
               // scope for accessing cache
@@ -1129,6 +1463,7 @@ properties:
                 DeliveryEventResult delivery_result = ERROR;
                 try
                 {
+                  auto callback_timer = timings.measure(STAGE_CALLBACK);
                   auto delivery_response = http_client_.CreateRequest()
                    .post(sg_group_callback_url)
                    .headers({{userver::http::headers::kContentType, userver::http::content_type::kApplicationJson.ToString()}})
@@ -1169,7 +1504,7 @@ properties:
               if (task_data.id_sgroup > 0)
                 result.id_descriptor = addSGroupFaceDescriptor(task_data.id_sgroup, face_data[best_register_index].fd, frame(r));
               else
-                result.id_descriptor = addFaceDescriptor(config.id_group, config.id_vstream, face_data[best_register_index].fd, frame(r));
+                result.id_descriptor = addFaceDescriptor(*resolved_config, face_data[best_register_index].fd, frame(r));
             }
 
             if (result.id_descriptor > 0)
@@ -1282,7 +1617,7 @@ properties:
 
   void Workflow::loadDNNStatsData()
   {
-    auto f_name = std::filesystem::current_path().string() + "/dnn_stats_data.json";
+    const auto& f_name = local_config_.dnn_stats_path;
     if (!std::filesystem::exists(f_name))
       return;
 
@@ -1290,13 +1625,12 @@ properties:
     {
       std::fstream f(f_name);
       auto json_data = userver::formats::json::FromStream(f);
-      auto dnn_stats_ptr = dnn_stats_data.Lock();
-      dnn_stats_ptr->clear();
+      dnn_stats_data.clear();
       for (const auto& item : json_data["data"])
-        (*dnn_stats_ptr)[item["id_vstream"].As<int32_t>()] = DNNStatsData{
-          item["fd_count"].As<int32_t>(),
-          item["fc_count"].As<int32_t>(),
-          item["fr_count"].As<int32_t>()};
+        dnn_stats_data.findOrCreate(item["id_vstream"].As<int32_t>()).first->add(DNNStatsData{
+          item["fd_count"].As<int64_t>(),
+          item["fc_count"].As<int64_t>(),
+          item["fr_count"].As<int64_t>()});
     } catch (const std::exception& e)
     {
       LOG_ERROR_TO(logger_) << e.what();
@@ -1307,11 +1641,10 @@ properties:
   {
     userver::formats::json::ValueBuilder list_data;
     DNNStatsData all_data;
-    // scope to access concurrent variable
-    {
-      auto dnn_stats_ptr = dnn_stats_data.Lock();
-      for (const auto& [fst, snd] : *dnn_stats_ptr)
+    dnn_stats_data.forEach(
+      [&](const int32_t fst, const DNNStatsCounters& counters)
       {
+        const auto snd = counters.load();
         all_data.fd_count += snd.fd_count;
         all_data.fc_count += snd.fc_count;
         all_data.fr_count += snd.fr_count;
@@ -1321,8 +1654,7 @@ properties:
         v["fc_count"] = snd.fc_count;
         v["fr_count"] = snd.fr_count;
         list_data.PushBack(std::move(v));
-      }
-    }
+      });
     userver::formats::json::ValueBuilder json_data;
     json_data["all"]["fd_count"] = all_data.fd_count;
     json_data["all"]["fc_count"] = all_data.fc_count;
@@ -1330,14 +1662,66 @@ properties:
     json_data["data"] = std::move(list_data);
     try
     {
-      std::ofstream f(std::filesystem::current_path().string() + "/dnn_stats_data.json");
-      f << ToString(json_data.ExtractValue());
+      // write to a temporary file and rename it, so the previous data is never lost
+      std::lock_guard lock(dnn_stats_save_mutex_);
+      userver::fs::RewriteFileContentsAtomically(fs_task_processor_, local_config_.dnn_stats_path, ToString(json_data.ExtractValue()),
+        boost::filesystem::perms::owner_read | boost::filesystem::perms::owner_write | boost::filesystem::perms::group_read | boost::filesystem::perms::others_read);
     } catch (const std::exception& e)
     {
       LOG_ERROR_TO(logger_) << e.what();
     }
   }
 
+  void Workflow::writeStatistics(userver::utils::statistics::Writer& writer) const
+  {
+    auto dnn_writer = writer["dnn"];
+    dnn_stats_data.forEach(
+      [&dnn_writer](const int32_t id_vstream, const DNNStatsCounters& counters)
+      {
+        const auto data = counters.load();
+        const auto label = std::to_string(id_vstream);
+        dnn_writer["fd_count"].ValueWithLabels(userver::utils::statistics::Rate{static_cast<uint64_t>(data.fd_count)}, userver::utils::statistics::LabelView{"id_vstream", label});
+        dnn_writer["fc_count"].ValueWithLabels(userver::utils::statistics::Rate{static_cast<uint64_t>(data.fc_count)}, userver::utils::statistics::LabelView{"id_vstream", label});
+        dnn_writer["fr_count"].ValueWithLabels(userver::utils::statistics::Rate{static_cast<uint64_t>(data.fr_count)}, userver::utils::statistics::LabelView{"id_vstream", label});
+      });
+
+    auto capture_writer = writer["capture"];
+    duplicate_frame_stats.forEach(
+      [&capture_writer](const int32_t id_vstream, const Ingest::DuplicateCounters& counters)
+      {
+        const auto captured_frames = counters.captured_frames.load(std::memory_order_relaxed);
+        const auto duplicate_frames = counters.duplicate_frames.load(std::memory_order_relaxed);
+        const auto label = std::to_string(id_vstream);
+        capture_writer["captured_frames"].ValueWithLabels(userver::utils::statistics::Rate{static_cast<uint64_t>(captured_frames)}, userver::utils::statistics::LabelView{"id_vstream", label});
+        capture_writer["duplicate_frames"].ValueWithLabels(userver::utils::statistics::Rate{static_cast<uint64_t>(duplicate_frames)}, userver::utils::statistics::LabelView{"id_vstream", label});
+        capture_writer["duplicate_ratio"].ValueWithLabels(captured_frames > 0 ? static_cast<double>(duplicate_frames) / static_cast<double>(captured_frames) : 0.0,
+          userver::utils::statistics::LabelView{"id_vstream", label});
+      });
+
+    auto scene_filter_writer = writer["scene_filter"];
+    scene_filter_stats.forEach(
+      [&scene_filter_writer](const int32_t id_vstream, const SceneFilter::Counters& counters)
+      {
+        const auto checked_frames = counters.checked_frames.load(std::memory_order_relaxed);
+        const auto skipped_frames = counters.skipped_frames.load(std::memory_order_relaxed);
+        const auto label = std::to_string(id_vstream);
+        scene_filter_writer["checked_frames"].ValueWithLabels(userver::utils::statistics::Rate{static_cast<uint64_t>(checked_frames)}, userver::utils::statistics::LabelView{"id_vstream", label});
+        scene_filter_writer["skipped_frames"].ValueWithLabels(userver::utils::statistics::Rate{static_cast<uint64_t>(skipped_frames)}, userver::utils::statistics::LabelView{"id_vstream", label});
+        scene_filter_writer["skip_ratio"].ValueWithLabels(checked_frames > 0 ? static_cast<double>(skipped_frames) / static_cast<double>(checked_frames) : 0.0,
+          userver::utils::statistics::LabelView{"id_vstream", label});
+      });
+
+    writer["simd"]["isa"].ValueWithLabels(1, {"isa", Simd::isaName(Simd::activeIsa())});
+
+    auto stage_writer = writer["pipeline"]["stage_latency"];
+    pipeline_timings.forEach(
+      [&stage_writer](const int32_t id_group, const PipelineTimings& timings)
+      {
+        const auto label = std::to_string(id_group);
+        timings.write(stage_writer, PIPELINE_STAGE_NAMES, {"id_group", label});
+      });
+  }
+
   void Workflow::doOldLogMaintenance() const
   {
     LOG_INFO_TO(logger_, "Removing obsolete entries from the log_faces table");
@@ -1369,10 +1753,18 @@ properties:
         }
   }
 
-  void Workflow::doFlagDeletedMaintenance() const
+  void Workflow::doFlagDeletedMaintenance()
   {
     LOG_DEBUG_TO(logger_, "Deleting marked records from the database");
 
+    // release the runtime state of removed video streams with stopped workflows
+    if (const auto cache = vstreams_config_cache_.Get())
+      stream_runtimes.eraseIf(
+        [&cache](const std::string& vstream_key, const StreamRuntime& runtime)
+        {
+          return !cache->getData().contains(vstream_key) && !runtime.pipeline_state.Lock()->is_running;
+        });
+
     auto tp = std::chrono::system_clock::now() - local_config_.flag_deleted_ttl;
     auto trx = pg_cluster_->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
     try
@@ -1496,26 +1888,16 @@ properties:
 
     // scope for accessing concurrent variable
     {
-      const auto now = std::chrono::steady_clock::now();
-      auto data_ptr = vstream_timeouts.Lock();
-      if (data_ptr->contains(task_data.vstream_key))
-        if (data_ptr->at(task_data.vstream_key) < now)
-        {
-          data_ptr->erase(task_data.vstream_key);
-          is_timeout = true;
-        }
-    }
-
-    // scope for accessing concurrent variable
-    {
-      auto data_ptr = being_processed_vstreams.Lock();
-      if (data_ptr->contains(task_data.vstream_key))
+      auto state_ptr = task_data.runtime->pipeline_state.Lock();
+      if (state_ptr->timeout && state_ptr->timeout < std::chrono::steady_clock::now())
       {
-        if (data_ptr->at(task_data.vstream_key) && !is_timeout)
-          do_next = true;
-        else
-          data_ptr->erase(task_data.vstream_key);
+        state_ptr->timeout.reset();
+        is_timeout = true;
       }
+      if (state_ptr->is_running && state_ptr->is_active && !is_timeout)
+        do_next = true;
+      else
+        state_ptr->is_running = false;
     }
 
     if (is_timeout)
@@ -1550,32 +1932,18 @@ properties:
     return out;
   }
 
-  bool Workflow::detectFaces(const TaskData& task_data, const cv::Mat& frame, const VStreamConfig& config, std::vector<FaceDetection>& detected_faces)
+  bool Workflow::detectFaces(const TaskData& task_data, const cv::Mat& frame, const ResolvedConfig& resolved_config, std::vector<FaceDetection>& detected_faces)
   {
-    decltype(CommonConfig::dnn_fd_model_name) dnn_fd_model_name = "scrfd";
-    decltype(CommonConfig::dnn_fd_input_width) dnn_fd_input_width = 320;
-    decltype(CommonConfig::dnn_fd_input_height) dnn_fd_input_height = 320;
-    decltype(CommonConfig::dnn_fd_input_tensor_name) dnn_fd_input_tensor_name = "input.1";
+    const auto& config = resolved_config.config;
+    const auto& dnn_fd_model_name = resolved_config.common_config.dnn_fd_model_name;
+    const auto dnn_fd_input_width = resolved_config.common_config.dnn_fd_input_width;
+    const auto dnn_fd_input_height = resolved_config.common_config.dnn_fd_input_height;
+    const auto& dnn_fd_input_tensor_name = resolved_config.common_config.dnn_fd_input_tensor_name;
 
-    // scope for accessing cache
-    {
-      if (auto cache = common_config_cache_.Get(); cache->getCommonConfig().contains(config.id_group))
-      {
-        dnn_fd_model_name = cache->getCommonConfig().at(config.id_group).dnn_fd_model_name;
-        dnn_fd_input_width = cache->getCommonConfig().at(config.id_group).dnn_fd_input_width;
-        dnn_fd_input_height = cache->getCommonConfig().at(config.id_group).dnn_fd_input_height;
-        dnn_fd_input_tensor_name = cache->getCommonConfig().at(config.id_group).dnn_fd_input_tensor_name;
-      }
-    }
-
-    std::unique_ptr<tc::InferenceServerHttpClient> triton_client;
-    auto err = tc::InferenceServerHttpClient::Create(&triton_client, config.dnn_fd_inference_server, false);
-    if (!err.IsOk())
+    if (resolved_config.dnn_fd_client == nullptr)
     {
       if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
-        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-          "Error! Unable to create inference client: {}",
-          err.Message());
+        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError, "Error! Unable to create inference client");
       return false;
     }
 
@@ -1585,98 +1953,49 @@ properties:
       USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
         "vstream_key = {};  before image preprocessing for face detection",
         task_data.vstream_key);
+    auto preprocess_timer = task_data.timings->measure(STAGE_FD_PREPROCESS);
     cv::Mat pr_img = preprocessImage(frame, dnn_fd_input_width, dnn_fd_input_height, scale);
     int channels = 3;
     int input_size = channels * dnn_fd_input_width * dnn_fd_input_height;
     std::vector<float> input_buffer(input_size);
-    for (int c = 0; c < channels; ++c)
-      for (int h = 0; h < dnn_fd_input_height; ++h)
-        for (int w = 0; w < dnn_fd_input_width; ++w)
-          input_buffer[c * dnn_fd_input_height * dnn_fd_input_width + h * dnn_fd_input_width + w] = (static_cast<float>(pr_img.at<cv::Vec3b>(h, w)[2 - c]) - 127.5f) / 128.0f;
+
+    // (x - 127.5) / 128
+    constexpr float fd_alpha[] = {1.0f / 128.0f, 1.0f / 128.0f, 1.0f / 128.0f};
+    constexpr float fd_beta[] = {-127.5f / 128.0f, -127.5f / 128.0f, -127.5f / 128.0f};
+    Simd::kernels().bgrToPlanarRgb(pr_img.data, pr_img.step, dnn_fd_input_width, dnn_fd_input_height, fd_alpha, fd_beta, input_buffer.data());
+    preprocess_timer.stop();
     if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
       USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
         "vstream_key = {};  after image preprocessing for face detection",
         task_data.vstream_key);
 
-    std::vector<uint8_t> input_data(input_size * sizeof(float));
-    memcpy(input_data.data(), input_buffer.data(), input_data.size());
-    std::vector<int64_t> shape = {1, channels, dnn_fd_input_height, dnn_fd_input_width};
-    tc::InferInput* input;
-    err = tc::InferInput::Create(&input, dnn_fd_input_tensor_name, shape, "FP32");
-    if (!err.IsOk())
-    {
-      if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
-        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-          "Error! Unable to create input data: {}", err.Message());
-      return false;
-    }
-    std::shared_ptr<tc::InferInput> input_ptr(input);
-    std::vector inputs = {input_ptr.get()};
-    err = input_ptr->AppendRaw(input_data);
-    if (!err.IsOk())
-    {
-      if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
-        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-          "Error! Unable to append input data: {}",
-          err.Message());
-      return false;
-    }
-
-    std::vector output_tensors = {"448", "471", "494", "451", "474", "497", "454", "477", "500"};
-    std::vector<const tc::InferRequestedOutput*> outputs;
-    outputs.reserve(output_tensors.size());
-    std::vector<std::shared_ptr<tc::InferRequestedOutput>> outputs_ptr;
-    outputs_ptr.reserve(output_tensors.size());
-    for (size_t i = 0; i < output_tensors.size(); ++i)
-    {
-      tc::InferRequestedOutput* p;
-      err = tc::InferRequestedOutput::Create(&p, output_tensors[i]);
-      if (!err.IsOk())
-      {
-        if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
-          USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-            "Error! Unable to create output data: {}",
-            err.Message());
-        return false;
-      }
-      outputs_ptr.emplace_back(p);
-      outputs.emplace_back(outputs_ptr[i].get());
-    }
-
-    tc::InferOptions options(dnn_fd_model_name);
-    options.model_version_ = "";
-    tc::InferResult* result;
+    const std::vector<Inference::InputTensor> inputs = {
+      {.name = dnn_fd_input_tensor_name, .shape = resolved_config.dnn_fd_input_shape, .data = input_buffer.data()}};
+    std::unique_ptr<Inference::Result> result_ptr;
+    std::string error;
 
     if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
       USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
         "vstream_key = {};  before inference face detection",
         task_data.vstream_key);
+    auto inference_timer = task_data.timings->measure(STAGE_FD_INFERENCE);
     userver::engine::AsyncNoSpan(fs_task_processor_,
       [&]
       {
-        err = triton_client->Infer(&result, options, inputs, outputs);
+        result_ptr = resolved_config.dnn_fd_client->infer(dnn_fd_model_name, inputs, resolved_config.dnn_fd_outputs, error);
       }).Get();
+    inference_timer.stop();
     if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
       USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
         "vstream_key = {};  after inference face detection",
         task_data.vstream_key);
 
-    if (!err.IsOk())
+    if (result_ptr == nullptr)
     {
       if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-          "Error! Unable to send inference request: {}",
-          err.Message());
-      return false;
-    }
-
-    std::shared_ptr<tc::InferResult> result_ptr(result);
-    if (!result_ptr->RequestStatus().IsOk())
-    {
-      if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
-        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-          "Error! Unable to receive inference result: {}",
-          err.Message());
+          "Error! {}",
+          error);
       return false;
     }
 
@@ -1685,6 +2004,7 @@ properties:
         "vstream_key = {};  inference face detection OK",
         task_data.vstream_key);
 
+    auto postprocess_timer = task_data.timings->measure(STAGE_FD_POSTPROCESS);
     std::vector feat_stride = {8, 16, 32};
 
     detected_faces.clear();
@@ -1693,17 +2013,17 @@ properties:
       constexpr int fmc = 3;
       const float* scores_data;
       size_t scores_size;
-      result_ptr->RawData(output_tensors[i], reinterpret_cast<const uint8_t**>(&scores_data), &scores_size);
+      result_ptr->rawData(DNN_FD_OUTPUT_TENSORS[i], reinterpret_cast<const uint8_t**>(&scores_data), &scores_size);
 
       const float* bbox_preds_data;
       size_t bbox_preds_size;
-      result_ptr->RawData(output_tensors[i + fmc], reinterpret_cast<const uint8_t**>(&bbox_preds_data), &bbox_preds_size);
+      result_ptr->rawData(DNN_FD_OUTPUT_TENSORS[i + fmc], reinterpret_cast<const uint8_t**>(&bbox_preds_data), &bbox_preds_size);
       auto bbox_preds = cv::Mat(static_cast<int>(bbox_preds_size / 4 / sizeof(float)), 4, CV_32F, const_cast<float*>(bbox_preds_data));
       bbox_preds *= feat_stride[i];
 
       const float* kps_preds_data;
       size_t kps_preds_size;
-      result_ptr->RawData(output_tensors[i + fmc * 2], reinterpret_cast<const uint8_t**>(&kps_preds_data), &kps_preds_size);
+      result_ptr->rawData(DNN_FD_OUTPUT_TENSORS[i + fmc * 2], reinterpret_cast<const uint8_t**>(&kps_preds_data), &kps_preds_size);
       auto kps_preds = cv::Mat(static_cast<int>(kps_preds_size / 10 / sizeof(float)), 10, CV_32F, const_cast<float*>(kps_preds_data));
       kps_preds *= feat_stride[i];
 
@@ -1751,36 +2071,20 @@ properties:
     return true;
   }
 
-  bool Workflow::inferFaceClass(const TaskData& task_data, const cv::Mat& aligned_face, const VStreamConfig& config, std::vector<FaceClass>& face_classes)
+  bool Workflow::inferFaceClass(const TaskData& task_data, const cv::Mat& aligned_face, const ResolvedConfig& resolved_config, std::vector<FaceClass>& face_classes)
   {
-    decltype(CommonConfig::dnn_fc_model_name) dnn_fc_model_name = "genet";
-    decltype(CommonConfig::dnn_fc_input_width) dnn_fc_input_width = 192;
-    decltype(CommonConfig::dnn_fc_input_height) dnn_fc_input_height = 192;
-    decltype(CommonConfig::dnn_fc_input_tensor_name) dnn_fc_input_tensor_name = "input.1";
-    decltype(CommonConfig::dnn_fc_output_tensor_name) dnn_fc_output_tensor_name = "419";
-    decltype(CommonConfig::dnn_fc_output_size) dnn_fc_output_size = 3;
-
-    // scope for accessing cache
-    {
-      if (auto cache = common_config_cache_.Get(); cache->getCommonConfig().contains(config.id_group))
-      {
-        dnn_fc_model_name = cache->getCommonConfig().at(config.id_group).dnn_fc_model_name;
-        dnn_fc_input_width = cache->getCommonConfig().at(config.id_group).dnn_fc_input_width;
-        dnn_fc_input_height = cache->getCommonConfig().at(config.id_group).dnn_fc_input_height;
-        dnn_fc_input_tensor_name = cache->getCommonConfig().at(config.id_group).dnn_fc_input_tensor_name;
-        dnn_fc_output_tensor_name = cache->getCommonConfig().at(config.id_group).dnn_fc_output_tensor_name;
-        dnn_fc_output_size = cache->getCommonConfig().at(config.id_group).dnn_fc_output_size;
-      }
-    }
-
-    std::unique_ptr<tc::InferenceServerHttpClient> triton_client;
-    auto err = tc::InferenceServerHttpClient::Create(&triton_client, config.dnn_fc_inference_server, false);
-    if (!err.IsOk())
+    const auto& config = resolved_config.config;
+    const auto& dnn_fc_model_name = resolved_config.common_config.dnn_fc_model_name;
+    const auto dnn_fc_input_width = resolved_config.common_config.dnn_fc_input_width;
+    const auto dnn_fc_input_height = resolved_config.common_config.dnn_fc_input_height;
+    const auto& dnn_fc_input_tensor_name = resolved_config.common_config.dnn_fc_input_tensor_name;
+    const auto& dnn_fc_output_tensor_name = resolved_config.common_config.dnn_fc_output_tensor_name;
+    const auto dnn_fc_output_size = resolved_config.common_config.dnn_fc_output_size;
+
+    if (resolved_config.dnn_fc_client == nullptr)
     {
       if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
-        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-          "Error! Unable to create inference client: {}",
-          err.Message());
+        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError, "Error! Unable to create inference client");
       return false;
     }
 
@@ -1788,100 +2092,40 @@ properties:
     int input_size = channels * dnn_fc_input_width * dnn_fc_input_height;
     std::vector<float> input_buffer(input_size);
 
-    for (int c = 0; c < channels; ++c)
-      for (int h = 0; h < dnn_fc_input_height; ++h)
-        for (int w = 0; w < dnn_fc_input_width; ++w)
-        {
-          float mean = 0.0f;
-          float std_d = 1.0f;
-          if (c == 0)
-          {
-            mean = 0.485;
-            std_d = 0.229;
-          }
-          if (c == 1)
-          {
-            mean = 0.456;
-            std_d = 0.224;
-          }
-          if (c == 2)
-          {
-            mean = 0.406;
-            std_d = 0.225;
-          }
-          input_buffer[c * dnn_fc_input_height * dnn_fc_input_width + h * dnn_fc_input_width + w] =
-            (static_cast<float>(aligned_face.at<cv::Vec3b>(h, w)[2 - c]) / 255.0f - mean) / std_d;
-        }
-    std::vector<uint8_t> input_data(input_size * sizeof(float));
-    memcpy(input_data.data(), input_buffer.data(), input_data.size());
-    std::vector<int64_t> shape = {1, channels, dnn_fc_input_height, dnn_fc_input_width};
-    tc::InferInput* input;
-    err = tc::InferInput::Create(&input, dnn_fc_input_tensor_name, shape, "FP32");
-    if (!err.IsOk())
-    {
-      if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
-        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-          "Error! Unable to create input data: {}",
-          err.Message());
-      return false;
-    }
-    std::shared_ptr<tc::InferInput> input_ptr(input);
-    err = input_ptr->AppendRaw(input_data);
-    if (!err.IsOk())
-    {
-      if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
-        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-          "Error! Unable to append input data: {}",
-          err.Message());
-      return false;
-    }
-    std::vector inputs = {input_ptr.get()};
-
-    tc::InferRequestedOutput* output;
-    err = tc::InferRequestedOutput::Create(&output, dnn_fc_output_tensor_name);
-    if (!err.IsOk())
-    {
-      if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
-        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-          "Error! Unable to create output data: {}",
-          err.Message());
-      return false;
-    }
-    std::shared_ptr<tc::InferRequestedOutput> output_ptr(output);
-    std::vector<const tc::InferRequestedOutput*> outputs = {output_ptr.get()};
-
-    tc::InferOptions options(dnn_fc_model_name);
-    options.model_version_ = "";
-    tc::InferResult* result;
+    // (x / 255 - mean) / std with ImageNet mean and std of RGB channels
+    constexpr float means[] = {0.485f, 0.456f, 0.406f};
+    constexpr float std_ds[] = {0.229f, 0.224f, 0.225f};
+    constexpr float fc_alpha[] = {1.0f / (255.0f * std_ds[0]), 1.0f / (255.0f * std_ds[1]), 1.0f / (255.0f * std_ds[2])};
+    constexpr float fc_beta[] = {-means[0] / std_ds[0], -means[1] / std_ds[1], -means[2] / std_ds[2]};
+    Simd::kernels().bgrToPlanarRgb(aligned_face.data, aligned_face.step, dnn_fc_input_width, dnn_fc_input_height, fc_alpha, fc_beta,
+      input_buffer.data());
+    const std::vector<Inference::InputTensor> inputs = {
+      {.name = dnn_fc_input_tensor_name, .shape = resolved_config.dnn_fc_input_shape, .data = input_buffer.data()}};
+    std::unique_ptr<Inference::Result> result_ptr;
+    std::string error;
 
     if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
       USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
         "vstream_key = {};  before inference face class",
         task_data.vstream_key);
+    auto inference_timer = task_data.timings->measure(STAGE_FC_INFERENCE);
     userver::engine::AsyncNoSpan(fs_task_processor_,
       [&]
       {
-        err = triton_client->Infer(&result, options, inputs, outputs);
+        result_ptr = resolved_config.dnn_fc_client->infer(dnn_fc_model_name, inputs, resolved_config.dnn_fc_outputs, error);
       }).Get();
+    inference_timer.stop();
     if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
       USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
         "vstream_key = {};  after inference face class",
         task_data.vstream_key);
 
-    if (!err.IsOk())
+    if (result_ptr == nullptr)
     {
       if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-          "Error! Unable to send inference request: {}",
-          err.Message());
-      return false;
-    }
-
-    std::shared_ptr<tc::InferResult> result_ptr(result);
-    if (!result_ptr->RequestStatus().IsOk())
-    {
-      if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
-        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError, "Error! Unable to receive inference result");
+          "Error! {}",
+          error);
       return false;
     }
 
@@ -1892,13 +2136,12 @@ properties:
 
     const float* result_data;
     size_t output_size;
-    err = result_ptr->RawData(dnn_fc_output_tensor_name, reinterpret_cast<const uint8_t**>(&result_data), &output_size);
-    if (!err.IsOk())
+    if (!result_ptr->rawData(dnn_fc_output_tensor_name, reinterpret_cast<const uint8_t**>(&result_data), &output_size))
     {
       if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
           "Error! Failed to get output: {}",
-          err.Message());
+          dnn_fc_output_tensor_name);
       return false;
     }
 
@@ -1909,121 +2152,62 @@ properties:
     return true;
   }
 
-  bool Workflow::extractFaceDescriptor(const TaskData& task_data, const cv::Mat& aligned_face, const VStreamConfig& config, FaceDescriptor& face_descriptor)
+  bool Workflow::extractFaceDescriptor(const TaskData& task_data, const cv::Mat& aligned_face, const ResolvedConfig& resolved_config, FaceDescriptor& face_descriptor)
   {
-    decltype(CommonConfig::dnn_fr_model_name) dnn_fr_model_name = "arcface";
-    decltype(CommonConfig::dnn_fr_input_width) dnn_fr_input_width = 112;
-    decltype(CommonConfig::dnn_fr_input_height) dnn_fr_input_height = 112;
-    decltype(CommonConfig::dnn_fr_input_tensor_name) dnn_fr_input_tensor_name = "input.1";
-    decltype(CommonConfig::dnn_fr_output_tensor_name) dnn_fr_output_tensor_name = "683";
-    decltype(CommonConfig::dnn_fr_output_size) dnn_fr_output_size = 512;
-
-    // scope for accessing cache
-    {
-      if (auto cache = common_config_cache_.Get(); cache->getCommonConfig().contains(config.id_group))
-      {
-        dnn_fr_model_name = cache->getCommonConfig().at(config.id_group).dnn_fr_model_name;
-        dnn_fr_input_width = cache->getCommonConfig().at(config.id_group).dnn_fr_input_width;
-        dnn_fr_input_height = cache->getCommonConfig().at(config.id_group).dnn_fr_input_height;
-        dnn_fr_input_tensor_name = cache->getCommonConfig().at(config.id_group).dnn_fr_input_tensor_name;
-        dnn_fr_output_tensor_name = cache->getCommonConfig().at(config.id_group).dnn_fr_output_tensor_name;
-        dnn_fr_output_size = cache->getCommonConfig().at(config.id_group).dnn_fr_output_size;
-      }
-    }
-
-    std::unique_ptr<tc::InferenceServerHttpClient> triton_client;
-    auto err = tc::InferenceServerHttpClient::Create(&triton_client, config.dnn_fr_inference_server, false);
-    if (!err.IsOk())
+    const auto& config = resolved_config.config;
+    const auto& dnn_fr_model_name = resolved_config.common_config.dnn_fr_model_name;
+    const auto dnn_fr_input_width = resolved_config.common_config.dnn_fr_input_width;
+    const auto dnn_fr_input_height = resolved_config.common_config.dnn_fr_input_height;
+    const auto& dnn_fr_input_tensor_name = resolved_config.common_config.dnn_fr_input_tensor_name;
+    const auto& dnn_fr_output_tensor_name = resolved_config.common_config.dnn_fr_output_tensor_name;
+    const auto dnn_fr_output_size = resolved_config.common_config.dnn_fr_output_size;
+
+    if (resolved_config.dnn_fr_client == nullptr)
     {
       if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
-        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-          "Error! Unable to create inference client: {}",
-          err.Message());
+        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError, "Error! Unable to create inference client");
       return false;
     }
 
     int channels = 3;
     int input_size = channels * dnn_fr_input_width * dnn_fr_input_height;
     std::vector<float> input_buffer(input_size);
-    for (int c = 0; c < channels; ++c)
-      for (int h = 0; h < dnn_fr_input_height; ++h)
-        for (int w = 0; w < dnn_fr_input_width; ++w)
-          if (dnn_fr_model_name == "arcface")
-            input_buffer[c * dnn_fr_input_height * dnn_fr_input_width + h * dnn_fr_input_width + w] = static_cast<float>(aligned_face.at<cv::Vec3b>(h, w)[2 - c]) / 127.5f - 1.0f;
-          else
-            input_buffer[c * dnn_fr_input_height * dnn_fr_input_width + h * dnn_fr_input_width + w] = (static_cast<float>(aligned_face.at<cv::Vec3b>(h, w)[2 - c]) - 127.5f) / 128.0f;
-    std::vector<uint8_t> input_data(input_size * sizeof(float));
-    memcpy(input_data.data(), input_buffer.data(), input_data.size());
-    std::vector<int64_t> shape = {1, channels, dnn_fr_input_height, dnn_fr_input_width};
-    tc::InferInput* input;
-    err = tc::InferInput::Create(&input, dnn_fr_input_tensor_name, shape, "FP32");
-    if (!err.IsOk())
-    {
-      if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
-        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-          "Error! Unable to create input data: {}",
-          err.Message());
-      return false;
-    }
-    std::shared_ptr<tc::InferInput> input_ptr(input);
-    err = input_ptr->AppendRaw(input_data);
-    if (!err.IsOk())
-    {
-      if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
-        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-          "Error! Unable to append input data: {}",
-          err.Message());
-      return false;
-    }
-    std::vector inputs = {input_ptr.get()};
-
-    tc::InferRequestedOutput* output;
-    err = tc::InferRequestedOutput::Create(&output, dnn_fr_output_tensor_name);
-    if (!err.IsOk())
-    {
-      if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
-        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-          "Error! Unable to create output data: {}",
-          err.Message());
-      return false;
-    }
-    std::shared_ptr<tc::InferRequestedOutput> output_ptr(output);
-    std::vector<const tc::InferRequestedOutput*> outputs = {output_ptr.get()};
 
-    tc::InferOptions options(dnn_fr_model_name);
-    options.model_version_ = "";
-    tc::InferResult* result;
+    // x / 127.5 - 1 for arcface, (x - 127.5) / 128 for other models
+    const bool is_arcface = dnn_fr_model_name == "arcface";
+    const float fr_scale = is_arcface ? 1.0f / 127.5f : 1.0f / 128.0f;
+    const float fr_shift = is_arcface ? -1.0f : -127.5f / 128.0f;
+    const float fr_alpha[] = {fr_scale, fr_scale, fr_scale};
+    const float fr_beta[] = {fr_shift, fr_shift, fr_shift};
+    Simd::kernels().bgrToPlanarRgb(aligned_face.data, aligned_face.step, dnn_fr_input_width, dnn_fr_input_height, fr_alpha, fr_beta,
+      input_buffer.data());
+    const std::vector<Inference::InputTensor> inputs = {
+      {.name = dnn_fr_input_tensor_name, .shape = resolved_config.dnn_fr_input_shape, .data = input_buffer.data()}};
+    std::unique_ptr<Inference::Result> result_ptr;
+    std::string error;
 
     if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
       USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
         "vstream_key = {};  before inference for extracting descriptor",
         task_data.vstream_key);
+    auto inference_timer = task_data.timings->measure(STAGE_FR_INFERENCE);
     userver::engine::AsyncNoSpan(fs_task_processor_,
       [&]
       {
-        err = triton_client->Infer(&result, options, inputs, outputs);
+        result_ptr = resolved_config.dnn_fr_client->infer(dnn_fr_model_name, inputs, resolved_config.dnn_fr_outputs, error);
       }).Get();
+    inference_timer.stop();
     if (config.logs_level <= userver::logging::Level::kTrace || task_data.task_type == TASK_TEST)
       USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
         "vstream_key = {};  after inference for extracting descriptor",
         task_data.vstream_key);
 
-    if (!err.IsOk())
+    if (result_ptr == nullptr)
     {
       if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-          "Error! Unable to send inference request: {}",
-          err.Message());
-      return false;
-    }
-
-    std::shared_ptr<tc::InferResult> result_ptr(result);
-    if (!result_ptr->RequestStatus().IsOk())
-    {
-      if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
-        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-          "Error! Unable to receive inference result: {}",
-          err.Message());
+          "Error! {}",
+          error);
       return false;
     }
 
@@ -2034,13 +2218,12 @@ properties:
 
     const float* result_data;
     size_t output_size;
-    err = result_ptr->RawData(dnn_fr_output_tensor_name, reinterpret_cast<const uint8_t**>(&result_data), &output_size);
-    if (!err.IsOk())
+    if (!result_ptr->rawData(dnn_fr_output_tensor_name, reinterpret_cast<const uint8_t**>(&result_data), &output_size))
     {
       if (config.logs_level <= userver::logging::Level::kError || task_data.task_type == TASK_TEST)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
           "Error! Failed to get output: {}",
-          err.Message());
+          dnn_fr_output_tensor_name);
       return false;
     }
 
@@ -2073,15 +2256,12 @@ properties:
     return result;
   }
 
-  int32_t Workflow::addFaceDescriptor(const int32_t id_group, const int32_t id_vstream, const FaceDescriptor& fd, const cv::Mat& f_img,
+  int32_t Workflow::addFaceDescriptor(const ResolvedConfig& resolved_config, const FaceDescriptor& fd, const cv::Mat& f_img,
     const int32_t id_parent)
   {
-    decltype(CommonConfig::dnn_fr_output_size) dnn_fr_output_size = 512;
-    // scope for accessing cache
-    {
-      if (const auto cache = common_config_cache_.Get(); cache->getCommonConfig().contains(id_group))
-        dnn_fr_output_size = cache->getCommonConfig().at(id_group).dnn_fr_output_size;
-    }
+    const auto id_group = resolved_config.config.id_group;
+    const auto id_vstream = resolved_config.config.id_vstream;
+    const auto dnn_fr_output_size = resolved_config.common_config.dnn_fr_output_size;
 
     int32_t id_descriptor = -1;
     auto trx = pg_cluster_->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
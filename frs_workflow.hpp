@@ -1,13 +1,25 @@
 #pragma once
 
+#include <atomic>
+#include <optional>
+
 #include <absl/strings/str_replace.h>
 #include <userver/clients/http/client.hpp>
 #include <userver/components/loggable_component_base.hpp>
 #include <userver/concurrent/background_task_storage.hpp>
 #include <userver/logging/component.hpp>
+#include <userver/engine/mutex.hpp>
 #include <userver/storages/postgres/postgres_fwd.hpp>
+#include <userver/utils/statistics/entry.hpp>
 
+#include "frame_ingest.hpp"
 #include "frs_caches.hpp"
+#include "frs_face_tracker.hpp"
+#include "inference_client.hpp"
+#include "rtsp_ingest.hpp"
+#include "scene_filter.hpp"
+#include "sharded_registry.hpp"
+#include "stage_timings.hpp"
 
 namespace Frs
 {
@@ -59,6 +71,10 @@ namespace Frs
     std::chrono::milliseconds clear_old_events{std::chrono::days{1}};
     std::chrono::milliseconds log_faces_ttl{std::chrono::hours{4}};
     std::chrono::milliseconds events_ttl{std::chrono::days{30}};
+    std::string dnn_stats_path;
+    std::chrono::milliseconds dnn_stats_save_interval{std::chrono::minutes{1}};
+    Inference::OnnxRuntimeOptions onnxruntime_options;
+    int32_t rtsp_decoder_pool_size{4};
   };
 
   enum TaskType
@@ -70,6 +86,46 @@ namespace Frs
     TASK_TEST
   };
 
+  // pipeline stages with latency statistics
+  enum PipelineStage
+  {
+    STAGE_CAPTURE,
+    STAGE_DECODE,
+    STAGE_FD_PREPROCESS,
+    STAGE_FD_INFERENCE,
+    STAGE_FD_POSTPROCESS,
+    STAGE_FACE_ALIGNMENT,
+    STAGE_FACE_ALIGNMENT_FC,
+    STAGE_FC_INFERENCE,
+    STAGE_FR_INFERENCE,
+    STAGE_MATCHING,
+    STAGE_DB_INSERT,
+    STAGE_FILE_WRITE,
+    STAGE_FILE_WRITE_DATA,
+    STAGE_CALLBACK,
+    STAGE_COUNT
+  };
+
+  inline static constexpr std::array<std::string_view, STAGE_COUNT> PIPELINE_STAGE_NAMES = {
+    "capture",
+    "decode",
+    "fd_preprocess",
+    "fd_inference",
+    "fd_postprocess",
+    "face_alignment",
+    "face_alignment_fc",
+    "fc_inference",
+    "fr_inference",
+    "matching",
+    "db_insert",
+    "file_write",
+    "file_write_data",
+    "callback"};
+
+  using PipelineTimings = StageTimings<STAGE_COUNT>;
+
+  struct StreamRuntime;
+
   struct TaskData
   {
     int32_t id_group{};
@@ -81,6 +137,8 @@ namespace Frs
     int face_width{};
     int face_height{};
     int id_sgroup{};
+    std::shared_ptr<StreamRuntime> runtime{};  // only for the video stream workflow
+    std::shared_ptr<PipelineTimings> timings{};  // timings of the video streams group
   };
 
   struct DescriptorRegistrationResult
@@ -98,9 +156,31 @@ namespace Frs
   // to collect inference statistics
   struct DNNStatsData
   {
-    int fd_count{};
-    int fc_count{};
-    int fr_count{};
+    int64_t fd_count{};
+    int64_t fc_count{};
+    int64_t fr_count{};
+  };
+
+  struct DNNStatsCounters
+  {
+    std::atomic<int64_t> fd_count{};
+    std::atomic<int64_t> fc_count{};
+    std::atomic<int64_t> fr_count{};
+
+    void add(const DNNStatsData& data)
+    {
+      fd_count.fetch_add(data.fd_count, std::memory_order_relaxed);
+      fc_count.fetch_add(data.fc_count, std::memory_order_relaxed);
+      fr_count.fetch_add(data.fr_count, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] DNNStatsData load() const
+    {
+      return {
+        fd_count.load(std::memory_order_relaxed),
+        fc_count.load(std::memory_order_relaxed),
+        fr_count.load(std::memory_order_relaxed)};
+    }
   };
 
   struct alignas(float) FaceDetection
@@ -145,6 +225,15 @@ namespace Frs
     HashMap<int, SGroupFaceData> sg_descriptors;
   };
 
+  // quality of an aligned face image
+  struct FaceQuality
+  {
+    double laplacian = 0.0;  // variance of the Laplacian, the sharpness
+    double brightness = 0.0;  // mean luma, 0-255
+    double contrast = 0.0;  // standard deviation of the luma
+    double saturation = 0.0;  // share of the saturated (over-exposed) pixels, 0-1
+  };
+
   struct FaceClass
   {
     int class_index;
@@ -158,6 +247,62 @@ namespace Frs
     cv::Mat face_image;
   };
 
+  // Image and descriptor kernels of the pipeline
+  double cosineDistance(const FaceDescriptor& fd1, const FaceDescriptor& fd2);
+  FaceQuality faceQuality(const cv::Mat& face);
+  bool isFrontalFace(const cv::Mat& landmarks);
+  void nms(std::vector<FaceDetection>& dets, float nms_thresh = 0.4);
+  cv::Mat alignFaceTransform(const cv::Mat& landmarks);
+  cv::Mat warpAlignedFace(const cv::Mat& frame, const cv::Mat& transform, int face_width, int face_height);
+
+  // Immutable snapshot of the merged group and video stream configuration.
+  // It is rebuilt only when a revision of the underlying caches changes, the pipeline holds it by shared pointer.
+  struct ResolvedConfig
+  {
+    std::weak_ptr<const ConfigContainer> common_config_revision;
+    std::weak_ptr<const VStreamConfigContainer> vstreams_config_revision;
+    CommonConfig common_config;
+    VStreamConfig config;
+    std::vector<int64_t> dnn_fd_input_shape;
+    std::vector<int64_t> dnn_fc_input_shape;
+    std::vector<int64_t> dnn_fr_input_shape;
+    std::vector<std::string> dnn_fd_outputs;
+    std::vector<std::string> dnn_fc_outputs;
+    std::vector<std::string> dnn_fr_outputs;
+    std::shared_ptr<Inference::Client> dnn_fd_client;  // nullptr if the inference backend is unavailable
+    std::shared_ptr<Inference::Client> dnn_fc_client;
+    std::shared_ptr<Inference::Client> dnn_fr_client;
+    cv::Rect2f work_area;  // in percent, empty if not specified
+
+    [[nodiscard]] bool isActual(const std::shared_ptr<const ConfigContainer>& common_cache,
+      const std::shared_ptr<const VStreamConfigContainer>& vstreams_cache) const;
+    [[nodiscard]] cv::Rect getWorkArea(int width, int height) const;
+  };
+
+  using ResolvedConfigPtr = std::shared_ptr<const ResolvedConfig>;
+
+  // Per-stream state of the workflow, resolved once at startWorkflow and carried by the pipeline in TaskData
+  struct StreamRuntime
+  {
+    struct PipelineState
+    {
+      bool is_running{false};  // a pipeline task exists
+      bool is_active{false};  // the pipeline should continue with the next frame
+      std::optional<std::chrono::steady_clock::time_point> timeout;
+    };
+
+    userver::concurrent::Variable<PipelineState> pipeline_state;
+
+    // Accessed only by the pipeline of the stream, which never runs concurrently with itself
+    ResolvedConfigPtr resolved_config;
+    std::vector<UnknownDescriptorData> unknown_descriptors;
+    std::unique_ptr<Ingest::MjpegReader> mjpeg_reader;  // capture mode "mjpeg"
+    std::unique_ptr<Ingest::RtspReader> rtsp_reader;  // capture mode "rtsp"
+    Ingest::DuplicateDetector duplicate_detector;
+    SceneFilter::Filter scene_filter;
+    FaceTracker face_tracker;
+  };
+
   class Workflow final : public userver::components::LoggableComponentBase
   {
   public:
@@ -167,6 +312,7 @@ namespace Frs
     std::string kOldLogsMaintenance = "old_logs_maintenance";
     std::string kFlagDeletedMaintenance = "flag_deleted_maintenance";
     std::string kCopyEventsMaintenance = "copy_events_maintenance";
+    std::string kDNNStatsSave = "dnn_stats_save";
     std::string kOldEventsMaintenance = "old_events_maintenance";
 
     static constexpr std::string_view MIME_IMAGE = "image/jpeg";
@@ -268,11 +414,13 @@ namespace Frs
     DescriptorRegistrationResult processPipeline(TaskData&& task_data);
     void loadDNNStatsData();
     void saveDNNStatsData() const;
+    [[nodiscard]] std::shared_ptr<const PipelineTimings> getPipelineTimings(int32_t id_group) const;
 
   private:
     userver::concurrent::BackgroundTaskStorageCore tasks_;
     userver::engine::TaskProcessor& task_processor_;
     userver::engine::TaskProcessor& fs_task_processor_;
+    userver::engine::TaskProcessor& rtsp_task_processor_;  // the reading tasks of the RTSP streams
     userver::clients::http::Client& http_client_;
     userver::logging::LoggerPtr logger_;
     userver::storages::postgres::ClusterPtr pg_cluster_;
@@ -286,33 +434,45 @@ namespace Frs
     userver::utils::PeriodicTask flag_deleted_maintenance_task_;
     userver::utils::PeriodicTask copy_events_maintenance_task_;
     userver::utils::PeriodicTask old_events_maintenance_task_;
+    userver::utils::PeriodicTask dnn_stats_save_task_;
 
     LocalConfig local_config_;
+    std::unique_ptr<Inference::ClientFactory> inference_clients_;
+    std::unique_ptr<Ingest::DecoderPool> rtsp_decoders_;  // shared by the RTSP streams
 
-    userver::concurrent::Variable<HashMap<std::string, bool>> being_processed_vstreams;
-    userver::concurrent::Variable<HashMap<int32_t, DNNStatsData>> dnn_stats_data;
-    userver::concurrent::Variable<HashMap<std::string, std::chrono::time_point<std::chrono::steady_clock>>> vstream_timeouts;
-    userver::concurrent::Variable<HashMap<int32_t, std::vector<UnknownDescriptorData>>> unknown_descriptors;
+    ShardedRegistry<std::string, StreamRuntime> stream_runtimes;
+    ShardedRegistry<int32_t, DNNStatsCounters> dnn_stats_data;
+    ShardedRegistry<int32_t, Ingest::DuplicateCounters> duplicate_frame_stats;  // key is id_vstream
+    ShardedRegistry<int32_t, SceneFilter::Counters> scene_filter_stats;  // key is id_vstream
+    ShardedRegistry<int32_t, PipelineTimings> pipeline_timings;  // key is id_group
+    mutable userver::engine::Mutex dnn_stats_save_mutex_;
+    userver::utils::statistics::Entry statistics_holder_;
 
     // Maintenance member functions
     void doOldLogMaintenance() const;
-    void doFlagDeletedMaintenance() const;
+    void doFlagDeletedMaintenance();
     void doCopyEventsMaintenance() const;
     void doOldEventsMaintenance() const;
 
+    void writeStatistics(userver::utils::statistics::Writer& writer) const;
+
     void nextPipeline(TaskData&& task_data, std::chrono::milliseconds delay);
 
+    ResolvedConfigPtr resolveConfig(const TaskData& task_data);
+    ResolvedConfigPtr buildResolvedConfig(const TaskData& task_data, std::shared_ptr<const ConfigContainer> common_cache,
+      std::shared_ptr<const VStreamConfigContainer> vstreams_cache) const;
+
     // Inference pipeline functions
     static cv::Mat preprocessImage(const cv::Mat& img, int width, int height, float& scale);
-    bool detectFaces(const TaskData& task_data, const cv::Mat& frame, const VStreamConfig& config,
+    bool detectFaces(const TaskData& task_data, const cv::Mat& frame, const ResolvedConfig& resolved_config,
       std::vector<FaceDetection>& detected_faces);
-    bool inferFaceClass(const TaskData& task_data, const cv::Mat& aligned_face, const VStreamConfig& config,
+    bool inferFaceClass(const TaskData& task_data, const cv::Mat& aligned_face, const ResolvedConfig& resolved_config,
       std::vector<FaceClass>& face_classes);
-    bool extractFaceDescriptor(const TaskData& task_data, const cv::Mat& aligned_face, const VStreamConfig& config,
+    bool extractFaceDescriptor(const TaskData& task_data, const cv::Mat& aligned_face, const ResolvedConfig& resolved_config,
       FaceDescriptor& face_descriptor);
     int64_t addLogFace(int32_t id_vstream, const userver::storages::postgres::TimePointTz& log_date,
       int32_t id_descriptor, double quality, const cv::Rect& face_rect, const std::string& screenshot_url, const boost::uuids::uuid& uuid, CopyEventData copy_event_data = NONE) const;
-    int32_t addFaceDescriptor(int32_t id_group, int32_t id_vstream, const FaceDescriptor& fd, const cv::Mat& f_img, int32_t id_parent = 0);
+    int32_t addFaceDescriptor(const ResolvedConfig& resolved_config, const FaceDescriptor& fd, const cv::Mat& f_img, int32_t id_parent = 0);
     int32_t addSGroupFaceDescriptor(int32_t id_sgroup, const FaceDescriptor& fd, const cv::Mat& f_img);
   };
 }  // namespace Frs
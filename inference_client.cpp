@@ -0,0 +1,306 @@
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <numeric>
+
+#include <absl/strings/str_cat.h>
+#include <http_client.h>
+#ifdef WITH_ONNXRUNTIME
+#include <onnxruntime_cxx_api.h>
+#endif
+#include <userver/engine/mutex.hpp>
+
+#include "inference_client.hpp"
+
+namespace tc = triton::client;
+
+namespace Inference
+{
+  namespace
+  {
+    size_t elementCount(const std::vector<int64_t>& shape)
+    {
+      return static_cast<size_t>(std::accumulate(shape.begin(), shape.end(), int64_t{1}, std::multiplies<>()));
+    }
+
+    class TritonResult final : public Result
+    {
+    public:
+      explicit TritonResult(tc::InferResult* result)
+        : result_(result)
+      {
+      }
+
+      bool rawData(const std::string& output_name, const uint8_t** data, size_t* byte_size) const override
+      {
+        return result_->RawData(output_name, data, byte_size).IsOk();
+      }
+
+    private:
+      std::unique_ptr<tc::InferResult> result_;
+    };
+
+    class TritonClient final : public Client
+    {
+    public:
+      explicit TritonClient(std::string server_url)
+        : server_url_(std::move(server_url))
+      {
+      }
+
+      std::unique_ptr<Result> infer(const std::string& model_name, const std::vector<InputTensor>& inputs,
+        const std::vector<std::string>& output_names, std::string& error) override
+      {
+        // creating the HTTP client doesn't open a connection, and a separate client avoids sharing its state between concurrent requests
+        std::unique_ptr<tc::InferenceServerHttpClient> triton_client;
+        auto err = tc::InferenceServerHttpClient::Create(&triton_client, server_url_, false);
+        if (!err.IsOk())
+        {
+          error = absl::StrCat("Unable to create inference client: ", err.Message());
+          return nullptr;
+        }
+
+        std::vector<std::unique_ptr<tc::InferInput>> input_ptrs;
+        std::vector<tc::InferInput*> triton_inputs;
+        input_ptrs.reserve(inputs.size());
+        triton_inputs.reserve(inputs.size());
+        for (const auto& [name, shape, data] : inputs)
+        {
+          tc::InferInput* input;
+          err = tc::InferInput::Create(&input, name, shape, "FP32");
+          if (!err.IsOk())
+          {
+            error = absl::StrCat("Unable to create input data: ", err.Message());
+            return nullptr;
+          }
+          input_ptrs.emplace_back(input);
+          triton_inputs.emplace_back(input);
+
+          // the data is referenced by the request without copying
+          err = input->AppendRaw(reinterpret_cast<const uint8_t*>(data), elementCount(shape) * sizeof(float));
+          if (!err.IsOk())
+          {
+            error = absl::StrCat("Unable to set up input data: ", err.Message());
+            return nullptr;
+          }
+        }
+
+        std::vector<std::unique_ptr<tc::InferRequestedOutput>> output_ptrs;
+        std::vector<const tc::InferRequestedOutput*> triton_outputs;
+        output_ptrs.reserve(output_names.size());
+        triton_outputs.reserve(output_names.size());
+        for (const auto& output_name : output_names)
+        {
+          tc::InferRequestedOutput* output;
+          err = tc::InferRequestedOutput::Create(&output, output_name);
+          if (!err.IsOk())
+          {
+            error = absl::StrCat("Unable to create output data: ", err.Message());
+            return nullptr;
+          }
+          output_ptrs.emplace_back(output);
+          triton_outputs.emplace_back(output);
+        }
+
+        tc::InferOptions options(model_name);
+        options.model_version_ = "";
+        tc::InferResult* result;
+        err = triton_client->Infer(&result, options, triton_inputs, triton_outputs);
+        if (!err.IsOk())
+        {
+          error = absl::StrCat("Unable to send inference request: ", err.Message());
+          return nullptr;
+        }
+
+        auto result_ptr = std::make_unique<TritonResult>(result);
+        if (const auto status = result->RequestStatus(); !status.IsOk())
+        {
+          error = absl::StrCat("Unable to receive inference result: ", status.Message());
+          return nullptr;
+        }
+
+        return result_ptr;
+      }
+
+    private:
+      std::string server_url_;
+    };
+
+#ifdef WITH_ONNXRUNTIME
+    Ort::Env& ortEnv()
+    {
+      static Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "falprs");
+      return env;
+    }
+
+    class OnnxRuntimeResult final : public Result
+    {
+    public:
+      OnnxRuntimeResult(const std::vector<std::string>& output_names, std::vector<Ort::Value>&& values)
+        : output_names_(output_names),
+          values_(std::move(values))
+      {
+      }
+
+      bool rawData(const std::string& output_name, const uint8_t** data, size_t* byte_size) const override
+      {
+        for (size_t i = 0; i < output_names_.size() && i < values_.size(); ++i)
+          if (output_names_[i] == output_name)
+          {
+            *data = reinterpret_cast<const uint8_t*>(values_[i].GetTensorData<float>());
+            *byte_size = values_[i].GetTensorTypeAndShapeInfo().GetElementCount() * sizeof(float);
+            return true;
+          }
+
+        return false;
+      }
+
+    private:
+      std::vector<std::string> output_names_;
+      std::vector<Ort::Value> values_;
+    };
+
+    // Sessions of one model; each session serves one request at a time with a limited number of threads,
+    // so the pool size bounds both the concurrency and the CPU usage of the model
+    struct SessionPool
+    {
+      struct Slot
+      {
+        userver::engine::Mutex mutex;
+        std::unique_ptr<Ort::Session> session;
+      };
+
+      std::vector<std::unique_ptr<Slot>> slots;
+      std::atomic<size_t> next_slot{0};
+    };
+
+    class OnnxRuntimeClient final : public Client
+    {
+    public:
+      OnnxRuntimeClient(std::string model_repository, const OnnxRuntimeOptions& options)
+        : model_repository_(std::move(model_repository)),
+          options_(options)
+      {
+      }
+
+      std::unique_ptr<Result> infer(const std::string& model_name, const std::vector<InputTensor>& inputs,
+        const std::vector<std::string>& output_names, std::string& error) override
+      {
+        const auto session_pool = getSessionPool(model_name, error);
+        if (session_pool == nullptr)
+          return nullptr;
+
+        auto& slot = *session_pool->slots[session_pool->next_slot.fetch_add(1, std::memory_order_relaxed) % session_pool->slots.size()];
+        try
+        {
+          const auto memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+          std::vector<const char*> input_names;
+          std::vector<Ort::Value> input_values;
+          input_names.reserve(inputs.size());
+          input_values.reserve(inputs.size());
+          for (const auto& [name, shape, data] : inputs)
+          {
+            input_names.emplace_back(name.c_str());
+            input_values.emplace_back(Ort::Value::CreateTensor<float>(memory_info, const_cast<float*>(data), elementCount(shape),
+              shape.data(), shape.size()));
+          }
+
+          std::vector<const char*> output_name_ptrs;
+          output_name_ptrs.reserve(output_names.size());
+          for (const auto& output_name : output_names)
+            output_name_ptrs.emplace_back(output_name.c_str());
+
+          std::lock_guard lock(slot.mutex);
+          auto values = slot.session->Run(Ort::RunOptions{nullptr}, input_names.data(), input_values.data(), input_values.size(),
+            output_name_ptrs.data(), output_name_ptrs.size());
+          return std::make_unique<OnnxRuntimeResult>(output_names, std::move(values));
+        } catch (const Ort::Exception& e)
+        {
+          error = absl::StrCat("Unable to do inference of the model ", model_name, ": ", e.what());
+          return nullptr;
+        }
+      }
+
+    private:
+      std::string model_repository_;
+      OnnxRuntimeOptions options_;
+      userver::concurrent::Variable<absl::flat_hash_map<std::string, std::shared_ptr<SessionPool>>> session_pools_;
+
+      std::shared_ptr<SessionPool> getSessionPool(const std::string& model_name, std::string& error)
+      {
+        {
+          const auto data_ptr = session_pools_.Lock();
+          if (const auto it = data_ptr->find(model_name); it != data_ptr->end())
+            return it->second;
+        }
+
+        // the same model repository layout as for Triton Inference Server
+        const auto model_path = absl::StrCat(model_repository_, "/", model_name, "/1/model.onnx");
+        if (!std::filesystem::exists(model_path))
+        {
+          error = absl::StrCat("Unable to find the model file ", model_path);
+          return nullptr;
+        }
+
+        // the sessions are built without the lock, so the loading of a model doesn't block the inference of the loaded ones
+        auto session_pool = std::make_shared<SessionPool>();
+        try
+        {
+          Ort::SessionOptions session_options;
+          session_options.SetIntraOpNumThreads(options_.intra_op_threads);
+          session_options.SetInterOpNumThreads(1);
+          session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+          for (int32_t i = 0; i < std::max(options_.session_pool_size, 1); ++i)
+          {
+            auto slot = std::make_unique<SessionPool::Slot>();
+            slot->session = std::make_unique<Ort::Session>(ortEnv(), model_path.c_str(), session_options);
+            session_pool->slots.emplace_back(std::move(slot));
+          }
+        } catch (const Ort::Exception& e)
+        {
+          error = absl::StrCat("Unable to load the model file ", model_path, ": ", e.what());
+          return nullptr;
+        }
+
+        // of the pools built concurrently for the same model the first inserted one is kept
+        return session_pools_.Lock()->try_emplace(model_name, std::move(session_pool)).first->second;
+      }
+    };
+#endif
+  }  // namespace
+
+  ClientFactory::ClientFactory(const OnnxRuntimeOptions& onnxruntime_options)
+    : onnxruntime_options_(onnxruntime_options)
+  {
+  }
+
+  std::shared_ptr<Client> ClientFactory::getClient(const std::string& backend, const std::string& server, std::string& error)
+  {
+    const auto client_key = absl::StrCat(backend, "|", server);
+    auto data_ptr = clients_.Lock();
+    if (const auto it = data_ptr->find(client_key); it != data_ptr->end())
+      return it->second;
+
+    std::shared_ptr<Client> client;
+    if (backend == BACKEND_TRITON)
+    {
+      client = std::make_shared<TritonClient>(server);
+    } else if (backend == BACKEND_ONNXRUNTIME)
+    {
+#ifdef WITH_ONNXRUNTIME
+      client = std::make_shared<OnnxRuntimeClient>(server, onnxruntime_options_);
+#else
+      error = "Unable to use ONNX Runtime inference backend: the project is built without WITH_ONNXRUNTIME option";
+      return nullptr;
+#endif
+    } else
+    {
+      error = absl::StrCat("Unknown inference backend: ", backend);
+      return nullptr;
+    }
+    (*data_ptr)[client_key] = client;
+
+    return client;
+  }
+}  // namespace Inference
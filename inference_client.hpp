@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <userver/concurrent/variable.hpp>
+
+// Inference backends of the neural network models: the remote Triton Inference Server
+// and the in-process ONNX Runtime (available if the project is built with WITH_ONNXRUNTIME option)
+namespace Inference
+{
+  inline static constexpr auto BACKEND_TRITON = "triton";
+  inline static constexpr auto BACKEND_ONNXRUNTIME = "onnxruntime";
+
+  // FP32 input tensor; the data is not copied and must stay valid until the inference request is completed
+  struct InputTensor
+  {
+    std::string name;
+    std::vector<int64_t> shape;
+    const float* data{nullptr};
+  };
+
+  class Result
+  {
+  public:
+    virtual ~Result() = default;
+
+    // returns false if there is no output tensor with such name; the size is in bytes
+    virtual bool rawData(const std::string& output_name, const uint8_t** data, size_t* byte_size) const = 0;
+  };
+
+  class Client
+  {
+  public:
+    virtual ~Client() = default;
+
+    // blocking call, so it must be done in the task processor for blocking operations;
+    // returns nullptr on failure with the description in the error argument
+    virtual std::unique_ptr<Result> infer(const std::string& model_name, const std::vector<InputTensor>& inputs,
+      const std::vector<std::string>& output_names, std::string& error) = 0;
+  };
+
+  struct OnnxRuntimeOptions
+  {
+    int32_t intra_op_threads{1};  // threads used by one inference request
+    int32_t session_pool_size{2};  // concurrent inference requests per model
+  };
+
+  // Creates clients on the first request and shares them between all pipelines
+  class ClientFactory
+  {
+  public:
+    explicit ClientFactory(const OnnxRuntimeOptions& onnxruntime_options);
+
+    // the server is the URL of Triton Inference Server or the path to the model repository for ONNX Runtime;
+    // returns nullptr on failure with the description in the error argument
+    std::shared_ptr<Client> getClient(const std::string& backend, const std::string& server, std::string& error);
+
+  private:
+    [[maybe_unused]] OnnxRuntimeOptions onnxruntime_options_;
+    userver::concurrent::Variable<absl::flat_hash_map<std::string, std::shared_ptr<Client>>> clients_;
+  };
+}  // namespace Inference
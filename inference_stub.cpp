@@ -0,0 +1,311 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <random>
+
+#include <absl/strings/str_cat.h>
+#include <userver/components/component_config.hpp>
+#include <userver/engine/sleep.hpp>
+#include <userver/formats/common/items.hpp>
+#include <userver/formats/json.hpp>
+#include <userver/formats/serialize/common_containers.hpp>
+#include <userver/http/content_type.hpp>
+#include <userver/server/handlers/exceptions.hpp>
+#include <userver/server/http/http_request.hpp>
+#include <userver/utils/rand.hpp>
+#include <userver/yaml_config/merge_schemas.hpp>
+
+#include "inference_stub.hpp"
+
+namespace InferenceStub
+{
+  namespace
+  {
+    size_t elementCount(const std::vector<int64_t>& shape)
+    {
+      return static_cast<size_t>(std::accumulate(shape.begin(), shape.end(), int64_t{1}, std::multiplies<>()));
+    }
+
+    LatencyDistribution parseLatencyDistribution(const std::string& value)
+    {
+      if (value == "uniform")
+        return LatencyDistribution::UNIFORM;
+      if (value == "normal")
+        return LatencyDistribution::NORMAL;
+      if (value == "lognormal")
+        return LatencyDistribution::LOGNORMAL;
+      if (value == "fixed")
+        return LatencyDistribution::FIXED;
+
+      throw std::runtime_error(absl::StrCat("Unknown latency distribution: ", value));
+    }
+
+    // a replay file contains raw FP32 records of the output one after another (e.g. dumped from a real inference server)
+    std::vector<std::vector<float>> loadRecords(const std::string& file_name, const size_t record_size)
+    {
+      std::ifstream f(file_name, std::ios::binary | std::ios::ate);
+      if (!f.is_open())
+        throw std::runtime_error(absl::StrCat("Unable to open replay file: ", file_name));
+
+      const auto file_size = static_cast<size_t>(f.tellg());
+      const auto record_byte_size = record_size * sizeof(float);
+      if (record_byte_size == 0 || file_size < record_byte_size)
+        throw std::runtime_error(absl::StrCat("Replay file is smaller than one output record: ", file_name));
+
+      f.seekg(0);
+      std::vector<std::vector<float>> records(file_size / record_byte_size);
+      for (auto& record : records)
+      {
+        record.resize(record_size);
+        f.read(reinterpret_cast<char*>(record.data()), static_cast<std::streamsize>(record_byte_size));
+      }
+
+      return records;
+    }
+  }  // namespace
+
+  Handler::Handler(const userver::components::ComponentConfig& config, const userver::components::ComponentContext& context)
+    : HttpHandlerBase(config, context)
+  {
+    for (const auto& [model_name, model_config] : userver::formats::common::Items(config[ConfigParams::MODELS]))
+    {
+      auto& model = models_[model_name];
+      const auto& latency_config = model_config[ConfigParams::LATENCY];
+      model.latency.distribution = parseLatencyDistribution(latency_config[ConfigParams::LATENCY_DISTRIBUTION].As<std::string>("fixed"));
+      model.latency.mean = latency_config[ConfigParams::LATENCY_MEAN].As<decltype(model.latency.mean)>(model.latency.mean);
+      model.latency.stddev = latency_config[ConfigParams::LATENCY_STDDEV].As<decltype(model.latency.stddev)>(model.latency.stddev);
+      model.latency.min = latency_config[ConfigParams::LATENCY_MIN].As<decltype(model.latency.min)>(model.latency.min);
+      model.latency.max = latency_config[ConfigParams::LATENCY_MAX].As<decltype(model.latency.max)>(model.latency.max);
+      model.error_rate = model_config[ConfigParams::ERROR_RATE].As<decltype(model.error_rate)>(model.error_rate);
+
+      for (const auto& output_config : model_config[ConfigParams::OUTPUTS])
+      {
+        auto output = std::make_unique<OutputData>();
+        output->name = output_config[ConfigParams::OUTPUT_NAME].As<std::string>();
+        output->shape = output_config[ConfigParams::OUTPUT_SHAPE].As<std::vector<int64_t>>();
+        const auto record_size = elementCount(output->shape);
+        if (const auto file_name = output_config[ConfigParams::OUTPUT_FILE].As<std::string>(""); !file_name.empty())
+          output->records = loadRecords(file_name, record_size);
+        else
+          output->records.emplace_back(record_size, output_config[ConfigParams::OUTPUT_FILL].As<float>(0.0f));
+        model.outputs.emplace_back(std::move(output));
+      }
+    }
+  }
+
+  std::string Handler::HandleRequestThrow(const userver::server::http::HttpRequest& request,
+    userver::server::request::RequestContext&) const
+  {
+    const auto& model_name = request.GetPathArg("model");
+    const auto model_it = models_.find(model_name);
+    if (model_it == models_.end())
+      throw userver::server::handlers::ResourceNotFound(
+        userver::server::handlers::ExternalBody{ToString(userver::formats::json::MakeObject("error", absl::StrCat("Unknown model: ", model_name)))});
+    const auto& model = model_it->second;
+
+    // the request header is JSON, it may be followed by binary data of the inputs, which is not used
+    const auto& body = request.RequestBody();
+    size_t header_length = body.size();
+    if (const auto& header_length_value = request.GetHeader(HEADER_INFERENCE_HEADER_CONTENT_LENGTH); !header_length_value.empty())
+      header_length = std::min(static_cast<size_t>(std::stoull(header_length_value)), body.size());
+    const auto inference_request = userver::formats::json::FromString(std::string_view{body.data(), header_length});
+
+    // outputs are returned as binary data unless the client explicitly asks otherwise
+    absl::flat_hash_map<std::string, bool> requested_outputs;
+    if (inference_request.HasMember("outputs"))
+      for (const auto& output : inference_request["outputs"])
+        requested_outputs[output["name"].As<std::string>()] = output["parameters"]["binary_data"].As<bool>(true);
+
+    // outputs with the leading dimension of 1 are repeated for every input of a batched request
+    int64_t batch_size = 1;
+    if (inference_request.HasMember("inputs") && !inference_request["inputs"].IsEmpty())
+      if (const auto& shape = inference_request["inputs"][0]["shape"]; shape.IsArray() && !shape.IsEmpty())
+        batch_size = std::max(shape[0].As<int64_t>(), int64_t{1});
+
+    userver::engine::InterruptibleSleepFor(sampleLatency(model.latency));
+
+    auto& response = request.GetHttpResponse();
+    if (model.error_rate > 0.0 && userver::utils::WithDefaultRandom(
+          [&](auto& rng)
+          {
+            return std::bernoulli_distribution(model.error_rate)(rng);
+          }))
+    {
+      response.SetStatus(userver::server::http::HttpStatus::kInternalServerError);
+      response.SetContentType(userver::http::content_type::kApplicationJson);
+      return ToString(userver::formats::json::MakeObject("error", "injected inference error"));
+    }
+
+    userver::formats::json::ValueBuilder response_builder;
+    response_builder["model_name"] = model_name;
+    response_builder["model_version"] = "1";
+    if (inference_request.HasMember("id"))
+      response_builder["id"] = inference_request["id"];
+    response_builder["outputs"] = userver::formats::json::ValueBuilder(userver::formats::common::Type::kArray);
+
+    std::string binary_data;
+    for (const auto& output : model.outputs)
+    {
+      bool is_binary = true;
+      if (!requested_outputs.empty())
+      {
+        const auto it = requested_outputs.find(output->name);
+        if (it == requested_outputs.end())
+          continue;
+        is_binary = it->second;
+      }
+
+      const auto record_count = !output->shape.empty() && output->shape[0] == 1 ? batch_size : 1;
+      std::vector<float> record;
+      for (int64_t i = 0; i < record_count; ++i)
+      {
+        const auto& next = output->records[output->next_record.fetch_add(1, std::memory_order_relaxed) % output->records.size()];
+        record.insert(record.end(), next.begin(), next.end());
+      }
+      auto shape = output->shape;
+      if (!shape.empty())
+        shape[0] *= record_count;
+      userver::formats::json::ValueBuilder output_builder;
+      output_builder["name"] = output->name;
+      output_builder["datatype"] = "FP32";
+      output_builder["shape"] = shape;
+      if (is_binary)
+      {
+        output_builder["parameters"]["binary_data_size"] = record.size() * sizeof(float);
+        binary_data.append(reinterpret_cast<const char*>(record.data()), record.size() * sizeof(float));
+      } else
+        output_builder["data"] = record;
+      response_builder["outputs"].PushBack(output_builder.ExtractValue());
+    }
+
+    auto result = ToString(response_builder.ExtractValue());
+    if (binary_data.empty())
+    {
+      response.SetContentType(userver::http::content_type::kApplicationJson);
+      return result;
+    }
+
+    response.SetHeader(std::string{HEADER_INFERENCE_HEADER_CONTENT_LENGTH}, std::to_string(result.size()));
+    response.SetContentType(userver::http::content_type::kApplicationOctetStream);
+    result.append(binary_data);
+
+    return result;
+  }
+
+  std::chrono::microseconds Handler::sampleLatency(const LatencyConfig& latency)
+  {
+    const auto mean = static_cast<double>(latency.mean.count());
+    const auto stddev = static_cast<double>(latency.stddev.count());
+    double value = mean;
+    switch (latency.distribution)
+    {
+      case LatencyDistribution::FIXED:
+        break;
+
+      case LatencyDistribution::UNIFORM:
+        value = userver::utils::WithDefaultRandom(
+          [&](auto& rng)
+          {
+            return std::uniform_real_distribution<double>(static_cast<double>(latency.min.count()), static_cast<double>(latency.max.count()))(rng);
+          });
+        break;
+
+      case LatencyDistribution::NORMAL:
+        value = userver::utils::WithDefaultRandom(
+          [&](auto& rng)
+          {
+            return std::normal_distribution<double>(mean, stddev)(rng);
+          });
+        break;
+
+      case LatencyDistribution::LOGNORMAL:
+        // parameters of the underlying normal distribution giving the required mean and standard deviation
+        if (mean > 0.0)
+        {
+          const auto sigma2 = std::log(1.0 + stddev * stddev / (mean * mean));
+          value = userver::utils::WithDefaultRandom(
+            [&](auto& rng)
+            {
+              return std::lognormal_distribution<double>(std::log(mean) - sigma2 / 2.0, std::sqrt(sigma2))(rng);
+            });
+        }
+        break;
+    }
+
+    return std::chrono::microseconds{static_cast<int64_t>(std::clamp(value, static_cast<double>(latency.min.count()),
+      static_cast<double>(latency.max.count())))};
+  }
+
+  userver::yaml_config::Schema Handler::GetStaticConfigSchema()
+  {
+    return userver::yaml_config::MergeSchemas<HttpHandlerBase>(R"~(
+type: object
+description: KServe v2 inference server stub
+additionalProperties: false
+properties:
+    models:
+        type: object
+        description: Models by name
+        additionalProperties:
+            type: object
+            description: Model stub settings
+            additionalProperties: false
+            properties:
+                latency:
+                    type: object
+                    description: Latency of an inference request
+                    additionalProperties: false
+                    properties:
+                        distribution:
+                            type: string
+                            description: fixed, uniform (between min and max), normal or lognormal (with mean and stddev)
+                            defaultDescription: fixed
+                        mean:
+                            type: string
+                            description: Mean latency, the latency of the fixed distribution
+                            defaultDescription: 0ms
+                        stddev:
+                            type: string
+                            description: Standard deviation of the latency
+                            defaultDescription: 0ms
+                        min:
+                            type: string
+                            description: Lower bound of the latency
+                            defaultDescription: 0ms
+                        max:
+                            type: string
+                            description: Upper bound of the latency
+                            defaultDescription: 10s
+                error-rate:
+                    type: number
+                    description: Share of requests failed with HTTP 500
+                    defaultDescription: 0
+                outputs:
+                    type: array
+                    description: Output tensors (FP32)
+                    items:
+                        type: object
+                        description: Output tensor
+                        additionalProperties: false
+                        properties:
+                            name:
+                                type: string
+                                description: Tensor name
+                            shape:
+                                type: array
+                                description: Tensor shape
+                                items:
+                                    type: integer
+                                    description: Dimension
+                            fill:
+                                type: number
+                                description: Value of all elements of a canned output
+                                defaultDescription: 0
+                            file:
+                                type: string
+                                description: File with raw FP32 records of the output to replay in turn
+  )~");
+  }
+}  // namespace InferenceStub
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <userver/server/handlers/http_handler_base.hpp>
+
+// Stub of an inference server speaking the KServe v2 HTTP protocol (the one used by Triton Inference Server).
+// It returns shape-correct outputs without running the models, so the pipelines can be load-tested without GPU.
+namespace InferenceStub
+{
+  namespace ConfigParams
+  {
+    inline static constexpr auto MODELS = "models";
+    inline static constexpr auto LATENCY = "latency";
+    inline static constexpr auto LATENCY_DISTRIBUTION = "distribution";
+    inline static constexpr auto LATENCY_MEAN = "mean";
+    inline static constexpr auto LATENCY_STDDEV = "stddev";
+    inline static constexpr auto LATENCY_MIN = "min";
+    inline static constexpr auto LATENCY_MAX = "max";
+    inline static constexpr auto ERROR_RATE = "error-rate";
+    inline static constexpr auto OUTPUTS = "outputs";
+    inline static constexpr auto OUTPUT_NAME = "name";
+    inline static constexpr auto OUTPUT_SHAPE = "shape";
+    inline static constexpr auto OUTPUT_FILL = "fill";
+    inline static constexpr auto OUTPUT_FILE = "file";
+  }  // namespace ConfigParams
+
+  enum class LatencyDistribution
+  {
+    FIXED,
+    UNIFORM,
+    NORMAL,
+    LOGNORMAL
+  };
+
+  struct LatencyConfig
+  {
+    LatencyDistribution distribution{LatencyDistribution::FIXED};
+    std::chrono::microseconds mean{0};
+    std::chrono::microseconds stddev{0};
+    std::chrono::microseconds min{0};
+    std::chrono::microseconds max{std::chrono::seconds{10}};
+  };
+
+  struct OutputData
+  {
+    std::string name;
+    std::vector<int64_t> shape;
+
+    // FP32 records of the output: one canned record or several replayed in turn
+    std::vector<std::vector<float>> records;
+    mutable std::atomic<size_t> next_record{0};
+  };
+
+  struct ModelData
+  {
+    LatencyConfig latency;
+    double error_rate{0.0};
+    std::vector<std::unique_ptr<OutputData>> outputs;
+  };
+
+  class Handler final : public userver::server::handlers::HttpHandlerBase
+  {
+  public:
+    static constexpr auto kName = "handler-inference-stub";
+
+    // binary data extension of the KServe v2 protocol
+    static constexpr auto HEADER_INFERENCE_HEADER_CONTENT_LENGTH = "Inference-Header-Content-Length";
+
+    Handler(const userver::components::ComponentConfig& config, const userver::components::ComponentContext& context);
+    std::string HandleRequestThrow(const userver::server::http::HttpRequest& request,
+      userver::server::request::RequestContext& context) const override;
+    static userver::yaml_config::Schema GetStaticConfigSchema();
+
+  private:
+    absl::flat_hash_map<std::string, ModelData> models_;
+
+    static std::chrono::microseconds sampleLatency(const LatencyConfig& latency);
+  };
+}  // namespace InferenceStub
@@ -0,0 +1,16 @@
+#include <userver/components/minimal_server_component_list.hpp>
+#include <userver/server/handlers/ping.hpp>
+#include <userver/server/handlers/server_monitor.hpp>
+#include <userver/utils/daemon_run.hpp>
+
+#include "inference_stub.hpp"
+
+int main(const int argc, char* argv[])
+{
+  const auto component_list = userver::components::MinimalServerComponentList()
+    .Append<userver::server::handlers::Ping>()
+    .Append<userver::server::handlers::ServerMonitor>()
+    .Append<InferenceStub::Handler>();
+
+  return userver::utils::DaemonMain(argc, argv, component_list);
+}
@@ -0,0 +1,437 @@
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <random>
+
+#include <benchmark/benchmark.h>
+#include <opencv2/imgproc.hpp>
+
+#include "scene_filter.hpp"
+#include "similarity.hpp"
+#include "simd_kernels.hpp"
+
+// clang-format off
+#ifdef BUILD_LPRS
+  #include "lprs_workflow.hpp"
+#endif
+
+#ifdef BUILD_FRS
+  #include "frs_workflow.hpp"
+#endif
+// clang-format on
+
+// Microbenchmarks of the hot kernels of the pipelines at production sizes; input data is random with a fixed seed,
+// so the numbers are comparable between runs and versions
+namespace
+{
+  constexpr uint32_t SEED = 42;
+
+  // synthetic frame: smooth gradients with noise, so that resizing and filtering do real work
+  cv::Mat makeFrame(const int width, const int height)
+  {
+    cv::Mat frame(height, width, CV_8UC3);
+    cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(256));
+    cv::GaussianBlur(frame, frame, {5, 5}, 0);
+    return frame;
+  }
+
+  // every instruction set supported by the CPU, the argument is an index in Simd::supportedIsas()
+  void supportedIsaArgs(benchmark::internal::Benchmark* benchmark)
+  {
+    for (size_t i = 0; i < Simd::supportedIsas().size(); ++i)
+      benchmark->Arg(static_cast<int64_t>(i));
+  }
+
+  void BM_SimdDot(benchmark::State& state)
+  {
+    const auto isa = Simd::supportedIsas()[state.range(0)];
+    const auto& kernels = Simd::kernels(isa);
+    std::mt19937 rng(SEED);
+    std::normal_distribution<float> distribution;
+    std::vector<float> a(512);
+    std::vector<float> b(512);
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+      a[i] = distribution(rng);
+      b[i] = distribution(rng);
+    }
+
+    for ([[maybe_unused]] auto _ : state)
+      benchmark::DoNotOptimize(kernels.dot(a.data(), b.data(), a.size()));
+    state.SetLabel(Simd::isaName(isa));
+  }
+  BENCHMARK(BM_SimdDot)->Apply(supportedIsaArgs);
+
+  void BM_SimdBgrToPlanarRgb(benchmark::State& state)
+  {
+    const auto isa = Simd::supportedIsas()[state.range(0)];
+    const auto& kernels = Simd::kernels(isa);
+    const auto image = makeFrame(640, 640);
+    constexpr float alpha[] = {1.0f / 128.0f, 1.0f / 128.0f, 1.0f / 128.0f};
+    constexpr float beta[] = {-127.5f / 128.0f, -127.5f / 128.0f, -127.5f / 128.0f};
+    std::vector<float> planar(3 * image.total());
+
+    for ([[maybe_unused]] auto _ : state)
+    {
+      kernels.bgrToPlanarRgb(image.data, image.step, image.cols, image.rows, alpha, beta, planar.data());
+      benchmark::DoNotOptimize(planar.data());
+    }
+    state.SetLabel(Simd::isaName(isa));
+  }
+  BENCHMARK(BM_SimdBgrToPlanarRgb)->Apply(supportedIsaArgs);
+
+  // one check of the scene prefilter: thumbnail of a 1920x1080 frame and its difference with the previous one
+  void BM_SceneFilter(benchmark::State& state)
+  {
+    const auto frame = makeFrame(1920, 1080);
+    const cv::Rect area(0, 0, frame.cols, frame.rows);
+    SceneFilter::Filter filter;
+    filter.isChanged(frame, area, {}, 0.0f);
+
+    for ([[maybe_unused]] auto _ : state)
+      benchmark::DoNotOptimize(filter.isChanged(frame, area, {}, 1.0f));
+  }
+  BENCHMARK(BM_SceneFilter);
+
+  void BM_SimdSad(benchmark::State& state)
+  {
+    const auto isa = Simd::supportedIsas()[state.range(0)];
+    const auto& kernels = Simd::kernels(isa);
+    std::mt19937 rng(SEED);
+    std::vector<uint8_t> a(SceneFilter::THUMBNAIL_WIDTH * SceneFilter::THUMBNAIL_HEIGHT);
+    std::vector<uint8_t> b(a.size());
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+      a[i] = static_cast<uint8_t>(rng() & 0xFF);
+      b[i] = static_cast<uint8_t>(rng() & 0xFF);
+    }
+
+    for ([[maybe_unused]] auto _ : state)
+      benchmark::DoNotOptimize(kernels.sad(a.data(), b.data(), a.size()));
+    state.SetLabel(Simd::isaName(isa));
+  }
+  BENCHMARK(BM_SimdSad)->Apply(supportedIsaArgs);
+
+#ifdef BUILD_FRS
+  constexpr int DESCRIPTOR_SIZE = 512;
+
+  // L2-normalized descriptor, as produced by the pipeline
+  Frs::FaceDescriptor makeDescriptor(std::mt19937& rng, const int size = DESCRIPTOR_SIZE)
+  {
+    std::normal_distribution<float> distribution;
+    Frs::FaceDescriptor fd(1, size, CV_32F);
+    for (int i = 0; i < size; ++i)
+      fd.at<float>(0, i) = distribution(rng);
+    return fd / cv::norm(fd, cv::NORM_L2);
+  }
+
+  // five landmarks of a frontal face (eyes, nose, mouth corners) in a 1920x1080 frame with some jitter
+  cv::Mat makeLandmarks(std::mt19937& rng)
+  {
+    std::uniform_real_distribution<float> jitter(-3.0f, 3.0f);
+    const float points[5][2] = {{900.0f, 500.0f}, {964.0f, 500.0f}, {932.0f, 538.0f}, {906.0f, 574.0f}, {958.0f, 574.0f}};
+    cv::Mat landmarks(5, 2, CV_32F);
+    for (int i = 0; i < 5; ++i)
+    {
+      landmarks.at<float>(i, 0) = points[i][0] + jitter(rng);
+      landmarks.at<float>(i, 1) = points[i][1] + jitter(rng);
+    }
+    return landmarks;
+  }
+
+  // face detections clustered around a few faces, like the raw output of the detector before suppression
+  std::vector<Frs::FaceDetection> makeFaceDetections(std::mt19937& rng, const int64_t count)
+  {
+    std::uniform_real_distribution<float> center(100.0f, 1800.0f);
+    std::uniform_real_distribution<float> jitter(-8.0f, 8.0f);
+    std::uniform_real_distribution<float> confidence(0.5f, 1.0f);
+    std::vector<cv::Point2f> faces(16);
+    for (auto& face : faces)
+      face = {center(rng), center(rng) / 2.0f};
+
+    std::vector<Frs::FaceDetection> detections(count);
+    for (int64_t i = 0; i < count; ++i)
+    {
+      const auto& face = faces[i % faces.size()];
+      auto& [bbox, face_confidence, landmark] = detections[i];
+      bbox[0] = face.x - 40.0f + jitter(rng);
+      bbox[1] = face.y - 50.0f + jitter(rng);
+      bbox[2] = face.x + 40.0f + jitter(rng);
+      bbox[3] = face.y + 50.0f + jitter(rng);
+      face_confidence = confidence(rng);
+      std::fill(std::begin(landmark), std::end(landmark), 0.0f);
+    }
+    return detections;
+  }
+
+  void BM_CosineDistance(benchmark::State& state)
+  {
+    std::mt19937 rng(SEED);
+    const auto query = makeDescriptor(rng);
+    std::vector<Frs::FaceDescriptor> gallery;
+    gallery.reserve(state.range(0));
+    for (int64_t i = 0; i < state.range(0); ++i)
+      gallery.emplace_back(makeDescriptor(rng));
+
+    for ([[maybe_unused]] auto _ : state)
+    {
+      double max_cos_distance = -2.0;
+      for (const auto& fd : gallery)
+        max_cos_distance = std::max(max_cos_distance, Frs::cosineDistance(query, fd));
+      benchmark::DoNotOptimize(max_cos_distance);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+  BENCHMARK(BM_CosineDistance)->Arg(1000)->Arg(10000)->Arg(100000);
+
+  // contiguous gallery, like the descriptors of the records read from the data files of events
+  std::vector<float> makeGallery(std::mt19937& rng, const int64_t count)
+  {
+    std::vector<float> gallery(count * DESCRIPTOR_SIZE);
+    for (int64_t i = 0; i < count; ++i)
+      std::memcpy(gallery.data() + i * DESCRIPTOR_SIZE, makeDescriptor(rng).ptr<float>(0), DESCRIPTOR_SIZE * sizeof(float));
+    return gallery;
+  }
+
+  void BM_SimilarityOneToMany(benchmark::State& state)
+  {
+    std::mt19937 rng(SEED);
+    const auto query = makeDescriptor(rng);
+    const auto gallery = makeGallery(rng, state.range(0));
+    const Similarity::StridedRows rows{.data = gallery.data(), .count = static_cast<size_t>(state.range(0)), .stride = DESCRIPTOR_SIZE};
+    std::vector<float> similarities(rows.count);
+
+    for ([[maybe_unused]] auto _ : state)
+    {
+      Similarity::oneToMany<DESCRIPTOR_SIZE>(query.ptr<float>(0), rows, Similarity::Metric::COSINE, similarities);
+      benchmark::DoNotOptimize(similarities.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+  BENCHMARK(BM_SimilarityOneToMany)->Arg(1000)->Arg(10000)->Arg(100000);
+
+  // the search of the API: the faces of a special group against the records of a data file
+  void BM_SimilarityManyToMany(benchmark::State& state)
+  {
+    std::mt19937 rng(SEED);
+    const auto queries_data = makeGallery(rng, 16);
+    const auto gallery = makeGallery(rng, state.range(0));
+    const Similarity::StridedRows queries{.data = queries_data.data(), .count = 16, .stride = DESCRIPTOR_SIZE};
+    const Similarity::StridedRows rows{.data = gallery.data(), .count = static_cast<size_t>(state.range(0)), .stride = DESCRIPTOR_SIZE};
+    std::vector<float> similarities(queries.count * rows.count);
+
+    for ([[maybe_unused]] auto _ : state)
+    {
+      Similarity::manyToMany<DESCRIPTOR_SIZE>(queries, rows, Similarity::Metric::COSINE, similarities);
+      benchmark::DoNotOptimize(similarities.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0) * 16);
+  }
+  BENCHMARK(BM_SimilarityManyToMany)->Arg(1000)->Arg(10000);
+
+  // the matching of the workflow: normalized descriptors of the cache scattered in memory
+  void BM_SimilarityBest(benchmark::State& state)
+  {
+    std::mt19937 rng(SEED);
+    const auto query = makeDescriptor(rng);
+    std::vector<Frs::FaceDescriptor> gallery;
+    std::vector<const float*> rows;
+    gallery.reserve(state.range(0));
+    for (int64_t i = 0; i < state.range(0); ++i)
+      rows.push_back(gallery.emplace_back(makeDescriptor(rng)).ptr<float>(0));
+
+    for ([[maybe_unused]] auto _ : state)
+      benchmark::DoNotOptimize(Similarity::best<DESCRIPTOR_SIZE>(query.ptr<float>(0), Similarity::GatheredRows{rows}, Similarity::Metric::DOT));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+  BENCHMARK(BM_SimilarityBest)->Arg(1000)->Arg(10000)->Arg(100000);
+
+  void BM_SimilarityTopK(benchmark::State& state)
+  {
+    std::mt19937 rng(SEED);
+    const auto query = makeDescriptor(rng);
+    const auto gallery = makeGallery(rng, state.range(0));
+    const Similarity::StridedRows rows{.data = gallery.data(), .count = static_cast<size_t>(state.range(0)), .stride = DESCRIPTOR_SIZE};
+
+    for ([[maybe_unused]] auto _ : state)
+      benchmark::DoNotOptimize(Similarity::topK<DESCRIPTOR_SIZE>(query.ptr<float>(0), rows, 10, Similarity::Metric::DOT));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+  BENCHMARK(BM_SimilarityTopK)->Arg(10000)->Arg(100000);
+
+  void BM_FaceNms(benchmark::State& state)
+  {
+    std::mt19937 rng(SEED);
+    const auto detections = makeFaceDetections(rng, state.range(0));
+    for ([[maybe_unused]] auto _ : state)
+    {
+      auto dets = detections;
+      Frs::nms(dets);
+      benchmark::DoNotOptimize(dets.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+  }
+  BENCHMARK(BM_FaceNms)->Arg(100)->Arg(1000)->Arg(8400);
+
+  void BM_FaceQuality(benchmark::State& state)
+  {
+    const auto face = makeFrame(112, 112);
+    for ([[maybe_unused]] auto _ : state)
+      benchmark::DoNotOptimize(Frs::faceQuality(face));
+  }
+  BENCHMARK(BM_FaceQuality);
+
+  // the transform and the faces for arcface and genet
+  void BM_AlignFace(benchmark::State& state)
+  {
+    std::mt19937 rng(SEED);
+    const auto frame = makeFrame(1920, 1080);
+    const auto landmarks = makeLandmarks(rng);
+    for ([[maybe_unused]] auto _ : state)
+    {
+      const auto transform = Frs::alignFaceTransform(landmarks);
+      benchmark::DoNotOptimize(Frs::warpAlignedFace(frame, transform, 112, 112));
+      benchmark::DoNotOptimize(Frs::warpAlignedFace(frame, transform, 192, 192));
+    }
+  }
+  BENCHMARK(BM_AlignFace);
+
+  void BM_IsFrontalFace(benchmark::State& state)
+  {
+    std::mt19937 rng(SEED);
+    const auto landmarks = makeLandmarks(rng);
+    for ([[maybe_unused]] auto _ : state)
+      benchmark::DoNotOptimize(Frs::isFrontalFace(landmarks));
+  }
+  BENCHMARK(BM_IsFrontalFace);
+#endif
+
+#ifdef BUILD_LPRS
+  void BM_PreprocessImageForVdNet(benchmark::State& state)
+  {
+    const auto frame = makeFrame(1920, 1080);
+    cv::Point2f shift;
+    double scale;
+    for ([[maybe_unused]] auto _ : state)
+      benchmark::DoNotOptimize(Lprs::Workflow::preprocessImageForVdNet(frame, 640, 640, shift, scale));
+  }
+  BENCHMARK(BM_PreprocessImageForVdNet);
+
+  void BM_PreprocessImageForVcNet(benchmark::State& state)
+  {
+    const auto vehicle = makeFrame(400, 300);
+    for ([[maybe_unused]] auto _ : state)
+      benchmark::DoNotOptimize(Lprs::Workflow::preprocessImageForVcNet(vehicle, 224, 224));
+  }
+  BENCHMARK(BM_PreprocessImageForVcNet);
+
+  void BM_PreprocessImageForLpdNet(benchmark::State& state)
+  {
+    const auto vehicle = makeFrame(400, 300);
+    cv::Point2f shift;
+    double scale;
+    for ([[maybe_unused]] auto _ : state)
+      benchmark::DoNotOptimize(Lprs::Workflow::preprocessImageForLpdNet(vehicle, 640, 640, shift, scale));
+  }
+  BENCHMARK(BM_PreprocessImageForLpdNet);
+
+  // plate detection on the frame: the argument is the tile size, 0 - the whole frame
+  void BM_PreprocessFrameTilesForLpdNet(benchmark::State& state)
+  {
+    const auto frame = makeFrame(1920, 1080);
+    const auto tiles = Lprs::Workflow::lpdFrameTiles(frame.cols, frame.rows, static_cast<int32_t>(state.range(0)));
+    cv::Point2f shift;
+    double scale;
+    for ([[maybe_unused]] auto _ : state)
+      for (const auto& tile : tiles)
+        benchmark::DoNotOptimize(Lprs::Workflow::preprocessImageForLpdNet(frame(tile), 640, 640, shift, scale));
+  }
+  BENCHMARK(BM_PreprocessFrameTilesForLpdNet)->Arg(0)->Arg(1280);
+
+  void BM_AssignPlatesToVehicles(benchmark::State& state)
+  {
+    std::mt19937 rng(SEED);
+    std::uniform_real_distribution<float> position(0.0f, 1600.0f);
+    std::vector<Lprs::Vehicle> vehicles(state.range(0));
+    std::vector<Lprs::LicensePlate> plates(state.range(0));
+    for (size_t i = 0; i < vehicles.size(); ++i)
+    {
+      const auto x = position(rng);
+      const auto y = position(rng) / 2.0f;
+      vehicles[i] = {{x, y, x + 320.0f, y + 240.0f}, 0.9f, false, {}};
+      plates[i].bbox[0] = x + 120.0f;
+      plates[i].bbox[1] = y + 180.0f;
+      plates[i].bbox[2] = x + 200.0f;
+      plates[i].bbox[3] = y + 200.0f;
+    }
+    for ([[maybe_unused]] auto _ : state)
+    {
+      auto frame_vehicles = vehicles;
+      Lprs::Workflow::assignPlatesToVehicles(std::vector(plates), frame_vehicles);
+      benchmark::DoNotOptimize(frame_vehicles.data());
+    }
+  }
+  BENCHMARK(BM_AssignPlatesToVehicles)->Arg(5)->Arg(15)->Arg(50);
+
+  void BM_PreprocessImageForLprNet(benchmark::State& state)
+  {
+    // plate image after the perspective transformation
+    const auto plate = makeFrame(160, 34);
+    cv::Point2f shift;
+    double scale;
+    for ([[maybe_unused]] auto _ : state)
+      benchmark::DoNotOptimize(Lprs::Workflow::preprocessImageForLprNet(plate, 160, 160, shift, scale));
+  }
+  BENCHMARK(BM_PreprocessImageForLprNet);
+
+  // LPRNet output [1, 40, 525]: 4 box rows and 36 char class rows; nine chars of a plate, some of them ambiguous
+  std::vector<float> makeLprNetOutput(std::mt19937& rng)
+  {
+    constexpr int num_rows = 40;
+    constexpr int num_cols = 525;
+    std::uniform_real_distribution<float> noise(0.0f, 0.1f);
+    std::vector<float> output(num_rows * num_cols);
+    for (auto& value : output)
+      value = noise(rng);
+
+    for (int c = 0; c < 9; ++c)
+    {
+      const int col = c * 50 + 10;
+      output[0 * num_cols + col] = 10.0f + static_cast<float>(c) * 16.0f;
+      output[1 * num_cols + col] = 80.0f;
+      output[2 * num_cols + col] = 14.0f;
+      output[3 * num_cols + col] = 24.0f;
+      output[(4 + (c * 7) % 36) * num_cols + col] = 0.9f;
+      if (c % 4 == 0)
+        output[(4 + (c * 7 + 1) % 36) * num_cols + col] = 0.6f;
+    }
+    return output;
+  }
+
+  void BM_DecodeLprNetChars(benchmark::State& state)
+  {
+    std::mt19937 rng(SEED);
+    const auto output = makeLprNetOutput(rng);
+    for ([[maybe_unused]] auto _ : state)
+      benchmark::DoNotOptimize(Lprs::Workflow::decodeLprNetChars(output.data(), 0.4f, {0.0f, 63.0f}, 1.0, Lprs::PLATE_CLASS_RU_1));
+  }
+  BENCHMARK(BM_DecodeLprNetChars);
+
+  void BM_AssemblePlateNumbers(benchmark::State& state)
+  {
+    std::mt19937 rng(SEED);
+    const auto output = makeLprNetOutput(rng);
+    const auto chars_data = Lprs::Workflow::decodeLprNetChars(output.data(), 0.4f, {0.0f, 63.0f}, 1.0, Lprs::PLATE_CLASS_RU_1);
+    for ([[maybe_unused]] auto _ : state)
+    {
+      auto chars = chars_data;
+      std::vector<Lprs::PlateNumberData> plate_numbers;
+      Lprs::Workflow::assemblePlateNumbers(chars, 0.7f, plate_numbers);
+      benchmark::DoNotOptimize(plate_numbers.data());
+    }
+  }
+  BENCHMARK(BM_AssemblePlateNumbers);
+#endif
+}  // namespace
+
+BENCHMARK_MAIN();
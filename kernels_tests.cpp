@@ -0,0 +1,177 @@
+#include <cmath>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "simd_kernels.hpp"
+
+// Every instruction set supported by the CPU is compared with the scalar kernels directly, without the startup self-check,
+// which would silently fall back to the scalar kernels
+namespace
+{
+  constexpr uint32_t SEED = 42;
+
+  // lengths with the tails for all vector widths
+  constexpr size_t LENGTHS[] = {1, 7, 15, 33, 129, 513};
+
+  class SimdKernelsTest : public testing::TestWithParam<Simd::Isa>
+  {
+  protected:
+    const Simd::Kernels& scalar_ = Simd::kernels(Simd::Isa::SCALAR);
+    const Simd::Kernels& kernels_ = Simd::kernels(GetParam());
+    std::mt19937 rng_{SEED};
+
+    std::vector<float> randomFloats(const size_t size)
+    {
+      std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+      std::vector<float> result(size);
+      for (auto& value : result)
+        value = distribution(rng_);
+      return result;
+    }
+
+    // an image of the given row step, bytes close to 255 are frequent to have saturated pixels
+    std::vector<uint8_t> randomImage(const size_t step, const int height)
+    {
+      std::vector<uint8_t> result(step * height);
+      for (auto& value : result)
+        value = static_cast<uint8_t>((rng_() & 1) != 0 ? 255 - (rng_() & 0x07) : rng_() & 0xFF);
+      return result;
+    }
+  };
+
+  // the tolerance of a float sum: the summation order differs between the kernels
+  float sumTolerance(const std::vector<float>& a, const std::vector<float>& b)
+  {
+    float magnitude = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i)
+      magnitude += std::fabs(a[i] * b[i]);
+    return 1e-5f * magnitude + 1e-6f;
+  }
+
+  TEST_P(SimdKernelsTest, Dot)
+  {
+    for (const auto size : LENGTHS)
+    {
+      SCOPED_TRACE("size = " + std::to_string(size));
+      const auto a = randomFloats(size);
+      const auto b = randomFloats(size);
+      EXPECT_NEAR(kernels_.dot(a.data(), b.data(), size), scalar_.dot(a.data(), b.data(), size), sumTolerance(a, b));
+    }
+  }
+
+  TEST_P(SimdKernelsTest, DotAndNorms)
+  {
+    for (const auto size : LENGTHS)
+    {
+      SCOPED_TRACE("size = " + std::to_string(size));
+      const auto a = randomFloats(size);
+      const auto b = randomFloats(size);
+      float dot, norm_a, norm_b;
+      float reference_dot, reference_norm_a, reference_norm_b;
+      kernels_.dotAndNorms(a.data(), b.data(), size, dot, norm_a, norm_b);
+      scalar_.dotAndNorms(a.data(), b.data(), size, reference_dot, reference_norm_a, reference_norm_b);
+      EXPECT_NEAR(dot, reference_dot, sumTolerance(a, b));
+      EXPECT_NEAR(norm_a, reference_norm_a, sumTolerance(a, a));
+      EXPECT_NEAR(norm_b, reference_norm_b, sumTolerance(b, b));
+    }
+  }
+
+  TEST_P(SimdKernelsTest, FixedSizeDotAndNorms)
+  {
+    const std::pair<size_t, Simd::FixedSizeKernels> fixed_kernels[] = {
+      {128, kernels_.dim128}, {256, kernels_.dim256}, {512, kernels_.dim512}};
+    for (const auto& [size, fixed] : fixed_kernels)
+    {
+      SCOPED_TRACE("size = " + std::to_string(size));
+      const auto a = randomFloats(size);
+      const auto b = randomFloats(size);
+      EXPECT_NEAR(fixed.dot(a.data(), b.data(), size), scalar_.dot(a.data(), b.data(), size), sumTolerance(a, b));
+      float dot, norm_a, norm_b;
+      float reference_dot, reference_norm_a, reference_norm_b;
+      fixed.dotAndNorms(a.data(), b.data(), size, dot, norm_a, norm_b);
+      scalar_.dotAndNorms(a.data(), b.data(), size, reference_dot, reference_norm_a, reference_norm_b);
+      EXPECT_NEAR(dot, reference_dot, sumTolerance(a, b));
+      EXPECT_NEAR(norm_a, reference_norm_a, sumTolerance(a, a));
+      EXPECT_NEAR(norm_b, reference_norm_b, sumTolerance(b, b));
+    }
+  }
+
+  TEST_P(SimdKernelsTest, BgrToPlanarRgb)
+  {
+    constexpr float alpha[3] = {1.0f / 255.0f, 1.0f / 127.5f, 1.0f / 128.0f};
+    constexpr float beta[3] = {0.0f, -1.0f, -127.5f / 128.0f};
+    for (const auto width : LENGTHS)
+    {
+      SCOPED_TRACE("width = " + std::to_string(width));
+      constexpr int height = 3;
+      const size_t step = 3 * width + 5;
+      const auto image = randomImage(step, height);
+      std::vector<float> planes(3 * width * height);
+      std::vector<float> reference_planes(3 * width * height);
+      kernels_.bgrToPlanarRgb(image.data(), step, static_cast<int>(width), height, alpha, beta, planes.data());
+      scalar_.bgrToPlanarRgb(image.data(), step, static_cast<int>(width), height, alpha, beta, reference_planes.data());
+      for (size_t i = 0; i < planes.size(); ++i)
+        ASSERT_NEAR(planes[i], reference_planes[i], 1e-6f) << "index = " << i;
+    }
+  }
+
+  TEST_P(SimdKernelsTest, Sad)
+  {
+    for (const auto size : LENGTHS)
+    {
+      SCOPED_TRACE("size = " + std::to_string(size));
+      const auto a = randomImage(size, 1);
+      const auto b = randomImage(size, 1);
+      EXPECT_EQ(kernels_.sad(a.data(), b.data(), size), scalar_.sad(a.data(), b.data(), size));
+    }
+  }
+
+  TEST_P(SimdKernelsTest, QualitySums)
+  {
+    // the inner widths are the lengths with the tails, a border of 3 as for the faces
+    constexpr int border = 3;
+    for (const auto inner_width : LENGTHS)
+      for (const int height : {border * 2 + 1, 112})
+      {
+        const int width = static_cast<int>(inner_width) + 2 * border;
+        SCOPED_TRACE("width = " + std::to_string(width) + ", height = " + std::to_string(height));
+        const size_t step = 3 * width + 7;
+        const auto image = randomImage(step, height);
+        Simd::QualitySums sums;
+        Simd::QualitySums reference_sums;
+        kernels_.qualitySums(image.data(), step, width, height, border, sums);
+        scalar_.qualitySums(image.data(), step, width, height, border, reference_sums);
+        EXPECT_EQ(sums.laplacian_sum, reference_sums.laplacian_sum);
+        EXPECT_EQ(sums.laplacian_sq_sum, reference_sums.laplacian_sq_sum);
+        EXPECT_EQ(sums.luma_sum, reference_sums.luma_sum);
+        EXPECT_EQ(sums.luma_sq_sum, reference_sums.luma_sq_sum);
+        EXPECT_EQ(sums.saturated_count, reference_sums.saturated_count);
+        EXPECT_EQ(sums.count, reference_sums.count);
+      }
+  }
+
+  // the scalar kernels against the values computed by hand
+  TEST(SimdScalarKernelsTest, QualitySumsOfFlatImage)
+  {
+    constexpr int width = 10;
+    constexpr int height = 8;
+    const std::vector<uint8_t> image(3 * width * height, 255);
+    Simd::QualitySums sums;
+    Simd::kernels(Simd::Isa::SCALAR).qualitySums(image.data(), 3 * width, width, height, 3, sums);
+    EXPECT_EQ(sums.count, 4 * 2);
+    EXPECT_EQ(sums.laplacian_sum, 0);
+    EXPECT_EQ(sums.laplacian_sq_sum, 0);
+    EXPECT_EQ(sums.luma_sum, 255 * sums.count);
+    EXPECT_EQ(sums.saturated_count, sums.count);
+  }
+
+  INSTANTIATE_TEST_SUITE_P(SupportedIsas, SimdKernelsTest, testing::ValuesIn(Simd::supportedIsas()),
+    [](const testing::TestParamInfo<Simd::Isa>& info)
+    {
+      return std::string(Simd::isaName(info.param));
+    });
+}  // namespace
@@ -52,8 +52,14 @@ namespace Lprs
     static constexpr auto ERROR_NO_METHOD = "Method not found";
 
     // queries
+    // a stream marked for deletion and not purged yet is added anew: with the new config only
     static constexpr auto SQL_ADD_STREAM = R"__SQL__(
       insert into vstreams(id_group, ext_id, config) values($1, $2, $3)
+      on conflict (id_group, ext_id) do update
+      set
+        config = excluded.config,
+        flag_deleted = false,
+        last_updated = now()
     )__SQL__";
 
     static constexpr auto SQL_GET_STREAM = R"__SQL__(
@@ -64,20 +70,26 @@ namespace Lprs
       where
         id_group = $1
         and ext_id = $2
+        and not flag_deleted
     )__SQL__";
 
     static constexpr auto SQL_UPDATE_STREAM = R"__SQL__(
       update
         vstreams
       set
-        config = $1
+        config = $1,
+        last_updated = now()
       where
         id_vstream = $2
     )__SQL__";
 
+    // do not delete row from a database, just mark for deletion
     static constexpr auto SQL_REMOVE_STREAM = R"__SQL__(
-      delete from
+      update
         vstreams
+      set
+        last_updated = now(),
+        flag_deleted = true
       where
         id_group = $1
         and ext_id = $2
@@ -91,6 +103,7 @@ namespace Lprs
         vstreams
       where
         id_group = $1
+        and not flag_deleted
       order by
         ext_id
     )__SQL__";
@@ -122,7 +135,7 @@ namespace Lprs
         1
     )__SQL__";
 
-    static constexpr auto SQL_SET_STREAM_DEFAULT_CONFIG_PARAMS = "update default_vstream_config set config = coalesce(config, $2) || $2 where id_group = $1";
+    static constexpr auto SQL_SET_STREAM_DEFAULT_CONFIG_PARAMS = "update default_vstream_config set config = coalesce(config, $2) || $2, last_updated = now() where id_group = $1";
     static constexpr auto SQL_GET_STREAM_DEFAULT_CONFIG_PARAMS = "select config from default_vstream_config where id_group = $1";
 
     // Component is valid after construction and is able to accept requests
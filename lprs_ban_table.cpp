@@ -0,0 +1,61 @@
+#include <algorithm>
+
+#include "lprs_ban_table.hpp"
+
+namespace Lprs
+{
+  namespace
+  {
+    // the heap is rebuilt from the entries when the outdated expirations outnumber them by this factor
+    constexpr size_t MAX_OUTDATED_FACTOR = 2;
+    constexpr size_t MIN_REBUILD_SIZE = 64;
+  }  // namespace
+
+  bool BanTable::laterExpiration(const Expiration& a, const Expiration& b)
+  {
+    return a.tp > b.tp;
+  }
+
+  const BanTable::Entry* BanTable::find(const std::string& number, const std::chrono::steady_clock::time_point now) const
+  {
+    const auto it = entries_.find(number);
+    if (it == entries_.end() || it->second.tp2 < now)
+      return nullptr;
+
+    return &it->second;
+  }
+
+  void BanTable::set(const std::string& number, const Entry& entry)
+  {
+    entries_[number] = entry;
+    expirations_.push_back({entry.tp2, number});
+    std::ranges::push_heap(expirations_, laterExpiration);
+
+    if (expirations_.size() > MIN_REBUILD_SIZE && expirations_.size() > MAX_OUTDATED_FACTOR * entries_.size())
+    {
+      expirations_.clear();
+      for (const auto& [n, e] : entries_)
+        expirations_.push_back({e.tp2, n});
+      std::ranges::make_heap(expirations_, laterExpiration);
+    }
+  }
+
+  void BanTable::expire(const std::chrono::steady_clock::time_point now)
+  {
+    while (!expirations_.empty() && expirations_.front().tp < now)
+    {
+      std::ranges::pop_heap(expirations_, laterExpiration);
+      const auto& expiration = expirations_.back();
+
+      // the entry may have been extended after this expiration was scheduled
+      if (const auto it = entries_.find(expiration.number); it != entries_.end() && it->second.tp2 < now)
+        entries_.erase(it);
+      expirations_.pop_back();
+    }
+  }
+
+  size_t BanTable::size() const
+  {
+    return entries_.size();
+  }
+}  // namespace Lprs
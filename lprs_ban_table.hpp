@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <opencv2/core.hpp>
+
+namespace Lprs
+{
+  // Two-stage ban data of the plate numbers of a stream (see Workflow::checkBan). An entry expires at the end of its second stage;
+  // the expiration times are kept in a min-heap, so the maintenance removes the expired entries without scanning the whole table.
+  class BanTable
+  {
+  public:
+    struct Entry
+    {
+      std::chrono::steady_clock::time_point tp1;  // end of the first stage
+      std::chrono::steady_clock::time_point tp2;  // end of the second stage
+      cv::Rect2f bbox;
+    };
+
+    // the entry of the number, nullptr if there is none or it has expired
+    [[nodiscard]] const Entry* find(const std::string& number, std::chrono::steady_clock::time_point now) const;
+
+    void set(const std::string& number, const Entry& entry);
+
+    // removes the entries expired by the time point
+    void expire(std::chrono::steady_clock::time_point now);
+
+    [[nodiscard]] size_t size() const;
+
+  private:
+    struct Expiration
+    {
+      std::chrono::steady_clock::time_point tp;
+      std::string number;
+    };
+
+    absl::flat_hash_map<std::string, Entry> entries_;
+
+    // a number gets a new expiration on every update, the outdated ones are skipped when they reach the top
+    std::vector<Expiration> expirations_;
+
+    static bool laterExpiration(const Expiration& a, const Expiration& b);
+  };
+}  // namespace Lprs
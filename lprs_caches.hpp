@@ -29,33 +29,45 @@ namespace Lprs
     inline static constexpr auto EVENTS_SCREENSHOTS_URL_PREFIX = "screenshots-url-prefix";
     inline static constexpr auto FAILED_PATH = "failed-path";
     inline static constexpr auto FAILED_TTL = "failed-ttl";
+    inline static constexpr auto DNN_STATS_PATH = "dnn-stats-path";
+    inline static constexpr auto DNN_STATS_SAVE_INTERVAL = "dnn-stats-save-interval";
+    inline static constexpr auto ONNXRUNTIME_INTRA_OP_THREADS = "onnxruntime-intra-op-threads";
+    inline static constexpr auto ONNXRUNTIME_SESSION_POOL_SIZE = "onnxruntime-session-pool-size";
+    inline static constexpr auto RTSP_DECODER_POOL_SIZE = "rtsp-decoder-pool-size";
 
     // Video stream
     inline static constexpr auto CALLBACK_TIMEOUT = "callback-timeout";
     inline static constexpr auto VD_NET_INFERENCE_SERVER = "vd-net-inference-server";
+    inline static constexpr auto VD_NET_INFERENCE_BACKEND = "vd-net-inference-backend";
     inline static constexpr auto VD_NET_MODEL_NAME = "vd-net-model-name";
     inline static constexpr auto VD_NET_INPUT_WIDTH = "vd-net-input-width";
     inline static constexpr auto VD_NET_INPUT_HEIGHT = "vd-net-input-height";
     inline static constexpr auto VD_NET_INPUT_TENSOR_NAME = "vd-net-input-tensor-name";
     inline static constexpr auto VD_NET_OUTPUT_TENSOR_NAME = "vd-net-output-tensor-name";
-    inline static constexpr auto VC_NET_INFERENCE_SERVER = "vd-net-inference-server";
+    inline static constexpr auto VC_NET_INFERENCE_SERVER = "vc-net-inference-server";
+    inline static constexpr auto VC_NET_INFERENCE_BACKEND = "vc-net-inference-backend";
     inline static constexpr auto VC_NET_MODEL_NAME = "vc-net-model-name";
     inline static constexpr auto VC_NET_INPUT_WIDTH = "vc-net-input-width";
     inline static constexpr auto VC_NET_INPUT_HEIGHT = "vc-net-input-height";
     inline static constexpr auto VC_NET_INPUT_TENSOR_NAME = "vc-net-input-tensor-name";
     inline static constexpr auto VC_NET_OUTPUT_TENSOR_NAME = "vc-net-output-tensor-name";
+    inline static constexpr auto VC_NET_MAX_BATCH_SIZE = "vc-net-max-batch-size";
     inline static constexpr auto LPD_NET_INFERENCE_SERVER = "lpd-net-inference-server";
+    inline static constexpr auto LPD_NET_INFERENCE_BACKEND = "lpd-net-inference-backend";
     inline static constexpr auto LPD_NET_MODEL_NAME = "lpd-net-model-name";
     inline static constexpr auto LPD_NET_INPUT_WIDTH = "lpd-net-input-width";
     inline static constexpr auto LPD_NET_INPUT_HEIGHT = "lpd-net-input-height";
     inline static constexpr auto LPD_NET_INPUT_TENSOR_NAME = "lpd-net-input-tensor-name";
     inline static constexpr auto LPD_NET_OUTPUT_TENSOR_NAME = "lpd-net-output-tensor-name";
+    inline static constexpr auto LPD_NET_MAX_BATCH_SIZE = "lpd-net-max-batch-size";
     inline static constexpr auto LPR_NET_INFERENCE_SERVER = "lpr-net-inference-server";
+    inline static constexpr auto LPR_NET_INFERENCE_BACKEND = "lpr-net-inference-backend";
     inline static constexpr auto LPR_NET_MODEL_NAME = "lpr-net-model-name";
     inline static constexpr auto LPR_NET_INPUT_WIDTH = "lpr-net-input-width";
     inline static constexpr auto LPR_NET_INPUT_HEIGHT = "lpr-net-input-height";
     inline static constexpr auto LPR_NET_INPUT_TENSOR_NAME = "lpr-net-input-tensor-name";
     inline static constexpr auto LPR_NET_OUTPUT_TENSOR_NAME = "lpr-net-output-tensor-name";
+    inline static constexpr auto LPR_NET_MAX_BATCH_SIZE = "lpr-net-max-batch-size";
     inline static constexpr auto VEHICLE_CONFIDENCE = "vehicle-confidence";
     inline static constexpr auto VEHICLE_IOU_THRESHOLD = "vehicle-iou-threshold";
     inline static constexpr auto VEHICLE_AREA_RATIO_THRESHOLD = "vehicle-area-ratio-threshold";
@@ -65,15 +77,21 @@ namespace Lprs
     inline static constexpr auto CHAR_IOU_THRESHOLD = "char-iou-threshold";
     inline static constexpr auto MAX_CAPTURE_ERROR_COUNT = "max-capture-error-count";
     inline static constexpr auto CAPTURE_TIMEOUT = "capture-timeout";
+    inline static constexpr auto CAPTURE_MODE = "capture-mode";
+    inline static constexpr auto MOTION_THRESHOLD = "motion-threshold";
     inline static constexpr auto EVENT_LOG_BEFORE = "event-log-before";
     inline static constexpr auto EVENT_LOG_AFTER = "event-log-after";
     inline static constexpr auto DELAY_BETWEEN_FRAMES = "delay-between-frames";
     inline static constexpr auto BAN_DURATION = "ban-duration";
     inline static constexpr auto BAN_DURATION_AREA = "ban-duration-area";
     inline static constexpr auto BAN_IOU_THRESHOLD = "ban-iou-threshold";
+    inline static constexpr auto PLATE_VOTES = "plate-votes";
+    inline static constexpr auto PLATE_RECOGNIZE_INTERVAL = "plate-recognize-interval";
     inline static constexpr auto DELAY_AFTER_ERROR = "delay-after-error";
     inline static constexpr auto LOGS_LEVEL = "logs-level";
     inline static constexpr auto MIN_PLATE_HEIGHT = "min-plate-height";
+    inline static constexpr auto LPD_FRAME_MODE_VEHICLES = "lpd-frame-mode-vehicles";
+    inline static constexpr auto LPD_FRAME_TILE_SIZE = "lpd-frame-tile-size";
     inline static constexpr auto FLAG_SAVE_FAILED = "flag-save-failed";
     inline static constexpr auto FLAG_PROCESS_SPECIAL = "flag-process-special";
     inline static constexpr auto WORKFLOW_TIMEOUT = "workflow-timeout";
@@ -87,6 +105,7 @@ namespace Lprs
   struct VStreamConfig
   {
     std::string vd_net_inference_server{"127.0.0.1:8000"};
+    std::string vd_net_inference_backend{"triton"};
     std::string vd_net_model_name{"vdnet_yolo"};
     int32_t vd_net_input_width = 640;
     int32_t vd_net_input_height = 640;
@@ -94,25 +113,31 @@ namespace Lprs
     std::string vd_net_output_tensor_name{"output0"};
 
     std::string vc_net_inference_server{"127.0.0.1:8000"};
+    std::string vc_net_inference_backend{"triton"};
     std::string vc_net_model_name{"vc_genet"};
     int32_t vc_net_input_width = 224;
     int32_t vc_net_input_height = 224;
     std::string vc_net_input_tensor_name{"input"};
     std::string vc_net_output_tensor_name{"output"};
+    int32_t vc_net_max_batch_size = 8;
 
     std::string lpd_net_inference_server{"127.0.0.1:8000"};
+    std::string lpd_net_inference_backend{"triton"};
     std::string lpd_net_model_name{"lpdnet_yolo"};
     int32_t lpd_net_input_width = 640;
     int32_t lpd_net_input_height = 640;
     std::string lpd_net_input_tensor_name{"images"};
     std::string lpd_net_output_tensor_name{"output0"};
+    int32_t lpd_net_max_batch_size = 8;
 
     std::string lpr_net_inference_server{"127.0.0.1:8000"};
+    std::string lpr_net_inference_backend{"triton"};
     std::string lpr_net_model_name{"lprnet_yolo"};
     int32_t lpr_net_input_width = 160;
     int32_t lpr_net_input_height = 160;
     std::string lpr_net_input_tensor_name{"images"};
     std::string lpr_net_output_tensor_name{"output0"};
+    int32_t lpr_net_max_batch_size = 8;
 
     std::chrono::milliseconds callback_timeout{std::chrono::seconds{2}};
     float plate_confidence{0.6};
@@ -124,15 +149,21 @@ namespace Lprs
     float vehicle_area_ratio_threshold{0.01};
     float special_confidence{0.7};
     std::chrono::milliseconds capture_timeout{std::chrono::seconds{2}};
+    std::string capture_mode{"snapshot"};
+    float motion_threshold{0.0f};  // 0 - the scene prefilter is off
     std::chrono::milliseconds event_log_before{std::chrono::seconds{10}};
     std::chrono::milliseconds event_log_after{std::chrono::seconds{5}};
     std::chrono::milliseconds delay_between_frames{std::chrono::seconds{1}};
     std::chrono::milliseconds ban_duration{std::chrono::seconds{30}};
     std::chrono::milliseconds ban_duration_area{std::chrono::hours{12}};
     float ban_iou_threshold{0.9};
+    int32_t plate_votes{1};
+    std::chrono::milliseconds plate_recognize_interval{std::chrono::seconds{10}};
     std::chrono::milliseconds delay_after_error{std::chrono::seconds{30}};
     userver::logging::Level logs_level{userver::logging::Level::kInfo};
     int32_t min_plate_height{0};
+    int32_t lpd_frame_mode_vehicles{0};  // 0 - plates are always detected on the vehicle crops
+    int32_t lpd_frame_tile_size{1280};
     std::vector<std::vector<cv::Point2f>> work_area;
     bool flag_save_failed{false};
     bool flag_process_special{false};
@@ -146,79 +177,98 @@ namespace Lprs
     std::string callback_url;
   };
 
-  static VStreamConfig updateVStreamConfig(const userver::formats::json::Value& json)
+  inline std::vector<std::vector<cv::Point2f>> convertToWorkArea(const userver::formats::json::Value& value,
+    const std::vector<std::vector<cv::Point2f>>& default_value)
   {
-    VStreamConfig config;
-
-    config.vd_net_inference_server = convertToString(json[ConfigParams::VD_NET_INFERENCE_SERVER], config.vd_net_inference_server);
-    config.vd_net_model_name = convertToString(json[ConfigParams::VD_NET_MODEL_NAME], config.vd_net_model_name);
-    config.vd_net_input_width = convertToNumber(json[ConfigParams::VD_NET_INPUT_WIDTH], config.vd_net_input_width);
-    config.vd_net_input_height = convertToNumber(json[ConfigParams::VD_NET_INPUT_HEIGHT], config.vd_net_input_height);
-    config.vd_net_input_tensor_name = convertToString(json[ConfigParams::VD_NET_INPUT_TENSOR_NAME], config.vd_net_input_tensor_name);
-    config.vd_net_output_tensor_name = convertToString(json[ConfigParams::VD_NET_OUTPUT_TENSOR_NAME], config.vd_net_output_tensor_name);
-
-    config.vc_net_inference_server = convertToString(json[ConfigParams::VC_NET_INFERENCE_SERVER], config.vc_net_inference_server);
-    config.vc_net_model_name = convertToString(json[ConfigParams::VC_NET_MODEL_NAME], config.vc_net_model_name);
-    config.vc_net_input_width = convertToNumber(json[ConfigParams::VC_NET_INPUT_WIDTH], config.vc_net_input_width);
-    config.vc_net_input_height = convertToNumber(json[ConfigParams::VC_NET_INPUT_HEIGHT], config.vc_net_input_height);
-    config.vc_net_input_tensor_name = convertToString(json[ConfigParams::VC_NET_INPUT_TENSOR_NAME], config.vc_net_input_tensor_name);
-    config.vc_net_output_tensor_name = convertToString(json[ConfigParams::VC_NET_OUTPUT_TENSOR_NAME], config.vc_net_output_tensor_name);
-
-    config.lpd_net_inference_server = convertToString(json[ConfigParams::LPD_NET_INFERENCE_SERVER], config.lpd_net_inference_server);
-    config.lpd_net_model_name = convertToString(json[ConfigParams::LPD_NET_MODEL_NAME], config.lpd_net_model_name);
-    config.lpd_net_input_width = convertToNumber(json[ConfigParams::LPD_NET_INPUT_WIDTH], config.lpd_net_input_width);
-    config.lpd_net_input_height = convertToNumber(json[ConfigParams::LPD_NET_INPUT_HEIGHT], config.lpd_net_input_height);
-    config.lpd_net_input_tensor_name = convertToString(json[ConfigParams::LPD_NET_INPUT_TENSOR_NAME], config.lpd_net_input_tensor_name);
-    config.lpd_net_output_tensor_name = convertToString(json[ConfigParams::LPD_NET_OUTPUT_TENSOR_NAME], config.lpd_net_output_tensor_name);
-
-    config.lpr_net_inference_server = convertToString(json[ConfigParams::LPR_NET_INFERENCE_SERVER], config.lpr_net_inference_server);
-    config.lpr_net_model_name = convertToString(json[ConfigParams::LPR_NET_MODEL_NAME], config.lpr_net_model_name);
-    config.lpr_net_input_width = convertToNumber(json[ConfigParams::LPR_NET_INPUT_WIDTH], config.lpr_net_input_width);
-    config.lpr_net_input_height = convertToNumber(json[ConfigParams::LPR_NET_INPUT_HEIGHT], config.lpr_net_input_height);
-    config.lpr_net_input_tensor_name = convertToString(json[ConfigParams::LPR_NET_INPUT_TENSOR_NAME], config.lpr_net_input_tensor_name);
-    config.lpr_net_output_tensor_name = convertToString(json[ConfigParams::LPR_NET_OUTPUT_TENSOR_NAME], config.lpr_net_output_tensor_name);
-
-    config.callback_timeout = convertToDuration(json[ConfigParams::CALLBACK_TIMEOUT], config.callback_timeout);
-    config.plate_confidence = convertToNumber(json[ConfigParams::PLATE_CONFIDENCE], config.plate_confidence);
-    config.char_score = convertToNumber(json[ConfigParams::CHAR_SCORE], config.char_score);
-    config.char_iou_threshold = convertToNumber(json[ConfigParams::CHAR_IOU_THRESHOLD], config.char_iou_threshold);
-    config.max_capture_error_count = convertToNumber(json[ConfigParams::MAX_CAPTURE_ERROR_COUNT], config.max_capture_error_count);
-    config.vehicle_confidence = convertToNumber(json[ConfigParams::VEHICLE_CONFIDENCE], config.vehicle_confidence);
-    config.vehicle_iou_threshold = convertToNumber(json[ConfigParams::VEHICLE_IOU_THRESHOLD], config.vehicle_iou_threshold);
-    config.vehicle_area_ratio_threshold = convertToNumber(json[ConfigParams::VEHICLE_AREA_RATIO_THRESHOLD], config.vehicle_area_ratio_threshold);
-    config.special_confidence = convertToNumber(json[ConfigParams::SPECIAL_CONFIDENCE], config.special_confidence);
-    config.capture_timeout = convertToDuration(json[ConfigParams::CAPTURE_TIMEOUT], config.capture_timeout);
-    config.event_log_before = convertToDuration(json[ConfigParams::EVENT_LOG_BEFORE], config.event_log_before);
-    config.event_log_after = convertToDuration(json[ConfigParams::EVENT_LOG_AFTER], config.event_log_after);
-    config.delay_between_frames = convertToDuration(json[ConfigParams::DELAY_BETWEEN_FRAMES], config.delay_between_frames);
-    config.ban_duration = convertToDuration(json[ConfigParams::BAN_DURATION], config.ban_duration);
-    config.ban_duration_area = convertToDuration(json[ConfigParams::BAN_DURATION_AREA], config.ban_duration_area);
-    config.ban_iou_threshold = convertToNumber(json[ConfigParams::BAN_IOU_THRESHOLD], config.ban_iou_threshold);
-    config.delay_after_error = convertToDuration(json[ConfigParams::DELAY_AFTER_ERROR], config.delay_after_error);
-    config.min_plate_height = convertToNumber(json[ConfigParams::MIN_PLATE_HEIGHT], config.min_plate_height);
-    config.flag_save_failed = convertToBool(json[ConfigParams::FLAG_SAVE_FAILED], config.flag_save_failed);
-    config.flag_process_special = convertToBool(json[ConfigParams::FLAG_PROCESS_SPECIAL], config.flag_process_special);
-    config.screenshot_url = convertToString(json[ConfigParams::SCREENSHOT_URL], config.screenshot_url);
-    config.callback_url = convertToString(json[ConfigParams::CALLBACK_URL], config.callback_url);
-    config.logs_level = convertToLevel(json[ConfigParams::LOGS_LEVEL], config.logs_level);
-    if (json.HasMember(ConfigParams::WORK_AREA) && json[ConfigParams::WORK_AREA].IsArray())
-      try
-      {
-        for (auto v = json[ConfigParams::WORK_AREA].As<std::vector<std::vector<std::vector<float>>>>(); auto& i : v)
-        {
-          std::vector<cv::Point2f> polygon;
-          polygon.reserve(i.size());
-          for (auto& j : i)
-            polygon.emplace_back(j[0], j[1]);
-          config.work_area.push_back(std::move(polygon));
-        }
-      } catch (...)
+    if (!value.IsArray())
+      return default_value;
+
+    std::vector<std::vector<cv::Point2f>> work_area;
+    try
+    {
+      for (auto v = value.As<std::vector<std::vector<std::vector<float>>>>(); auto& i : v)
       {
-        config.work_area = {};
+        std::vector<cv::Point2f> polygon;
+        polygon.reserve(i.size());
+        for (auto& j : i)
+          polygon.emplace_back(j[0], j[1]);
+        work_area.push_back(std::move(polygon));
       }
-    config.workflow_timeout = convertToDuration(json[ConfigParams::WORKFLOW_TIMEOUT], config.workflow_timeout);
+    } catch (...)
+    {
+      work_area = {};
+    }
+
+    return work_area;
+  }
+
+  inline constexpr ConfigSchema VSTREAM_CONFIG_SCHEMA{std::array{
+    bindParam<&VStreamConfig::vd_net_inference_server>(ConfigParams::VD_NET_INFERENCE_SERVER),
+    bindParam<&VStreamConfig::vd_net_inference_backend>(ConfigParams::VD_NET_INFERENCE_BACKEND),
+    bindParam<&VStreamConfig::vd_net_model_name>(ConfigParams::VD_NET_MODEL_NAME),
+    bindParam<&VStreamConfig::vd_net_input_width>(ConfigParams::VD_NET_INPUT_WIDTH),
+    bindParam<&VStreamConfig::vd_net_input_height>(ConfigParams::VD_NET_INPUT_HEIGHT),
+    bindParam<&VStreamConfig::vd_net_input_tensor_name>(ConfigParams::VD_NET_INPUT_TENSOR_NAME),
+    bindParam<&VStreamConfig::vd_net_output_tensor_name>(ConfigParams::VD_NET_OUTPUT_TENSOR_NAME),
+    bindParam<&VStreamConfig::vc_net_inference_server>(ConfigParams::VC_NET_INFERENCE_SERVER),
+    bindParam<&VStreamConfig::vc_net_inference_backend>(ConfigParams::VC_NET_INFERENCE_BACKEND),
+    bindParam<&VStreamConfig::vc_net_model_name>(ConfigParams::VC_NET_MODEL_NAME),
+    bindParam<&VStreamConfig::vc_net_input_width>(ConfigParams::VC_NET_INPUT_WIDTH),
+    bindParam<&VStreamConfig::vc_net_input_height>(ConfigParams::VC_NET_INPUT_HEIGHT),
+    bindParam<&VStreamConfig::vc_net_input_tensor_name>(ConfigParams::VC_NET_INPUT_TENSOR_NAME),
+    bindParam<&VStreamConfig::vc_net_output_tensor_name>(ConfigParams::VC_NET_OUTPUT_TENSOR_NAME),
+    bindParam<&VStreamConfig::vc_net_max_batch_size>(ConfigParams::VC_NET_MAX_BATCH_SIZE),
+    bindParam<&VStreamConfig::lpd_net_inference_server>(ConfigParams::LPD_NET_INFERENCE_SERVER),
+    bindParam<&VStreamConfig::lpd_net_inference_backend>(ConfigParams::LPD_NET_INFERENCE_BACKEND),
+    bindParam<&VStreamConfig::lpd_net_model_name>(ConfigParams::LPD_NET_MODEL_NAME),
+    bindParam<&VStreamConfig::lpd_net_input_width>(ConfigParams::LPD_NET_INPUT_WIDTH),
+    bindParam<&VStreamConfig::lpd_net_input_height>(ConfigParams::LPD_NET_INPUT_HEIGHT),
+    bindParam<&VStreamConfig::lpd_net_input_tensor_name>(ConfigParams::LPD_NET_INPUT_TENSOR_NAME),
+    bindParam<&VStreamConfig::lpd_net_output_tensor_name>(ConfigParams::LPD_NET_OUTPUT_TENSOR_NAME),
+    bindParam<&VStreamConfig::lpd_net_max_batch_size>(ConfigParams::LPD_NET_MAX_BATCH_SIZE),
+    bindParam<&VStreamConfig::lpr_net_inference_server>(ConfigParams::LPR_NET_INFERENCE_SERVER),
+    bindParam<&VStreamConfig::lpr_net_inference_backend>(ConfigParams::LPR_NET_INFERENCE_BACKEND),
+    bindParam<&VStreamConfig::lpr_net_model_name>(ConfigParams::LPR_NET_MODEL_NAME),
+    bindParam<&VStreamConfig::lpr_net_input_width>(ConfigParams::LPR_NET_INPUT_WIDTH),
+    bindParam<&VStreamConfig::lpr_net_input_height>(ConfigParams::LPR_NET_INPUT_HEIGHT),
+    bindParam<&VStreamConfig::lpr_net_input_tensor_name>(ConfigParams::LPR_NET_INPUT_TENSOR_NAME),
+    bindParam<&VStreamConfig::lpr_net_output_tensor_name>(ConfigParams::LPR_NET_OUTPUT_TENSOR_NAME),
+    bindParam<&VStreamConfig::lpr_net_max_batch_size>(ConfigParams::LPR_NET_MAX_BATCH_SIZE),
+    bindParam<&VStreamConfig::callback_timeout>(ConfigParams::CALLBACK_TIMEOUT),
+    bindParam<&VStreamConfig::plate_confidence>(ConfigParams::PLATE_CONFIDENCE),
+    bindParam<&VStreamConfig::char_score>(ConfigParams::CHAR_SCORE),
+    bindParam<&VStreamConfig::char_iou_threshold>(ConfigParams::CHAR_IOU_THRESHOLD),
+    bindParam<&VStreamConfig::max_capture_error_count>(ConfigParams::MAX_CAPTURE_ERROR_COUNT),
+    bindParam<&VStreamConfig::vehicle_confidence>(ConfigParams::VEHICLE_CONFIDENCE),
+    bindParam<&VStreamConfig::vehicle_iou_threshold>(ConfigParams::VEHICLE_IOU_THRESHOLD),
+    bindParam<&VStreamConfig::vehicle_area_ratio_threshold>(ConfigParams::VEHICLE_AREA_RATIO_THRESHOLD),
+    bindParam<&VStreamConfig::special_confidence>(ConfigParams::SPECIAL_CONFIDENCE),
+    bindParam<&VStreamConfig::capture_timeout>(ConfigParams::CAPTURE_TIMEOUT),
+    bindParam<&VStreamConfig::capture_mode>(ConfigParams::CAPTURE_MODE),
+    bindParam<&VStreamConfig::motion_threshold>(ConfigParams::MOTION_THRESHOLD),
+    bindParam<&VStreamConfig::event_log_before>(ConfigParams::EVENT_LOG_BEFORE),
+    bindParam<&VStreamConfig::event_log_after>(ConfigParams::EVENT_LOG_AFTER),
+    bindParam<&VStreamConfig::delay_between_frames>(ConfigParams::DELAY_BETWEEN_FRAMES),
+    bindParam<&VStreamConfig::ban_duration>(ConfigParams::BAN_DURATION),
+    bindParam<&VStreamConfig::ban_duration_area>(ConfigParams::BAN_DURATION_AREA),
+    bindParam<&VStreamConfig::ban_iou_threshold>(ConfigParams::BAN_IOU_THRESHOLD),
+    bindParam<&VStreamConfig::plate_votes>(ConfigParams::PLATE_VOTES),
+    bindParam<&VStreamConfig::plate_recognize_interval>(ConfigParams::PLATE_RECOGNIZE_INTERVAL),
+    bindParam<&VStreamConfig::delay_after_error>(ConfigParams::DELAY_AFTER_ERROR),
+    bindParam<&VStreamConfig::min_plate_height>(ConfigParams::MIN_PLATE_HEIGHT),
+    bindParam<&VStreamConfig::lpd_frame_mode_vehicles>(ConfigParams::LPD_FRAME_MODE_VEHICLES),
+    bindParam<&VStreamConfig::lpd_frame_tile_size>(ConfigParams::LPD_FRAME_TILE_SIZE),
+    bindParam<&VStreamConfig::flag_save_failed>(ConfigParams::FLAG_SAVE_FAILED),
+    bindParam<&VStreamConfig::flag_process_special>(ConfigParams::FLAG_PROCESS_SPECIAL),
+    bindParam<&VStreamConfig::screenshot_url>(ConfigParams::SCREENSHOT_URL),
+    bindParam<&VStreamConfig::callback_url>(ConfigParams::CALLBACK_URL),
+    bindParam<&VStreamConfig::logs_level>(ConfigParams::LOGS_LEVEL),
+    bindParam<&VStreamConfig::work_area, convertToWorkArea>(ConfigParams::WORK_AREA),
+    bindParam<&VStreamConfig::workflow_timeout>(ConfigParams::WORKFLOW_TIMEOUT)}};
 
-    return config;
+  static VStreamConfig updateVStreamConfig(const userver::formats::json::Value& json)
+  {
+    return VSTREAM_CONFIG_SCHEMA.parse(json);
   }
 
   // Video stream groups' cache
@@ -250,6 +300,7 @@ namespace Lprs
     int32_t id_vstream;
     std::string ext_id;
     std::optional<userver::formats::json::Value> config;
+    bool flag_deleted{};
   };
 
   class VStreamConfigContainer
@@ -257,6 +308,13 @@ namespace Lprs
   public:
     void insert_or_assign(const std::string& key, VStreamConfigData&& item)
     {
+      if (item.flag_deleted)
+      {
+        // item is mark for deletion, so remove it from cache
+        data_.erase(key);
+        return;
+      }
+
       VStreamConfig config{};
       if (item.config)
         config = updateVStreamConfig(*item.config);
@@ -292,13 +350,16 @@ namespace Lprs
         vs.id_group,
         vs.id_vstream,
         vs.ext_id,
-        coalesce(d.config, '{}') || coalesce(vs.config, '{}') config
+        coalesce(d.config, '{}') || coalesce(vs.config, '{}') config,
+        vs.flag_deleted
       from
         vstreams vs
         left join default_vstream_config d
           on d.id_group = vs.id_group
     )__SQL__";
-    static constexpr const char* kUpdatedField = nullptr;
+    // a change of the group's default config also refreshes all video streams of the group
+    static constexpr auto kUpdatedField = "greatest(vs.last_updated, coalesce(d.last_updated, '-infinity'))";
+    using UpdatedFieldType = userver::storages::postgres::TimePointTz;
     using CacheContainer = VStreamConfigContainer;
     static constexpr auto kClusterHostType = userver::storages::postgres::ClusterHostType::kMaster;
   };
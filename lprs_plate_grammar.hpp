@@ -0,0 +1,131 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+namespace Lprs
+{
+  // LPRNet char classes: the class of a char is its index in the alphabet
+  inline static constexpr std::string_view PLATE_ALPHABET = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+  inline static constexpr size_t MAX_PLATE_LENGTH = 12;
+
+  namespace PlateChars
+  {
+    inline static constexpr std::string_view DIGITS = "0123456789";
+    inline static constexpr std::string_view RU_LETTERS = "ABCEHKMOPTXY";  // latin letters having the same look as the cyrillic ones on the plates
+  }  // namespace PlateChars
+
+  // License plate class description
+  struct PlateFormat
+  {
+    const char* name;  // plate type in the events
+    std::array<std::string_view, MAX_PLATE_LENGTH> positions;  // chars allowed at every position of the number, the number ends at the first empty one
+    size_t min_length;
+    float aspect_ratio;  // height to width ratio of the plate image for LPRNet
+    bool is_double_line;
+  };
+
+  // License plate classes in the order of LPDNet outputs; a new class needs only a new entry here
+  inline static constexpr PlateFormat PLATE_FORMATS[] = {
+    {"ru_1",
+      {PlateChars::RU_LETTERS, PlateChars::DIGITS, PlateChars::DIGITS, PlateChars::DIGITS, PlateChars::RU_LETTERS, PlateChars::RU_LETTERS,
+        PlateChars::DIGITS, PlateChars::DIGITS, PlateChars::DIGITS},
+      8, 112.0f / 520.0f, false},
+    {"ru_1a",
+      {PlateChars::RU_LETTERS, PlateChars::DIGITS, PlateChars::DIGITS, PlateChars::DIGITS, PlateChars::RU_LETTERS, PlateChars::RU_LETTERS,
+        PlateChars::DIGITS, PlateChars::DIGITS, PlateChars::DIGITS},
+      8, 170.0f / 290.0f, true},
+  };
+  inline static constexpr int32_t PLATE_CLASS_COUNT = static_cast<int32_t>(std::size(PLATE_FORMATS));
+  inline static constexpr int32_t PLATE_CLASS_RU_1 = 0;
+  inline static constexpr int32_t PLATE_CLASS_RU_1A = 1;
+
+  // char class of every byte, -1 for the chars out of the alphabet
+  inline static constexpr auto PLATE_CHAR_CLASSES = []
+  {
+    std::array<int8_t, 256> result{};
+    result.fill(-1);
+    for (size_t i = 0; i < PLATE_ALPHABET.size(); ++i)
+      result[static_cast<unsigned char>(PLATE_ALPHABET[i])] = static_cast<int8_t>(i);
+    return result;
+  }();
+
+  // Plate format compiled into the bit masks of the char classes allowed at every position, so a char is checked by a single lookup
+  class PlateGrammar
+  {
+  public:
+    constexpr PlateGrammar() = default;
+
+    constexpr explicit PlateGrammar(const PlateFormat& format)
+      : min_length_(format.min_length)
+    {
+      while (max_length_ < MAX_PLATE_LENGTH && !format.positions[max_length_].empty())
+      {
+        for (const char c : format.positions[max_length_])
+          masks_[max_length_] |= uint64_t{1} << PLATE_CHAR_CLASSES[static_cast<unsigned char>(c)];
+        ++max_length_;
+      }
+    }
+
+    // the char class is allowed at the position
+    [[nodiscard]] constexpr bool accepts(const size_t position, const int32_t char_class) const
+    {
+      return position < max_length_ && char_class >= 0 && ((masks_[position] >> char_class) & 1) != 0;
+    }
+
+    // the number is valid or, for a prefix, can still be completed to a valid one
+    [[nodiscard]] constexpr bool matches(const std::string_view number, const bool is_prefix = false) const
+    {
+      if (number.size() > max_length_ || (!is_prefix && number.size() < min_length_))
+        return false;
+
+      for (size_t i = 0; i < number.size(); ++i)
+        if (!accepts(i, PLATE_CHAR_CLASSES[static_cast<unsigned char>(number[i])]))
+          return false;
+
+      return true;
+    }
+
+  private:
+    std::array<uint64_t, MAX_PLATE_LENGTH> masks_{};
+    size_t min_length_{0};
+    size_t max_length_{0};
+  };
+
+  namespace Detail
+  {
+    constexpr bool isValidPlateFormat(const PlateFormat& format)
+    {
+      size_t length = 0;
+      while (length < MAX_PLATE_LENGTH && !format.positions[length].empty())
+      {
+        for (const char c : format.positions[length])
+          if (PLATE_CHAR_CLASSES[static_cast<unsigned char>(c)] < 0)
+            return false;
+        ++length;
+      }
+
+      return format.min_length <= length && format.aspect_ratio > 0.0f;
+    }
+  }  // namespace Detail
+
+  static_assert(PLATE_ALPHABET.size() <= 64, "char classes must fit the bit masks");
+  static_assert([]
+    {
+      for (const auto& format : PLATE_FORMATS)
+        if (!Detail::isValidPlateFormat(format))
+          return false;
+      return true;
+    }(), "invalid plate format");
+
+  // grammars of the plate classes
+  inline static constexpr auto PLATE_GRAMMARS = []
+  {
+    std::array<PlateGrammar, PLATE_CLASS_COUNT> result;
+    for (size_t i = 0; i < result.size(); ++i)
+      result[i] = PlateGrammar(PLATE_FORMATS[i]);
+    return result;
+  }();
+}  // namespace Lprs
@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <iterator>
+
+#include "lprs_plate_tracker.hpp"
+#include "tracking.hpp"
+
+namespace Lprs
+{
+  cv::Point2f PlateTracker::platePosition(const Observation& plate)
+  {
+    const auto& v = plate.vehicle_box;
+    if (v.width <= 0.0f || v.height <= 0.0f)
+      return {};
+
+    return {(plate.plate_box.x + plate.plate_box.width / 2.0f - v.x) / v.width, (plate.plate_box.y + plate.plate_box.height / 2.0f - v.y) / v.height};
+  }
+
+  std::vector<size_t> PlateTracker::observe(const std::vector<Observation>& plates, const Options& options, const std::chrono::steady_clock::time_point now,
+    std::vector<ReportedNumber>& lost_numbers)
+  {
+    std::erase_if(tracks_, [&options, now, &lost_numbers](Track& track)
+      {
+        if (now - track.last_seen_tp <= options.ttl)
+          return false;
+        std::ranges::move(track.reported_numbers, std::back_inserter(lost_numbers));
+        return true;
+      });
+
+    std::vector<cv::Rect2f> predicted_boxes;
+    predicted_boxes.reserve(tracks_.size());
+    for (const auto& track : tracks_)
+      predicted_boxes.push_back(Tracking::predict(track.vehicle_box, track.velocity));
+    std::vector<cv::Rect2f> vehicle_boxes;
+    std::vector<cv::Point2f> plate_positions;
+    vehicle_boxes.reserve(plates.size());
+    plate_positions.reserve(plates.size());
+    for (const auto& plate : plates)
+    {
+      vehicle_boxes.push_back(plate.vehicle_box);
+      plate_positions.push_back(platePosition(plate));
+    }
+
+    const auto matches = Tracking::associate(predicted_boxes, vehicle_boxes, MIN_IOU,
+      [this, &plates, &plate_positions](const size_t t, const size_t d)
+      {
+        return tracks_[t].plate_class == plates[d].plate_class && cv::norm(plate_positions[d] - tracks_[t].plate_position) <= MAX_PLATE_DISPLACEMENT;
+      });
+
+    std::vector<size_t> result(plates.size());
+    for (size_t d = 0; d < plates.size(); ++d)
+    {
+      Track* track = nullptr;
+      if (matches[d] >= 0)
+      {
+        track = &tracks_[matches[d]];
+        track->velocity = plates[d].vehicle_box.tl() - track->vehicle_box.tl();
+        result[d] = matches[d];
+      } else
+      {
+        result[d] = tracks_.size();
+        track = &tracks_.emplace_back();
+        track->plate_class = plates[d].plate_class;
+      }
+      track->vehicle_box = plates[d].vehicle_box;
+      track->plate_position = plate_positions[d];
+      track->plate_box = plates[d].plate_box;
+      track->last_seen_tp = now;
+    }
+
+    return result;
+  }
+
+  bool PlateTracker::needsReading(const size_t track, const Options& options, const std::chrono::steady_clock::time_point now) const
+  {
+    const auto& t = tracks_[track];
+    if (t.readings.empty() || confirmedNumbers(track, options).empty())
+      return true;
+    if (Tracking::iou(t.plate_box, t.read_plate_box) < STATIONARY_IOU)
+      return true;
+
+    return now - t.read_tp >= options.recognize_interval;
+  }
+
+  void PlateTracker::addReading(const size_t track, const std::vector<PlateNumberData>& plate_numbers, const Options& options,
+    const std::chrono::steady_clock::time_point now)
+  {
+    auto& t = tracks_[track];
+    const auto window = static_cast<size_t>(2 * std::max(options.votes, 1) - 1);
+    t.readings.push_back(plate_numbers);
+    if (t.readings.size() > window)
+      t.readings.erase(t.readings.begin(), t.readings.end() - static_cast<std::ptrdiff_t>(window));
+    t.read_plate_box = t.plate_box;
+    t.read_tp = now;
+  }
+
+  std::vector<PlateNumberData> PlateTracker::confirmedNumbers(const size_t track, const Options& options) const
+  {
+    struct Votes
+    {
+      PlateNumberData data;
+      int32_t count{0};
+    };
+
+    const auto& t = tracks_[track];
+    const auto window = static_cast<size_t>(2 * std::max(options.votes, 1) - 1);
+    std::vector<Votes> votes;
+    for (size_t i = t.readings.size() > window ? t.readings.size() - window : 0; i < t.readings.size(); ++i)
+      for (const auto& [number, score] : t.readings[i])
+      {
+        auto it = std::ranges::find_if(votes, [&number](const Votes& v)
+          {
+            return v.data.number == number;
+          });
+        if (it == votes.end())
+          votes.push_back({{number, score}, 1});
+        else
+        {
+          ++it->count;
+          it->data.score = std::max(it->data.score, score);
+        }
+      }
+    std::ranges::sort(votes, [](const Votes& a, const Votes& b)
+      {
+        return a.count != b.count ? a.count > b.count : a.data.score > b.data.score;
+      });
+
+    std::vector<PlateNumberData> result;
+    for (auto& [data, count] : votes)
+      if (count >= options.votes)
+        result.push_back(std::move(data));
+
+    return result;
+  }
+
+  const PlateTracker::ReportedNumber* PlateTracker::findReported(const size_t track, const std::string& number) const
+  {
+    const auto& reported_numbers = tracks_[track].reported_numbers;
+    const auto it = std::ranges::find(reported_numbers, number, &ReportedNumber::number);
+    return it != reported_numbers.end() ? &*it : nullptr;
+  }
+
+  void PlateTracker::setReported(const size_t track, const std::string& number, const cv::Rect2f& plate_box,
+    const std::chrono::steady_clock::time_point now)
+  {
+    auto& reported_numbers = tracks_[track].reported_numbers;
+    if (const auto it = std::ranges::find(reported_numbers, number, &ReportedNumber::number); it != reported_numbers.end())
+    {
+      it->plate_box = plate_box;
+      it->reported_tp = now;
+    } else
+      reported_numbers.push_back({number, plate_box, now});
+  }
+
+  PlateTracker::ReportedNumber PlateTracker::releaseReported(const size_t track, const std::string& number)
+  {
+    auto& reported_numbers = tracks_[track].reported_numbers;
+    const auto it = std::ranges::find(reported_numbers, number, &ReportedNumber::number);
+    auto result = std::move(*it);
+    reported_numbers.erase(it);
+    return result;
+  }
+}  // namespace Lprs
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace Lprs
+{
+  struct PlateNumberData
+  {
+    std::string number;
+    float score;
+  };
+
+  // Keeps the license plates of the vehicles of a stream as tracks between the frames. A plate is recognized while its track
+  // has no confirmed number or while it's moving, the numbers are confirmed by voting over the recent readings,
+  // and a track keeps the first stage of the ban of its reported numbers, so a stationary vehicle costs neither LPRNet requests
+  // nor ban lookups.
+  // Tracks are matched by the IoU of the vehicle boxes moved by their last displacement, and the plate must keep its place
+  // within the vehicle box.
+  class PlateTracker
+  {
+  public:
+    struct Options
+    {
+      int32_t votes{1};  // readings out of the last 2 * votes - 1 to confirm a number
+      std::chrono::milliseconds recognize_interval{std::chrono::seconds{10}};  // a stationary plate is read again after this interval
+      std::chrono::milliseconds ttl{std::chrono::seconds{3}};  // a track not seen for this long is dropped
+    };
+
+    struct Observation
+    {
+      cv::Rect2f vehicle_box;
+      cv::Rect2f plate_box;
+      int32_t plate_class{};
+    };
+
+    // a number reported by a track, renewed on every confirmation of the number like the first stage of its ban
+    struct ReportedNumber
+    {
+      std::string number;
+      cv::Rect2f plate_box;  // the plate box at the last confirmation
+      std::chrono::steady_clock::time_point reported_tp;  // the last confirmation
+    };
+
+    // the minimum IoU of a vehicle with the predicted box of its track
+    static constexpr float MIN_IOU = 0.3f;
+
+    // the maximum displacement of the plate center within the vehicle box, in vehicle box sizes
+    static constexpr float MAX_PLATE_DISPLACEMENT = 0.2f;
+
+    // the minimum IoU of a plate with its box at the last reading for the plate to be considered stationary
+    static constexpr float STATIONARY_IOU = 0.8f;
+
+    // matches the plates of the frame with the tracks, creates tracks for the new plates and drops the lost ones, whose reported
+    // numbers are appended to lost_numbers to carry on their ban; returns the track index of every plate, the indices are valid until the next call
+    std::vector<size_t> observe(const std::vector<Observation>& plates, const Options& options, std::chrono::steady_clock::time_point now,
+      std::vector<ReportedNumber>& lost_numbers);
+
+    // the plate of the track should be recognized in this frame
+    [[nodiscard]] bool needsReading(size_t track, const Options& options, std::chrono::steady_clock::time_point now) const;
+
+    void addReading(size_t track, const std::vector<PlateNumberData>& plate_numbers, const Options& options, std::chrono::steady_clock::time_point now);
+
+    // numbers read at least options.votes times in the voting window, by decreasing number of votes and score
+    [[nodiscard]] std::vector<PlateNumberData> confirmedNumbers(size_t track, const Options& options) const;
+
+    // the report of the number by the track, nullptr if the track hasn't reported it
+    [[nodiscard]] const ReportedNumber* findReported(size_t track, const std::string& number) const;
+
+    // reports the number by the track or renews its report
+    void setReported(size_t track, const std::string& number, const cv::Rect2f& plate_box, std::chrono::steady_clock::time_point now);
+
+    // removes the report of the number from the track and returns it, to carry on its ban; the number must be reported by the track
+    ReportedNumber releaseReported(size_t track, const std::string& number);
+
+  private:
+    struct Track
+    {
+      cv::Rect2f vehicle_box;
+      cv::Point2f velocity;
+      cv::Point2f plate_position;  // center of the plate relative to the vehicle box, in vehicle box sizes
+      cv::Rect2f plate_box;
+      int32_t plate_class{};
+      std::chrono::steady_clock::time_point last_seen_tp;
+
+      std::vector<std::vector<PlateNumberData>> readings;  // the voting window, the oldest reading first
+      cv::Rect2f read_plate_box;  // the plate box at the last reading
+      std::chrono::steady_clock::time_point read_tp;
+      std::vector<ReportedNumber> reported_numbers;
+    };
+
+    std::vector<Track> tracks_;
+
+    static cv::Point2f platePosition(const Observation& plate);
+  };
+}  // namespace Lprs
@@ -0,0 +1,68 @@
+#include <opencv2/imgproc.hpp>
+
+#include "lprs_work_area.hpp"
+
+namespace Lprs
+{
+  void WorkArea::update(const std::vector<std::vector<cv::Point2f>>& work_area, const int32_t width, const int32_t height)
+  {
+    if (frame_size_ == cv::Size{width, height} && work_area_ == work_area)
+      return;
+
+    work_area_ = work_area;
+    frame_size_ = {width, height};
+    polygons_.assign(work_area.size(), {});
+    for (size_t i = 0; i < work_area.size(); ++i)
+    {
+      polygons_[i].reserve(work_area[i].size());
+      for (const auto& point : work_area[i])
+        polygons_[i].emplace_back(static_cast<int>(point.x * static_cast<float>(width) / 100.0f),
+          static_cast<int>(point.y * static_cast<float>(height) / 100.0f));
+    }
+
+    bounding_rect_ = {0, 0, width, height};
+    integral_.release();
+    if (polygons_.empty())
+      return;
+
+    bounding_rect_ = cv::boundingRect(polygons_.front());
+    for (const auto& polygon : polygons_)
+      bounding_rect_ |= cv::boundingRect(polygon);
+
+    cv::Mat mask = cv::Mat::zeros(height, width, CV_8UC1);
+    cv::fillPoly(mask, polygons_, cv::Scalar(1));
+    cv::integral(mask, integral_, CV_32S);
+  }
+
+  bool WorkArea::empty() const
+  {
+    return polygons_.empty();
+  }
+
+  const std::vector<std::vector<cv::Point>>& WorkArea::polygons() const
+  {
+    return polygons_;
+  }
+
+  const cv::Rect& WorkArea::boundingRect() const
+  {
+    return bounding_rect_;
+  }
+
+  int64_t WorkArea::pixelCount(const cv::Rect& rect) const
+  {
+    const auto r = rect & cv::Rect(0, 0, frame_size_.width, frame_size_.height);
+    if (r.empty())
+      return 0;
+    if (integral_.empty())
+      return r.area();
+
+    return static_cast<int64_t>(integral_.at<int32_t>(r.y + r.height, r.x + r.width)) - integral_.at<int32_t>(r.y, r.x + r.width)
+      - integral_.at<int32_t>(r.y + r.height, r.x) + integral_.at<int32_t>(r.y, r.x);
+  }
+
+  bool WorkArea::intersects(const cv::Rect& rect) const
+  {
+    return pixelCount(rect) > 0;
+  }
+}  // namespace Lprs
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace Lprs
+{
+  // Work area of a stream in the frame coordinates: the polygons, their bounding rectangle and the integral image of their raster mask,
+  // so the share of a rectangle inside the work area costs four lookups. It's rebuilt only when the work area or the frame size changes.
+  class WorkArea
+  {
+  public:
+    // the work area polygons are in percent of the frame size, as in the stream config
+    void update(const std::vector<std::vector<cv::Point2f>>& work_area, int32_t width, int32_t height);
+
+    // there is no work area, the whole frame is used
+    [[nodiscard]] bool empty() const;
+
+    [[nodiscard]] const std::vector<std::vector<cv::Point>>& polygons() const;
+
+    // the whole frame if there is no work area
+    [[nodiscard]] const cv::Rect& boundingRect() const;
+
+    // number of the work area pixels in the rectangle
+    [[nodiscard]] int64_t pixelCount(const cv::Rect& rect) const;
+
+    [[nodiscard]] bool intersects(const cv::Rect& rect) const;
+
+  private:
+    std::vector<std::vector<cv::Point2f>> work_area_;
+    cv::Size frame_size_;
+    std::vector<std::vector<cv::Point>> polygons_;
+    cv::Rect bounding_rect_;
+    cv::Mat integral_;  // CV_32S, (height + 1) x (width + 1); empty if there is no work area
+  };
+}  // namespace Lprs
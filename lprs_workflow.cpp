@@ -1,22 +1,28 @@
 #include <cmath>
 #include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <numeric>
 
 #include <absl/strings/str_format.h>
 #include <absl/strings/substitute.h>
 #include <boost/uuid/uuid_generators.hpp>
 #include <boost/uuid/uuid_io.hpp>
-#include <http_client.h>
+#include <userver/components/statistics_storage.hpp>
 #include <userver/engine/sleep.hpp>
 #include <userver/engine/wait_all_checked.hpp>
+#include <userver/formats/json/serialize.hpp>
 #include <userver/fs/write.hpp>
 #include <userver/http/common_headers.hpp>
 #include <userver/http/content_type.hpp>
+#include <userver/utils/statistics/writer.hpp>
 #include <userver/yaml_config/merge_schemas.hpp>
 
 #include "lprs_api.hpp"
 #include "lprs_workflow.hpp"
-
-namespace tc = triton::client;
+#include "simd_kernels.hpp"
 
 namespace Lprs
 {
@@ -95,12 +101,8 @@ namespace Lprs
   {
     constexpr int32_t xmin = 0;
 
-    // single line license plate number
-    if (a.plate_class == PLATE_CLASS_RU_1)
-      return a.bbox[xmin] < b.bbox[xmin];
-
     // double line license plate number
-    if (a.plate_class == PLATE_CLASS_RU_1A)
+    if (PLATE_FORMATS[a.plate_class].is_double_line)
     {
       constexpr int32_t ymin = 1;
       constexpr int32_t ymax = 3;
@@ -160,25 +162,12 @@ namespace Lprs
     return r;
   }
 
-  inline std::vector<std::vector<cv::Point>> convertToAbsolute(const std::vector<std::vector<cv::Point2f>>& work_area, const int32_t width, const int32_t height)
-  {
-    std::vector<std::vector<cv::Point>> wa(work_area.size());
-    for (size_t i = 0; i < work_area.size(); ++i)
-    {
-      wa[i].reserve(work_area[i].size());
-      for (size_t j = 0; j < work_area[i].size(); ++j)
-        wa[i].emplace_back(static_cast<int>(work_area[i][j].x * static_cast<float>(width) / 100.0f),
-          static_cast<int>(work_area[i][j].y * static_cast<float>(height) / 100.0f));
-    }
-
-    return wa;
-  }
-
   Workflow::Workflow(const userver::components::ComponentConfig& config,
     const userver::components::ComponentContext& context)
     : LoggableComponentBase{config, context},
       task_processor_(context.GetTaskProcessor(config["task_processor"].As<std::string>())),
       fs_task_processor_(context.GetTaskProcessor(config["fs-task-processor"].As<std::string>())),
+      rtsp_task_processor_(context.GetTaskProcessor(config["rtsp-task-processor"].As<std::string>())),
       http_client_(context.FindComponent<userver::components::HttpClient>().GetHttpClient()),
       vstreams_config_cache_(context.FindComponent<VStreamsConfigCache>()),
       pg_cluster_(context.FindComponent<userver::components::Postgres>(kDatabase).GetCluster()),
@@ -198,6 +187,28 @@ namespace Lprs
     if (!local_config_.failed_path.empty() && !local_config_.failed_path.ends_with("/"))
       local_config_.failed_path += "/";
     local_config_.failed_ttl = config[ConfigParams::SECTION_NAME][ConfigParams::FAILED_TTL].As<decltype(local_config_.failed_ttl)>();
+    local_config_.dnn_stats_path = config[ConfigParams::SECTION_NAME][ConfigParams::DNN_STATS_PATH].As<decltype(local_config_.dnn_stats_path)>(
+      std::filesystem::current_path().string() + "/lprs_dnn_stats_data.json");
+    local_config_.dnn_stats_save_interval = config[ConfigParams::SECTION_NAME][ConfigParams::DNN_STATS_SAVE_INTERVAL].As<decltype(local_config_.dnn_stats_save_interval)>(
+      local_config_.dnn_stats_save_interval);
+    local_config_.onnxruntime_options.intra_op_threads = config[ConfigParams::SECTION_NAME][ConfigParams::ONNXRUNTIME_INTRA_OP_THREADS].As<decltype(local_config_.onnxruntime_options.intra_op_threads)>(
+      local_config_.onnxruntime_options.intra_op_threads);
+    local_config_.onnxruntime_options.session_pool_size = config[ConfigParams::SECTION_NAME][ConfigParams::ONNXRUNTIME_SESSION_POOL_SIZE].As<decltype(local_config_.onnxruntime_options.session_pool_size)>(
+      local_config_.onnxruntime_options.session_pool_size);
+    inference_clients_ = std::make_unique<Inference::ClientFactory>(local_config_.onnxruntime_options);
+    local_config_.rtsp_decoder_pool_size = config[ConfigParams::SECTION_NAME][ConfigParams::RTSP_DECODER_POOL_SIZE].As<decltype(local_config_.rtsp_decoder_pool_size)>(
+      local_config_.rtsp_decoder_pool_size);
+    rtsp_decoders_ = std::make_unique<Ingest::DecoderPool>(local_config_.rtsp_decoder_pool_size);
+    LOG_INFO_TO(logger_, "SIMD kernels: {}", Simd::isaName(Simd::activeIsa()));
+
+    loadDNNStatsData();
+
+    // inference and pipeline statistics are available through the monitor listener
+    statistics_holder_ = context.FindComponent<userver::components::StatisticsStorage>().GetStorage().RegisterWriter(
+      "lprs", [this](userver::utils::statistics::Writer& writer)
+      {
+        writeStatistics(writer);
+      });
 
     if (local_config_.ban_maintenance_interval.count() > 0)
       ban_maintenance_task_.Start(kBanMaintenanceName,
@@ -212,6 +223,21 @@ namespace Lprs
           {userver::utils::PeriodicTask::Flags::kStrong}},
         [this]
         { doEventsLogMaintenance(); });
+
+    // periodic saving of inference statistics so that they survive a crash
+    if (local_config_.dnn_stats_save_interval.count() > 0)
+      dnn_stats_save_task_.Start(kDNNStatsSaveName,
+        {local_config_.dnn_stats_save_interval,
+          {userver::utils::PeriodicTask::Flags::kStrong}},
+        [this]
+        { saveDNNStatsData(); });
+  }
+
+  Workflow::~Workflow()
+  {
+    statistics_holder_.Unregister();
+    dnn_stats_save_task_.Stop();
+    saveDNNStatsData();
   }
 
   userver::yaml_config::Schema Workflow::GetStaticConfigSchema()
@@ -228,6 +254,9 @@ properties:
     fs-task-processor:
         type: string
         description: task processor to process filesystem bound tasks
+    rtsp-task-processor:
+        type: string
+        description: task processor for reading the RTSP streams, every stream in the RTSP capture mode keeps one of its threads
     config:
         type: object
         description: default configuration parameters
@@ -265,6 +294,26 @@ properties:
                 type: string
                 description: Time to live for the unrecognized license plates screenshots
                 defaultDescription: 60d
+            dnn-stats-path:
+                type: string
+                description: Local path of the file for saving inference statistics
+                defaultDescription: lprs_dnn_stats_data.json in the current working directory
+            dnn-stats-save-interval:
+                type: string
+                description: Period for saving inference statistics to the file (0 - only on shutdown)
+                defaultDescription: 1m
+            onnxruntime-intra-op-threads:
+                type: integer
+                description: Number of threads used by one inference request of the ONNX Runtime backend
+                defaultDescription: 1
+            onnxruntime-session-pool-size:
+                type: integer
+                description: Number of ONNX Runtime sessions per model, i.e. the limit of concurrent inference requests to the model
+                defaultDescription: 2
+            rtsp-decoder-pool-size:
+                type: integer
+                description: Number of video decoders shared by the streams in the RTSP capture mode, i.e. the limit of frames decoded at once
+                defaultDescription: 4
   )~");
   }
 
@@ -280,45 +329,34 @@ properties:
       workflow_timeout = cache->getData().at(vstream_key).workflow_timeout;
     }
 
+    auto runtime = stream_runtimes.findOrCreate(vstream_key).first;
     bool do_pipeline = false;
     // scope for accessing concurrent variable
     {
-      auto data_ptr = being_processed_vstreams.Lock();
-      if (!data_ptr->contains(vstream_key))
+      auto state_ptr = runtime->pipeline_state.Lock();
+      if (!state_ptr->is_running)
         do_pipeline = true;
-      (*data_ptr)[vstream_key] = true;
-    }
-
-    if (workflow_timeout.count() > 0)
-    {
-      auto data_ptr = vstream_timeouts.Lock();
-      (*data_ptr)[vstream_key] = std::chrono::steady_clock::now() + workflow_timeout;
+      state_ptr->is_running = true;
+      state_ptr->is_active = true;
+      if (workflow_timeout.count() > 0)
+        state_ptr->timeout = std::chrono::steady_clock::now() + workflow_timeout;
     }
 
     if (do_pipeline)
-      tasks_.Detach(AsyncNoSpan(task_processor_, &Workflow::processPipeline, this, std::move(vstream_key)));
+      tasks_.Detach(AsyncNoSpan(task_processor_, &Workflow::processPipeline, this, std::move(vstream_key), std::move(runtime)));
   }
 
   void Workflow::stopWorkflow(std::string&& vstream_key, const bool is_internal)
   {
-    // scope for accessing concurrent variable
-    {
-      auto data_ptr = being_processed_vstreams.Lock();
-      if (data_ptr->contains(vstream_key))
-      {
-        if (is_internal)
-          data_ptr->erase(vstream_key);
-        else
-          (*data_ptr)[vstream_key] = false;
-      }
-    }
+    const auto runtime = stream_runtimes.find(vstream_key);
+    if (runtime == nullptr)
+      return;
 
-    // scope for accessing concurrent variable
-    {
-      auto data_ptr = vstream_timeouts.Lock();
-      if (data_ptr->contains(vstream_key))
-        data_ptr->erase(vstream_key);
-    }
+    auto state_ptr = runtime->pipeline_state.Lock();
+    if (is_internal)
+      state_ptr->is_running = false;
+    state_ptr->is_active = false;
+    state_ptr->timeout.reset();
   }
 
   const LocalConfig& Workflow::getLocalConfig()
@@ -331,13 +369,18 @@ properties:
     return logger_;
   }
 
+  std::shared_ptr<const PipelineTimings> Workflow::getPipelineTimings(const int32_t id_group) const
+  {
+    return pipeline_timings.find(id_group);
+  }
+
   // private methods
   void Workflow::OnAllComponentsAreStopping()
   {
     tasks_.CancelAndWait();
   }
 
-  void Workflow::processPipeline(std::string&& vstream_key)
+  void Workflow::processPipeline(std::string&& vstream_key, std::shared_ptr<StreamRuntime>&& runtime)
   {
     VStreamConfig config;
 
@@ -359,6 +402,9 @@ properties:
       return;
     }
 
+    const auto timings_ptr = pipeline_timings.findOrCreate(config.id_group).first;
+    auto& timings = *timings_ptr;
+
     if (config.logs_level <= userver::logging::Level::kDebug)
       USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kDebug,
         "Start processPipeline: vstream_key = {};  frame_url = {}",
@@ -371,64 +417,112 @@ properties:
           "vstream_key = {};  before image acquisition",
           vstream_key);
 
-      // parse user and password
-      std::string auth_user;
-      std::string auth_password;
-      if (auto char_alpha = config.screenshot_url.find('@'); char_alpha != std::string::npos)
+      std::string image_data;
+      cv::Mat frame;  // decoded right away in the RTSP capture mode
+      std::string capture_error;
+      const auto stream_idle_timeout = std::max(std::chrono::milliseconds{std::chrono::minutes{1}}, 3 * (config.delay_between_frames + config.delay_after_error));
+      auto capture_timer = timings.measure(STAGE_CAPTURE);
+      if (config.capture_mode == Ingest::CAPTURE_MODE_MJPEG)
       {
-        if (auto protocol_suffix = config.screenshot_url.find("://"); protocol_suffix != std::string::npos && protocol_suffix < char_alpha)
-        {
-          if (auto char_colon = config.screenshot_url.find(':', protocol_suffix + 3); char_colon != std::string::npos && char_colon < char_alpha)
-          {
-            auto char_slash = protocol_suffix + 2;
-            auth_user = config.screenshot_url.substr(char_slash + 1, char_colon - char_slash - 1);
-            auth_password = config.screenshot_url.substr(char_colon + 1, char_alpha - char_colon - 1);
-          }
-        }
+        // the latest frame of the stream kept open between the frames
+        const Ingest::MjpegReader::Options mjpeg_options{
+          .url = config.screenshot_url,
+          .read_timeout = config.capture_timeout,
+          .idle_timeout = stream_idle_timeout};
+        Ingest::takeMjpegFrame(runtime->mjpeg_reader, http_client_, task_processor_, mjpeg_options, image_data, capture_error);
+      } else if (config.capture_mode == Ingest::CAPTURE_MODE_RTSP)
+      {
+        const Ingest::RtspReader::Options rtsp_options{
+          .url = config.screenshot_url,
+          .read_timeout = config.capture_timeout,
+          .idle_timeout = stream_idle_timeout,
+          .frame_interval = config.delay_between_frames};
+        Ingest::takeRtspFrame(runtime->rtsp_reader, *rtsp_decoders_, rtsp_task_processor_, fs_task_processor_, rtsp_options, frame, capture_error);
+      } else
+      {
+        // parse user and password
+        std::string auth_user;
+        std::string auth_password;
+        Ingest::parseUrlCredentials(config.screenshot_url, auth_user, auth_password);
+        // clang-format off
+        auto capture_response = http_client_.CreateRequest()
+          .get(config.screenshot_url)
+          .http_auth_type(userver::clients::http::HttpAuthType::kAnySafe, false, auth_user, auth_password)
+          .retry(config.max_capture_error_count)
+          .timeout(config.capture_timeout)
+          .perform();
+        // clang-format on
+        if (capture_response->status_code() != userver::clients::http::Status::OK || capture_response->body_view().empty())
+          capture_error = absl::Substitute("status_code = $0", static_cast<int>(capture_response->status_code()));
+        else
+          image_data = capture_response->body();
       }
-      // clang-format off
-      auto capture_response = http_client_.CreateRequest()
-        .get(config.screenshot_url)
-        .http_auth_type(userver::clients::http::HttpAuthType::kAnySafe, false, auth_user, auth_password)
-        .retry(config.max_capture_error_count)
-        .timeout(config.capture_timeout)
-        .perform();
-      // clang-format on
+      capture_timer.stop();
       if (config.logs_level <= userver::logging::Level::kTrace)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
           "vstream_key = {};  after image acquisition",
           vstream_key);
 
-      if (capture_response->status_code() != userver::clients::http::Status::OK || capture_response->body_view().empty())
+      if (image_data.empty() && frame.empty())
       {
         if (config.logs_level <= userver::logging::Level::kError)
           USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
-            "vstream_key = {};  url = {};  status_code = {}",
-            vstream_key, config.screenshot_url, capture_response->status_code());
+            "vstream_key = {};  url = {};  {}",
+            vstream_key, config.screenshot_url, capture_error);
         if (config.delay_after_error.count() > 0)
         {
           if (config.logs_level <= userver::logging::Level::kError)
             USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
               "vstream_key = {};  delay for {}ms",
               vstream_key, config.delay_after_error.count());
-          nextPipeline(std::move(vstream_key), config.delay_after_error);
+          nextPipeline(std::move(vstream_key), std::move(runtime), config.delay_after_error);
         } else
           stopWorkflow(std::move(vstream_key));
 
         return;
       }
 
+      // a camera polled faster than its snapshot rate returns the same image again
+      if (!image_data.empty())
+      {
+        const bool is_duplicate = runtime->duplicate_detector.isDuplicate(image_data);
+        duplicate_frame_stats.findOrCreate(config.id_vstream).first->add(is_duplicate);
+        if (is_duplicate)
+        {
+          if (config.logs_level <= userver::logging::Level::kDebug)
+            USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kDebug,
+              "vstream_key = {};  the image is the same as the previous one",
+              vstream_key);
+          nextPipeline(std::move(vstream_key), std::move(runtime), config.delay_between_frames);
+          return;
+        }
+      }
+
       if (config.logs_level <= userver::logging::Level::kTrace)
       {
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
           "vstream_key = {};  image size = {} bytes",
-          vstream_key, capture_response->body_view().size());
+          vstream_key, image_data.size());
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
           "vstream_key = {};  before decoding the image",
           vstream_key);
       }
-      cv::Mat frame = imdecode(std::vector<char>(capture_response->body_view().begin(), capture_response->body_view().end()),
-        cv::IMREAD_COLOR);
+      auto decode_timer = timings.measure(STAGE_DECODE);
+      if (frame.empty())
+        frame = imdecode(std::vector<char>(image_data.begin(), image_data.end()), cv::IMREAD_COLOR);
+      decode_timer.stop();
+
+      // the screenshot to save: the captured image or the decoded frame encoded on the first request
+      const auto screenshot_data = [&image_data, &frame]() -> const std::string&
+      {
+        if (image_data.empty())
+        {
+          std::vector<uchar> buffer;
+          imencode(".jpg", frame, buffer);
+          image_data.assign(buffer.begin(), buffer.end());
+        }
+        return image_data;
+      };
       if (config.logs_level <= userver::logging::Level::kTrace)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
           "vstream_key = {};  after decoding the image",
@@ -443,24 +537,60 @@ properties:
 
       // cv::Mat frame = cv::imread("2023-05-16_17_43_57.png", cv::IMREAD_COLOR);
       // cv::Mat frame = cv::imread("ru002.jpg", cv::IMREAD_COLOR);
+
+      runtime->work_area.update(config.work_area, frame.cols, frame.rows);
+      const auto& work_area = runtime->work_area;
+
+      // a static scene in the work area is skipped before the inference
+      if (config.motion_threshold > 0.0f)
+      {
+        const bool is_changed = runtime->scene_filter.isChanged(frame, work_area.boundingRect(), work_area.polygons(), config.motion_threshold);
+        scene_filter_stats.findOrCreate(config.id_vstream).first->add(!is_changed);
+        if (!is_changed)
+        {
+          if (config.logs_level <= userver::logging::Level::kDebug)
+            USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kDebug,
+              "vstream_key = {};  the scene hasn't changed, difference = {}",
+              vstream_key, runtime->scene_filter.lastDifference());
+          nextPipeline(std::move(vstream_key), std::move(runtime), config.delay_between_frames);
+          return;
+        }
+      }
+
       std::vector<Vehicle> detected_vehicles;
       if (config.logs_level <= userver::logging::Level::kTrace)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
           "vstream_key = {};  before doInferenceVdNet",
           vstream_key);
+      DNNStatsData stats_data;
+      auto vd_timer = timings.measure(STAGE_VD_INFERENCE);
       doInferenceVdNet(frame, config, detected_vehicles);
+      vd_timer.stop();
+      ++stats_data.vd_count;
       if (config.logs_level <= userver::logging::Level::kTrace)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
           "vstream_key = {};  after doInferenceVdNet",
           vstream_key);
 
+      // the vehicles out of the work area can have neither plates nor events, so they aren't sent to VCNet and LPDNet
+      if (!work_area.empty())
+        std::erase_if(detected_vehicles,
+          [&work_area](const auto& vehicle)
+          {
+            return !work_area.intersects(cv::Rect(cv::Point{static_cast<int>(vehicle.bbox[0]), static_cast<int>(vehicle.bbox[1])},
+              cv::Point{static_cast<int>(vehicle.bbox[2]), static_cast<int>(vehicle.bbox[3])}));
+          });
+
       if (config.flag_process_special)
       {
         if (config.logs_level <= userver::logging::Level::kTrace)
           USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
             "vstream_key = {};  before doInferenceVcNet",
             vstream_key);
-        doInferenceVcNet(frame, config, detected_vehicles);
+        auto vc_timer = timings.measure(STAGE_VC_INFERENCE);
+        doInferenceVcNet(frame, config, detected_vehicles, runtime->tensor_arena.vc_net);
+        vc_timer.stop();
+        stats_data.vc_count += static_cast<int64_t>(detected_vehicles.size());
         if (config.logs_level <= userver::logging::Level::kTrace)
           USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
             "vstream_key = {};  after doInferenceVcNet",
@@ -475,26 +605,23 @@ properties:
 
       // check for a special vehicles ban
       bool is_special_banned = false;
+      if (runtime->ban_special_tp)
       {
-        auto ban_special_data_ptr = ban_special_data.Lock();
-        if (ban_special_data_ptr->contains(vstream_key))
+        auto now = std::chrono::steady_clock::now();
+        is_special_banned = *runtime->ban_special_tp > now;
+        if (is_special_banned)
         {
-          auto now = std::chrono::steady_clock::now();
-          is_special_banned = (*ban_special_data_ptr)[vstream_key] > now;
-          if (is_special_banned)
-          {
-            if (config.logs_level <= userver::logging::Level::kTrace)
-              USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
-                "vstream_key = {};  special vehicles are banned ({}s left)",
-                vstream_key, std::chrono::duration_cast<std::chrono::seconds>((*ban_special_data_ptr)[vstream_key] - now).count());
-          } else
-          {
-            ban_special_data_ptr->erase(vstream_key);
-            if (config.logs_level <= userver::logging::Level::kTrace)
-              USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
-                "vstream_key = {};  special vehicles are no longer banned",
-                vstream_key);
-          }
+          if (config.logs_level <= userver::logging::Level::kTrace)
+            USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
+              "vstream_key = {};  special vehicles are banned ({}s left)",
+              vstream_key, std::chrono::duration_cast<std::chrono::seconds>(*runtime->ban_special_tp - now).count());
+        } else
+        {
+          runtime->ban_special_tp.reset();
+          if (config.logs_level <= userver::logging::Level::kTrace)
+            USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
+              "vstream_key = {};  special vehicles are no longer banned",
+              vstream_key);
         }
       }
 
@@ -502,13 +629,33 @@ properties:
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
           "vstream_key = {};  before doInferenceLpdNet",
           vstream_key);
-      doInferenceLpdNet(frame, config, detected_vehicles);
+      auto lpd_timer = timings.measure(STAGE_LPD_INFERENCE);
+      if (config.lpd_frame_mode_vehicles > 0 && detected_vehicles.size() >= static_cast<size_t>(config.lpd_frame_mode_vehicles))
+      {
+        // a crowded scene costs a fixed number of requests over the frame tiles instead of a request per vehicle
+        auto tiles = lpdFrameTiles(frame.cols, frame.rows, config.lpd_frame_tile_size);
+        std::erase_if(tiles,
+          [&work_area](const auto& tile)
+          {
+            return !work_area.intersects(tile);
+          });
+        doInferenceLpdNetOnFrame(frame, config, tiles, work_area, detected_vehicles, runtime->tensor_arena.lpd_net);
+        lpd_timer.stop();
+        stats_data.lpd_count += static_cast<int64_t>(tiles.size());
+      } else
+      {
+        doInferenceLpdNet(frame, config, work_area, detected_vehicles, runtime->tensor_arena.lpd_net);
+        lpd_timer.stop();
+        stats_data.lpd_count += static_cast<int64_t>(detected_vehicles.size());
+      }
       if (config.logs_level <= userver::logging::Level::kTrace)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
           "vstream_key = {};  after doInferenceLpdNet",
           vstream_key);
 
-      removeDuplicatePlates(config, detected_vehicles, frame.cols, frame.rows);
+      auto postprocess_timer = timings.measure(STAGE_POSTPROCESS);
+      removeDuplicatePlates(config, work_area, detected_vehicles);
+      postprocess_timer.stop();
 
       // for test
       // save images of the special vehicles
@@ -521,90 +668,117 @@ properties:
         }*/
 
       std::vector<LicensePlate*> detected_plates;
+      std::vector<PlateTracker::Observation> plate_observations;
       for (const auto& [bbox, confidence, is_special, license_plates] : detected_vehicles)
         for (const auto& license_plate : license_plates)
+        {
           detected_plates.push_back(const_cast<LicensePlate*>(&license_plate));
+          plate_observations.push_back({
+            .vehicle_box = cv::Rect2f(cv::Point2f{bbox[0], bbox[1]}, cv::Point2f{bbox[2], bbox[3]}),
+            .plate_box = cv::Rect2f(cv::Point2f{license_plate.bbox[0], license_plate.bbox[1]}, cv::Point2f{license_plate.bbox[2], license_plate.bbox[3]}),
+            .plate_class = license_plate.plate_class});
+        }
+
+      // the plates are tracked between the frames: a plate is read only while its number isn't confirmed, while it's moving
+      // or after the recognize interval
+      const PlateTracker::Options track_options{
+        .votes = config.plate_votes,
+        .recognize_interval = config.plate_recognize_interval,
+        .ttl = std::max(std::chrono::milliseconds{std::chrono::seconds{3}}, 3 * config.delay_between_frames)};
+      const auto track_tp = std::chrono::steady_clock::now();
+      std::vector<PlateTracker::ReportedNumber> lost_numbers;
+      const auto plate_tracks = runtime->plate_tracker.observe(plate_observations, track_options, track_tp, lost_numbers);
+      if (!lost_numbers.empty())
+        extendBans(*runtime, config, lost_numbers);
+      std::vector<LicensePlate*> plates_to_read;
+      std::vector<bool> is_plate_read(detected_plates.size(), false);
+      for (size_t i = 0; i < detected_plates.size(); ++i)
+        if (runtime->plate_tracker.needsReading(plate_tracks[i], track_options, track_tp))
+        {
+          plates_to_read.push_back(detected_plates[i]);
+          is_plate_read[i] = true;
+        }
+      if (config.logs_level <= userver::logging::Level::kTrace)
+        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
+          "vstream_key = {};  plates to read: {} of {}",
+          vstream_key, plates_to_read.size(), detected_plates.size());
 
       bool result = true;
-      if (!detected_plates.empty())
+      if (!plates_to_read.empty())
       {
         if (config.logs_level <= userver::logging::Level::kTrace)
           USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
             "vstream_key = {};  before doInferenceLprNet",
             vstream_key);
-        result = doInferenceLprNet(frame, config, detected_plates);
+        auto lpr_timer = timings.measure(STAGE_LPR_INFERENCE);
+        result = doInferenceLprNet(frame, config, plates_to_read, runtime->tensor_arena.lpr_net);
+        lpr_timer.stop();
+        stats_data.lpr_count += static_cast<int64_t>(plates_to_read.size());
         if (config.logs_level <= userver::logging::Level::kTrace)
           USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
             "vstream_key = {};  after doInferenceLprNet",
             vstream_key);
       }
+      // to collect inference statistics
+      dnn_stats_data.findOrCreate(config.id_vstream).first->add(stats_data);
+
       if (result)
       {
+        // the readings are voted by the tracks, and every plate gets the numbers confirmed by its track
+        std::vector<bool> is_plate_failed(detected_plates.size(), false);
+        for (size_t i = 0; i < detected_plates.size(); ++i)
+        {
+          auto& plate_numbers = detected_plates[i]->plate_numbers;
+          if (is_plate_read[i])
+          {
+            is_plate_failed[i] = plate_numbers.empty();
+            runtime->plate_tracker.addReading(plate_tracks[i], plate_numbers, track_options, track_tp);
+          }
+          plate_numbers = runtime->plate_tracker.confirmedNumbers(plate_tracks[i], track_options);
+        }
+
         auto now = std::chrono::steady_clock::now();
         userver::formats::json::ValueBuilder json_data;
         userver::formats::json::ValueBuilder callback_info;
         bool has_special = false;
         bool has_failed = false;
+        size_t plate_index = 0;
         for (const auto& [bbox, confidence, is_special, license_plates] : detected_vehicles)
         {
           userver::formats::json::ValueBuilder vehicle_data;
           has_special = has_special || is_special;
           for (const auto& [bbox_plate, confidence_plate, kpts, plate_class, plate_numbers] : license_plates)
           {
-            has_failed = has_failed || plate_numbers.empty();
+            const auto plate_track = plate_tracks[plate_index];
+            has_failed = has_failed || is_plate_failed[plate_index];
+            ++plate_index;
             for (const auto& [number, score] : plate_numbers)
             {
-              auto k = absl::StrCat(vstream_key, "_", number);
-
-              // Description of the two-stage ban.
-              // If the system sees the number for the first time, then after processing it will fall into the first stage of the ban.
-              // At the first stage of the ban, the number is ignored regardless of its location in the frame.
-              // After some time (config ban-duration), the number falls into the second stage of the ban.
-              // At the second stage of the ban (config ban-duration-area), the number is also ignored until it changes its location in the frame.
-              // If at the second stage of the ban the number changes its location (config ban-iou-threshold), it will be processed and will again be included in the first stage.
+              // The track keeps the first stage of the ban of its reported numbers, renewing it on every confirmation without ban lookups.
+              // A number new to its track, or not confirmed for ban-duration, is checked against the two-stage ban of the ban table.
               if (config.ban_duration.count() > 0 && config.ban_duration_area.count() > 0)
               {
-                bool is_banned = false;
-                auto banned_tp1 = now + config.ban_duration;
-                auto banned_tp2 = now + config.ban_duration_area;
-                auto banned_bbox = cv::Rect2f(cv::Point2f{bbox_plate[0], bbox_plate[1]}, cv::Point2f{bbox_plate[2], bbox_plate[3]});
-                auto data_ptr = ban_data.Lock();
-                if (data_ptr->contains(k))
+                const cv::Rect2f plate_box(cv::Point2f{bbox_plate[0], bbox_plate[1]}, cv::Point2f{bbox_plate[2], bbox_plate[3]});
+                if (const auto* reported = runtime->plate_tracker.findReported(plate_track, number))
                 {
-                  is_banned = (*data_ptr)[k].tp1 > now;
-                  if (is_banned)
-                  {
-                    if (config.logs_level <= userver::logging::Level::kDebug)
-                      USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kDebug,
-                        "vstream_key = {};  plate number {} is banned at the first stage ({}s left)",
-                        vstream_key, number, std::chrono::duration_cast<std::chrono::seconds>((*data_ptr)[k].tp1 - now).count());
-                  } else
+                  if (now - reported->reported_tp < config.ban_duration)
                   {
-                    // check area ban
-                    auto iou_value = iou(banned_bbox, (*data_ptr)[k].bbox);
-                    is_banned = iou_value > config.ban_iou_threshold;
-                    if (is_banned)
-                    {
-                      // extending the second stage of the ban
-                      banned_bbox = (*data_ptr)[k].bbox;
-                      banned_tp1 = (*data_ptr)[k].tp1;
-                    }
-                    if (config.logs_level <= userver::logging::Level::kDebug)
-                    {
-                      if (is_banned)
-                        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kDebug,
-                          "vstream_key = {};  plate_number {} is banned at the second stage (iou = {:.2f}, threshold = {:.2f})",
-                          vstream_key, number, iou_value, config.ban_iou_threshold);
-                      else
-                        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kDebug,
-                          "vstream_key = {};  plate_numbers {} was removed from the the second stage ban (iou = {:.2f}, threshold = {:.2f})",
-                          vstream_key, number, iou_value, config.ban_iou_threshold);
-                    }
+                    runtime->plate_tracker.setReported(plate_track, number, plate_box, now);
+                    if (config.logs_level <= userver::logging::Level::kTrace)
+                      USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
+                        "vstream_key = {};  plate number {} has already been reported by its track",
+                        vstream_key, number);
+                    continue;
                   }
+
+                  // the first stage is over, the second one (ban-duration-area) is checked by the ban table
+                  extendBans(*runtime, config, {runtime->plate_tracker.releaseReported(plate_track, number)});
                 }
-                // update ban data
-                (*data_ptr)[k] = {banned_tp1, banned_tp2, banned_bbox};
-                if (is_banned)
+                const auto ban_stage = checkBan(*runtime, config, number, plate_box, now);
+                // a number at the second stage stays with the ban table, it's reported again once it changes its location
+                if (ban_stage != BanStage::SECOND)
+                  runtime->plate_tracker.setReported(plate_track, number, plate_box, now);
+                if (ban_stage != BanStage::NONE)
                   continue;
               }
 
@@ -629,10 +803,10 @@ properties:
                 static_cast<int32_t>(kpts[7]));
               plate_data[Api::PARAM_NUMBER] = number;
               plate_data[Api::PARAM_SCORE] = score;
-              plate_data[Api::PARAM_PLATE_TYPE] = PLATE_CLASSES[plate_class];
+              plate_data[Api::PARAM_PLATE_TYPE] = PLATE_FORMATS[plate_class].name;
               vehicle_data[Api::PARAM_PLATES_INFO].PushBack(std::move(plate_data));
               userver::formats::json::ValueBuilder plate_data_short;
-              plate_data_short[Api::PARAM_PLATE_TYPE] = PLATE_CLASSES[plate_class];
+              plate_data_short[Api::PARAM_PLATE_TYPE] = PLATE_FORMATS[plate_class].name;
               plate_data_short[Api::PARAM_NUMBER] = number;
               callback_info.PushBack(std::move(plate_data_short));
             }
@@ -660,15 +834,19 @@ properties:
           json_data[Api::PARAM_SCREENSHOT_URL] = absl::StrCat(local_config_.events_screenshots_url_prefix, path_suffix,
             uuid, screenshot_extension);
           json_data[Api::PARAM_EVENT_DATE] = log_date;
+          auto db_timer = timings.measure(STAGE_DB_INSERT);
           auto id_event = addEventLog(config.id_vstream, log_date, json_data.ExtractValue());
+          db_timer.stop();
 
           // write a screenshot to a file
+          auto file_timer = timings.measure(STAGE_FILE_WRITE);
           auto path_prefix = absl::StrCat(local_config_.events_screenshots_path, path_suffix);
           userver::fs::CreateDirectories(fs_task_processor_, path_prefix);
           auto path = absl::StrCat(path_prefix, uuid, screenshot_extension);
-          userver::fs::RewriteFileContents(fs_task_processor_, path, capture_response->body_view());
+          userver::fs::RewriteFileContents(fs_task_processor_, path, screenshot_data());
           userver::fs::Chmod(fs_task_processor_, path,
             boost::filesystem::perms::owner_read | boost::filesystem::perms::owner_write | boost::filesystem::perms::others_read | boost::filesystem::perms::others_write);
+          file_timer.stop();
 
           // send data to callback
           userver::formats::json::ValueBuilder json_callback;
@@ -680,6 +858,7 @@ properties:
           json_callback[Api::PARAM_HAS_SPECIAL] = has_special;
           try
           {
+            auto callback_timer = timings.measure(STAGE_CALLBACK);
             // clang-format off
             auto response = http_client_.CreateRequest()
               .post(config.callback_url)
@@ -703,10 +882,7 @@ properties:
         }
 
         if (has_special)
-        {
-          auto ban_special_data_ptr = ban_special_data.Lock();
-          (*ban_special_data_ptr)[vstream_key] = now + config.ban_duration;
-        }
+          runtime->ban_special_tp = now + config.ban_duration;
 
         if (has_failed && config.flag_save_failed)
         {
@@ -719,16 +895,13 @@ properties:
           userver::fs::CreateDirectories(fs_task_processor_, path_prefix);
           auto path = absl::StrCat(path_prefix, uuid, screenshot_extension);
           auto path_draw = absl::StrCat(path_prefix, uuid, "_draw", screenshot_extension);
-          userver::fs::RewriteFileContents(fs_task_processor_, path, capture_response->body_view());
+          userver::fs::RewriteFileContents(fs_task_processor_, path, screenshot_data());
           userver::fs::Chmod(fs_task_processor_, path,
             boost::filesystem::perms::owner_read | boost::filesystem::perms::owner_write | boost::filesystem::perms::others_read | boost::filesystem::perms::others_write);
 
           // draw failed license plates on the frame
-          if (!config.work_area.empty())
-          {
-            auto wa = convertToAbsolute(config.work_area, frame.cols, frame.rows);
-            polylines(frame, wa, true, cv::Scalar(0, 200, 0), 2);
-          }
+          if (!work_area.empty())
+            polylines(frame, work_area.polygons(), true, cv::Scalar(0, 200, 0), 2);
           for (const auto& [bbox, confidence, is_special, license_plates] : detected_vehicles)
           {
             std::vector<std::vector<cv::Point>> vehicle_polygons;
@@ -742,14 +915,14 @@ properties:
           plate_polygons_good.reserve(detected_plates.size());
           std::vector<std::vector<cv::Point>> plate_polygons_failed;
           plate_polygons_failed.reserve(detected_plates.size());
-          for (auto plate_ptr : detected_plates)
+          for (size_t i = 0; i < detected_plates.size(); ++i)
           {
-            auto& [bbox, confidence, kpts, plate_class, plate_numbers] = *plate_ptr;
+            const auto& kpts = detected_plates[i]->kpts;
             std::vector<cv::Point> p = {{static_cast<int>(kpts[0]), static_cast<int>(kpts[1])},
                 {static_cast<int>(kpts[2]), static_cast<int>(kpts[3])},
                 {static_cast<int>(kpts[4]), static_cast<int>(kpts[5])},
                 {static_cast<int>(kpts[6]), static_cast<int>(kpts[7])}};
-            if (plate_ptr->plate_numbers.empty())
+            if (is_plate_failed[i])
               plate_polygons_failed.push_back(p);
             else
               plate_polygons_good.push_back(p);
@@ -763,11 +936,8 @@ properties:
       }
 
       // for test draw on the frame
-      /*if (!config.work_area.empty())
-      {
-        auto wa = convertToAbsolute(config.work_area, frame.cols, frame.rows);
-        polylines(frame, wa, true, cv::Scalar(0, 200, 0), 2);
-      }
+      /*if (!work_area.empty())
+        polylines(frame, work_area.polygons(), true, cv::Scalar(0, 200, 0), 2);
       for (const auto& vehicle : detected_vehicles)
       {
         std::vector<std::vector<cv::Point>> vehicle_polygons;
@@ -803,7 +973,7 @@ properties:
           USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kError,
             "vstream_key = {};  delay for {}ms",
             vstream_key, config.delay_after_error.count());
-        nextPipeline(std::move(vstream_key), config.delay_after_error);
+        nextPipeline(std::move(vstream_key), std::move(runtime), config.delay_after_error);
       } else
         stopWorkflow(std::move(vstream_key));
 
@@ -815,18 +985,206 @@ properties:
         "End processPipeline: vstream_key = {};",
         vstream_key);
 
-    nextPipeline(std::move(vstream_key), config.delay_between_frames);
+    nextPipeline(std::move(vstream_key), std::move(runtime), config.delay_between_frames);
   }
 
   void Workflow::doBanMaintenance()
   {
     LOG_DEBUG_TO(logger_, "call doBanMaintenance");
     auto t_now = std::chrono::steady_clock::now();
-    auto data_ptr = ban_data.Lock();
-    absl::erase_if(*data_ptr,
-      [&t_now](const auto& item)
+    // every stream is locked only for removing its own expired entries
+    stream_runtimes.forEach(
+      [&t_now](const std::string&, StreamRuntime& runtime)
+      {
+        runtime.ban_table.Lock()->expire(t_now);
+      });
+
+    // release the runtime state of removed video streams with stopped workflows
+    const auto cache = vstreams_config_cache_.Get();
+    stream_runtimes.eraseIf(
+      [&cache](const std::string& vstream_key, const StreamRuntime& runtime)
+      {
+        return !cache->getData().contains(vstream_key) && !runtime.pipeline_state.Lock()->is_running;
+      });
+  }
+
+  // Description of the two-stage ban.
+  // If the system sees the number for the first time, then after processing it will fall into the first stage of the ban.
+  // At the first stage of the ban, the number is ignored regardless of its location in the frame.
+  // After some time (config ban-duration), the number falls into the second stage of the ban.
+  // At the second stage of the ban (config ban-duration-area), the number is also ignored until it changes its location in the frame.
+  // If at the second stage of the ban the number changes its location (config ban-iou-threshold), it will be processed and will again be included in the first stage.
+  Workflow::BanStage Workflow::checkBan(StreamRuntime& runtime, const VStreamConfig& config, const std::string& number, const cv::Rect2f& bbox,
+    const std::chrono::steady_clock::time_point now) const
+  {
+    auto ban_stage = BanStage::NONE;
+    auto banned_tp1 = now + config.ban_duration;
+    auto banned_tp2 = now + config.ban_duration_area;
+    auto banned_bbox = bbox;
+    auto table_ptr = runtime.ban_table.Lock();
+    if (const auto* entry = table_ptr->find(number, now))
+    {
+      if (entry->tp1 > now)
+      {
+        ban_stage = BanStage::FIRST;
+        if (config.logs_level <= userver::logging::Level::kDebug)
+          USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kDebug,
+            "vstream_key = {}_{};  plate number {} is banned at the first stage ({}s left)",
+            config.id_group, config.ext_id, number, std::chrono::duration_cast<std::chrono::seconds>(entry->tp1 - now).count());
+      } else
+      {
+        // check area ban
+        auto iou_value = iou(banned_bbox, entry->bbox);
+        if (iou_value > config.ban_iou_threshold)
+        {
+          ban_stage = BanStage::SECOND;
+          // extending the second stage of the ban
+          banned_bbox = entry->bbox;
+          banned_tp1 = entry->tp1;
+        }
+        if (config.logs_level <= userver::logging::Level::kDebug)
+        {
+          if (ban_stage == BanStage::SECOND)
+            USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kDebug,
+              "vstream_key = {}_{};  plate_number {} is banned at the second stage (iou = {:.2f}, threshold = {:.2f})",
+              config.id_group, config.ext_id, number, iou_value, config.ban_iou_threshold);
+          else
+            USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kDebug,
+              "vstream_key = {}_{};  plate_numbers {} was removed from the the second stage ban (iou = {:.2f}, threshold = {:.2f})",
+              config.id_group, config.ext_id, number, iou_value, config.ban_iou_threshold);
+        }
+      }
+    }
+    // update ban data
+    table_ptr->set(number, {banned_tp1, banned_tp2, banned_bbox});
+
+    return ban_stage;
+  }
+
+  void Workflow::extendBans(StreamRuntime& runtime, const VStreamConfig& config, const std::vector<PlateTracker::ReportedNumber>& reported_numbers) const
+  {
+    // the numbers reported by a track are banned from their last confirmation, as if they had been checked on every frame of the track
+    auto table_ptr = runtime.ban_table.Lock();
+    for (const auto& [number, plate_box, reported_tp] : reported_numbers)
+      table_ptr->set(number, {reported_tp + config.ban_duration, reported_tp + config.ban_duration_area, plate_box});
+  }
+
+  void Workflow::loadDNNStatsData()
+  {
+    const auto& f_name = local_config_.dnn_stats_path;
+    if (!std::filesystem::exists(f_name))
+      return;
+
+    try
+    {
+      std::fstream f(f_name);
+      auto json_data = userver::formats::json::FromStream(f);
+      dnn_stats_data.clear();
+      for (const auto& item : json_data["data"])
+        dnn_stats_data.findOrCreate(item["id_vstream"].As<int32_t>()).first->add(DNNStatsData{
+          item["vd_count"].As<int64_t>(),
+          item["vc_count"].As<int64_t>(),
+          item["lpd_count"].As<int64_t>(),
+          item["lpr_count"].As<int64_t>()});
+    } catch (const std::exception& e)
+    {
+      LOG_ERROR_TO(logger_) << e.what();
+    }
+  }
+
+  void Workflow::saveDNNStatsData() const
+  {
+    userver::formats::json::ValueBuilder list_data;
+    DNNStatsData all_data;
+    dnn_stats_data.forEach(
+      [&](const int32_t id_vstream, const DNNStatsCounters& counters)
       {
-        return item.second.tp2 < t_now;
+        const auto data = counters.load();
+        all_data.vd_count += data.vd_count;
+        all_data.vc_count += data.vc_count;
+        all_data.lpd_count += data.lpd_count;
+        all_data.lpr_count += data.lpr_count;
+        userver::formats::json::ValueBuilder v;
+        v["id_vstream"] = id_vstream;
+        v["vd_count"] = data.vd_count;
+        v["vc_count"] = data.vc_count;
+        v["lpd_count"] = data.lpd_count;
+        v["lpr_count"] = data.lpr_count;
+        list_data.PushBack(std::move(v));
+      });
+    userver::formats::json::ValueBuilder json_data;
+    json_data["all"]["vd_count"] = all_data.vd_count;
+    json_data["all"]["vc_count"] = all_data.vc_count;
+    json_data["all"]["lpd_count"] = all_data.lpd_count;
+    json_data["all"]["lpr_count"] = all_data.lpr_count;
+    json_data["data"] = std::move(list_data);
+    try
+    {
+      // write to a temporary file and rename it, so the previous data is never lost
+      std::lock_guard lock(dnn_stats_save_mutex_);
+      userver::fs::RewriteFileContentsAtomically(fs_task_processor_, local_config_.dnn_stats_path, ToString(json_data.ExtractValue()),
+        boost::filesystem::perms::owner_read | boost::filesystem::perms::owner_write | boost::filesystem::perms::group_read | boost::filesystem::perms::others_read);
+    } catch (const std::exception& e)
+    {
+      LOG_ERROR_TO(logger_) << e.what();
+    }
+  }
+
+  void Workflow::writeStatistics(userver::utils::statistics::Writer& writer) const
+  {
+    auto dnn_writer = writer["dnn"];
+    dnn_stats_data.forEach(
+      [&dnn_writer](const int32_t id_vstream, const DNNStatsCounters& counters)
+      {
+        const auto data = counters.load();
+        const auto label = std::to_string(id_vstream);
+        dnn_writer["vd_count"].ValueWithLabels(userver::utils::statistics::Rate{static_cast<uint64_t>(data.vd_count)}, userver::utils::statistics::LabelView{"id_vstream", label});
+        dnn_writer["vc_count"].ValueWithLabels(userver::utils::statistics::Rate{static_cast<uint64_t>(data.vc_count)}, userver::utils::statistics::LabelView{"id_vstream", label});
+        dnn_writer["lpd_count"].ValueWithLabels(userver::utils::statistics::Rate{static_cast<uint64_t>(data.lpd_count)}, userver::utils::statistics::LabelView{"id_vstream", label});
+        dnn_writer["lpr_count"].ValueWithLabels(userver::utils::statistics::Rate{static_cast<uint64_t>(data.lpr_count)}, userver::utils::statistics::LabelView{"id_vstream", label});
+      });
+
+    auto capture_writer = writer["capture"];
+    duplicate_frame_stats.forEach(
+      [&capture_writer](const int32_t id_vstream, const Ingest::DuplicateCounters& counters)
+      {
+        const auto captured_frames = counters.captured_frames.load(std::memory_order_relaxed);
+        const auto duplicate_frames = counters.duplicate_frames.load(std::memory_order_relaxed);
+        const auto label = std::to_string(id_vstream);
+        capture_writer["captured_frames"].ValueWithLabels(userver::utils::statistics::Rate{static_cast<uint64_t>(captured_frames)}, userver::utils::statistics::LabelView{"id_vstream", label});
+        capture_writer["duplicate_frames"].ValueWithLabels(userver::utils::statistics::Rate{static_cast<uint64_t>(duplicate_frames)}, userver::utils::statistics::LabelView{"id_vstream", label});
+        capture_writer["duplicate_ratio"].ValueWithLabels(captured_frames > 0 ? static_cast<double>(duplicate_frames) / static_cast<double>(captured_frames) : 0.0,
+          userver::utils::statistics::LabelView{"id_vstream", label});
+      });
+
+    auto scene_filter_writer = writer["scene_filter"];
+    scene_filter_stats.forEach(
+      [&scene_filter_writer](const int32_t id_vstream, const SceneFilter::Counters& counters)
+      {
+        const auto checked_frames = counters.checked_frames.load(std::memory_order_relaxed);
+        const auto skipped_frames = counters.skipped_frames.load(std::memory_order_relaxed);
+        const auto label = std::to_string(id_vstream);
+        scene_filter_writer["checked_frames"].ValueWithLabels(userver::utils::statistics::Rate{static_cast<uint64_t>(checked_frames)}, userver::utils::statistics::LabelView{"id_vstream", label});
+        scene_filter_writer["skipped_frames"].ValueWithLabels(userver::utils::statistics::Rate{static_cast<uint64_t>(skipped_frames)}, userver::utils::statistics::LabelView{"id_vstream", label});
+        scene_filter_writer["skip_ratio"].ValueWithLabels(checked_frames > 0 ? static_cast<double>(skipped_frames) / static_cast<double>(checked_frames) : 0.0,
+          userver::utils::statistics::LabelView{"id_vstream", label});
+      });
+
+    auto ban_writer = writer["ban"];
+    stream_runtimes.forEach(
+      [&ban_writer](const std::string& vstream_key, StreamRuntime& runtime)
+      {
+        ban_writer["table_size"].ValueWithLabels(static_cast<int64_t>(runtime.ban_table.Lock()->size()), userver::utils::statistics::LabelView{"vstream_key", vstream_key});
+      });
+
+    writer["simd"]["isa"].ValueWithLabels(1, {"isa", Simd::isaName(Simd::activeIsa())});
+
+    auto stage_writer = writer["pipeline"]["stage_latency"];
+    pipeline_timings.forEach(
+      [&stage_writer](const int32_t id_group, const PipelineTimings& timings)
+      {
+        const auto label = std::to_string(id_group);
+        timings.write(stage_writer, PIPELINE_STAGE_NAMES, {"id_group", label});
       });
   }
 
@@ -836,10 +1194,12 @@ properties:
     auto tp = std::chrono::system_clock::now() - local_config_.events_log_ttl;
     LOG_DEBUG_TO(logger_) << "delete event logs older than " << tp;
     const userver::storages::postgres::Query query{SQL_REMOVE_OLD_EVENTS};
+    const userver::storages::postgres::Query query_vstreams{SQL_REMOVE_DELETED_VSTREAMS};
     auto trx = pg_cluster_->Begin(userver::storages::postgres::ClusterHostType::kMaster, {});
     try
     {
       trx.Execute(query, userver::storages::postgres::TimePointTz{tp});
+      trx.Execute(query_vstreams, userver::storages::postgres::TimePointTz{tp});
       trx.Commit();
     } catch (std::exception& e)
     {
@@ -870,7 +1230,7 @@ properties:
         }
   }
 
-  void Workflow::nextPipeline(std::string&& vstream_key, const std::chrono::milliseconds delay)
+  void Workflow::nextPipeline(std::string&& vstream_key, std::shared_ptr<StreamRuntime>&& runtime, const std::chrono::milliseconds delay)
   {
     userver::engine::InterruptibleSleepFor(delay);
 
@@ -879,26 +1239,16 @@ properties:
 
     // scope for accessing concurrent variable
     {
-      const auto now = std::chrono::steady_clock::now();
-      auto data_ptr = vstream_timeouts.Lock();
-      if (data_ptr->contains(vstream_key))
-        if (data_ptr->at(vstream_key) < now)
-        {
-          data_ptr->erase(vstream_key);
-          is_timeout = true;
-        }
-    }
-
-    // scope for accessing concurrent variable
-    {
-      auto data_ptr = being_processed_vstreams.Lock();
-      if (data_ptr->contains(vstream_key))
+      auto state_ptr = runtime->pipeline_state.Lock();
+      if (state_ptr->timeout && state_ptr->timeout < std::chrono::steady_clock::now())
       {
-        if (data_ptr->at(vstream_key) && !is_timeout)
-          do_next = true;
-        else
-          data_ptr->erase(vstream_key);
+        state_ptr->timeout.reset();
+        is_timeout = true;
       }
+      if (state_ptr->is_running && state_ptr->is_active && !is_timeout)
+        do_next = true;
+      else
+        state_ptr->is_running = false;
     }
 
     if (is_timeout)
@@ -907,7 +1257,7 @@ properties:
         vstream_key);
 
     if (do_next)
-      tasks_.Detach(AsyncNoSpan(task_processor_, &Workflow::processPipeline, this, std::move(vstream_key)));
+      tasks_.Detach(AsyncNoSpan(task_processor_, &Workflow::processPipeline, this, std::move(vstream_key), std::move(runtime)));
   }
 
   // Inference pipeline methods
@@ -917,29 +1267,40 @@ properties:
     return preprocessImageForLpdNet(img, width, height, shift, scale);
   }
 
-    std::vector<float> Workflow::preprocessImageForVcNet(const cv::Mat& img, const int32_t width, const int32_t height)
+  std::vector<float> Workflow::preprocessImageForVcNet(const cv::Mat& img, const int32_t width, const int32_t height)
+  {
+    constexpr int32_t channels = 3;
+    std::vector<float> input_buffer(channels * width * height);
+    preprocessImageForVcNet(img, width, height, input_buffer.data());
+
+    return input_buffer;
+  }
+
+  void Workflow::preprocessImageForVcNet(const cv::Mat& img, const int32_t width, const int32_t height, float* input)
   {
     cv::Mat out(height, width, CV_8UC3);
     resize(img, out, out.size(), 0, 0, cv::INTER_AREA);
 
+    // (x / 255 - mean) / std
+    constexpr float means[] = {0.5f, 0.5f, 0.5f};
+    constexpr float std_d[] = {0.5f, 0.5f, 0.5f};
+    constexpr float alpha[] = {1.0f / (255.0f * std_d[0]), 1.0f / (255.0f * std_d[1]), 1.0f / (255.0f * std_d[2])};
+    constexpr float beta[] = {-means[0] / std_d[0], -means[1] / std_d[1], -means[2] / std_d[2]};
+    Simd::kernels().bgrToPlanarRgb(out.data, out.step, width, height, alpha, beta, input);
+  }
+
+  std::vector<float> Workflow::preprocessImageForLpdNet(const cv::Mat& img, const int32_t width, const int32_t height, cv::Point2f& shift,
+    double& scale)
+  {
     constexpr int32_t channels = 3;
-    const int32_t input_size = channels * width * height;
-    std::vector<float> input_buffer(input_size);
-    /*const std::vector<float> means = {0.485, 0.456, 0.406};
-    const std::vector<float> std_d = {0.229, 0.224, 0.225};*/
-    const std::vector<float> means = {0.5, 0.5, 0.5};
-    const std::vector<float> std_d = {0.5, 0.5, 0.5};
-    for (auto c = 0; c < channels; ++c)
-      for (auto h = 0; h < height; ++h)
-        for (auto w = 0; w < width; ++w)
-          input_buffer[c * height * width + h * width + w] =
-            (static_cast<float>(out.at<cv::Vec3b>(h, w)[2 - c]) / 255.0f - means[c]) / std_d[c];
+    std::vector<float> input_buffer(channels * width * height);
+    preprocessImageForLpdNet(img, width, height, shift, scale, input_buffer.data());
 
     return input_buffer;
   }
 
-  std::vector<float> Workflow::preprocessImageForLpdNet(const cv::Mat& img, const int32_t width, const int32_t height, cv::Point2f& shift,
-    double& scale)
+  void Workflow::preprocessImageForLpdNet(const cv::Mat& img, const int32_t width, const int32_t height, cv::Point2f& shift, double& scale,
+    float* input)
   {
     const auto r_w = width / (img.cols * 1.0);
     const auto r_h = height / (img.rows * 1.0);
@@ -966,19 +1327,23 @@ properties:
     // for test
     // cv::imwrite(absl::Substitute("p_$0_$1.jpg", border_left, border_top), out);
 
+    constexpr float alpha[] = {1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f};
+    constexpr float beta[] = {0.0f, 0.0f, 0.0f};
+    Simd::kernels().bgrToPlanarRgb(out.data, out.step, width, height, alpha, beta, input);
+  }
+
+  std::vector<float> Workflow::preprocessImageForLprNet(const cv::Mat& img, const int32_t width, const int32_t height, cv::Point2f& shift,
+    double& scale)
+  {
     constexpr int32_t channels = 3;
-    const int32_t input_size = channels * width * height;
-    std::vector<float> input_buffer(input_size);
-    for (auto c = 0; c < channels; ++c)
-      for (auto h = 0; h < height; ++h)
-        for (auto w = 0; w < width; ++w)
-          input_buffer[c * height * width + h * width + w] =
-            static_cast<float>(out.at<cv::Vec3b>(h, w)[2 - c]) / 255.0f;
+    std::vector<float> input_buffer(channels * width * height);
+    preprocessImageForLprNet(img, width, height, shift, scale, input_buffer.data());
 
     return input_buffer;
   }
 
-  std::vector<float> Workflow::preprocessImageForLprNet(const cv::Mat& img, const int32_t width, const int32_t height, cv::Point2f& shift, double& scale)
+  void Workflow::preprocessImageForLprNet(const cv::Mat& img, const int32_t width, const int32_t height, cv::Point2f& shift, double& scale,
+    float* input)
   {
     const auto r_w = width / (img.cols * 1.0);
     const auto r_h = height / (img.rows * 1.0);
@@ -1000,29 +1365,76 @@ properties:
     // for test
     // cv::imwrite("plate.jpg", out);
 
-    constexpr int32_t channels = 3;
-    const int32_t input_size = channels * width * height;
-    std::vector<float> input_buffer(input_size);
-    for (auto c = 0; c < channels; ++c)
-      for (auto h = 0; h < height; ++h)
-        for (auto w = 0; w < width; ++w)
-          input_buffer[c * height * width + h * width + w] =
-            static_cast<float>(out.at<cv::Vec3b>(h, w)[2 - c]) / 255.0f;
+    constexpr float alpha[] = {1.0f / 255.0f, 1.0f / 255.0f, 1.0f / 255.0f};
+    constexpr float beta[] = {0.0f, 0.0f, 0.0f};
+    Simd::kernels().bgrToPlanarRgb(out.data, out.step, width, height, alpha, beta, input);
+  }
 
-    return input_buffer;
+  std::vector<std::unique_ptr<Inference::Result>> Workflow::inferBatches(Inference::Client& client, const std::string& model_name,
+    const std::string& input_name, const std::vector<int64_t>& input_shape, const std::string& output_name, const std::vector<float>& arena,
+    const size_t count, const int32_t max_batch_size, std::vector<std::string>& errors) const
+  {
+    const auto batch_size = static_cast<size_t>(std::max(max_batch_size, 1));
+    const auto batch_count = (count + batch_size - 1) / batch_size;
+    const auto input_size = static_cast<size_t>(std::accumulate(input_shape.begin(), input_shape.end(), int64_t{1}, std::multiplies<>()));
+    const std::vector<std::string> output_names = {output_name};
+
+    std::vector<std::string> batch_errors(batch_count);
+    std::vector<userver::engine::TaskWithResult<std::unique_ptr<Inference::Result>>> tasks;
+    tasks.reserve(batch_count);
+    for (size_t bindex = 0; bindex < batch_count; ++bindex)
+      tasks.emplace_back(AsyncNoSpan(fs_task_processor_,
+        [&, bindex]
+        {
+          const auto first = bindex * batch_size;
+          std::vector<int64_t> shape = {static_cast<int64_t>(std::min(batch_size, count - first))};
+          shape.insert(shape.end(), input_shape.begin(), input_shape.end());
+          const std::vector<Inference::InputTensor> inputs = {{.name = input_name, .shape = std::move(shape), .data = arena.data() + first * input_size}};
+          return client.infer(model_name, inputs, output_names, batch_errors[bindex]);
+        }));
+    WaitAllChecked(tasks);
+
+    std::vector<std::unique_ptr<Inference::Result>> results;
+    results.reserve(batch_count);
+    errors.resize(count);
+    for (size_t bindex = 0; bindex < batch_count; ++bindex)
+    {
+      results.push_back(tasks[bindex].Get());
+      if (results.back() == nullptr)
+        for (size_t index = bindex * batch_size; index < std::min(count, (bindex + 1) * batch_size); ++index)
+          errors[index] = batch_errors[bindex];
+    }
+
+    return results;
+  }
+
+  const float* Workflow::batchOutputData(const std::vector<std::unique_ptr<Inference::Result>>& results, const std::string& output_name,
+    const size_t index, const size_t count, const int32_t max_batch_size)
+  {
+    const auto batch_size = static_cast<size_t>(std::max(max_batch_size, 1));
+    const auto& result = results[index / batch_size];
+    const float* data;
+    size_t data_size;
+    if (result == nullptr || !result->rawData(output_name, reinterpret_cast<const uint8_t**>(&data), &data_size))
+      return nullptr;
+
+    // the output records of the batch inputs follow one another
+    const auto first = index / batch_size * batch_size;
+    const auto record_size = data_size / sizeof(float) / std::min(batch_size, count - first);
+    return data + (index - first) * record_size;
   }
 
   bool Workflow::doInferenceVdNet(const cv::Mat& img, const VStreamConfig& config, std::vector<Vehicle>& detected_vehicles) const
   {
     detected_vehicles.clear();
 
-    std::unique_ptr<tc::InferenceServerHttpClient> triton_client;
-    auto err = tc::InferenceServerHttpClient::Create(&triton_client, config.vd_net_inference_server, false);
-    if (!err.IsOk())
+    std::string error;
+    const auto inference_client = inference_clients_->getClient(config.vd_net_inference_backend, config.vd_net_inference_server, error);
+    if (inference_client == nullptr)
     {
       LOG_ERROR_TO(logger_,
-        "Error! Unable to create inference client: {}",
-        err.Message());
+        "Error! {}",
+        error);
       return false;
     }
 
@@ -1039,45 +1451,10 @@ properties:
         "vstream_key = {}_{};  after preprocess image for VDNet",
         config.id_group, config.ext_id);
 
-    std::vector<uint8_t> input_data(config.vd_net_input_width * config.vd_net_input_height * 3 * sizeof(float));
-    memcpy(input_data.data(), input_buffer.data(), input_data.size());
-    std::vector<int64_t> shape = {1, 3, config.vd_net_input_height, config.vd_net_input_width};
-    tc::InferInput* input;
-    err = tc::InferInput::Create(&input, config.vd_net_input_tensor_name, shape, "FP32");
-    if (!err.IsOk())
-    {
-      LOG_ERROR_TO(logger_,
-        "Error! Unable to create input data: {}",
-        err.Message());
-      return false;
-    }
-    std::shared_ptr<tc::InferInput> input_ptr(input);
-
-    tc::InferRequestedOutput* output;
-    err = tc::InferRequestedOutput::Create(&output, config.vd_net_output_tensor_name);
-    if (!err.IsOk())
-    {
-      LOG_ERROR_TO(logger_,
-        "Error! Unable to create output data: {}",
-        err.Message());
-      return false;
-    }
-    std::shared_ptr<tc::InferRequestedOutput> output_ptr(output);
-
-    std::vector inputs = {input_ptr.get()};
-    std::vector<const tc::InferRequestedOutput*> outputs = {output_ptr.get()};
-    err = input_ptr->AppendRaw(input_data);
-    if (!err.IsOk())
-    {
-      LOG_ERROR_TO(logger_,
-        "Error! Unable to set up input data: {}",
-        err.Message());
-      return false;
-    }
-
-    tc::InferOptions options(config.vd_net_model_name);
-    options.model_version_ = "";
-    tc::InferResult* result;
+    const std::vector<Inference::InputTensor> inputs = {
+      {.name = config.vd_net_input_tensor_name, .shape = {1, 3, config.vd_net_input_height, config.vd_net_input_width}, .data = input_buffer.data()}};
+    const std::vector<std::string> output_names = {config.vd_net_output_tensor_name};
+    std::unique_ptr<Inference::Result> result_ptr;
 
     AsyncNoSpan(fs_task_processor_,
       [&]
@@ -1086,26 +1463,17 @@ properties:
           USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
             "vstream_key = {}_{};  before inference VDNet",
             config.id_group, config.ext_id);
-        err = triton_client->Infer(&result, options, inputs, outputs);
+        result_ptr = inference_client->infer(config.vd_net_model_name, inputs, output_names, error);
         if (config.logs_level <= userver::logging::Level::kTrace)
           USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
             "vstream_key = {}_{};  after inference VDNet",
             config.id_group, config.ext_id);
       }).Get();
-    if (!err.IsOk())
-    {
-      LOG_ERROR_TO(logger_,
-        "Error! Unable to send inference request: {}",
-        err.Message());
-      return false;
-    }
-
-    std::shared_ptr<tc::InferResult> result_ptr(result);
-    if (!result_ptr->RequestStatus().IsOk())
+    if (result_ptr == nullptr)
     {
       LOG_ERROR_TO(logger_,
-        "Error! Unable to receive inference result: {}",
-        err.Message());
+        "Error! {}",
+        error);
       return false;
     }
 
@@ -1116,7 +1484,7 @@ properties:
 
     const float* data;
     size_t data_size;
-    result_ptr->RawData(config.vd_net_output_tensor_name, reinterpret_cast<const uint8_t**>(&data), &data_size);
+    result_ptr->rawData(config.vd_net_output_tensor_name, reinterpret_cast<const uint8_t**>(&data), &data_size);
 
     // the output tensor has a dimension of [7, 8400]
     //  0 - bbox x_center
@@ -1170,28 +1538,22 @@ properties:
     return true;
   }
 
-  bool Workflow::doInferenceVcNet(const cv::Mat& img, const VStreamConfig& config, std::vector<Vehicle>& detected_vehicles) const
+  bool Workflow::doInferenceVcNet(const cv::Mat& img, const VStreamConfig& config, std::vector<Vehicle>& detected_vehicles,
+    std::vector<float>& arena) const
   {
-    std::vector<userver::engine::TaskWithResult<triton::client::Error>> tasks;
-    tasks.reserve(detected_vehicles.size());
-
-    std::vector<std::unique_ptr<tc::InferenceServerHttpClient>> triton_clients;
-    triton_clients.resize(detected_vehicles.size());
-
-    std::vector<tc::InferResult*> results;
-    results.resize(detected_vehicles.size());
-
-    std::vector<std::vector<uint8_t>> inputs_data;
-    inputs_data.resize(detected_vehicles.size());
-
-    std::vector<std::shared_ptr<tc::InferInput>> input_ptrs;
-    input_ptrs.reserve(detected_vehicles.size());
-
-    std::vector<std::shared_ptr<tc::InferRequestedOutput>> output_ptrs;
-    output_ptrs.reserve(detected_vehicles.size());
+    std::string error;
+    const auto inference_client = inference_clients_->getClient(config.vc_net_inference_backend, config.vc_net_inference_server, error);
+    if (inference_client == nullptr)
+    {
+      LOG_ERROR_TO(logger_,
+        "Error! {}",
+        error);
+      return false;
+    }
 
-    std::vector<tc::InferOptions> options;
-    options.reserve(detected_vehicles.size());
+    constexpr int32_t channels = 3;
+    const auto input_size = static_cast<size_t>(channels * config.vc_net_input_height * config.vc_net_input_width);
+    arena.resize(detected_vehicles.size() * input_size);
 
     if (config.logs_level <= userver::logging::Level::kTrace)
       USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
@@ -1200,15 +1562,6 @@ properties:
 
     for (size_t vindex = 0; vindex < detected_vehicles.size(); ++vindex)
     {
-      auto err = tc::InferenceServerHttpClient::Create(&triton_clients[vindex], config.lpr_net_inference_server, false);
-      if (!err.IsOk())
-      {
-        LOG_ERROR_TO(logger_,
-          "Error! Unable to create inference client: {}",
-          err.Message());
-        return false;
-      }
-
       const auto& [bbox, confidence, is_special, license_plates] = detected_vehicles[vindex];
       if (config.logs_level <= userver::logging::Level::kTrace)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
@@ -1216,55 +1569,17 @@ properties:
           config.id_group, config.ext_id, vindex);
       cv::Rect roi(cv::Point{static_cast<int>(bbox[0]), static_cast<int>(bbox[1])},
         cv::Point{static_cast<int>(bbox[2]), static_cast<int>(bbox[3])});
-      auto input_buffer = preprocessImageForVcNet(img(roi), config.vc_net_input_width, config.vc_net_input_height);
+      preprocessImageForVcNet(img(roi), config.vc_net_input_width, config.vc_net_input_height, arena.data() + vindex * input_size);
       if (config.logs_level <= userver::logging::Level::kTrace)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
           "vstream_key = {}_{};  after preprocess image {} for VcNet",
           config.id_group, config.ext_id, vindex);
-
-      inputs_data[vindex].resize(config.vc_net_input_width * config.vc_net_input_height * 3 * sizeof(float));
-      memcpy(inputs_data[vindex].data(), input_buffer.data(), inputs_data[vindex].size());
-      std::vector<int64_t> shape = {1, 3, config.vc_net_input_height, config.vc_net_input_width};
-      tc::InferInput* input;
-      err = tc::InferInput::Create(&input, config.vc_net_input_tensor_name, shape, "FP32");
-      if (!err.IsOk())
-      {
-        LOG_ERROR_TO(logger_,
-          "Error! Unable to create input data: {}",
-          err.Message());
-        return false;
-      }
-      input_ptrs.emplace_back(input);
-
-      tc::InferRequestedOutput* output;
-      err = tc::InferRequestedOutput::Create(&output, config.vc_net_output_tensor_name);
-      if (!err.IsOk())
-      {
-        LOG_ERROR_TO(logger_,
-          "Error! Unable to create output data: {}",
-          err.Message());
-        return false;
-      }
-      output_ptrs.emplace_back(output);
-
-      err = input_ptrs.back()->AppendRaw(inputs_data[vindex]);
-      if (!err.IsOk())
-      {
-        LOG_ERROR_TO(logger_,
-          "Error! Unable to set up input data: {}",
-          err.Message());
-        return false;
-      }
-      options.emplace_back(config.vc_net_model_name);
-      options.back().model_version_ = "";
-
-      tasks.emplace_back(AsyncNoSpan(fs_task_processor_,
-        [&, vindex]
-        {
-          return triton_clients[vindex]->Infer(&results[vindex], options[vindex], {input_ptrs[vindex].get()}, {output_ptrs[vindex].get()});
-        }));
     }
-    WaitAllChecked(tasks);
+
+    std::vector<std::string> errors;
+    const auto results = inferBatches(*inference_client, config.vc_net_model_name, config.vc_net_input_tensor_name,
+      {channels, config.vc_net_input_height, config.vc_net_input_width}, config.vc_net_output_tensor_name, arena, detected_vehicles.size(),
+      config.vc_net_max_batch_size, errors);
 
     if (config.logs_level <= userver::logging::Level::kTrace)
       USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
@@ -1279,27 +1594,15 @@ properties:
     bool is_ok = false;
     for (size_t vindex = 0; vindex < detected_vehicles.size(); ++vindex)
     {
-      if (auto err = tasks[vindex].Get(); !err.IsOk())
+      const float* data = batchOutputData(results, config.vc_net_output_tensor_name, vindex, detected_vehicles.size(), config.vc_net_max_batch_size);
+      if (data == nullptr)
       {
         LOG_ERROR_TO(logger_,
-          "Error! Unable to send inference request (vindex = {}): {}",
-          vindex, err.Message());
+          "Error! Unable to do inference (vindex = {}): {}",
+          vindex, errors[vindex]);
         continue;
       }
 
-      const std::shared_ptr<tc::InferResult> result_ptr(results[vindex]);
-      if (!result_ptr->RequestStatus().IsOk())
-      {
-        LOG_ERROR_TO(logger_,
-          "Error! Unable to receive inference result (vindex = {}): {}",
-          vindex, result_ptr->RequestStatus().Message());
-        continue;
-      }
-
-      const float* data;
-      size_t data_size;
-      result_ptr->RawData(config.vc_net_output_tensor_name, reinterpret_cast<const uint8_t**>(&data), &data_size);
-
       std::vector<float> scores;
       scores.assign(data, data + 2);
 
@@ -1324,28 +1627,22 @@ properties:
     return is_ok;
   }
 
-  bool Workflow::doInferenceLpdNet(const cv::Mat& img, const VStreamConfig& config, std::vector<Vehicle>& detected_vehicles)
+  bool Workflow::doInferenceLpdNet(const cv::Mat& img, const VStreamConfig& config, const WorkArea& work_area, std::vector<Vehicle>& detected_vehicles,
+    std::vector<float>& arena)
   {
-    std::vector<userver::engine::TaskWithResult<triton::client::Error>> tasks;
-    tasks.reserve(detected_vehicles.size());
-
-    std::vector<std::unique_ptr<tc::InferenceServerHttpClient>> triton_clients;
-    triton_clients.resize(detected_vehicles.size());
-
-    std::vector<tc::InferResult*> results;
-    results.resize(detected_vehicles.size());
-
-    std::vector<std::vector<uint8_t>> inputs_data;
-    inputs_data.resize(detected_vehicles.size());
-
-    std::vector<std::shared_ptr<tc::InferInput>> input_ptrs;
-    input_ptrs.reserve(detected_vehicles.size());
-
-    std::vector<std::shared_ptr<tc::InferRequestedOutput>> output_ptrs;
-    output_ptrs.reserve(detected_vehicles.size());
+    std::string error;
+    const auto inference_client = inference_clients_->getClient(config.lpd_net_inference_backend, config.lpd_net_inference_server, error);
+    if (inference_client == nullptr)
+    {
+      LOG_ERROR_TO(logger_,
+        "Error! {}",
+        error);
+      return false;
+    }
 
-    std::vector<tc::InferOptions> options;
-    options.reserve(detected_vehicles.size());
+    constexpr int32_t channels = 3;
+    const auto input_size = static_cast<size_t>(channels * config.lpd_net_input_height * config.lpd_net_input_width);
+    arena.resize(detected_vehicles.size() * input_size);
 
     std::vector<cv::Point2f> shifts;
     shifts.resize(detected_vehicles.size());
@@ -1360,14 +1657,6 @@ properties:
 
     for (size_t vindex = 0; vindex < detected_vehicles.size(); ++vindex)
     {
-      auto err = tc::InferenceServerHttpClient::Create(&triton_clients[vindex], config.lpd_net_inference_server, false);
-      if (!err.IsOk())
-      {
-        LOG_ERROR_TO(logger_,
-          "Error! Unable to create inference client: {}",
-          err.Message());
-        return false;
-      }
       const auto& [bbox, confidence, is_special, license_plates] = detected_vehicles[vindex];
       if (config.logs_level <= userver::logging::Level::kTrace)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
@@ -1379,56 +1668,18 @@ properties:
       // for test
       // cv::imwrite(absl::Substitute("for_lpd_net_$0_$1_$2_$3.jpg", roi.tl().x, roi.tl().y, roi.br().x, roi.br().y), img(roi));
 
-      auto input_buffer = preprocessImageForLpdNet(img(roi), config.lpd_net_input_width, config.lpd_net_input_height, shifts[vindex],
-        scales[vindex]);
+      preprocessImageForLpdNet(img(roi), config.lpd_net_input_width, config.lpd_net_input_height, shifts[vindex], scales[vindex],
+        arena.data() + vindex * input_size);
       if (config.logs_level <= userver::logging::Level::kTrace)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
           "vstream_key = {}_{};  after preprocess image {} for LPDNet",
           config.id_group, config.ext_id, vindex);
-
-      inputs_data[vindex].resize(config.lpd_net_input_width * config.lpd_net_input_height * 3 * sizeof(float));
-      memcpy(inputs_data[vindex].data(), input_buffer.data(), inputs_data[vindex].size());
-      std::vector<int64_t> shape = {1, 3, config.lpd_net_input_height, config.lpd_net_input_width};
-      tc::InferInput* input;
-      err = tc::InferInput::Create(&input, config.lpd_net_input_tensor_name, shape, "FP32");
-      if (!err.IsOk())
-      {
-        LOG_ERROR_TO(logger_,
-          "Error! Unable to create input data: {}",
-          err.Message());
-        return false;
-      }
-      input_ptrs.emplace_back(input);
-
-      tc::InferRequestedOutput* output;
-      err = tc::InferRequestedOutput::Create(&output, config.lpd_net_output_tensor_name);
-      if (!err.IsOk())
-      {
-        LOG_ERROR_TO(logger_,
-          "Error! Unable to create output data: {}",
-          err.Message());
-        return false;
-      }
-      output_ptrs.emplace_back(output);
-
-      err = input_ptrs.back()->AppendRaw(inputs_data[vindex]);
-      if (!err.IsOk())
-      {
-        LOG_ERROR_TO(logger_,
-          "Error! Unable to set up input data: {}",
-          err.Message());
-        return false;
-      }
-      options.emplace_back(config.lpd_net_model_name);
-      options.back().model_version_ = "";
-
-      tasks.emplace_back(AsyncNoSpan(fs_task_processor_,
-        [&, vindex]
-        {
-          return triton_clients[vindex]->Infer(&results[vindex], options[vindex], {input_ptrs[vindex].get()}, {output_ptrs[vindex].get()});
-        }));
     }
-    WaitAllChecked(tasks);
+
+    std::vector<std::string> errors;
+    const auto results = inferBatches(*inference_client, config.lpd_net_model_name, config.lpd_net_input_tensor_name,
+      {channels, config.lpd_net_input_height, config.lpd_net_input_width}, config.lpd_net_output_tensor_name, arena, detected_vehicles.size(),
+      config.lpd_net_max_batch_size, errors);
 
     if (config.logs_level <= userver::logging::Level::kTrace)
       USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
@@ -1438,70 +1689,23 @@ properties:
     bool is_ok = false;
     for (size_t vindex = 0; vindex < detected_vehicles.size(); ++vindex)
     {
-      if (auto err = tasks[vindex].Get(); !err.IsOk())
+      const float* data = batchOutputData(results, config.lpd_net_output_tensor_name, vindex, detected_vehicles.size(), config.lpd_net_max_batch_size);
+      if (data == nullptr)
       {
         LOG_ERROR_TO(logger_,
-          "Error! Unable to send inference request (vindex = {}): {}",
-          vindex, err.Message());
-        continue;
-      }
-
-      std::shared_ptr<tc::InferResult> result_ptr(results[vindex]);
-      if (!result_ptr->RequestStatus().IsOk())
-      {
-        LOG_ERROR_TO(logger_,
-          "Error! Unable to receive inference result (vindex = {}): {}",
-          vindex, result_ptr->RequestStatus().Message());
+          "Error! Unable to do inference (vindex = {}): {}",
+          vindex, errors[vindex]);
         continue;
       }
 
       auto& [bbox, confidence, is_special, license_plates] = detected_vehicles[vindex];
       auto& detected_plates = license_plates;
-      const float* data;
-      size_t data_size;
-      result_ptr->RawData(config.lpd_net_output_tensor_name, reinterpret_cast<const uint8_t**>(&data), &data_size);
-
-      // the output tensor has a dimension of [14, 8400], and each column contains:
-      //  0 - bbox x_center
-      //  1 - bbox y_center
-      //  2 - bbox width
-      //  3 - bbox height
-      //  4 - confidence of class 0
-      //  5 - confidence of class 1
-      //  6..13 - coordinates of four key points
-      auto num_rows = 12 + PLATE_CLASS_COUNT;  // 12 = 4 (bbox coordinates) + 8 (key points coordinates)
-      auto num_cols = 8400;
-      auto bbox_index = 0;
-      auto class_start_index = bbox_index + 4;
-      auto kpts_start_index = num_rows - 8;
+
       if (config.logs_level <= userver::logging::Level::kTrace)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
           "vstream_key = {}_{};  license plate confidence threshold (vindex = {}): {}",
           config.id_group, config.ext_id, vindex, config.plate_confidence);
-      for (auto j = 0; j < num_cols; ++j)
-        for (auto k = class_start_index; k < class_start_index + PLATE_CLASS_COUNT; ++k)
-          if (data[k * num_cols + j] > config.plate_confidence)
-          {
-            // calculating absolute coordinates of the license plate
-            detected_plates.emplace_back();
-            detected_plates.back().bbox[0] = bbox[0] + static_cast<float>((data[(bbox_index + 0) * num_cols + j] - data[(bbox_index + 2) * num_cols + j] / 2 - shifts[vindex].x) / scales[vindex]);
-            detected_plates.back().bbox[1] = bbox[1] + static_cast<float>((data[(bbox_index + 1) * num_cols + j] - data[(bbox_index + 3) * num_cols + j] / 2 - shifts[vindex].y) / scales[vindex]);
-            detected_plates.back().bbox[2] = bbox[0] + static_cast<float>((data[(bbox_index + 0) * num_cols + j] + data[(bbox_index + 2) * num_cols + j] / 2 - shifts[vindex].x) / scales[vindex]);
-            detected_plates.back().bbox[3] = bbox[1] + static_cast<float>((data[(bbox_index + 1) * num_cols + j] + data[(bbox_index + 3) * num_cols + j] / 2 - shifts[vindex].y) / scales[vindex]);
-            for (int l = 0; l < 8; ++l)
-            {
-              auto sh = shifts[vindex].x;
-              auto delta = bbox[0];
-              if (l % 2 == 1)
-              {
-                sh = shifts[vindex].y;
-                delta = bbox[1];
-              }
-              detected_plates.back().kpts[l] = delta + static_cast<float>((data[(kpts_start_index + l) * num_cols + j] - sh) / scales[vindex]);
-            }
-            detected_plates.back().confidence = data[k * num_cols + j];
-            detected_plates.back().plate_class = k - class_start_index;
-          }
+      detected_plates = decodeLpdNetPlates(data, config.plate_confidence, shifts[vindex], scales[vindex], {bbox[0], bbox[1]});
 
       if (config.logs_level <= userver::logging::Level::kTrace)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
@@ -1513,19 +1717,111 @@ properties:
           "vstream_key = {}_{};  after nms_plates count (vindex = {}): {}",
           config.id_group, config.ext_id, vindex, detected_plates.size());
 
-      // remove small detections or outside the work area
-      if (!config.work_area.empty() || config.min_plate_height > 0)
-        std::erase_if(detected_plates, [&config, this, img_width = img.cols, img_height = img.rows](const auto& plate)
+      removeUnsuitablePlates(config, work_area, detected_plates);
+
+      if (config.logs_level <= userver::logging::Level::kTrace)
+        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
+          "vstream_key = {}_{};  detected plate count (vindex = {}): {}",
+          config.id_group, config.ext_id, vindex, detected_plates.size());
+
+      is_ok = true;
+    }
+
+    return is_ok;
+  }
+
+  bool Workflow::doInferenceLpdNetOnFrame(const cv::Mat& img, const VStreamConfig& config, const std::vector<cv::Rect>& tiles, const WorkArea& work_area,
+    std::vector<Vehicle>& detected_vehicles, std::vector<float>& arena)
+  {
+    std::string error;
+    const auto inference_client = inference_clients_->getClient(config.lpd_net_inference_backend, config.lpd_net_inference_server, error);
+    if (inference_client == nullptr)
+    {
+      LOG_ERROR_TO(logger_,
+        "Error! {}",
+        error);
+      return false;
+    }
+
+    constexpr int32_t channels = 3;
+    const auto input_size = static_cast<size_t>(channels * config.lpd_net_input_height * config.lpd_net_input_width);
+    arena.resize(tiles.size() * input_size);
+
+    std::vector<cv::Point2f> shifts;
+    shifts.resize(tiles.size());
+
+    std::vector<double> scales;
+    scales.resize(tiles.size());
+
+    if (config.logs_level <= userver::logging::Level::kTrace)
+      USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
+        "vstream_key = {}_{};  before inference LPDNet on the frame ({} vehicles, {} tiles)",
+        config.id_group, config.ext_id, detected_vehicles.size(), tiles.size());
+
+    for (size_t tindex = 0; tindex < tiles.size(); ++tindex)
+      preprocessImageForLpdNet(img(tiles[tindex]), config.lpd_net_input_width, config.lpd_net_input_height, shifts[tindex], scales[tindex],
+        arena.data() + tindex * input_size);
+
+    std::vector<std::string> errors;
+    const auto results = inferBatches(*inference_client, config.lpd_net_model_name, config.lpd_net_input_tensor_name,
+      {channels, config.lpd_net_input_height, config.lpd_net_input_width}, config.lpd_net_output_tensor_name, arena, tiles.size(),
+      config.lpd_net_max_batch_size, errors);
+
+    if (config.logs_level <= userver::logging::Level::kTrace)
+      USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
+        "vstream_key = {}_{};  after inference LPDNet on the frame",
+        config.id_group, config.ext_id);
+
+    bool is_ok = false;
+    std::vector<LicensePlate> detected_plates;
+    for (size_t tindex = 0; tindex < tiles.size(); ++tindex)
+    {
+      const float* data = batchOutputData(results, config.lpd_net_output_tensor_name, tindex, tiles.size(), config.lpd_net_max_batch_size);
+      if (data == nullptr)
+      {
+        LOG_ERROR_TO(logger_,
+          "Error! Unable to do inference (tindex = {}): {}",
+          tindex, errors[tindex]);
+        continue;
+      }
+
+      auto tile_plates = decodeLpdNetPlates(data, config.plate_confidence, shifts[tindex], scales[tindex],
+        {static_cast<float>(tiles[tindex].x), static_cast<float>(tiles[tindex].y)});
+      detected_plates.insert(detected_plates.end(), std::make_move_iterator(tile_plates.begin()), std::make_move_iterator(tile_plates.end()));
+      is_ok = true;
+    }
+
+    // the overlapping tiles may detect the same plate twice
+    nms_plates(detected_plates);
+    removeUnsuitablePlates(config, work_area, detected_plates);
+    if (config.logs_level <= userver::logging::Level::kTrace)
+      USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
+        "vstream_key = {}_{};  detected plate count on the frame: {}",
+        config.id_group, config.ext_id, detected_plates.size());
+    assignPlatesToVehicles(std::move(detected_plates), detected_vehicles);
+
+    return is_ok;
+  }
+
+  void Workflow::removeUnsuitablePlates(const VStreamConfig& config, const WorkArea& work_area, std::vector<LicensePlate>& plates) const
+  {
+    // remove small detections or outside the work area
+    if (!work_area.empty() || config.min_plate_height > 0)
+      std::erase_if(plates, [&config, &work_area, this](const auto& plate)
+        {
+          auto do_erase = true;
+          if (!work_area.empty())
           {
-            auto do_erase = true;
-            if (!config.work_area.empty())
+            const std::vector<cv::Point2f> plate_polygon = {
+              {plate.kpts[0], plate.kpts[1]}, {plate.kpts[2], plate.kpts[3]}, {plate.kpts[4], plate.kpts[5]}, {plate.kpts[6], plate.kpts[7]}};
+
+            // the mask only rejects the plates whose bounding rectangle is completely outside the work area: it's the union
+            // of the polygons, and a plate has to fall completely into one of them, so the others need the exact polygon test
+            if (work_area.intersects(cv::boundingRect(plate_polygon)))
             {
-              const std::vector<cv::Point2f> plate_polygon = {
-                {plate.kpts[0], plate.kpts[1]}, {plate.kpts[2], plate.kpts[3]}, {plate.kpts[4], plate.kpts[5]}, {plate.kpts[6], plate.kpts[7]}};
               std::vector<cv::Point> intersection_polygon;
               const auto plate_area = intersectConvexConvex(plate_polygon, plate_polygon, intersection_polygon, true);
-
-              for (const auto wa = convertToAbsolute(config.work_area, img_width, img_height); const auto& v : wa)
+              for (const auto& v : work_area.polygons())
               {
                 constexpr auto threshold = 0.999;
                 intersection_polygon.clear();
@@ -1535,44 +1831,35 @@ properties:
                   break;
                 }
               }
-            } else
-              do_erase = false;
-
-            if (do_erase && config.logs_level <= userver::logging::Level::kTrace)
+            }
+          } else
+            do_erase = false;
+
+          if (do_erase && config.logs_level <= userver::logging::Level::kTrace)
+            USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
+              "vstream_key = {}_{};  license plate does not fall completely into the work area;  key points: [({:.2f}, {:.2f}) ({:.2f}, {:.2f}) ({:.2f}, {:.2f}) ({:.2f}, {:.2f})]",
+              config.id_group, config.ext_id,
+              plate.kpts[0], plate.kpts[1], plate.kpts[2], plate.kpts[3], plate.kpts[4], plate.kpts[5], plate.kpts[6], plate.kpts[7]);
+
+          // remove small license plate
+          if (!do_erase && config.min_plate_height > 0
+              && std::min(
+                   euclidean_distance(plate.kpts[0], plate.kpts[1], plate.kpts[6], plate.kpts[7]),
+                   euclidean_distance(plate.kpts[2], plate.kpts[3], plate.kpts[4], plate.kpts[5]))
+                   < config.min_plate_height)
+          {
+            do_erase = true;
+            if (config.logs_level <= userver::logging::Level::kTrace)
               USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
-                "vstream_key = {}_{};  license plate does not fall completely into the work area;  key points: [({:.2f}, {:.2f}) ({:.2f}, {:.2f}) ({:.2f}, {:.2f}) ({:.2f}, {:.2f})]",
+                "vstream_key = {}_{};  license plate height is too small;  key points: [({:.2f}, {:.2f}) ({:.2f}, {:.2f}) ({:.2f}, {:.2f}) ({:.2f}, {:.2f})]",
                 config.id_group, config.ext_id,
                 plate.kpts[0], plate.kpts[1], plate.kpts[2], plate.kpts[3], plate.kpts[4], plate.kpts[5], plate.kpts[6], plate.kpts[7]);
+          }
 
-            // remove small license plate
-            if (!do_erase && config.min_plate_height > 0
-                && std::min(
-                     euclidean_distance(plate.kpts[0], plate.kpts[1], plate.kpts[6], plate.kpts[7]),
-                     euclidean_distance(plate.kpts[2], plate.kpts[3], plate.kpts[4], plate.kpts[5]))
-                     < config.min_plate_height)
-            {
-              do_erase = true;
-              if (config.logs_level <= userver::logging::Level::kTrace)
-                USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
-                  "vstream_key = {}_{};  license plate height is too small;  key points: [({:.2f}, {:.2f}) ({:.2f}, {:.2f}) ({:.2f}, {:.2f}) ({:.2f}, {:.2f})]",
-                  config.id_group, config.ext_id,
-                  plate.kpts[0], plate.kpts[1], plate.kpts[2], plate.kpts[3], plate.kpts[4], plate.kpts[5], plate.kpts[6], plate.kpts[7]);
-            }
-
-            return do_erase; });
-
-      if (config.logs_level <= userver::logging::Level::kTrace)
-        USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
-          "vstream_key = {}_{};  detected plate count (vindex = {}): {}",
-          config.id_group, config.ext_id, vindex, detected_plates.size());
-
-      is_ok = true;
-    }
-
-    return is_ok;
+          return do_erase; });
   }
 
-  void Workflow::removeDuplicatePlates(const VStreamConfig& config, std::vector<Vehicle>& detected_vehicles, int32_t width, int32_t height) const
+  void Workflow::removeDuplicatePlates(const VStreamConfig& config, const WorkArea& work_area, std::vector<Vehicle>& detected_vehicles) const
   {
     for (int i = 0; i < static_cast<int>(detected_vehicles.size()) - 1; ++i)
       for (size_t j = i + 1; j < detected_vehicles.size(); ++j)
@@ -1631,89 +1918,211 @@ properties:
                }
              }
         }
-    std::erase_if(detected_vehicles, [&config, img_width = width, img_height = height](const auto& vehicle)
+    std::erase_if(detected_vehicles, [&work_area](const auto& vehicle)
       {
         auto do_erase = vehicle.license_plates.size() == 0 && !vehicle.is_special;
-        if (!config.work_area.empty() && !do_erase)
+        if (!work_area.empty() && !do_erase)
+          do_erase = !work_area.intersects(cv::Rect(cv::Point{static_cast<int>(vehicle.bbox[0]), static_cast<int>(vehicle.bbox[1])},
+            cv::Point{static_cast<int>(vehicle.bbox[2]), static_cast<int>(vehicle.bbox[3])}));
+        return do_erase;
+      });
+  }
+
+  std::vector<LicensePlate> Workflow::decodeLpdNetPlates(const float* data, const float plate_confidence, const cv::Point2f& shift, const double scale,
+    const cv::Point2f& offset)
+  {
+    std::vector<LicensePlate> plates;
+    // the output tensor has a dimension of [14, 8400], and each column contains:
+    //  0 - bbox x_center
+    //  1 - bbox y_center
+    //  2 - bbox width
+    //  3 - bbox height
+    //  4 - confidence of class 0
+    //  5 - confidence of class 1
+    //  6..13 - coordinates of four key points
+    auto num_rows = 12 + PLATE_CLASS_COUNT;  // 12 = 4 (bbox coordinates) + 8 (key points coordinates)
+    auto num_cols = 8400;
+    auto bbox_index = 0;
+    auto class_start_index = bbox_index + 4;
+    auto kpts_start_index = num_rows - 8;
+    for (auto j = 0; j < num_cols; ++j)
+      for (auto k = class_start_index; k < class_start_index + PLATE_CLASS_COUNT; ++k)
+        if (data[k * num_cols + j] > plate_confidence)
         {
-          bool has_intersection = false;
-          const std::vector<cv::Point2f> vehicle_polygon = {
-            {vehicle.bbox[0], vehicle.bbox[1]},
-            {vehicle.bbox[2], vehicle.bbox[1]},
-            {vehicle.bbox[2], vehicle.bbox[3]},
-            {vehicle.bbox[0], vehicle.bbox[3]}};
-          for (const auto wa = convertToAbsolute(config.work_area, img_width, img_height); const auto& v : wa)
+          // calculating absolute coordinates of the license plate
+          plates.emplace_back();
+          plates.back().bbox[0] = offset.x + static_cast<float>((data[(bbox_index + 0) * num_cols + j] - data[(bbox_index + 2) * num_cols + j] / 2 - shift.x) / scale);
+          plates.back().bbox[1] = offset.y + static_cast<float>((data[(bbox_index + 1) * num_cols + j] - data[(bbox_index + 3) * num_cols + j] / 2 - shift.y) / scale);
+          plates.back().bbox[2] = offset.x + static_cast<float>((data[(bbox_index + 0) * num_cols + j] + data[(bbox_index + 2) * num_cols + j] / 2 - shift.x) / scale);
+          plates.back().bbox[3] = offset.y + static_cast<float>((data[(bbox_index + 1) * num_cols + j] + data[(bbox_index + 3) * num_cols + j] / 2 - shift.y) / scale);
+          for (int l = 0; l < 8; ++l)
           {
-            std::vector<cv::Point> intersection_polygon;
-            intersectConvexConvex(v, vehicle_polygon, intersection_polygon, true);
-            if (intersection_polygon.size() >= 3)
+            auto sh = shift.x;
+            auto delta = offset.x;
+            if (l % 2 == 1)
             {
-              has_intersection = true;
-              break;
+              sh = shift.y;
+              delta = offset.y;
             }
+            plates.back().kpts[l] = delta + static_cast<float>((data[(kpts_start_index + l) * num_cols + j] - sh) / scale);
           }
-          do_erase = !has_intersection;
+          plates.back().confidence = data[k * num_cols + j];
+          plates.back().plate_class = k - class_start_index;
         }
-        return do_erase;
-      });
+
+    return plates;
   }
 
-  bool Workflow::isValidPlateNumber(const absl::string_view plate_number, const int32_t plate_class)
+  std::vector<cv::Rect> Workflow::lpdFrameTiles(const int32_t width, const int32_t height, const int32_t tile_size)
   {
-    if (plate_class == PLATE_CLASS_RU_1 || plate_class == PLATE_CLASS_RU_1A)
+    // the neighbouring tiles overlap at least by this part of the tile size, so a plate on the border fits into one of them completely
+    constexpr int32_t overlap_divisor = 8;
+
+    auto split = [tile_size](const int32_t length)
     {
-      const HashSet<char> numbers = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9'};
-      const HashSet<char> letters = {'A', 'B', 'C', 'E', 'H', 'K', 'M', 'O', 'P', 'T', 'X', 'Y'};
+      std::vector<std::pair<int32_t, int32_t>> spans;  // start and length
+      if (tile_size <= 0 || length <= tile_size)
+      {
+        spans.emplace_back(0, length);
+        return spans;
+      }
 
-      if (plate_number.size() < 8 || plate_number.size() > 9)
-        return false;
+      const int32_t overlap = tile_size / overlap_divisor;
+      const int32_t count = (length - overlap + tile_size - overlap - 1) / (tile_size - overlap);
+      for (int32_t i = 0; i < count; ++i)
+        spans.emplace_back(i * (length - tile_size) / (count - 1), tile_size);
+      return spans;
+    };
 
-      for (size_t i = 0; i < plate_number.size(); ++i)
-        if (i == 0 || i == 4 || i == 5)
-        {
-          if (!letters.contains(plate_number[i]))
-            return false;
-        } else
+    std::vector<cv::Rect> tiles;
+    for (const auto& [y, tile_height] : split(height))
+      for (const auto& [x, tile_width] : split(width))
+        tiles.emplace_back(x, y, tile_width, tile_height);
+
+    return tiles;
+  }
+
+  void Workflow::assignPlatesToVehicles(std::vector<LicensePlate>&& plates, std::vector<Vehicle>& vehicles)
+  {
+    for (auto& plate : plates)
+    {
+      const auto cx = (plate.bbox[0] + plate.bbox[2]) / 2.0f;
+      const auto cy = (plate.bbox[1] + plate.bbox[3]) / 2.0f;
+      Vehicle* owner = nullptr;
+      auto owner_area = std::numeric_limits<float>::max();
+      for (auto& vehicle : vehicles)
+        if (cx >= vehicle.bbox[0] && cx <= vehicle.bbox[2] && cy >= vehicle.bbox[1] && cy <= vehicle.bbox[3])
         {
-          if (!numbers.contains(plate_number[i]))
-            return false;
+          // the smallest of the overlapping vehicles is the nearest one
+          if (const auto area = (vehicle.bbox[2] - vehicle.bbox[0]) * (vehicle.bbox[3] - vehicle.bbox[1]); area < owner_area)
+          {
+            owner = &vehicle;
+            owner_area = area;
+          }
         }
+      if (owner != nullptr)
+        owner->license_plates.push_back(std::move(plate));
     }
-
-    return true;
   }
 
-  bool Workflow::doInferenceLprNet(const cv::Mat& img, const VStreamConfig& config, std::vector<LicensePlate*>& detected_plates)
+  std::vector<CharData> Workflow::decodeLprNetChars(const float* data, const float char_score, const cv::Point2f& shift, const double scale,
+    const int32_t plate_class)
   {
-    std::vector labels = {"0", "1", "2", "3", "4", "5", "6", "7", "8", "9", "A", "B", "C", "D", "E", "F", "G", "H", "I", "J", "K",
-      "L", "M", "N", "O", "P", "Q", "R", "S", "T", "U", "V", "W", "X", "Y", "Z", ""};
-
-    // scale values by plate class to calculate height of an image after perspective transformation
-    std::vector scale_height_by_plate_class = {
-      112.0f / 520.f,   // 0 - Russian type 1
-      170.0f / 290.0f,  // 1 - Russian type 1A
-    };
+    std::vector<CharData> chars_data;
+    auto num_rows = 4 + static_cast<int>(PLATE_ALPHABET.size());  // 4 (bbox coordinates) + char classes
+    auto num_cols = 525;
+    auto bbox_index = 0;
+    auto class_start_index = bbox_index + 4;
+    for (auto j = 0; j < num_cols; ++j)
+      for (auto k = class_start_index; k < num_rows; ++k)
+        if (data[k * num_cols + j] > char_score)
+        {
+          chars_data.emplace_back();
+          chars_data.back().bbox[0] = static_cast<float>(
+            (data[(bbox_index + 0) * num_cols + j] - data[(bbox_index + 2) * num_cols + j] / 2 - shift.x) / scale);
+          chars_data.back().bbox[1] = static_cast<float>(
+            (data[(bbox_index + 1) * num_cols + j] - data[(bbox_index + 3) * num_cols + j] / 2 - shift.y) / scale);
+          chars_data.back().bbox[2] = static_cast<float>(
+            (data[(bbox_index + 0) * num_cols + j] + data[(bbox_index + 2) * num_cols + j] / 2 - shift.x) / scale);
+          chars_data.back().bbox[3] = static_cast<float>(
+            (data[(bbox_index + 1) * num_cols + j] + data[(bbox_index + 3) * num_cols + j] / 2 - shift.y) / scale);
+
+          chars_data.back().confidence = data[k * num_cols + j];
+          chars_data.back().char_class = k - class_start_index;
+          chars_data.back().plate_class = plate_class;
+        }
 
-    std::vector<userver::engine::TaskWithResult<triton::client::Error>> tasks;
-    tasks.reserve(detected_plates.size());
+    return chars_data;
+  }
 
-    std::vector<std::unique_ptr<tc::InferenceServerHttpClient>> triton_clients;
-    triton_clients.resize(detected_plates.size());
+  void Workflow::assemblePlateNumbers(std::vector<CharData>& chars_data, const float char_iou_threshold, std::vector<PlateNumberData>& plate_numbers)
+  {
+    // a hypothesis score is the sum of the logarithms of its char confidences
+    struct Hypothesis
+    {
+      std::string number;
+      float log_score;
+    };
 
-    std::vector<tc::InferResult*> results;
-    results.resize(detected_plates.size());
+    std::ranges::sort(chars_data, cmp_chars_position);
+    HashSet<size_t> used_indices;
+    std::vector<Hypothesis> beam = {{"", 0.0f}};
+    std::vector<Hypothesis> candidates;
+    for (size_t i = 0; i < chars_data.size() && !beam.empty(); ++i)
+      if (!used_indices.contains(i))
+      {
+        std::vector<size_t> new_char_indices;
+        new_char_indices.push_back(i);
+        for (size_t j = i + 1; j < chars_data.size(); ++j)
+          if (!used_indices.contains(j))
+          {
+            auto r1 = cv::Rect2f(cv::Point2f{chars_data[i].bbox[0], chars_data[i].bbox[1]}, cv::Point2f{chars_data[i].bbox[2], chars_data[i].bbox[3]});
+            if (auto r2 = cv::Rect2f(cv::Point2f{chars_data[j].bbox[0], chars_data[j].bbox[1]}, cv::Point2f{chars_data[j].bbox[2], chars_data[j].bbox[3]}); iou(r1, r2) > char_iou_threshold)
+            {
+              new_char_indices.push_back(j);
+              used_indices.insert(j);
+            }
+          }
 
-    std::vector<std::vector<uint8_t>> inputs_data;
-    inputs_data.resize(detected_plates.size());
+        // every hypothesis is extended by every char of the position, the extensions breaking the plate grammar are dropped
+        // and only the best PLATE_BEAM_WIDTH ones are kept
+        candidates.clear();
+        for (const auto& [number, log_score] : beam)
+          for (const auto index : new_char_indices)
+          {
+            if (PLATE_GRAMMARS[chars_data[index].plate_class].accepts(number.size(), chars_data[index].char_class))
+              candidates.push_back({number + PLATE_ALPHABET[chars_data[index].char_class], log_score + std::log(chars_data[index].confidence)});
+          }
+        const auto count = std::min(candidates.size(), PLATE_BEAM_WIDTH);
+        std::ranges::partial_sort(candidates, candidates.begin() + static_cast<std::ptrdiff_t>(count),
+          [](const Hypothesis& a, const Hypothesis& b)
+          {
+            return a.log_score > b.log_score;
+          });
+        candidates.resize(count);
+        std::swap(beam, candidates);
+      }
 
-    std::vector<std::shared_ptr<tc::InferInput>> input_ptrs;
-    input_ptrs.reserve(detected_plates.size());
+    plate_numbers.reserve(plate_numbers.size() + beam.size());
+    for (auto& [number, log_score] : beam)
+      plate_numbers.push_back({std::move(number), std::exp(log_score)});
+  }
 
-    std::vector<std::shared_ptr<tc::InferRequestedOutput>> output_ptrs;
-    output_ptrs.reserve(detected_plates.size());
+  bool Workflow::doInferenceLprNet(const cv::Mat& img, const VStreamConfig& config, std::vector<LicensePlate*>& detected_plates, std::vector<float>& arena)
+  {
+    std::string error;
+    const auto inference_client = inference_clients_->getClient(config.lpr_net_inference_backend, config.lpr_net_inference_server, error);
+    if (inference_client == nullptr)
+    {
+      LOG_ERROR_TO(logger_,
+        "Error! {}",
+        error);
+      return false;
+    }
 
-    std::vector<tc::InferOptions> options;
-    options.reserve(detected_plates.size());
+    constexpr int32_t channels = 3;
+    const auto input_size = static_cast<size_t>(channels * config.lpr_net_input_height * config.lpr_net_input_width);
+    arena.resize(detected_plates.size() * input_size);
 
     std::vector<cv::Point2f> shifts;
     shifts.resize(detected_plates.size());
@@ -1728,14 +2137,6 @@ properties:
 
     for (size_t pindex = 0; pindex < detected_plates.size(); ++pindex)
     {
-      auto err = tc::InferenceServerHttpClient::Create(&triton_clients[pindex], config.lpr_net_inference_server, false);
-      if (!err.IsOk())
-      {
-        LOG_ERROR_TO(logger_,
-          "Error! Unable to create inference client: {}",
-          err.Message());
-        return false;
-      }
       auto& [bbox, confidence, kpts, plate_class, plate_numbers] = *detected_plates[pindex];
       if (config.logs_level <= userver::logging::Level::kTrace)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
@@ -1746,67 +2147,28 @@ properties:
       std::vector<cv::Point2f> dst = {
         {0.0f, 0.0f},
         {static_cast<float>(config.lpr_net_input_width - 1), 0.0f},
-        {static_cast<float>(config.lpr_net_input_width - 1), static_cast<float>(config.lpr_net_input_width) * scale_height_by_plate_class[plate_class] - 1},
-        {0.0f, static_cast<float>(config.lpr_net_input_width) * scale_height_by_plate_class[plate_class] - 1}};
+        {static_cast<float>(config.lpr_net_input_width - 1), static_cast<float>(config.lpr_net_input_width) * PLATE_FORMATS[plate_class].aspect_ratio - 1},
+        {0.0f, static_cast<float>(config.lpr_net_input_width) * PLATE_FORMATS[plate_class].aspect_ratio - 1}};
       auto transform_mat = cv::getPerspectiveTransform(src, dst);
       cv::Mat lp_image;
-      cv::warpPerspective(img, lp_image, transform_mat, {config.lpr_net_input_width, static_cast<int>(static_cast<float>(config.lpr_net_input_width) * scale_height_by_plate_class[plate_class])});
+      cv::warpPerspective(img, lp_image, transform_mat, {config.lpr_net_input_width, static_cast<int>(static_cast<float>(config.lpr_net_input_width) * PLATE_FORMATS[plate_class].aspect_ratio)});
 
       // for test
       // cv::imwrite(absl::Substitute("pp_$0.jpg", pindex), lp_image);
 
-      auto input_buffer = preprocessImageForLprNet(lp_image, config.lpr_net_input_width, config.lpr_net_input_height, shifts[pindex],
-        scales[pindex]);
+      preprocessImageForLprNet(lp_image, config.lpr_net_input_width, config.lpr_net_input_height, shifts[pindex], scales[pindex],
+        arena.data() + pindex * input_size);
 
       if (config.logs_level <= userver::logging::Level::kTrace)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
           "vstream_key = {}_{};  after preprocess image {} for LPRNet",
           config.id_group, config.ext_id, pindex);
-
-      inputs_data[pindex].resize(config.lpr_net_input_width * config.lpr_net_input_height * 3 * sizeof(float));
-      memcpy(inputs_data[pindex].data(), input_buffer.data(), inputs_data[pindex].size());
-      std::vector<int64_t> shape = {1, 3, config.lpr_net_input_height, config.lpr_net_input_width};
-      tc::InferInput* input;
-      err = tc::InferInput::Create(&input, config.lpr_net_input_tensor_name, shape, "FP32");
-      if (!err.IsOk())
-      {
-        LOG_ERROR_TO(logger_,
-          "Error! Unable to create input data: {}",
-          err.Message());
-        return false;
-      }
-      input_ptrs.emplace_back(input);
-
-      tc::InferRequestedOutput* output;
-      err = tc::InferRequestedOutput::Create(&output, config.lpr_net_output_tensor_name);
-      if (!err.IsOk())
-      {
-        LOG_ERROR_TO(logger_,
-          "Error! Unable to create output data: {}",
-          err.Message());
-        return false;
-      }
-      output_ptrs.emplace_back(output);
-
-      err = input_ptrs.back()->AppendRaw(inputs_data[pindex]);
-      if (!err.IsOk())
-      {
-        LOG_ERROR_TO(logger_,
-          "Error! Unable to set up input data: {}",
-          err.Message());
-        return false;
-      }
-
-      options.emplace_back(config.lpr_net_model_name);
-      options.back().model_version_ = "";
-
-      tasks.emplace_back(AsyncNoSpan(fs_task_processor_,
-        [&, pindex]
-        {
-          return triton_clients[pindex]->Infer(&results[pindex], options[pindex], {input_ptrs[pindex].get()}, {output_ptrs[pindex].get()});
-        }));
     }
-    WaitAllChecked(tasks);
+
+    std::vector<std::string> errors;
+    const auto results = inferBatches(*inference_client, config.lpr_net_model_name, config.lpr_net_input_tensor_name,
+      {channels, config.lpr_net_input_height, config.lpr_net_input_width}, config.lpr_net_output_tensor_name, arena, detected_plates.size(),
+      config.lpr_net_max_batch_size, errors);
 
     if (config.logs_level <= userver::logging::Level::kTrace)
       USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
@@ -1816,56 +2178,22 @@ properties:
     bool is_ok = false;
     for (size_t pindex = 0; pindex < detected_plates.size(); ++pindex)
     {
-      auto err = tasks[pindex].Get();
-      if (!err.IsOk())
-      {
-        LOG_ERROR_TO(logger_,
-          "Error! Unable to send inference request (vindex = {}): {}",
-          pindex, err.Message());
-        continue;
-      }
-
-      std::shared_ptr<tc::InferResult> result_ptr(results[pindex]);
-      if (!result_ptr->RequestStatus().IsOk())
+      const float* data = batchOutputData(results, config.lpr_net_output_tensor_name, pindex, detected_plates.size(), config.lpr_net_max_batch_size);
+      if (data == nullptr)
       {
         LOG_ERROR_TO(logger_,
-          "Error! Unable to receive inference result (vindex = {}): {}",
-          pindex, err.Message());
+          "Error! Unable to do inference (vindex = {}): {}",
+          pindex, errors[pindex]);
         continue;
       }
 
       auto& plate = *detected_plates[pindex];
-      const float* data;
-      size_t data_size;
-      result_ptr->RawData(config.lpr_net_output_tensor_name, reinterpret_cast<const uint8_t**>(&data), &data_size);
-
-      std::vector<CharData> chars_data;
-      auto num_rows = 40;
-      auto num_cols = 525;
-      auto bbox_index = 0;
-      auto class_start_index = bbox_index + 4;
+
       if (config.logs_level <= userver::logging::Level::kTrace)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
           "vstream_key = {}_{};  char score threshold: {:.2f}",
           config.id_group, config.ext_id, config.char_score);
-      for (auto j = 0; j < num_cols; ++j)
-        for (auto k = class_start_index; k < num_rows; ++k)
-          if (data[k * num_cols + j] > config.char_score)
-          {
-            chars_data.emplace_back();
-            chars_data.back().bbox[0] = static_cast<float>(
-              (data[(bbox_index + 0) * num_cols + j] - data[(bbox_index + 2) * num_cols + j] / 2 - shifts[pindex].x) / scales[pindex]);
-            chars_data.back().bbox[1] = static_cast<float>(
-              (data[(bbox_index + 1) * num_cols + j] - data[(bbox_index + 3) * num_cols + j] / 2 - shifts[pindex].y) / scales[pindex]);
-            chars_data.back().bbox[2] = static_cast<float>(
-              (data[(bbox_index + 0) * num_cols + j] + data[(bbox_index + 2) * num_cols + j] / 2 - shifts[pindex].x) / scales[pindex]);
-            chars_data.back().bbox[3] = static_cast<float>(
-              (data[(bbox_index + 1) * num_cols + j] + data[(bbox_index + 3) * num_cols + j] / 2 - shifts[pindex].y) / scales[pindex]);
-
-            chars_data.back().confidence = data[k * num_cols + j];
-            chars_data.back().char_class = k - class_start_index;
-            chars_data.back().plate_class = plate.plate_class;
-          }
+      auto chars_data = decodeLprNetChars(data, config.char_score, shifts[pindex], scales[pindex], plate.plate_class);
 
       if (config.logs_level <= userver::logging::Level::kTrace)
         USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
@@ -1878,44 +2206,13 @@ properties:
           config.id_group, config.ext_id, pindex, chars_data.size());
 
       // assembling license plate numbers from char data
-      std::ranges::sort(chars_data, cmp_chars_position);
-      HashSet<size_t> used_indices;
-      plate.plate_numbers.push_back({"", 1.0f});
-      for (size_t i = 0; i < chars_data.size(); ++i)
-        if (!used_indices.contains(i))
-        {
-          std::vector<size_t> new_char_indices;
-          new_char_indices.push_back(i);
-          for (size_t j = i + 1; j < chars_data.size(); ++j)
-            if (!used_indices.contains(j))
-            {
-              auto r1 = cv::Rect2f(cv::Point2f{chars_data[i].bbox[0], chars_data[i].bbox[1]}, cv::Point2f{chars_data[i].bbox[2], chars_data[i].bbox[3]});
-              if (auto r2 = cv::Rect2f(cv::Point2f{chars_data[j].bbox[0], chars_data[j].bbox[1]}, cv::Point2f{chars_data[j].bbox[2], chars_data[j].bbox[3]}); iou(r1, r2) > config.char_iou_threshold)
-              {
-                new_char_indices.push_back(j);
-                used_indices.insert(j);
-              }
-            }
-
-          if (new_char_indices.size() > 1)
-          {
-            auto copy_data = plate.plate_numbers;
-            for (size_t k = 1; k < new_char_indices.size(); ++k)
-              plate.plate_numbers.insert(plate.plate_numbers.end(), copy_data.begin(), copy_data.end());
-          }
-          for (size_t k = 0; k < plate.plate_numbers.size(); ++k)
-          {
-            auto m = k * new_char_indices.size() / plate.plate_numbers.size();
-            plate.plate_numbers[k].number += labels[chars_data[new_char_indices[m]].char_class];
-            plate.plate_numbers[k].score *= chars_data[new_char_indices[m]].confidence;
-          }
-        }
+      assemblePlateNumbers(chars_data, config.char_iou_threshold, plate.plate_numbers);
 
       // remove invalid numbers
       std::erase_if(plate.plate_numbers,
         [this, &plate, &config](const auto& item)
         {
-          auto is_valid = isValidPlateNumber(item.number, plate.plate_class);
+          auto is_valid = PLATE_GRAMMARS[plate.plate_class].matches(item.number);
           if (!is_valid)
             if (config.logs_level <= userver::logging::Level::kTrace)
               USERVER_IMPL_LOG_TO(logger_, userver::logging::Level::kTrace,
@@ -1,21 +1,29 @@
 #pragma once
 
-#include <absl/strings/string_view.h>
+#include <atomic>
+#include <optional>
+
 #include <userver/clients/http/component.hpp>
 #include <userver/concurrent/background_task_storage.hpp>
 #include <userver/concurrent/variable.hpp>
+#include <userver/engine/mutex.hpp>
 #include <userver/logging/component.hpp>
+#include <userver/utils/statistics/entry.hpp>
 
+#include "frame_ingest.hpp"
+#include "inference_client.hpp"
+#include "lprs_ban_table.hpp"
 #include "lprs_caches.hpp"
+#include "lprs_plate_grammar.hpp"
+#include "lprs_plate_tracker.hpp"
+#include "lprs_work_area.hpp"
+#include "rtsp_ingest.hpp"
+#include "scene_filter.hpp"
+#include "sharded_registry.hpp"
+#include "stage_timings.hpp"
 
 namespace Lprs
 {
-  // License plate classes
-  inline static constexpr char const* PLATE_CLASSES[] = {"ru_1", "ru_1a"};
-  inline static constexpr int32_t PLATE_CLASS_COUNT = 2;  // must be equal to the length of PLATE_CLASSES array
-  inline static constexpr int32_t PLATE_CLASS_RU_1 = 0;
-  inline static constexpr int32_t PLATE_CLASS_RU_1A = 1;
-
   namespace DatabaseFields
   {
     inline static constexpr auto ID_VSTREAM = "id_vstream";
@@ -34,12 +42,10 @@ namespace Lprs
     std::string events_screenshots_url_prefix;
     std::string failed_path;
     std::chrono::milliseconds failed_ttl{std::chrono::days{60}};
-  };
-
-  struct PlateNumberData
-  {
-    std::string number;
-    float score;
+    std::string dnn_stats_path;
+    std::chrono::milliseconds dnn_stats_save_interval{std::chrono::minutes{1}};
+    Inference::OnnxRuntimeOptions onnxruntime_options;
+    int32_t rtsp_decoder_pool_size{4};
   };
 
   struct LicensePlate
@@ -59,11 +65,100 @@ namespace Lprs
     int32_t plate_class;
   };
 
-  struct BannedPlateData
+  // pipeline stages with latency statistics
+  enum PipelineStage
+  {
+    STAGE_CAPTURE,
+    STAGE_DECODE,
+    STAGE_VD_INFERENCE,
+    STAGE_VC_INFERENCE,
+    STAGE_LPD_INFERENCE,
+    STAGE_POSTPROCESS,
+    STAGE_LPR_INFERENCE,
+    STAGE_DB_INSERT,
+    STAGE_FILE_WRITE,
+    STAGE_CALLBACK,
+    STAGE_COUNT
+  };
+
+  inline static constexpr std::array<std::string_view, STAGE_COUNT> PIPELINE_STAGE_NAMES = {
+    "capture",
+    "decode",
+    "vd_inference",
+    "vc_inference",
+    "lpd_inference",
+    "postprocess",
+    "lpr_inference",
+    "db_insert",
+    "file_write",
+    "callback"};
+
+  using PipelineTimings = StageTimings<STAGE_COUNT>;
+
+  // to collect inference statistics
+  struct DNNStatsData
+  {
+    int64_t vd_count{};
+    int64_t vc_count{};
+    int64_t lpd_count{};
+    int64_t lpr_count{};
+  };
+
+  struct DNNStatsCounters
   {
-    std::chrono::time_point<std::chrono::steady_clock> tp1;
-    std::chrono::time_point<std::chrono::steady_clock> tp2;
-    cv::Rect2f bbox;
+    std::atomic<int64_t> vd_count{};
+    std::atomic<int64_t> vc_count{};
+    std::atomic<int64_t> lpd_count{};
+    std::atomic<int64_t> lpr_count{};
+
+    void add(const DNNStatsData& data)
+    {
+      vd_count.fetch_add(data.vd_count, std::memory_order_relaxed);
+      vc_count.fetch_add(data.vc_count, std::memory_order_relaxed);
+      lpd_count.fetch_add(data.lpd_count, std::memory_order_relaxed);
+      lpr_count.fetch_add(data.lpr_count, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] DNNStatsData load() const
+    {
+      return {
+        vd_count.load(std::memory_order_relaxed),
+        vc_count.load(std::memory_order_relaxed),
+        lpd_count.load(std::memory_order_relaxed),
+        lpr_count.load(std::memory_order_relaxed)};
+    }
+  };
+
+  // Input tensors of the batched inference requests of a stream; they keep their capacity, so the frames don't allocate them again
+  struct TensorArena
+  {
+    std::vector<float> vc_net;
+    std::vector<float> lpd_net;
+    std::vector<float> lpr_net;
+  };
+
+  // Runtime state of a video stream which is kept between the workflow restarts
+  struct StreamRuntime
+  {
+    struct PipelineState
+    {
+      bool is_running{false};  // a pipeline task exists
+      bool is_active{false};  // the pipeline should continue with the next frame
+      std::optional<std::chrono::steady_clock::time_point> timeout;
+    };
+
+    userver::concurrent::Variable<PipelineState> pipeline_state;
+    userver::concurrent::Variable<BanTable> ban_table;
+
+    // Accessed only by the pipeline of the stream, which never runs concurrently with itself
+    std::optional<std::chrono::steady_clock::time_point> ban_special_tp;
+    std::unique_ptr<Ingest::MjpegReader> mjpeg_reader;  // capture mode "mjpeg"
+    std::unique_ptr<Ingest::RtspReader> rtsp_reader;  // capture mode "rtsp"
+    Ingest::DuplicateDetector duplicate_detector;
+    SceneFilter::Filter scene_filter;
+    PlateTracker plate_tracker;
+    TensorArena tensor_arena;
+    WorkArea work_area;
   };
 
   struct Vehicle
@@ -82,6 +177,7 @@ namespace Lprs
     static constexpr std::string_view kLogger = "lprs";
     std::string kBanMaintenanceName = "ban_maintenance";
     std::string kEventsLogMaintenanceName = "events_log_maintenance";
+    std::string kDNNStatsSaveName = "dnn_stats_save";
 
     // queries
     static constexpr auto SQL_ADD_EVENT = R"__SQL__(
@@ -92,59 +188,124 @@ namespace Lprs
       delete from events_log where log_date < $1;
     )__SQL__";
 
+    inline static constexpr auto SQL_REMOVE_DELETED_VSTREAMS = R"__SQL__(
+      delete from vstreams where flag_deleted and last_updated < $1;
+    )__SQL__";
+
     Workflow(const userver::components::ComponentConfig& config,
       const userver::components::ComponentContext& context);
+    ~Workflow() override;
     static userver::yaml_config::Schema GetStaticConfigSchema();
 
     void startWorkflow(std::string&& vstream_key);
     void stopWorkflow(std::string&& vstream_key, bool is_internal = true);
     const LocalConfig& getLocalConfig();
     const userver::logging::LoggerPtr& getLogger();
+    [[nodiscard]] std::shared_ptr<const PipelineTimings> getPipelineTimings(int32_t id_group) const;
+
+    // Stateless inference pipeline kernels (also used by the microbenchmarks)
+    static std::vector<float> preprocessImageForVdNet(const cv::Mat& img, int32_t width, int32_t height, cv::Point2f& shift, double& scale);
+    static std::vector<float> preprocessImageForVcNet(const cv::Mat& img, int32_t width, int32_t height);
+    static std::vector<float> preprocessImageForLpdNet(const cv::Mat& img, int32_t width, int32_t height, cv::Point2f& shift, double& scale);
+    static std::vector<float> preprocessImageForLprNet(const cv::Mat& img, int32_t width, int32_t height, cv::Point2f& shift, double& scale);
+
+    // the same kernels writing into an input of a batched tensor
+    static void preprocessImageForVcNet(const cv::Mat& img, int32_t width, int32_t height, float* input);
+    static void preprocessImageForLpdNet(const cv::Mat& img, int32_t width, int32_t height, cv::Point2f& shift, double& scale, float* input);
+    static void preprocessImageForLprNet(const cv::Mat& img, int32_t width, int32_t height, cv::Point2f& shift, double& scale, float* input);
+
+    // plates with the score above the threshold from LPDNet output, the coordinates are moved by the offset of the input image in the frame
+    static std::vector<LicensePlate> decodeLpdNetPlates(const float* data, float plate_confidence, const cv::Point2f& shift, double scale,
+      const cv::Point2f& offset);
+
+    // overlapping tiles of at most tile_size pixels covering the frame for LPDNet, the whole frame if tile_size is zero
+    static std::vector<cv::Rect> lpdFrameTiles(int32_t width, int32_t height, int32_t tile_size);
+
+    // assigns the plates detected on the frame to the smallest vehicles containing their centers, the plates out of the vehicles are dropped
+    static void assignPlatesToVehicles(std::vector<LicensePlate>&& plates, std::vector<Vehicle>& vehicles);
+
+    // chars with the score above the threshold from LPRNet output, the boxes are relative to the plate image
+    static std::vector<CharData> decodeLprNetChars(const float* data, float char_score, const cv::Point2f& shift, double scale,
+      int32_t plate_class);
+
+    // the maximum number of plate number variants kept while assembling a plate number
+    static constexpr size_t PLATE_BEAM_WIDTH = 16;
+
+    // assembles plate number variants from chars left after non-maximum suppression: overlapping chars are alternatives at the same position,
+    // the variants are decoded by a beam search pruned by the plate grammar at every position
+    static void assemblePlateNumbers(std::vector<CharData>& chars_data, float char_iou_threshold, std::vector<PlateNumberData>& plate_numbers);
 
   private:
     userver::concurrent::BackgroundTaskStorageCore tasks_;
     userver::engine::TaskProcessor& task_processor_;
     userver::engine::TaskProcessor& fs_task_processor_;
+    userver::engine::TaskProcessor& rtsp_task_processor_;  // the reading tasks of the RTSP streams
     userver::clients::http::Client& http_client_;
     const VStreamsConfigCache& vstreams_config_cache_;
     userver::storages::postgres::ClusterPtr pg_cluster_;
     userver::utils::PeriodicTask ban_maintenance_task_;
     userver::utils::PeriodicTask events_log_maintenance_task_;
+    userver::utils::PeriodicTask dnn_stats_save_task_;
     userver::logging::LoggerPtr logger_;
 
     LocalConfig local_config_;
+    std::unique_ptr<Inference::ClientFactory> inference_clients_;
+    std::unique_ptr<Ingest::DecoderPool> rtsp_decoders_;  // shared by the RTSP streams
 
-    userver::concurrent::Variable<HashMap<std::string, bool>> being_processed_vstreams;
-    userver::concurrent::Variable<HashMap<std::string, BannedPlateData>> ban_data;
-    userver::concurrent::Variable<HashMap<std::string, std::chrono::time_point<std::chrono::steady_clock>>> ban_special_data;
-    userver::concurrent::Variable<HashMap<std::string, std::chrono::time_point<std::chrono::steady_clock>>> vstream_timeouts;
+    ShardedRegistry<std::string, StreamRuntime> stream_runtimes;
+    ShardedRegistry<int32_t, DNNStatsCounters> dnn_stats_data;
+    ShardedRegistry<int32_t, Ingest::DuplicateCounters> duplicate_frame_stats;  // key is id_vstream
+    ShardedRegistry<int32_t, SceneFilter::Counters> scene_filter_stats;  // key is id_vstream
+    ShardedRegistry<int32_t, PipelineTimings> pipeline_timings;  // key is id_group
+    mutable userver::engine::Mutex dnn_stats_save_mutex_;
+    userver::utils::statistics::Entry statistics_holder_;
 
     void OnAllComponentsAreStopping() override;
-    void processPipeline(std::string&& vstream_key);
+    void processPipeline(std::string&& vstream_key, std::shared_ptr<StreamRuntime>&& runtime);
     void doBanMaintenance();
     void doEventsLogMaintenance() const;
-    void nextPipeline(std::string&& vstream_key, std::chrono::milliseconds delay);
-
-    // Inference pipeline methods
-    static std::vector<float> preprocessImageForVdNet(const cv::Mat& img, int32_t width, int32_t height, cv::Point2f& shift, double& scale);
-    static std::vector<float> preprocessImageForVcNet(const cv::Mat& img, int32_t width, int32_t height);
-    static std::vector<float> preprocessImageForLpdNet(const cv::Mat& img, int32_t width, int32_t height, cv::Point2f& shift, double& scale);
-    static std::vector<float> preprocessImageForLprNet(const cv::Mat& img, int32_t width, int32_t height, cv::Point2f& shift, double& scale);
+    void loadDNNStatsData();
+    void saveDNNStatsData() const;
+    void writeStatistics(userver::utils::statistics::Writer& writer) const;
+    void nextPipeline(std::string&& vstream_key, std::shared_ptr<StreamRuntime>&& runtime, std::chrono::milliseconds delay);
 
     // VDNet
     bool doInferenceVdNet(const cv::Mat& img, const VStreamConfig& config, std::vector<Vehicle>& detected_vehicles) const;
 
+    // Runs the model over count inputs of input_shape packed one after another in the arena, in concurrent batched requests
+    // of at most max_batch_size inputs; returns the result of every batch, nullptr on failure with the description in errors of its inputs
+    std::vector<std::unique_ptr<Inference::Result>> inferBatches(Inference::Client& client, const std::string& model_name, const std::string& input_name,
+      const std::vector<int64_t>& input_shape, const std::string& output_name, const std::vector<float>& arena, size_t count, int32_t max_batch_size,
+      std::vector<std::string>& errors) const;
+
+    // output data of the input with the index from the results of inferBatches, nullptr if its batch has failed
+    static const float* batchOutputData(const std::vector<std::unique_ptr<Inference::Result>>& results, const std::string& output_name, size_t index,
+      size_t count, int32_t max_batch_size);
+
     // VCNet
-    bool doInferenceVcNet(const cv::Mat& img, const VStreamConfig& config, std::vector<Vehicle>& detected_vehicles) const;
+    bool doInferenceVcNet(const cv::Mat& img, const VStreamConfig& config, std::vector<Vehicle>& detected_vehicles, std::vector<float>& arena) const;
 
     // LPDNet
-    bool doInferenceLpdNet(const cv::Mat& img, const VStreamConfig& config, std::vector<Vehicle>& detected_vehicles);
-    void removeDuplicatePlates(const VStreamConfig& config, std::vector<Vehicle>& detected_vehicles, int32_t width, int32_t height) const;
+    bool doInferenceLpdNet(const cv::Mat& img, const VStreamConfig& config, const WorkArea& work_area, std::vector<Vehicle>& detected_vehicles,
+      std::vector<float>& arena);
+    bool doInferenceLpdNetOnFrame(const cv::Mat& img, const VStreamConfig& config, const std::vector<cv::Rect>& tiles, const WorkArea& work_area,
+      std::vector<Vehicle>& detected_vehicles, std::vector<float>& arena);
+    void removeUnsuitablePlates(const VStreamConfig& config, const WorkArea& work_area, std::vector<LicensePlate>& plates) const;
+    void removeDuplicatePlates(const VStreamConfig& config, const WorkArea& work_area, std::vector<Vehicle>& detected_vehicles) const;
 
     // LPRNet
-    bool doInferenceLprNet(const cv::Mat& img, const VStreamConfig& config, std::vector<LicensePlate*>& detected_plates);
+    bool doInferenceLprNet(const cv::Mat& img, const VStreamConfig& config, std::vector<LicensePlate*>& detected_plates, std::vector<float>& arena);
 
-    static bool isValidPlateNumber(absl::string_view plate_number, int32_t plate_class);
+    // two-stage ban of the plate numbers across the tracks
+    enum class BanStage
+    {
+      NONE,
+      FIRST,
+      SECOND
+    };
+    BanStage checkBan(StreamRuntime& runtime, const VStreamConfig& config, const std::string& number, const cv::Rect2f& bbox,
+      std::chrono::steady_clock::time_point now) const;
+    void extendBans(StreamRuntime& runtime, const VStreamConfig& config, const std::vector<PlateTracker::ReportedNumber>& reported_numbers) const;
     int64_t addEventLog(int32_t id_vstream, const userver::storages::postgres::TimePointTz& log_date, const userver::formats::json::Value& info) const;
   };
 }  // namespace Lprs
@@ -7,6 +7,7 @@
 #include <userver/server/handlers/log_level.hpp>
 #include <userver/server/handlers/on_log_rotate.hpp>
 #include <userver/server/handlers/ping.hpp>
+#include <userver/server/handlers/server_monitor.hpp>
 #include <userver/testsuite/testsuite_support.hpp>
 #include <userver/utils/daemon_run.hpp>
 
@@ -52,6 +53,7 @@ int main(const int argc, char* argv[])
     .Append<userver::server::handlers::HttpHandlerStatic>()
     .Append<userver::server::handlers::LogLevel>()
     .Append<userver::server::handlers::OnLogRotate>()
+    .Append<userver::server::handlers::ServerMonitor>()
     .Append<userver::components::HttpClient>()
     .Append<userver::components::TestsuiteSupport>()
     .Append<userver::clients::dns::Component>();
@@ -0,0 +1,486 @@
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+#include <absl/strings/str_cat.h>
+#ifdef WITH_FFMPEG
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswscale/swscale.h>
+}
+#endif
+#include <userver/engine/async.hpp>
+#include <userver/engine/sleep.hpp>
+#include <userver/engine/task/cancel.hpp>
+
+#include "rtsp_ingest.hpp"
+
+namespace Ingest
+{
+  namespace
+  {
+    // opening a session includes the probing of the stream, so it takes longer than reading a packet
+    constexpr std::chrono::seconds CONNECT_TIMEOUT{10};
+
+    // a longer group of pictures is considered a broken stream, the packets are dropped until the next keyframe
+    constexpr size_t MAX_GOP_PACKETS = 1024;
+
+    // interrupts the blocking calls of libavformat on the reader destruction and on the read timeout
+    struct InterruptState
+    {
+      std::atomic<bool> is_stopped{false};
+      std::atomic<std::chrono::steady_clock::rep> deadline{0};
+
+      void setTimeout(const std::chrono::steady_clock::duration timeout)
+      {
+        deadline.store((std::chrono::steady_clock::now() + timeout).time_since_epoch().count(), std::memory_order_relaxed);
+      }
+    };
+
+#ifdef WITH_FFMPEG
+    std::atomic<uint64_t> last_stream_id{0};
+    std::once_flag network_init_flag;
+
+    struct PacketDeleter
+    {
+      void operator()(AVPacket* packet) const
+      {
+        av_packet_free(&packet);
+      }
+    };
+
+    struct CodecParametersDeleter
+    {
+      void operator()(AVCodecParameters* parameters) const
+      {
+        avcodec_parameters_free(&parameters);
+      }
+    };
+
+    using PacketPtr = std::shared_ptr<const AVPacket>;
+
+    std::string avError(const int code)
+    {
+      char buffer[AV_ERROR_MAX_STRING_SIZE]{};
+      av_strerror(code, buffer, sizeof(buffer));
+      return buffer;
+    }
+
+    int interruptCallback(void* opaque)
+    {
+      const auto* state = static_cast<const InterruptState*>(opaque);
+      return state->is_stopped.load(std::memory_order_relaxed)
+          || std::chrono::steady_clock::now().time_since_epoch().count() > state->deadline.load(std::memory_order_relaxed);
+    }
+#endif
+  }  // namespace
+
+  struct DecoderPool::Decoder
+  {
+#ifdef WITH_FFMPEG
+    AVCodecContext* context{nullptr};
+    AVFrame* frame{av_frame_alloc()};
+    AVFrame* last_frame{av_frame_alloc()};
+    SwsContext* sws_context{nullptr};
+#endif
+    uint64_t stream_id{0};  // the stream for which the codec context is opened
+
+#ifdef WITH_FFMPEG
+    ~Decoder()
+    {
+      sws_freeContext(sws_context);
+      av_frame_free(&last_frame);
+      av_frame_free(&frame);
+      avcodec_free_context(&context);
+    }
+
+    bool open(const uint64_t new_stream_id, const AVCodecParameters& parameters, std::string& error)
+    {
+      avcodec_free_context(&context);
+      stream_id = 0;
+      const AVCodec* codec = avcodec_find_decoder(parameters.codec_id);
+      if (codec == nullptr)
+      {
+        error = absl::StrCat("RTSP stream: unsupported codec ", avcodec_get_name(parameters.codec_id));
+        return false;
+      }
+
+      context = avcodec_alloc_context3(codec);
+      if (int ret = avcodec_parameters_to_context(context, &parameters); ret < 0)
+      {
+        error = absl::StrCat("RTSP stream: unable to set the codec parameters: ", avError(ret));
+        return false;
+      }
+
+      // the pool bounds the number of concurrent decodings, so each of them uses one thread
+      context->thread_count = 1;
+      if (int ret = avcodec_open2(context, codec, nullptr); ret < 0)
+      {
+        error = absl::StrCat("RTSP stream: unable to open the decoder: ", avError(ret));
+        return false;
+      }
+      stream_id = new_stream_id;
+
+      return true;
+    }
+
+    void receiveFrames()
+    {
+      while (avcodec_receive_frame(context, frame) == 0)
+      {
+        av_frame_unref(last_frame);
+        av_frame_move_ref(last_frame, frame);
+      }
+    }
+
+    // decodes the packets starting from a keyframe into the BGR image of the last frame
+    bool decode(const uint64_t packets_stream_id, const AVCodecParameters& parameters, const std::vector<PacketPtr>& packets,
+      cv::Mat& image, std::string& error)
+    {
+      if (context == nullptr || stream_id != packets_stream_id)
+      {
+        if (!open(packets_stream_id, parameters, error))
+          return false;
+      } else
+        avcodec_flush_buffers(context);
+
+      av_frame_unref(last_frame);
+      for (size_t i = 0; i < packets.size(); ++i)
+      {
+        // the frames before the last one are decoded only as references for it
+        context->skip_frame = i + 1 < packets.size() ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+        int ret;
+        while ((ret = avcodec_send_packet(context, packets[i].get())) == AVERROR(EAGAIN))
+          receiveFrames();
+        // a damaged packet spoils only the frames referring to it
+        if (ret == 0)
+          receiveFrames();
+      }
+      avcodec_send_packet(context, nullptr);
+      receiveFrames();
+
+      if (last_frame->width <= 0 || last_frame->height <= 0)
+      {
+        error = "RTSP stream: no frame is decoded";
+        return false;
+      }
+
+      const int width = last_frame->width;
+      const int height = last_frame->height;
+      sws_context = sws_getCachedContext(sws_context, width, height, static_cast<AVPixelFormat>(last_frame->format),
+        width, height, AV_PIX_FMT_BGR24, SWS_BILINEAR, nullptr, nullptr, nullptr);
+      if (sws_context == nullptr)
+      {
+        error = "RTSP stream: unsupported pixel format";
+        return false;
+      }
+      image.create(height, width, CV_8UC3);
+      uint8_t* const dst_data[] = {image.data};
+      const int dst_linesize[] = {static_cast<int>(image.step)};
+      sws_scale(sws_context, last_frame->data, last_frame->linesize, 0, height, dst_data, dst_linesize);
+      av_frame_unref(last_frame);
+
+      return true;
+    }
+#endif
+  };
+
+  struct RtspReader::Stream
+  {
+    InterruptState interrupt_state;
+
+    userver::engine::Mutex mutex;
+    userver::engine::ConditionVariable packet_ready;
+#ifdef WITH_FFMPEG
+    std::shared_ptr<const AVCodecParameters> codec_parameters;
+    std::vector<PacketPtr> packets;  // from the latest keyframe to the latest packet
+#endif
+    uint64_t stream_id{0};  // unique for every session, since the codec parameters can change
+    uint64_t sequence{0};  // number of the latest received packet
+    uint64_t keyframe_sequence{0};
+    uint64_t taken_sequence{0};
+    std::chrono::steady_clock::time_point keyframe_tp;  // zero until the first keyframe of the session
+    std::chrono::steady_clock::duration keyframe_interval{0};
+    std::string error;
+    std::chrono::steady_clock::time_point last_take_tp{std::chrono::steady_clock::now()};
+  };
+
+  DecoderPool::DecoderPool(const int32_t size)
+    : size_(static_cast<size_t>(std::max(size, 1)))
+  {
+  }
+
+  DecoderPool::~DecoderPool() = default;
+
+  std::unique_ptr<DecoderPool::Decoder> DecoderPool::acquire(const uint64_t stream_id, const std::chrono::milliseconds timeout)
+  {
+    std::unique_lock lock(mutex_);
+    if (!decoder_released_.WaitFor(lock, timeout, [this]
+          {
+            return !free_decoders_.empty() || created_ < size_;
+          }))
+      return nullptr;
+
+    // a decoder left opened for the stream avoids reopening of the codec
+    auto it = std::find_if(free_decoders_.begin(), free_decoders_.end(), [stream_id](const auto& decoder)
+      {
+        return decoder->stream_id == stream_id;
+      });
+    if (it == free_decoders_.end() && created_ < size_)
+    {
+      ++created_;
+      return std::make_unique<Decoder>();
+    }
+    if (it == free_decoders_.end())
+      it = std::prev(free_decoders_.end());
+
+    auto decoder = std::move(*it);
+    free_decoders_.erase(it);
+
+    return decoder;
+  }
+
+  void DecoderPool::release(std::unique_ptr<Decoder> decoder)
+  {
+    {
+      std::lock_guard lock(mutex_);
+      free_decoders_.emplace_back(std::move(decoder));
+    }
+    decoder_released_.NotifyOne();
+  }
+
+  RtspReader::RtspReader(DecoderPool& decoders, userver::engine::TaskProcessor& reader_task_processor,
+    userver::engine::TaskProcessor& blocking_task_processor, Options options)
+    : decoders_(decoders),
+      reader_task_processor_(reader_task_processor),
+      blocking_task_processor_(blocking_task_processor),
+      options_(std::move(options)),
+      stream_(std::make_unique<Stream>())
+  {
+#ifdef WITH_FFMPEG
+    task_ = userver::engine::AsyncNoSpan(reader_task_processor_, [this]
+      {
+        run();
+      });
+#endif
+  }
+
+  RtspReader::~RtspReader()
+  {
+    stream_->interrupt_state.is_stopped = true;
+    if (task_.IsValid())
+      task_.SyncCancel();
+  }
+
+  bool RtspReader::takeFrame(cv::Mat& frame, [[maybe_unused]] const std::chrono::milliseconds timeout, std::string& error)
+  {
+#ifdef WITH_FFMPEG
+    std::vector<PacketPtr> packets;
+    std::shared_ptr<const AVCodecParameters> codec_parameters;
+    uint64_t stream_id;
+    {
+      std::unique_lock lock(stream_->mutex);
+      stream_->last_take_tp = std::chrono::steady_clock::now();
+      if (!stream_->packet_ready.WaitFor(lock, timeout, [this]
+            {
+              return stream_->sequence > stream_->taken_sequence && !stream_->packets.empty();
+            }))
+      {
+        error = stream_->error.empty() ? "RTSP stream: no frame within the capture timeout" : stream_->error;
+        return false;
+      }
+
+      // at a low frame rate of the pipeline a keyframe not taken yet is recent enough, and it's decoded alone
+      if (stream_->keyframe_sequence > stream_->taken_sequence && stream_->keyframe_interval.count() > 0
+          && options_.frame_interval >= stream_->keyframe_interval)
+        packets.emplace_back(stream_->packets.front());
+      else
+        packets = stream_->packets;
+      codec_parameters = stream_->codec_parameters;
+      stream_id = stream_->stream_id;
+      stream_->taken_sequence = stream_->sequence;
+    }
+
+    auto decoder = decoders_.acquire(stream_id, timeout);
+    if (decoder == nullptr)
+    {
+      error = "RTSP stream: no free decoder within the capture timeout";
+      return false;
+    }
+
+    bool is_decoded = false;
+    try
+    {
+      is_decoded = userver::engine::AsyncNoSpan(blocking_task_processor_, [&]
+        {
+          return decoder->decode(stream_id, *codec_parameters, packets, frame, error);
+        }).Get();
+    } catch (...)
+    {
+      decoders_.release(std::move(decoder));
+      throw;
+    }
+    decoders_.release(std::move(decoder));
+
+    return is_decoded;
+#else
+    frame.release();
+    error = "Unable to use RTSP capture mode: the project is built without WITH_FFMPEG option";
+    return false;
+#endif
+  }
+
+  bool RtspReader::isRunning() const
+  {
+    return task_.IsValid() && !task_.IsFinished();
+  }
+
+  const RtspReader::Options& RtspReader::options() const
+  {
+    return options_;
+  }
+
+  void RtspReader::run()
+  {
+    while (!userver::engine::current_task::ShouldCancel() && !isIdle())
+    {
+      try
+      {
+        readStream();
+      } catch (const std::exception& e)
+      {
+        setError(e.what());
+      }
+
+      if (!isIdle())
+        userver::engine::InterruptibleSleepFor(options_.reconnect_delay);
+    }
+  }
+
+  void RtspReader::readStream()
+  {
+#ifdef WITH_FFMPEG
+    std::call_once(network_init_flag, []
+      {
+        avformat_network_init();
+      });
+
+    auto& interrupt_state = stream_->interrupt_state;
+    AVFormatContext* format_context = avformat_alloc_context();
+    format_context->interrupt_callback = {interruptCallback, &interrupt_state};
+    AVDictionary* format_options = nullptr;
+    av_dict_set(&format_options, "rtsp_transport", "tcp", 0);
+    av_dict_set_int(&format_options, "timeout", std::chrono::duration_cast<std::chrono::microseconds>(options_.read_timeout).count(), 0);
+    interrupt_state.setTimeout(std::max<std::chrono::steady_clock::duration>(CONNECT_TIMEOUT, options_.read_timeout));
+    int ret = avformat_open_input(&format_context, options_.url.c_str(), nullptr, &format_options);
+    av_dict_free(&format_options);
+    if (ret < 0)
+    {
+      setError(absl::StrCat("RTSP stream: unable to open the session: ", avError(ret)));
+      return;
+    }
+
+    const std::unique_ptr<AVFormatContext*, void (*)(AVFormatContext**)> format_context_guard(&format_context, avformat_close_input);
+    if (ret = avformat_find_stream_info(format_context, nullptr); ret < 0)
+    {
+      setError(absl::StrCat("RTSP stream: unable to get the stream info: ", avError(ret)));
+      return;
+    }
+
+    const int video_index = av_find_best_stream(format_context, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+    if (video_index < 0)
+    {
+      setError("RTSP stream: there is no video stream");
+      return;
+    }
+
+    std::shared_ptr<AVCodecParameters> codec_parameters(avcodec_parameters_alloc(), CodecParametersDeleter{});
+    if (ret = avcodec_parameters_copy(codec_parameters.get(), format_context->streams[video_index]->codecpar); ret < 0)
+    {
+      setError(absl::StrCat("RTSP stream: unable to copy the codec parameters: ", avError(ret)));
+      return;
+    }
+
+    {
+      std::lock_guard lock(stream_->mutex);
+      stream_->codec_parameters = std::move(codec_parameters);
+      stream_->stream_id = last_stream_id.fetch_add(1, std::memory_order_relaxed) + 1;
+      stream_->packets.clear();
+      stream_->keyframe_tp = {};
+      stream_->keyframe_interval = {};
+    }
+
+    const std::unique_ptr<AVPacket, PacketDeleter> packet(av_packet_alloc());
+    while (!userver::engine::current_task::ShouldCancel() && !isIdle())
+    {
+      interrupt_state.setTimeout(options_.read_timeout);
+      if (ret = av_read_frame(format_context, packet.get()); ret < 0)
+      {
+        setError(ret == AVERROR_EOF ? "RTSP stream: the session is closed by the camera"
+                                    : absl::StrCat("RTSP stream: unable to read a packet: ", avError(ret)));
+        return;
+      }
+      if (packet->stream_index != video_index)
+      {
+        av_packet_unref(packet.get());
+        continue;
+      }
+
+      const bool is_keyframe = (packet->flags & AV_PKT_FLAG_KEY) != 0;
+      AVPacket* received_packet = av_packet_alloc();
+      av_packet_move_ref(received_packet, packet.get());
+      const auto now = std::chrono::steady_clock::now();
+      {
+        std::lock_guard lock(stream_->mutex);
+        auto& packets = stream_->packets;
+        if (is_keyframe)
+        {
+          if (stream_->keyframe_tp != std::chrono::steady_clock::time_point{})
+            stream_->keyframe_interval = now - stream_->keyframe_tp;
+          stream_->keyframe_tp = now;
+          packets.clear();
+        } else if (packets.empty() || packets.size() >= MAX_GOP_PACKETS)
+        {
+          // can't be decoded without the keyframe
+          packets.clear();
+          av_packet_free(&received_packet);
+          continue;
+        }
+        packets.emplace_back(received_packet, PacketDeleter{});
+        ++stream_->sequence;
+        if (is_keyframe)
+          stream_->keyframe_sequence = stream_->sequence;
+        stream_->error.clear();
+      }
+      stream_->packet_ready.NotifyAll();
+    }
+#endif
+  }
+
+  void RtspReader::setError(std::string error)
+  {
+    std::lock_guard lock(stream_->mutex);
+    stream_->error = std::move(error);
+  }
+
+  bool RtspReader::isIdle()
+  {
+    std::lock_guard lock(stream_->mutex);
+    return std::chrono::steady_clock::now() - stream_->last_take_tp > options_.idle_timeout;
+  }
+
+  bool takeRtspFrame(std::unique_ptr<RtspReader>& reader, DecoderPool& decoders, userver::engine::TaskProcessor& reader_task_processor,
+    userver::engine::TaskProcessor& blocking_task_processor, const RtspReader::Options& options, cv::Mat& frame, std::string& error)
+  {
+    if (!reader || !reader->isRunning() || reader->options().url != options.url)
+    {
+      reader.reset();
+      reader = std::make_unique<RtspReader>(decoders, reader_task_processor, blocking_task_processor, options);
+    }
+
+    return reader->takeFrame(frame, options.read_timeout, error);
+  }
+}  // namespace Ingest
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <userver/engine/condition_variable.hpp>
+#include <userver/engine/mutex.hpp>
+#include <userver/engine/task/task_processor_fwd.hpp>
+#include <userver/engine/task/task_with_result.hpp>
+
+// Frame acquisition from RTSP video streams (available if the project is built with WITH_FFMPEG option).
+// The packets of a stream are received continuously, but a frame is decoded only when the pipeline takes it.
+namespace Ingest
+{
+  // Video decoders shared by the RTSP streams, the pool size bounds the number of frames decoded at once.
+  // Every decoding starts from a keyframe, so a decoder isn't bound to a stream and is reopened only when it passes to another one.
+  class DecoderPool
+  {
+  public:
+    struct Decoder;
+
+    explicit DecoderPool(int32_t size);
+    ~DecoderPool();
+
+    DecoderPool(const DecoderPool&) = delete;
+    DecoderPool& operator=(const DecoderPool&) = delete;
+
+    // a free decoder, preferably the last one used by the stream; nullptr if there is none within the timeout
+    std::unique_ptr<Decoder> acquire(uint64_t stream_id, std::chrono::milliseconds timeout);
+    void release(std::unique_ptr<Decoder> decoder);
+
+  private:
+    size_t size_;
+    size_t created_{0};
+    userver::engine::Mutex mutex_;
+    userver::engine::ConditionVariable decoder_released_;
+    std::vector<std::unique_ptr<Decoder>> free_decoders_;
+  };
+
+  // Keeps one RTSP session with a camera and the packets from the latest keyframe to the latest packet.
+  // The session is restored after errors, and the reader stops by itself if no frames have been taken for the idle timeout.
+  class RtspReader
+  {
+  public:
+    struct Options
+    {
+      std::string url;
+      std::chrono::milliseconds read_timeout{std::chrono::seconds{2}};  // no packets from the camera for this long breaks the session
+      std::chrono::milliseconds reconnect_delay{std::chrono::seconds{1}};
+      std::chrono::milliseconds idle_timeout{std::chrono::minutes{1}};
+
+      // period of taking frames by the pipeline: if it isn't shorter than the keyframe interval of the stream,
+      // only the latest keyframe is decoded instead of all the packets from it to the latest one
+      std::chrono::milliseconds frame_interval{0};
+    };
+
+    // the reading task occupies a thread of the reader task processor for the life of the reader,
+    // the decoding is done in the task processor for blocking operations
+    RtspReader(DecoderPool& decoders, userver::engine::TaskProcessor& reader_task_processor, userver::engine::TaskProcessor& blocking_task_processor,
+      Options options);
+    ~RtspReader();
+
+    RtspReader(const RtspReader&) = delete;
+    RtspReader& operator=(const RtspReader&) = delete;
+
+    // waits up to the timeout for a packet newer than the previously taken frame and decodes the frame;
+    // returns false with the last session or decoding error if there is no such frame
+    bool takeFrame(cv::Mat& frame, std::chrono::milliseconds timeout, std::string& error);
+
+    [[nodiscard]] bool isRunning() const;
+    [[nodiscard]] const Options& options() const;
+
+  private:
+    struct Stream;  // the received packets shared with the reading task
+
+    DecoderPool& decoders_;
+    userver::engine::TaskProcessor& reader_task_processor_;
+    userver::engine::TaskProcessor& blocking_task_processor_;
+    Options options_;
+    std::unique_ptr<Stream> stream_;
+
+    // the last member: the task uses the members above and is cancelled first on destruction
+    userver::engine::TaskWithResult<void> task_;
+
+    void run();
+    void readStream();
+    void setError(std::string error);
+    [[nodiscard]] bool isIdle();
+  };
+
+  // takes the latest frame of the RTSP stream, the reader is (re)started if it doesn't exist, has stopped or reads another URL;
+  // libav calls are blocking: every stream keeps a thread of the reader task processor, so its size limits the number of RTSP streams,
+  // and the decoding is done in the task processor for blocking operations
+  bool takeRtspFrame(std::unique_ptr<RtspReader>& reader, DecoderPool& decoders, userver::engine::TaskProcessor& reader_task_processor,
+    userver::engine::TaskProcessor& blocking_task_processor, const RtspReader::Options& options, cv::Mat& frame, std::string& error);
+}  // namespace Ingest
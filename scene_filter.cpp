@@ -0,0 +1,78 @@
+#include <opencv2/imgproc.hpp>
+
+#include "scene_filter.hpp"
+#include "simd_kernels.hpp"
+
+namespace SceneFilter
+{
+  cv::Mat makeThumbnail(const cv::Mat& frame, const cv::Rect& area, const std::vector<std::vector<cv::Point>>& polygons, cv::Mat& mask)
+  {
+    // downscaling before the color conversion is cheaper, and the area interpolation averages the sensor noise out
+    cv::Mat small;
+    cv::resize(frame(area), small, {THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT}, 0.0, 0.0, cv::INTER_AREA);
+    cv::Mat thumbnail;
+    if (small.channels() == 3)
+      cv::cvtColor(small, thumbnail, cv::COLOR_BGR2GRAY);
+    else
+      thumbnail = small;
+
+    if (polygons.empty())
+    {
+      mask.release();
+      return thumbnail;
+    }
+
+    const float scale_x = static_cast<float>(THUMBNAIL_WIDTH) / static_cast<float>(area.width);
+    const float scale_y = static_cast<float>(THUMBNAIL_HEIGHT) / static_cast<float>(area.height);
+    std::vector<std::vector<cv::Point>> thumbnail_polygons(polygons.size());
+    for (size_t i = 0; i < polygons.size(); ++i)
+    {
+      thumbnail_polygons[i].reserve(polygons[i].size());
+      for (const auto& point : polygons[i])
+        thumbnail_polygons[i].emplace_back(cvRound(static_cast<float>(point.x - area.x) * scale_x), cvRound(static_cast<float>(point.y - area.y) * scale_y));
+    }
+    mask = cv::Mat::zeros(THUMBNAIL_HEIGHT, THUMBNAIL_WIDTH, CV_8UC1);
+    cv::fillPoly(mask, thumbnail_polygons, cv::Scalar(255));
+    thumbnail.setTo(0, mask == 0);
+
+    return thumbnail;
+  }
+
+  float meanAbsoluteDifference(const cv::Mat& a, const cv::Mat& b, const cv::Mat& mask)
+  {
+    // the masked out pixels are zero in both thumbnails, so they add nothing to the sum
+    const auto size = a.total();
+    const auto pixel_count = mask.empty() ? size : static_cast<size_t>(cv::countNonZero(mask));
+    if (pixel_count == 0)
+      return 0.0f;
+
+    return static_cast<float>(Simd::kernels().sad(a.ptr<uint8_t>(), b.ptr<uint8_t>(), size)) / static_cast<float>(pixel_count);
+  }
+
+  bool Filter::isChanged(const cv::Mat& frame, const cv::Rect& work_area, const std::vector<std::vector<cv::Point>>& polygons, const float threshold)
+  {
+    const auto area = work_area & cv::Rect(0, 0, frame.cols, frame.rows);
+    if (area.empty())
+      return true;
+
+    cv::Mat mask;
+    auto thumbnail = makeThumbnail(frame, area, polygons, mask);
+    const bool is_comparable = !thumbnail_.empty() && frame.size() == frame_size_ && area == area_
+      && mask.size() == mask_.size() && (mask.empty() || cv::countNonZero(mask != mask_) == 0);
+    last_difference_ = is_comparable ? meanAbsoluteDifference(thumbnail, thumbnail_, mask) : 255.0f;
+    if (last_difference_ < threshold)
+      return false;
+
+    thumbnail_ = std::move(thumbnail);
+    mask_ = std::move(mask);
+    frame_size_ = frame.size();
+    area_ = area;
+
+    return true;
+  }
+
+  float Filter::lastDifference() const
+  {
+    return last_difference_;
+  }
+}  // namespace SceneFilter
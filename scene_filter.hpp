@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+// Prefilter of static scenes: a frame whose work area hasn't changed since the last processed frame is skipped before the inference
+namespace SceneFilter
+{
+  // size of the grayscale thumbnails being compared
+  inline constexpr int THUMBNAIL_WIDTH = 64;
+  inline constexpr int THUMBNAIL_HEIGHT = 48;
+
+  // grayscale thumbnail of the area (inside the frame); the pixels outside the polygons (in the frame coordinates, if any) are zero
+  cv::Mat makeThumbnail(const cv::Mat& frame, const cv::Rect& area, const std::vector<std::vector<cv::Point>>& polygons, cv::Mat& mask);
+
+  // mean absolute difference of the gray levels of two thumbnails over the nonzero pixels of the mask
+  float meanAbsoluteDifference(const cv::Mat& a, const cv::Mat& b, const cv::Mat& mask);
+
+  // The thumbnail of the last processed frame of a stream
+  class Filter
+  {
+  public:
+    // true if the frame differs from the last processed one by at least the threshold (gray levels from 0 to 255),
+    // then the frame becomes the last processed one; a frame of another size or area is always a change
+    bool isChanged(const cv::Mat& frame, const cv::Rect& work_area, const std::vector<std::vector<cv::Point>>& polygons, float threshold);
+
+    // the difference found by the last check
+    [[nodiscard]] float lastDifference() const;
+
+  private:
+    cv::Mat thumbnail_;
+    cv::Mat mask_;
+    cv::Size frame_size_;
+    cv::Rect area_;
+    float last_difference_{0.0f};
+  };
+
+  // to collect statistics of skipped frames
+  struct Counters
+  {
+    std::atomic<int64_t> checked_frames{};
+    std::atomic<int64_t> skipped_frames{};
+
+    void add(const bool is_skipped)
+    {
+      checked_frames.fetch_add(1, std::memory_order_relaxed);
+      if (is_skipped)
+        skipped_frames.fetch_add(1, std::memory_order_relaxed);
+    }
+  };
+}  // namespace SceneFilter
@@ -21,3 +21,4 @@ psql postgresql://$pg_user:$pg_passwd@$pg_host:$pg_port/$pg_db < $BASEDIR/../sql
 psql postgresql://$pg_user:$pg_passwd@$pg_host:$pg_port/$pg_db < $BASEDIR/../sql/frs/09_common_config.sql
 psql postgresql://$pg_user:$pg_passwd@$pg_host:$pg_port/$pg_db < $BASEDIR/../sql/frs/10_default_vstream_config.sql
 psql postgresql://$pg_user:$pg_passwd@$pg_host:$pg_port/$pg_db < $BASEDIR/../sql/frs/11_face_descriptors_new_column.sql
+psql postgresql://$pg_user:$pg_passwd@$pg_host:$pg_port/$pg_db < $BASEDIR/../sql/frs/12_config_last_updated.sql
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <absl/container/flat_hash_map.h>
+#include <absl/hash/hash.h>
+#include <userver/concurrent/variable.hpp>
+
+// Registry of shared objects split into independently locked shards,
+// so that operations on different keys rarely contend for the same mutex
+template <typename Key, typename Value, std::size_t ShardCount = 64>
+class ShardedRegistry
+{
+public:
+  using ShardData = absl::flat_hash_map<Key, std::shared_ptr<Value>>;
+
+  std::shared_ptr<Value> find(const Key& key) const
+  {
+    auto data_ptr = getShard(key).Lock();
+    if (const auto it = data_ptr->find(key); it != data_ptr->end())
+      return it->second;
+
+    return nullptr;
+  }
+
+  // returns an existing value or creates a new one; the flag is true for a created value
+  template <typename... Args>
+  std::pair<std::shared_ptr<Value>, bool> findOrCreate(const Key& key, Args&&... args)
+  {
+    auto data_ptr = getShard(key).Lock();
+    auto& value = (*data_ptr)[key];
+    if (value != nullptr)
+      return {value, false};
+
+    value = std::make_shared<Value>(std::forward<Args>(args)...);
+    return {value, true};
+  }
+
+  void erase(const Key& key)
+  {
+    auto data_ptr = getShard(key).Lock();
+    data_ptr->erase(key);
+  }
+
+  // predicate(key, value) is called under the lock of a shard
+  template <typename Predicate>
+  void eraseIf(Predicate&& predicate)
+  {
+    for (auto& shard : shards_)
+    {
+      auto data_ptr = shard.Lock();
+      absl::erase_if(*data_ptr,
+        [&predicate](const auto& item)
+        {
+          return predicate(item.first, *item.second);
+        });
+    }
+  }
+
+  // func(key, value) is called without holding any lock
+  template <typename Func>
+  void forEach(Func&& func) const
+  {
+    std::vector<std::pair<Key, std::shared_ptr<Value>>> items;
+    for (auto& shard : shards_)
+    {
+      // scope for accessing shard
+      {
+        auto data_ptr = shard.Lock();
+        items.assign(data_ptr->begin(), data_ptr->end());
+      }
+      for (const auto& [key, value] : items)
+        func(key, *value);
+    }
+  }
+
+  void clear()
+  {
+    for (auto& shard : shards_)
+    {
+      auto data_ptr = shard.Lock();
+      data_ptr->clear();
+    }
+  }
+
+private:
+  mutable std::array<userver::concurrent::Variable<ShardData>, ShardCount> shards_;
+
+  userver::concurrent::Variable<ShardData>& getShard(const Key& key) const
+  {
+    return shards_[absl::Hash<Key>{}(key) % ShardCount];
+  }
+};
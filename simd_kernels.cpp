@@ -0,0 +1,960 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "simd_kernels.hpp"
+
+namespace Simd
+{
+  namespace
+  {
+    // Fixed of the descriptor kernels is the size known at compile time, so the loops are unrolled and the tails are dropped;
+    // 0 - the size is the argument
+    constexpr bool hasTail(const size_t fixed, const size_t step)
+    {
+      return fixed == 0 || fixed % step != 0;
+    }
+
+    // Scalar kernels: the reference for the other instruction sets and the fallback
+    template <size_t Fixed>
+    float dotScalar(const float* a, const float* b, const size_t runtime_size)
+    {
+      const size_t size = Fixed == 0 ? runtime_size : Fixed;
+      float sum = 0.0f;
+      for (size_t i = 0; i < size; ++i)
+        sum += a[i] * b[i];
+      return sum;
+    }
+
+    template <size_t Fixed>
+    void dotAndNormsScalar(const float* a, const float* b, const size_t runtime_size, float& dot, float& norm_a, float& norm_b)
+    {
+      const size_t size = Fixed == 0 ? runtime_size : Fixed;
+      dot = norm_a = norm_b = 0.0f;
+      for (size_t i = 0; i < size; ++i)
+      {
+        dot += a[i] * b[i];
+        norm_a += a[i] * a[i];
+        norm_b += b[i] * b[i];
+      }
+    }
+
+    void bgrToPlanarRgbRow(const uint8_t* src, const int from, const int width, const float* alpha, const float* beta, float* dst_r,
+      float* dst_g, float* dst_b)
+    {
+      for (int x = from; x < width; ++x)
+      {
+        dst_r[x] = static_cast<float>(src[3 * x + 2]) * alpha[0] + beta[0];
+        dst_g[x] = static_cast<float>(src[3 * x + 1]) * alpha[1] + beta[1];
+        dst_b[x] = static_cast<float>(src[3 * x + 0]) * alpha[2] + beta[2];
+      }
+    }
+
+    void bgrToPlanarRgbScalar(const uint8_t* src, const size_t src_step, const int width, const int height, const float* alpha,
+      const float* beta, float* dst)
+    {
+      const size_t plane_size = static_cast<size_t>(width) * height;
+      for (int y = 0; y < height; ++y)
+      {
+        const size_t offset = static_cast<size_t>(y) * width;
+        bgrToPlanarRgbRow(src + y * src_step, 0, width, alpha, beta, dst + offset, dst + plane_size + offset, dst + 2 * plane_size + offset);
+      }
+    }
+
+    uint64_t sadScalar(const uint8_t* a, const uint8_t* b, const size_t size)
+    {
+      uint64_t sum = 0;
+      for (size_t i = 0; i < size; ++i)
+        sum += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+      return sum;
+    }
+
+    // pixels [from, to) of a row, the rows above and below are its neighbours for the Laplacian
+    void qualitySumsRow(const uint8_t* above, const uint8_t* row, const uint8_t* below, const int from, const int to, QualitySums& sums)
+    {
+      for (int x = from; x < to; ++x)
+      {
+        const int32_t laplacian = above[3 * x] + below[3 * x] + row[3 * x - 3] + row[3 * x + 3] - 4 * row[3 * x];
+        const int32_t luma = (LUMA_B * row[3 * x] + LUMA_G * row[3 * x + 1] + LUMA_R * row[3 * x + 2] + 128) >> 8;
+        sums.laplacian_sum += laplacian;
+        sums.laplacian_sq_sum += laplacian * laplacian;
+        sums.luma_sum += luma;
+        sums.luma_sq_sum += luma * luma;
+        sums.saturated_count += luma >= SATURATED_LUMA ? 1 : 0;
+      }
+    }
+
+    // the common part of the kernels: the empty sums for the images without inner pixels and the pixel count
+    bool startQualitySums(const int width, const int height, const int border, QualitySums& sums)
+    {
+      sums = {};
+      if (border < 1 || width <= 2 * border || height <= 2 * border)
+        return false;
+
+      sums.count = static_cast<int64_t>(width - 2 * border) * (height - 2 * border);
+      return true;
+    }
+
+    void qualitySumsScalar(const uint8_t* src, const size_t src_step, const int width, const int height, const int border, QualitySums& sums)
+    {
+      if (!startQualitySums(width, height, border, sums))
+        return;
+
+      for (int y = border; y < height - border; ++y)
+      {
+        const uint8_t* row = src + y * src_step;
+        qualitySumsRow(row - src_step, row, row + src_step, border, width - border, sums);
+      }
+    }
+
+    // the vector kernels keep the sums of a row in 32-bit lanes, which don't overflow for the rows up to this width
+    constexpr int MAX_VECTOR_ROW_WIDTH = 4096;
+
+    constexpr Kernels SCALAR_KERNELS{
+      .dot = dotScalar<0>,
+      .dotAndNorms = dotAndNormsScalar<0>,
+      .bgrToPlanarRgb = bgrToPlanarRgbScalar,
+      .sad = sadScalar,
+      .qualitySums = qualitySumsScalar,
+      .dim128 = {dotScalar<128>, dotAndNormsScalar<128>},
+      .dim256 = {dotScalar<256>, dotAndNormsScalar<256>},
+      .dim512 = {dotScalar<512>, dotAndNormsScalar<512>}};
+
+#if defined(__x86_64__) || defined(__i386__)
+    // pshufb masks splitting 16 interleaved BGR pixels (three 16-byte parts) into the channels
+    struct DeinterleaveMasks
+    {
+      alignas(16) int8_t values[3][3][16];  // channel, part, byte
+    };
+
+    constexpr DeinterleaveMasks makeDeinterleaveMasks()
+    {
+      DeinterleaveMasks masks{};
+      for (int channel = 0; channel < 3; ++channel)
+        for (int i = 0; i < 16; ++i)
+        {
+          const int index = 3 * i + channel;
+          for (int part = 0; part < 3; ++part)
+            masks.values[channel][part][i] = static_cast<int8_t>(index / 16 == part ? index % 16 : -128);
+        }
+      return masks;
+    }
+
+    constexpr DeinterleaveMasks DEINTERLEAVE_MASKS = makeDeinterleaveMasks();
+
+    // channels[0] is B, channels[1] is G, channels[2] is R
+    __attribute__((target("sse4.1,ssse3"))) inline void deinterleaveBgr(const uint8_t* src, __m128i channels[3])
+    {
+      const __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+      const __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+      const __m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+      for (int c = 0; c < 3; ++c)
+      {
+        const auto& masks = DEINTERLEAVE_MASKS.values[c];
+        channels[c] = _mm_or_si128(
+          _mm_or_si128(_mm_shuffle_epi8(p0, _mm_load_si128(reinterpret_cast<const __m128i*>(masks[0]))),
+            _mm_shuffle_epi8(p1, _mm_load_si128(reinterpret_cast<const __m128i*>(masks[1])))),
+          _mm_shuffle_epi8(p2, _mm_load_si128(reinterpret_cast<const __m128i*>(masks[2]))));
+      }
+    }
+
+    __attribute__((target("sse4.1,ssse3"))) inline __m128i extractChannel(const uint8_t* src, const int channel)
+    {
+      const auto& masks = DEINTERLEAVE_MASKS.values[channel];
+      return _mm_or_si128(
+        _mm_or_si128(_mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src)), _mm_load_si128(reinterpret_cast<const __m128i*>(masks[0]))),
+          _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16)), _mm_load_si128(reinterpret_cast<const __m128i*>(masks[1])))),
+        _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32)), _mm_load_si128(reinterpret_cast<const __m128i*>(masks[2]))));
+    }
+
+    __attribute__((target("sse4.1,ssse3"))) inline int64_t reduceSum(const __m128i v)
+    {
+      return static_cast<int64_t>(_mm_cvtsi128_si32(v)) + _mm_extract_epi32(v, 1) + _mm_extract_epi32(v, 2) + _mm_extract_epi32(v, 3);
+    }
+
+    __attribute__((target("sse4.1,ssse3"))) inline float reduceSum(const __m128 v)
+    {
+      __m128 shuffled = _mm_movehdup_ps(v);
+      __m128 sums = _mm_add_ps(v, shuffled);
+      shuffled = _mm_movehl_ps(shuffled, sums);
+      sums = _mm_add_ss(sums, shuffled);
+      return _mm_cvtss_f32(sums);
+    }
+
+    __attribute__((target("avx2,fma"))) inline float reduceSum(const __m256 v)
+    {
+      return reduceSum(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+    }
+
+    // SSE4
+    template <size_t Fixed>
+    __attribute__((target("sse4.1,ssse3"))) float dotSse4(const float* a, const float* b, const size_t runtime_size)
+    {
+      const size_t size = Fixed == 0 ? runtime_size : Fixed;
+      __m128 sum0 = _mm_setzero_ps();
+      __m128 sum1 = _mm_setzero_ps();
+      size_t i = 0;
+      for (; i + 8 <= size; i += 8)
+      {
+        sum0 = _mm_add_ps(sum0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        sum1 = _mm_add_ps(sum1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+      }
+      float sum = reduceSum(_mm_add_ps(sum0, sum1));
+      if constexpr (hasTail(Fixed, 8))
+        for (; i < size; ++i)
+          sum += a[i] * b[i];
+      return sum;
+    }
+
+    template <size_t Fixed>
+    __attribute__((target("sse4.1,ssse3"))) void dotAndNormsSse4(const float* a, const float* b, const size_t runtime_size, float& dot, float& norm_a,
+      float& norm_b)
+    {
+      const size_t size = Fixed == 0 ? runtime_size : Fixed;
+      __m128 sum_ab = _mm_setzero_ps();
+      __m128 sum_aa = _mm_setzero_ps();
+      __m128 sum_bb = _mm_setzero_ps();
+      size_t i = 0;
+      for (; i + 4 <= size; i += 4)
+      {
+        const __m128 va = _mm_loadu_ps(a + i);
+        const __m128 vb = _mm_loadu_ps(b + i);
+        sum_ab = _mm_add_ps(sum_ab, _mm_mul_ps(va, vb));
+        sum_aa = _mm_add_ps(sum_aa, _mm_mul_ps(va, va));
+        sum_bb = _mm_add_ps(sum_bb, _mm_mul_ps(vb, vb));
+      }
+      dot = reduceSum(sum_ab);
+      norm_a = reduceSum(sum_aa);
+      norm_b = reduceSum(sum_bb);
+      if constexpr (hasTail(Fixed, 4))
+        for (; i < size; ++i)
+        {
+          dot += a[i] * b[i];
+          norm_a += a[i] * a[i];
+          norm_b += b[i] * b[i];
+        }
+    }
+
+    __attribute__((target("sse4.1,ssse3"))) void bgrToPlanarRgbSse4(const uint8_t* src, const size_t src_step, const int width, const int height,
+      const float* alpha, const float* beta, float* dst)
+    {
+      const size_t plane_size = static_cast<size_t>(width) * height;
+      __m128 alphas[3];
+      __m128 betas[3];
+      for (int c = 0; c < 3; ++c)
+      {
+        alphas[c] = _mm_set1_ps(alpha[c]);
+        betas[c] = _mm_set1_ps(beta[c]);
+      }
+
+      for (int y = 0; y < height; ++y)
+      {
+        const uint8_t* row = src + y * src_step;
+        float* dst_planes[3];
+        for (int c = 0; c < 3; ++c)
+          dst_planes[c] = dst + c * plane_size + static_cast<size_t>(y) * width;
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+          __m128i channels[3];
+          deinterleaveBgr(row + 3 * x, channels);
+          for (int c = 0; c < 3; ++c)
+            for (int k = 0; k < 4; ++k)
+            {
+              // shift by an immediate value only
+              const __m128i bytes = k == 0 ? channels[2 - c]
+                : k == 1                   ? _mm_srli_si128(channels[2 - c], 4)
+                : k == 2                   ? _mm_srli_si128(channels[2 - c], 8)
+                                           : _mm_srli_si128(channels[2 - c], 12);
+              const __m128 values = _mm_cvtepi32_ps(_mm_cvtepu8_epi32(bytes));
+              _mm_storeu_ps(dst_planes[c] + x + 4 * k, _mm_add_ps(_mm_mul_ps(values, alphas[c]), betas[c]));
+            }
+        }
+        bgrToPlanarRgbRow(row, x, width, alpha, beta, dst_planes[0], dst_planes[1], dst_planes[2]);
+      }
+    }
+
+    // sum of the 64-bit halves; the 64-bit moves from a register (_mm_cvtsi128_si64, _mm_extract_epi64) don't exist on 32-bit x86
+    __attribute__((target("sse4.1,ssse3"))) inline uint64_t reduceSum64(const __m128i v)
+    {
+      alignas(16) uint64_t halves[2];
+      _mm_store_si128(reinterpret_cast<__m128i*>(halves), v);
+      return halves[0] + halves[1];
+    }
+
+    __attribute__((target("sse4.1,ssse3"))) uint64_t sadSse4(const uint8_t* a, const uint8_t* b, const size_t size)
+    {
+      // psadbw sums 8 absolute differences into each 64-bit half
+      __m128i sum = _mm_setzero_si128();
+      size_t i = 0;
+      for (; i + 16 <= size; i += 16)
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))));
+      return reduceSum64(sum) + sadScalar(a + i, b + i, size - i);
+    }
+
+    // 8 pixels of 16-bit channels: the Laplacian and the luma statistics are added to the 32-bit lanes of the row sums
+    // 16 bytes to the 16-bit values of the low and high halves
+    __attribute__((target("sse4.1,ssse3"))) inline void widen(const __m128i v, __m128i halves[2])
+    {
+      halves[0] = _mm_cvtepu8_epi16(v);
+      halves[1] = _mm_cvtepu8_epi16(_mm_srli_si128(v, 8));
+    }
+
+    __attribute__((target("sse4.1,ssse3"))) inline void addQualitySumsSse4(const __m128i laplacian, const __m128i b, const __m128i g, const __m128i r,
+      __m128i sums[5])
+    {
+      const __m128i ones = _mm_set1_epi16(1);
+      const __m128i luma = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(b, _mm_set1_epi16(LUMA_B)), _mm_mullo_epi16(g, _mm_set1_epi16(LUMA_G))),
+        _mm_add_epi16(_mm_mullo_epi16(r, _mm_set1_epi16(LUMA_R)), _mm_set1_epi16(128))), 8);
+      sums[0] = _mm_add_epi32(sums[0], _mm_madd_epi16(laplacian, ones));
+      sums[1] = _mm_add_epi32(sums[1], _mm_madd_epi16(laplacian, laplacian));
+      sums[2] = _mm_add_epi32(sums[2], _mm_madd_epi16(luma, ones));
+      sums[3] = _mm_add_epi32(sums[3], _mm_madd_epi16(luma, luma));
+      sums[4] = _mm_sub_epi32(sums[4], _mm_madd_epi16(_mm_cmpgt_epi16(luma, _mm_set1_epi16(SATURATED_LUMA - 1)), ones));
+    }
+
+    __attribute__((target("sse4.1,ssse3"))) void qualitySumsSse4(const uint8_t* src, const size_t src_step, const int width, const int height,
+      const int border, QualitySums& sums)
+    {
+      if (!startQualitySums(width, height, border, sums))
+        return;
+
+      for (int y = border; y < height - border; ++y)
+      {
+        const uint8_t* row = src + y * src_step;
+        const uint8_t* above = row - src_step;
+        const uint8_t* below = row + src_step;
+        __m128i row_sums[5] = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+
+        // the neighbour to the right of the last pixel is inside the image, so are the 16 pixels from it
+        int x = border;
+        for (; width <= MAX_VECTOR_ROW_WIDTH && x + 16 <= width - border; x += 16)
+        {
+          __m128i channels[3];
+          deinterleaveBgr(row + 3 * x, channels);
+          __m128i b[2], g[2], r[2], above_b[2], below_b[2], left_b[2], right_b[2];
+          widen(channels[0], b);
+          widen(channels[1], g);
+          widen(channels[2], r);
+          widen(extractChannel(above + 3 * x, 0), above_b);
+          widen(extractChannel(below + 3 * x, 0), below_b);
+          widen(extractChannel(row + 3 * (x - 1), 0), left_b);
+          widen(extractChannel(row + 3 * (x + 1), 0), right_b);
+          for (int k = 0; k < 2; ++k)
+            addQualitySumsSse4(_mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(above_b[k], below_b[k]), _mm_add_epi16(left_b[k], right_b[k])), _mm_slli_epi16(b[k], 2)),
+              b[k], g[k], r[k], row_sums);
+        }
+        sums.laplacian_sum += reduceSum(row_sums[0]);
+        sums.laplacian_sq_sum += reduceSum(row_sums[1]);
+        sums.luma_sum += reduceSum(row_sums[2]);
+        sums.luma_sq_sum += reduceSum(row_sums[3]);
+        sums.saturated_count += reduceSum(row_sums[4]);
+        qualitySumsRow(above, row, below, x, width - border, sums);
+      }
+    }
+
+    constexpr Kernels SSE4_KERNELS{
+      .dot = dotSse4<0>,
+      .dotAndNorms = dotAndNormsSse4<0>,
+      .bgrToPlanarRgb = bgrToPlanarRgbSse4,
+      .sad = sadSse4,
+      .qualitySums = qualitySumsSse4,
+      .dim128 = {dotSse4<128>, dotAndNormsSse4<128>},
+      .dim256 = {dotSse4<256>, dotAndNormsSse4<256>},
+      .dim512 = {dotSse4<512>, dotAndNormsSse4<512>}};
+
+    // AVX2 + FMA
+    template <size_t Fixed>
+    __attribute__((target("avx2,fma"))) float dotAvx2(const float* a, const float* b, const size_t runtime_size)
+    {
+      const size_t size = Fixed == 0 ? runtime_size : Fixed;
+      __m256 sum0 = _mm256_setzero_ps();
+      __m256 sum1 = _mm256_setzero_ps();
+      __m256 sum2 = _mm256_setzero_ps();
+      __m256 sum3 = _mm256_setzero_ps();
+      size_t i = 0;
+      for (; i + 32 <= size; i += 32)
+      {
+        sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+        sum1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), sum1);
+        sum2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), sum2);
+        sum3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), sum3);
+      }
+      for (; i + 8 <= size; i += 8)
+        sum0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), sum0);
+      float sum = reduceSum(_mm256_add_ps(_mm256_add_ps(sum0, sum1), _mm256_add_ps(sum2, sum3)));
+      if constexpr (hasTail(Fixed, 8))
+        for (; i < size; ++i)
+          sum += a[i] * b[i];
+      return sum;
+    }
+
+    template <size_t Fixed>
+    __attribute__((target("avx2,fma"))) void dotAndNormsAvx2(const float* a, const float* b, const size_t runtime_size, float& dot, float& norm_a,
+      float& norm_b)
+    {
+      const size_t size = Fixed == 0 ? runtime_size : Fixed;
+      __m256 sum_ab0 = _mm256_setzero_ps();
+      __m256 sum_aa0 = _mm256_setzero_ps();
+      __m256 sum_bb0 = _mm256_setzero_ps();
+      __m256 sum_ab1 = _mm256_setzero_ps();
+      __m256 sum_aa1 = _mm256_setzero_ps();
+      __m256 sum_bb1 = _mm256_setzero_ps();
+      size_t i = 0;
+      for (; i + 16 <= size; i += 16)
+      {
+        const __m256 va0 = _mm256_loadu_ps(a + i);
+        const __m256 vb0 = _mm256_loadu_ps(b + i);
+        const __m256 va1 = _mm256_loadu_ps(a + i + 8);
+        const __m256 vb1 = _mm256_loadu_ps(b + i + 8);
+        sum_ab0 = _mm256_fmadd_ps(va0, vb0, sum_ab0);
+        sum_aa0 = _mm256_fmadd_ps(va0, va0, sum_aa0);
+        sum_bb0 = _mm256_fmadd_ps(vb0, vb0, sum_bb0);
+        sum_ab1 = _mm256_fmadd_ps(va1, vb1, sum_ab1);
+        sum_aa1 = _mm256_fmadd_ps(va1, va1, sum_aa1);
+        sum_bb1 = _mm256_fmadd_ps(vb1, vb1, sum_bb1);
+      }
+      dot = reduceSum(_mm256_add_ps(sum_ab0, sum_ab1));
+      norm_a = reduceSum(_mm256_add_ps(sum_aa0, sum_aa1));
+      norm_b = reduceSum(_mm256_add_ps(sum_bb0, sum_bb1));
+      if constexpr (hasTail(Fixed, 16))
+        for (; i < size; ++i)
+        {
+          dot += a[i] * b[i];
+          norm_a += a[i] * a[i];
+          norm_b += b[i] * b[i];
+        }
+    }
+
+    __attribute__((target("avx2,fma"))) void bgrToPlanarRgbAvx2(const uint8_t* src, const size_t src_step, const int width, const int height,
+      const float* alpha, const float* beta, float* dst)
+    {
+      const size_t plane_size = static_cast<size_t>(width) * height;
+      __m256 alphas[3];
+      __m256 betas[3];
+      for (int c = 0; c < 3; ++c)
+      {
+        alphas[c] = _mm256_set1_ps(alpha[c]);
+        betas[c] = _mm256_set1_ps(beta[c]);
+      }
+
+      for (int y = 0; y < height; ++y)
+      {
+        const uint8_t* row = src + y * src_step;
+        float* dst_planes[3];
+        for (int c = 0; c < 3; ++c)
+          dst_planes[c] = dst + c * plane_size + static_cast<size_t>(y) * width;
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+          __m128i channels[3];
+          deinterleaveBgr(row + 3 * x, channels);
+          for (int c = 0; c < 3; ++c)
+          {
+            const __m256 low = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(channels[2 - c]));
+            const __m256 high = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(channels[2 - c], 8)));
+            _mm256_storeu_ps(dst_planes[c] + x, _mm256_fmadd_ps(low, alphas[c], betas[c]));
+            _mm256_storeu_ps(dst_planes[c] + x + 8, _mm256_fmadd_ps(high, alphas[c], betas[c]));
+          }
+        }
+        bgrToPlanarRgbRow(row, x, width, alpha, beta, dst_planes[0], dst_planes[1], dst_planes[2]);
+      }
+    }
+
+    __attribute__((target("avx2,fma"))) uint64_t sadAvx2(const uint8_t* a, const uint8_t* b, const size_t size)
+    {
+      __m256i sum = _mm256_setzero_si256();
+      size_t i = 0;
+      for (; i + 32 <= size; i += 32)
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i))));
+      const __m128i half_sum = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+      return reduceSum64(half_sum) + sadScalar(a + i, b + i, size - i);
+    }
+
+    __attribute__((target("avx2,fma"))) inline int64_t reduceSum(const __m256i v)
+    {
+      return reduceSum(_mm256_castsi256_si128(v)) + reduceSum(_mm256_extracti128_si256(v, 1));
+    }
+
+    // 16 pixels at once: a register of 16-bit channels
+    __attribute__((target("avx2,fma"))) void qualitySumsAvx2(const uint8_t* src, const size_t src_step, const int width, const int height,
+      const int border, QualitySums& sums)
+    {
+      if (!startQualitySums(width, height, border, sums))
+        return;
+
+      const __m256i ones = _mm256_set1_epi16(1);
+      for (int y = border; y < height - border; ++y)
+      {
+        const uint8_t* row = src + y * src_step;
+        const uint8_t* above = row - src_step;
+        const uint8_t* below = row + src_step;
+        __m256i row_sums[5] = {_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256()};
+
+        int x = border;
+        for (; width <= MAX_VECTOR_ROW_WIDTH && x + 16 <= width - border; x += 16)
+        {
+          __m128i channels[3];
+          deinterleaveBgr(row + 3 * x, channels);
+          const __m256i b = _mm256_cvtepu8_epi16(channels[0]);
+          const __m256i g = _mm256_cvtepu8_epi16(channels[1]);
+          const __m256i r = _mm256_cvtepu8_epi16(channels[2]);
+          const __m256i neighbours = _mm256_add_epi16(
+            _mm256_add_epi16(_mm256_cvtepu8_epi16(extractChannel(above + 3 * x, 0)), _mm256_cvtepu8_epi16(extractChannel(below + 3 * x, 0))),
+            _mm256_add_epi16(_mm256_cvtepu8_epi16(extractChannel(row + 3 * (x - 1), 0)), _mm256_cvtepu8_epi16(extractChannel(row + 3 * (x + 1), 0))));
+          const __m256i laplacian = _mm256_sub_epi16(neighbours, _mm256_slli_epi16(b, 2));
+          const __m256i luma = _mm256_srli_epi16(_mm256_add_epi16(
+            _mm256_add_epi16(_mm256_mullo_epi16(b, _mm256_set1_epi16(LUMA_B)), _mm256_mullo_epi16(g, _mm256_set1_epi16(LUMA_G))),
+            _mm256_add_epi16(_mm256_mullo_epi16(r, _mm256_set1_epi16(LUMA_R)), _mm256_set1_epi16(128))), 8);
+          row_sums[0] = _mm256_add_epi32(row_sums[0], _mm256_madd_epi16(laplacian, ones));
+          row_sums[1] = _mm256_add_epi32(row_sums[1], _mm256_madd_epi16(laplacian, laplacian));
+          row_sums[2] = _mm256_add_epi32(row_sums[2], _mm256_madd_epi16(luma, ones));
+          row_sums[3] = _mm256_add_epi32(row_sums[3], _mm256_madd_epi16(luma, luma));
+          row_sums[4] = _mm256_sub_epi32(row_sums[4], _mm256_madd_epi16(_mm256_cmpgt_epi16(luma, _mm256_set1_epi16(SATURATED_LUMA - 1)), ones));
+        }
+        sums.laplacian_sum += reduceSum(row_sums[0]);
+        sums.laplacian_sq_sum += reduceSum(row_sums[1]);
+        sums.luma_sum += reduceSum(row_sums[2]);
+        sums.luma_sq_sum += reduceSum(row_sums[3]);
+        sums.saturated_count += reduceSum(row_sums[4]);
+        qualitySumsRow(above, row, below, x, width - border, sums);
+      }
+    }
+
+    constexpr Kernels AVX2_KERNELS{
+      .dot = dotAvx2<0>,
+      .dotAndNorms = dotAndNormsAvx2<0>,
+      .bgrToPlanarRgb = bgrToPlanarRgbAvx2,
+      .sad = sadAvx2,
+      .qualitySums = qualitySumsAvx2,
+      .dim128 = {dotAvx2<128>, dotAndNormsAvx2<128>},
+      .dim256 = {dotAvx2<256>, dotAndNormsAvx2<256>},
+      .dim512 = {dotAvx2<512>, dotAndNormsAvx2<512>}};
+
+    // AVX-512: the tails are handled by masked loads.
+    // The intrinsics filling the unused result lanes with _mm*_undefined_* (_mm512_reduce_add_ps, _mm512_castps512_ps256, the conversions)
+    // make GCC 12 warn about an uninitialized variable of its own, so their zero-masked forms with a full mask are used instead;
+    // _mm512_extractf32x8_ps would need AVX-512DQ
+    template <int Half>
+    __attribute__((target("avx512f"))) inline __m256 extractHalf(const __m512 v)
+    {
+      return _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0x0F, _mm512_castps_pd(v), Half));
+    }
+
+    __attribute__((target("avx512f"))) inline float reduceSum(const __m512 v)
+    {
+      return reduceSum(_mm256_add_ps(extractHalf<0>(v), extractHalf<1>(v)));
+    }
+
+    template <size_t Fixed>
+    __attribute__((target("avx512f"))) float dotAvx512(const float* a, const float* b, const size_t runtime_size)
+    {
+      const size_t size = Fixed == 0 ? runtime_size : Fixed;
+      __m512 sum0 = _mm512_setzero_ps();
+      __m512 sum1 = _mm512_setzero_ps();
+      size_t i = 0;
+      for (; i + 32 <= size; i += 32)
+      {
+        sum0 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i), _mm512_loadu_ps(b + i), sum0);
+        sum1 = _mm512_fmadd_ps(_mm512_loadu_ps(a + i + 16), _mm512_loadu_ps(b + i + 16), sum1);
+      }
+      if constexpr (hasTail(Fixed, 32))
+        for (; i < size; i += 16)
+        {
+          const auto mask = static_cast<__mmask16>(size - i >= 16 ? 0xFFFF : (1u << (size - i)) - 1);
+          sum0 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, a + i), _mm512_maskz_loadu_ps(mask, b + i), sum0);
+        }
+      return reduceSum(_mm512_add_ps(sum0, sum1));
+    }
+
+    template <size_t Fixed>
+    __attribute__((target("avx512f"))) void dotAndNormsAvx512(const float* a, const float* b, const size_t runtime_size, float& dot, float& norm_a,
+      float& norm_b)
+    {
+      const size_t size = Fixed == 0 ? runtime_size : Fixed;
+      __m512 sum_ab = _mm512_setzero_ps();
+      __m512 sum_aa = _mm512_setzero_ps();
+      __m512 sum_bb = _mm512_setzero_ps();
+      for (size_t i = 0; i < size; i += 16)
+      {
+        const auto mask = static_cast<__mmask16>(size - i >= 16 ? 0xFFFF : (1u << (size - i)) - 1);
+        const __m512 va = _mm512_maskz_loadu_ps(mask, a + i);
+        const __m512 vb = _mm512_maskz_loadu_ps(mask, b + i);
+        sum_ab = _mm512_fmadd_ps(va, vb, sum_ab);
+        sum_aa = _mm512_fmadd_ps(va, va, sum_aa);
+        sum_bb = _mm512_fmadd_ps(vb, vb, sum_bb);
+      }
+      dot = reduceSum(sum_ab);
+      norm_a = reduceSum(sum_aa);
+      norm_b = reduceSum(sum_bb);
+    }
+
+    __attribute__((target("avx512f"))) void bgrToPlanarRgbAvx512(const uint8_t* src, const size_t src_step, const int width, const int height,
+      const float* alpha, const float* beta, float* dst)
+    {
+      const size_t plane_size = static_cast<size_t>(width) * height;
+      __m512 alphas[3];
+      __m512 betas[3];
+      for (int c = 0; c < 3; ++c)
+      {
+        alphas[c] = _mm512_set1_ps(alpha[c]);
+        betas[c] = _mm512_set1_ps(beta[c]);
+      }
+
+      for (int y = 0; y < height; ++y)
+      {
+        const uint8_t* row = src + y * src_step;
+        float* dst_planes[3];
+        for (int c = 0; c < 3; ++c)
+          dst_planes[c] = dst + c * plane_size + static_cast<size_t>(y) * width;
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+          __m128i channels[3];
+          deinterleaveBgr(row + 3 * x, channels);
+          for (int c = 0; c < 3; ++c)
+            _mm512_storeu_ps(dst_planes[c] + x, _mm512_fmadd_ps(_mm512_maskz_cvtepi32_ps(0xFFFF, _mm512_maskz_cvtepu8_epi32(0xFFFF, channels[2 - c])), alphas[c], betas[c]));
+        }
+        bgrToPlanarRgbRow(row, x, width, alpha, beta, dst_planes[0], dst_planes[1], dst_planes[2]);
+      }
+    }
+
+    // byte operations of AVX-512 need AVX-512BW, so the AVX2 kernel is used
+    constexpr Kernels AVX512_KERNELS{
+      .dot = dotAvx512<0>,
+      .dotAndNorms = dotAndNormsAvx512<0>,
+      .bgrToPlanarRgb = bgrToPlanarRgbAvx512,
+      .sad = sadAvx2,
+      .qualitySums = qualitySumsAvx2,
+      .dim128 = {dotAvx512<128>, dotAndNormsAvx512<128>},
+      .dim256 = {dotAvx512<256>, dotAndNormsAvx512<256>},
+      .dim512 = {dotAvx512<512>, dotAndNormsAvx512<512>}};
+#endif
+
+#if defined(__aarch64__)
+    // NEON is a part of the baseline of AArch64
+    template <size_t Fixed>
+    float dotNeon(const float* a, const float* b, const size_t runtime_size)
+    {
+      const size_t size = Fixed == 0 ? runtime_size : Fixed;
+      float32x4_t sum0 = vdupq_n_f32(0.0f);
+      float32x4_t sum1 = vdupq_n_f32(0.0f);
+      size_t i = 0;
+      for (; i + 8 <= size; i += 8)
+      {
+        sum0 = vfmaq_f32(sum0, vld1q_f32(a + i), vld1q_f32(b + i));
+        sum1 = vfmaq_f32(sum1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+      }
+      float sum = vaddvq_f32(vaddq_f32(sum0, sum1));
+      if constexpr (hasTail(Fixed, 8))
+        for (; i < size; ++i)
+          sum += a[i] * b[i];
+      return sum;
+    }
+
+    template <size_t Fixed>
+    void dotAndNormsNeon(const float* a, const float* b, const size_t runtime_size, float& dot, float& norm_a, float& norm_b)
+    {
+      const size_t size = Fixed == 0 ? runtime_size : Fixed;
+      float32x4_t sum_ab = vdupq_n_f32(0.0f);
+      float32x4_t sum_aa = vdupq_n_f32(0.0f);
+      float32x4_t sum_bb = vdupq_n_f32(0.0f);
+      size_t i = 0;
+      for (; i + 4 <= size; i += 4)
+      {
+        const float32x4_t va = vld1q_f32(a + i);
+        const float32x4_t vb = vld1q_f32(b + i);
+        sum_ab = vfmaq_f32(sum_ab, va, vb);
+        sum_aa = vfmaq_f32(sum_aa, va, va);
+        sum_bb = vfmaq_f32(sum_bb, vb, vb);
+      }
+      dot = vaddvq_f32(sum_ab);
+      norm_a = vaddvq_f32(sum_aa);
+      norm_b = vaddvq_f32(sum_bb);
+      if constexpr (hasTail(Fixed, 4))
+        for (; i < size; ++i)
+        {
+          dot += a[i] * b[i];
+          norm_a += a[i] * a[i];
+          norm_b += b[i] * b[i];
+        }
+    }
+
+    void bgrToPlanarRgbNeon(const uint8_t* src, const size_t src_step, const int width, const int height, const float* alpha,
+      const float* beta, float* dst)
+    {
+      const size_t plane_size = static_cast<size_t>(width) * height;
+      for (int y = 0; y < height; ++y)
+      {
+        const uint8_t* row = src + y * src_step;
+        float* dst_planes[3];
+        for (int c = 0; c < 3; ++c)
+          dst_planes[c] = dst + c * plane_size + static_cast<size_t>(y) * width;
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+          const uint8x16x3_t channels = vld3q_u8(row + 3 * x);  // B, G, R
+          for (int c = 0; c < 3; ++c)
+          {
+            const float32x4_t alphas = vdupq_n_f32(alpha[c]);
+            const float32x4_t betas = vdupq_n_f32(beta[c]);
+            const uint16x8_t low = vmovl_u8(vget_low_u8(channels.val[2 - c]));
+            const uint16x8_t high = vmovl_u8(vget_high_u8(channels.val[2 - c]));
+            vst1q_f32(dst_planes[c] + x, vfmaq_f32(betas, vcvtq_f32_u32(vmovl_u16(vget_low_u16(low))), alphas));
+            vst1q_f32(dst_planes[c] + x + 4, vfmaq_f32(betas, vcvtq_f32_u32(vmovl_u16(vget_high_u16(low))), alphas));
+            vst1q_f32(dst_planes[c] + x + 8, vfmaq_f32(betas, vcvtq_f32_u32(vmovl_u16(vget_low_u16(high))), alphas));
+            vst1q_f32(dst_planes[c] + x + 12, vfmaq_f32(betas, vcvtq_f32_u32(vmovl_u16(vget_high_u16(high))), alphas));
+          }
+        }
+        bgrToPlanarRgbRow(row, x, width, alpha, beta, dst_planes[0], dst_planes[1], dst_planes[2]);
+      }
+    }
+
+    uint64_t sadNeon(const uint8_t* a, const uint8_t* b, const size_t size)
+    {
+      uint64x2_t sum = vdupq_n_u64(0);
+      size_t i = 0;
+      for (; i + 16 <= size; i += 16)
+        sum = vpadalq_u32(sum, vpaddlq_u16(vpaddlq_u8(vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i)))));
+      return vaddvq_u64(sum) + sadScalar(a + i, b + i, size - i);
+    }
+
+    // 8 pixels of 16-bit channels: the Laplacian and the luma statistics are added to the 32-bit lanes of the row sums
+    inline void addQualitySumsNeon(const int16x8_t laplacian, const uint16x8_t b, const uint16x8_t g, const uint16x8_t r, int32x4_t& laplacian_sum,
+      int32x4_t& laplacian_sq_sum, uint32x4_t& luma_sum, uint32x4_t& luma_sq_sum, uint32x4_t& saturated_count)
+    {
+      const uint16x8_t luma = vrshrq_n_u16(vmlaq_n_u16(vmlaq_n_u16(vmulq_n_u16(b, LUMA_B), g, LUMA_G), r, LUMA_R), 8);
+      laplacian_sum = vpadalq_s16(laplacian_sum, laplacian);
+      laplacian_sq_sum = vmlal_s16(vmlal_s16(laplacian_sq_sum, vget_low_s16(laplacian), vget_low_s16(laplacian)), vget_high_s16(laplacian),
+        vget_high_s16(laplacian));
+      luma_sum = vpadalq_u16(luma_sum, luma);
+      luma_sq_sum = vmlal_u16(vmlal_u16(luma_sq_sum, vget_low_u16(luma), vget_low_u16(luma)), vget_high_u16(luma), vget_high_u16(luma));
+      saturated_count = vpadalq_u16(saturated_count, vshrq_n_u16(vcgeq_u16(luma, vdupq_n_u16(SATURATED_LUMA)), 15));
+    }
+
+    void qualitySumsNeon(const uint8_t* src, const size_t src_step, const int width, const int height, const int border, QualitySums& sums)
+    {
+      if (!startQualitySums(width, height, border, sums))
+        return;
+
+      for (int y = border; y < height - border; ++y)
+      {
+        const uint8_t* row = src + y * src_step;
+        const uint8_t* above = row - src_step;
+        const uint8_t* below = row + src_step;
+        int32x4_t laplacian_sum = vdupq_n_s32(0);
+        int32x4_t laplacian_sq_sum = vdupq_n_s32(0);
+        uint32x4_t luma_sum = vdupq_n_u32(0);
+        uint32x4_t luma_sq_sum = vdupq_n_u32(0);
+        uint32x4_t saturated_count = vdupq_n_u32(0);
+
+        int x = border;
+        for (; width <= MAX_VECTOR_ROW_WIDTH && x + 16 <= width - border; x += 16)
+        {
+          const uint8x16x3_t channels = vld3q_u8(row + 3 * x);  // B, G, R
+          const uint8x16_t above_b = vld3q_u8(above + 3 * x).val[0];
+          const uint8x16_t below_b = vld3q_u8(below + 3 * x).val[0];
+          const uint8x16_t left_b = vld3q_u8(row + 3 * (x - 1)).val[0];
+          const uint8x16_t right_b = vld3q_u8(row + 3 * (x + 1)).val[0];
+          const uint16x8_t neighbours_lo = vaddq_u16(vaddl_u8(vget_low_u8(above_b), vget_low_u8(below_b)), vaddl_u8(vget_low_u8(left_b), vget_low_u8(right_b)));
+          const uint16x8_t neighbours_hi = vaddq_u16(vaddl_high_u8(above_b, below_b), vaddl_high_u8(left_b, right_b));
+          const uint16x8_t b_lo = vmovl_u8(vget_low_u8(channels.val[0]));
+          const uint16x8_t b_hi = vmovl_high_u8(channels.val[0]);
+          addQualitySumsNeon(vsubq_s16(vreinterpretq_s16_u16(neighbours_lo), vreinterpretq_s16_u16(vshlq_n_u16(b_lo, 2))), b_lo,
+            vmovl_u8(vget_low_u8(channels.val[1])), vmovl_u8(vget_low_u8(channels.val[2])), laplacian_sum, laplacian_sq_sum, luma_sum, luma_sq_sum,
+            saturated_count);
+          addQualitySumsNeon(vsubq_s16(vreinterpretq_s16_u16(neighbours_hi), vreinterpretq_s16_u16(vshlq_n_u16(b_hi, 2))), b_hi,
+            vmovl_high_u8(channels.val[1]), vmovl_high_u8(channels.val[2]), laplacian_sum, laplacian_sq_sum, luma_sum, luma_sq_sum, saturated_count);
+        }
+        sums.laplacian_sum += vaddlvq_s32(laplacian_sum);
+        sums.laplacian_sq_sum += vaddlvq_s32(laplacian_sq_sum);
+        sums.luma_sum += static_cast<int64_t>(vaddlvq_u32(luma_sum));
+        sums.luma_sq_sum += static_cast<int64_t>(vaddlvq_u32(luma_sq_sum));
+        sums.saturated_count += static_cast<int64_t>(vaddlvq_u32(saturated_count));
+        qualitySumsRow(above, row, below, x, width - border, sums);
+      }
+    }
+
+    constexpr Kernels NEON_KERNELS{
+      .dot = dotNeon<0>,
+      .dotAndNorms = dotAndNormsNeon<0>,
+      .bgrToPlanarRgb = bgrToPlanarRgbNeon,
+      .sad = sadNeon,
+      .qualitySums = qualitySumsNeon,
+      .dim128 = {dotNeon<128>, dotAndNormsNeon<128>},
+      .dim256 = {dotNeon<256>, dotAndNormsNeon<256>},
+      .dim512 = {dotNeon<512>, dotAndNormsNeon<512>}};
+#endif
+
+    bool isClose(const float value, const float reference)
+    {
+      return std::fabs(value - reference) <= 1e-4f * std::max(1.0f, std::fabs(reference));
+    }
+
+    // compares the kernels with the scalar ones on random data of sizes with and without tails
+    bool agreesWithScalar(const Kernels& candidate)
+    {
+      std::mt19937 rng(42);
+      std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+      for (const size_t size : {128, 512, 517})
+      {
+        std::vector<float> a(size);
+        std::vector<float> b(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+          a[i] = distribution(rng);
+          b[i] = distribution(rng);
+        }
+
+        if (!isClose(candidate.dot(a.data(), b.data(), size), SCALAR_KERNELS.dot(a.data(), b.data(), size)))
+          return false;
+
+        float dot, norm_a, norm_b;
+        float reference_dot, reference_norm_a, reference_norm_b;
+        candidate.dotAndNorms(a.data(), b.data(), size, dot, norm_a, norm_b);
+        SCALAR_KERNELS.dotAndNorms(a.data(), b.data(), size, reference_dot, reference_norm_a, reference_norm_b);
+        if (!isClose(dot, reference_dot) || !isClose(norm_a, reference_norm_a) || !isClose(norm_b, reference_norm_b))
+          return false;
+      }
+
+      // an image with a row padding and a tail of pixels
+      constexpr int width = 37;
+      constexpr int height = 5;
+      constexpr size_t step = 3 * width + 7;
+      std::vector<uint8_t> image(step * height);
+      for (auto& value : image)
+        value = static_cast<uint8_t>(rng() & 0xFF);
+      constexpr float alpha[3] = {1.0f / 255.0f, 1.0f / 127.5f, 1.0f / 128.0f};
+      constexpr float beta[3] = {0.0f, -1.0f, -127.5f / 128.0f};
+      std::vector<float> planes(3 * width * height);
+      std::vector<float> reference_planes(3 * width * height);
+      candidate.bgrToPlanarRgb(image.data(), step, width, height, alpha, beta, planes.data());
+      SCALAR_KERNELS.bgrToPlanarRgb(image.data(), step, width, height, alpha, beta, reference_planes.data());
+      for (size_t i = 0; i < planes.size(); ++i)
+        if (!isClose(planes[i], reference_planes[i]))
+          return false;
+
+      // a size with a tail
+      constexpr size_t sad_size = 3 * 64 + 13;
+      std::vector<uint8_t> sad_a(sad_size);
+      std::vector<uint8_t> sad_b(sad_size);
+      for (size_t i = 0; i < sad_size; ++i)
+      {
+        sad_a[i] = static_cast<uint8_t>(rng() & 0xFF);
+        sad_b[i] = static_cast<uint8_t>(rng() & 0xFF);
+      }
+      if (candidate.sad(sad_a.data(), sad_b.data(), sad_size) != SCALAR_KERNELS.sad(sad_a.data(), sad_b.data(), sad_size))
+        return false;
+
+      // an image with a row padding, a tail of pixels and saturated areas
+      constexpr int quality_width = 53;
+      constexpr int quality_height = 9;
+      constexpr size_t quality_step = 3 * quality_width + 5;
+      std::vector<uint8_t> quality_image(quality_step * quality_height);
+      for (auto& value : quality_image)
+        value = static_cast<uint8_t>((rng() & 1) != 0 ? 255 - (rng() & 0x07) : rng() & 0xFF);
+      QualitySums quality_sums;
+      QualitySums reference_quality_sums;
+      candidate.qualitySums(quality_image.data(), quality_step, quality_width, quality_height, 3, quality_sums);
+      SCALAR_KERNELS.qualitySums(quality_image.data(), quality_step, quality_width, quality_height, 3, reference_quality_sums);
+      if (quality_sums != reference_quality_sums)
+        return false;
+
+      return true;
+    }
+  }  // namespace
+
+  const char* isaName(const Isa isa)
+  {
+    switch (isa)
+    {
+      case Isa::SCALAR:
+        return "scalar";
+      case Isa::SSE4:
+        return "sse4";
+      case Isa::AVX2:
+        return "avx2";
+      case Isa::AVX512:
+        return "avx512";
+      case Isa::NEON:
+        return "neon";
+    }
+
+    return "unknown";
+  }
+
+  const std::vector<Isa>& supportedIsas()
+  {
+    static const std::vector<Isa> isas = []
+    {
+      std::vector<Isa> result;
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx2"))
+        result.push_back(Isa::AVX512);
+      if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        result.push_back(Isa::AVX2);
+      if (__builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("ssse3"))
+        result.push_back(Isa::SSE4);
+#elif defined(__aarch64__)
+      result.push_back(Isa::NEON);
+#endif
+      result.push_back(Isa::SCALAR);
+      return result;
+    }();
+
+    return isas;
+  }
+
+  const Kernels& kernels(const Isa isa)
+  {
+    switch (isa)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+      case Isa::SSE4:
+        return SSE4_KERNELS;
+      case Isa::AVX2:
+        return AVX2_KERNELS;
+      case Isa::AVX512:
+        return AVX512_KERNELS;
+#elif defined(__aarch64__)
+      case Isa::NEON:
+        return NEON_KERNELS;
+#endif
+      default:
+        return SCALAR_KERNELS;
+    }
+  }
+
+  Isa activeIsa()
+  {
+    static const Isa isa = []
+    {
+      for (const auto candidate : supportedIsas())
+        if (candidate == Isa::SCALAR || agreesWithScalar(kernels(candidate)))
+          return candidate;
+
+      return Isa::SCALAR;
+    }();
+
+    return isa;
+  }
+
+  const Kernels& kernels()
+  {
+    static const Kernels& active_kernels = kernels(activeIsa());
+    return active_kernels;
+  }
+}  // namespace Simd
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Descriptor and preprocessing kernels compiled for several instruction sets; the best one supported by the CPU
+// is chosen at startup, so the binary is built for the baseline architecture and runs on any CPU of it
+namespace Simd
+{
+  enum class Isa
+  {
+    SCALAR,
+    SSE4,    // SSE4.1 + SSSE3
+    AVX2,    // AVX2 + FMA
+    AVX512,  // AVX-512F
+    NEON
+  };
+
+  // weights of the 8-bit luma: (LUMA_B * b + LUMA_G * g + LUMA_R * r + 128) >> 8
+  inline constexpr int32_t LUMA_B = 29;
+  inline constexpr int32_t LUMA_G = 150;
+  inline constexpr int32_t LUMA_R = 77;
+
+  // a pixel with the luma at least this is counted as saturated (over-exposed)
+  inline constexpr int32_t SATURATED_LUMA = 250;
+
+  // integer sums of the quality statistics of an image
+  struct QualitySums
+  {
+    int64_t laplacian_sum{};  // 4-neighbour Laplacian of the first (blue) channel
+    int64_t laplacian_sq_sum{};
+    int64_t luma_sum{};
+    int64_t luma_sq_sum{};
+    int64_t saturated_count{};
+    int64_t count{};
+
+    bool operator==(const QualitySums&) const = default;
+  };
+
+  // descriptor kernels for one size, which is a compile-time constant of them; the size argument is ignored
+  struct FixedSizeKernels
+  {
+    float (*dot)(const float* a, const float* b, size_t size);
+    void (*dotAndNorms)(const float* a, const float* b, size_t size, float& dot, float& norm_a, float& norm_b);
+  };
+
+  struct Kernels
+  {
+    float (*dot)(const float* a, const float* b, size_t size);
+
+    // dot product and squared norms of both vectors in one pass
+    void (*dotAndNorms)(const float* a, const float* b, size_t size, float& dot, float& norm_a, float& norm_b);
+
+    // 8-bit interleaved BGR image to planar RGB float: dst[c][y][x] = src[y][x][2 - c] * alpha[c] + beta[c]
+    void (*bgrToPlanarRgb)(const uint8_t* src, size_t src_step, int width, int height, const float* alpha, const float* beta, float* dst);
+
+    // sum of absolute differences of two 8-bit buffers
+    uint64_t (*sad)(const uint8_t* a, const uint8_t* b, size_t size);
+
+    // quality sums of an 8-bit interleaved BGR image over the pixels at least border (>= 1) pixels away from its edges
+    void (*qualitySums)(const uint8_t* src, size_t src_step, int width, int height, int border, QualitySums& sums);
+
+    // the descriptor kernels specialized for the output sizes of the common face recognition models
+    FixedSizeKernels dim128;
+    FixedSizeKernels dim256;
+    FixedSizeKernels dim512;
+  };
+
+  [[nodiscard]] const char* isaName(Isa isa);
+
+  // instruction sets supported by the CPU, from the best one
+  [[nodiscard]] const std::vector<Isa>& supportedIsas();
+
+  // the kernels of the instruction set, which must be supported by the CPU
+  [[nodiscard]] const Kernels& kernels(Isa isa);
+
+  // the best supported instruction set whose kernels agree with the scalar ones on the reference data
+  [[nodiscard]] Isa activeIsa();
+
+  [[nodiscard]] const Kernels& kernels();
+}  // namespace Simd
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "simd_kernels.hpp"
+
+// Descriptor similarity kernels shared by the matching of the workflow and the search of the API.
+// The dimension is a template parameter: the output sizes of the common face recognition models are specialized
+// at compile time, any other size goes through DYNAMIC_DIM. The innermost products are the dispatched SIMD kernels,
+// for the specialized dimensions their instantiations of the fixed size without the loop tails.
+namespace Similarity
+{
+  inline constexpr size_t DYNAMIC_DIM = 0;
+
+  // number of gallery rows compared with all queries at once in the many-to-many search, so that they stay in the cache
+  inline constexpr size_t BLOCK_ROWS = 64;
+
+  enum class Metric
+  {
+    DOT,    // descriptors are L2-normalized, so the dot product is the cosine
+    COSINE  // descriptors of any norm; vectors of zero norm have zero similarity
+  };
+
+  // descriptors placed one after another in memory, beginnings of the neighbours are stride floats apart
+  struct StridedRows
+  {
+    const float* data{nullptr};
+    size_t count{0};
+    size_t stride{0};
+  };
+
+  // descriptors scattered in memory
+  using GatheredRows = std::span<const float* const>;
+
+  struct Match
+  {
+    size_t index{0};  // row index in the gallery
+    float similarity{-2.0f};
+  };
+
+  namespace Detail
+  {
+    inline size_t rowCount(const StridedRows& rows)
+    {
+      return rows.count;
+    }
+
+    inline size_t rowCount(const GatheredRows& rows)
+    {
+      return rows.size();
+    }
+
+    inline const float* row(const StridedRows& rows, const size_t i)
+    {
+      return rows.data + i * rows.stride;
+    }
+
+    inline const float* row(const GatheredRows& rows, const size_t i)
+    {
+      return rows[i];
+    }
+
+    template <size_t Dim>
+    constexpr size_t dimension(const size_t dim)
+    {
+      return Dim == DYNAMIC_DIM ? dim : Dim;
+    }
+
+    // the dispatched kernels of the dimension, the generic ones for DYNAMIC_DIM
+    template <size_t Dim>
+    Simd::FixedSizeKernels sizedKernels()
+    {
+      const auto& kernels = Simd::kernels();
+      if constexpr (Dim == 128)
+        return kernels.dim128;
+      else if constexpr (Dim == 256)
+        return kernels.dim256;
+      else if constexpr (Dim == 512)
+        return kernels.dim512;
+      else
+        return {kernels.dot, kernels.dotAndNorms};
+    }
+
+    inline float cosine(const float dot, const float squared_norm_a, const float squared_norm_b)
+    {
+      const float norms = std::sqrt(squared_norm_a) * std::sqrt(squared_norm_b);
+      return norms > 0.0f ? dot / norms : 0.0f;
+    }
+  }  // namespace Detail
+
+  // calls f.template operator()<Dim>() with the compile-time dimension if there is a specialization for it
+  template <typename F>
+  decltype(auto) withDim(const size_t dim, F&& f)
+  {
+    switch (dim)
+    {
+      case 128:
+        return f.template operator()<128>();
+      case 256:
+        return f.template operator()<256>();
+      case 512:
+        return f.template operator()<512>();
+      default:
+        return f.template operator()<DYNAMIC_DIM>();
+    }
+  }
+
+  // one-to-one
+  template <size_t Dim = DYNAMIC_DIM>
+  float similarity(const float* a, const float* b, const Metric metric, const size_t dim = Dim)
+  {
+    const auto size = Detail::dimension<Dim>(dim);
+    const auto kernels = Detail::sizedKernels<Dim>();
+    if (metric == Metric::DOT)
+      return kernels.dot(a, b, size);
+
+    float dot, norm_a, norm_b;
+    kernels.dotAndNorms(a, b, size, dot, norm_a, norm_b);
+    return Detail::cosine(dot, norm_a, norm_b);
+  }
+
+  // one-to-many: out[i] is the similarity of the query and the i-th row
+  template <size_t Dim = DYNAMIC_DIM, typename Rows>
+  void oneToMany(const float* query, const Rows& rows, const Metric metric, std::span<float> out, const size_t dim = Dim)
+  {
+    const auto size = Detail::dimension<Dim>(dim);
+    const auto count = std::min(Detail::rowCount(rows), out.size());
+    const auto kernels = Detail::sizedKernels<Dim>();
+    if (metric == Metric::DOT)
+    {
+      for (size_t i = 0; i < count; ++i)
+        out[i] = kernels.dot(query, Detail::row(rows, i), size);
+      return;
+    }
+
+    // the fused kernel reads every row once, the query stays in the cache
+    for (size_t i = 0; i < count; ++i)
+    {
+      float dot, query_norm, row_norm;
+      kernels.dotAndNorms(query, Detail::row(rows, i), size, dot, query_norm, row_norm);
+      out[i] = Detail::cosine(dot, query_norm, row_norm);
+    }
+  }
+
+  // many-to-many: out[q * rows + i] is the similarity of the q-th query and the i-th row;
+  // the norms are computed once per vector and the rows are walked in blocks shared by all queries
+  template <size_t Dim = DYNAMIC_DIM, typename Queries, typename Rows>
+  void manyToMany(const Queries& queries, const Rows& rows, const Metric metric, std::span<float> out, const size_t dim = Dim)
+  {
+    const auto size = Detail::dimension<Dim>(dim);
+    const auto query_count = Detail::rowCount(queries);
+    const auto row_count = Detail::rowCount(rows);
+    if (out.size() < query_count * row_count)
+      return;
+
+    const auto kernels = Detail::sizedKernels<Dim>();
+    std::vector<float> query_norms;
+    std::vector<float> row_norms;
+    if (metric == Metric::COSINE)
+    {
+      query_norms.resize(query_count);
+      for (size_t q = 0; q < query_count; ++q)
+        query_norms[q] = kernels.dot(Detail::row(queries, q), Detail::row(queries, q), size);
+      row_norms.resize(row_count);
+      for (size_t i = 0; i < row_count; ++i)
+        row_norms[i] = kernels.dot(Detail::row(rows, i), Detail::row(rows, i), size);
+    }
+
+    for (size_t block = 0; block < row_count; block += BLOCK_ROWS)
+    {
+      const auto block_end = std::min(block + BLOCK_ROWS, row_count);
+      for (size_t q = 0; q < query_count; ++q)
+      {
+        const float* query = Detail::row(queries, q);
+        float* out_row = out.data() + q * row_count;
+        for (size_t i = block; i < block_end; ++i)
+        {
+          const float dot = kernels.dot(query, Detail::row(rows, i), size);
+          out_row[i] = metric == Metric::DOT ? dot : Detail::cosine(dot, query_norms[q], row_norms[i]);
+        }
+      }
+    }
+  }
+
+  // k most similar rows in descending order of similarity; of equal ones the row with the lower index goes first
+  template <size_t Dim = DYNAMIC_DIM, typename Rows>
+  std::vector<Match> topK(const float* query, const Rows& rows, const size_t k, const Metric metric, const size_t dim = Dim)
+  {
+    std::vector<float> similarities(Detail::rowCount(rows));
+    oneToMany<Dim>(query, rows, metric, similarities, dim);
+
+    std::vector<Match> matches(similarities.size());
+    for (size_t i = 0; i < similarities.size(); ++i)
+      matches[i] = {i, similarities[i]};
+    const auto greater = [](const Match& a, const Match& b)
+    {
+      return a.similarity > b.similarity || (a.similarity == b.similarity && a.index < b.index);
+    };
+    const auto top_count = std::min(k, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + static_cast<std::ptrdiff_t>(top_count), matches.end(), greater);
+    matches.resize(top_count);
+
+    return matches;
+  }
+
+  // the most similar row, the first one of equal ones; empty for an empty gallery
+  template <size_t Dim = DYNAMIC_DIM, typename Rows>
+  std::optional<Match> best(const float* query, const Rows& rows, const Metric metric, const size_t dim = Dim)
+  {
+    const auto size = Detail::dimension<Dim>(dim);
+    const auto count = Detail::rowCount(rows);
+    if (count == 0)
+      return std::nullopt;
+
+    const auto kernels = Detail::sizedKernels<Dim>();
+    Match match;
+    for (size_t i = 0; i < count; ++i)
+    {
+      const float* r = Detail::row(rows, i);
+      float s;
+      if (metric == Metric::DOT)
+        s = kernels.dot(query, r, size);
+      else
+      {
+        // the fused kernel reads the row once
+        float dot, query_norm, row_norm;
+        kernels.dotAndNorms(query, r, size, dot, query_norm, row_norm);
+        s = Detail::cosine(dot, query_norm, row_norm);
+      }
+      if (i == 0 || s > match.similarity)
+        match = {i, s};
+    }
+
+    return match;
+  }
+}  // namespace Similarity
@@ -0,0 +1,7 @@
+alter table common_config
+  add if not exists last_updated timestamp with time zone default now() not null;
+comment on column common_config.last_updated is 'Last update time (for cache operation)';
+
+alter table default_vstream_config
+  add if not exists last_updated timestamp with time zone default now() not null;
+comment on column default_vstream_config.last_updated is 'Last update time (for cache operation)';
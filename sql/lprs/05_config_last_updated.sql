@@ -0,0 +1,13 @@
+alter table vstreams
+  add if not exists last_updated timestamp with time zone default now() not null;
+alter table vstreams
+  add if not exists flag_deleted boolean default false not null;
+comment on column vstreams.last_updated is 'Last update time (for cache operation)';
+comment on column vstreams.flag_deleted is 'Sign of record deletion (for cache operation)';
+
+create index if not exists vstreams_last_updated_index
+  on vstreams (last_updated);
+
+alter table default_vstream_config
+  add if not exists last_updated timestamp with time zone default now() not null;
+comment on column default_vstream_config.last_updated is 'Last update time (for cache operation)';
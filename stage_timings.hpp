@@ -0,0 +1,117 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string_view>
+
+#include <userver/utils/statistics/percentile.hpp>
+#include <userver/utils/statistics/rate_counter.hpp>
+#include <userver/utils/statistics/recentperiod.hpp>
+#include <userver/utils/statistics/writer.hpp>
+
+// Latency histograms of the pipeline stages; accounting is a couple of relaxed atomic increments,
+// so the timings are always enabled
+template <std::size_t StageCount>
+class StageTimings
+{
+public:
+  // 1ms resolution up to 1s, then 100ms resolution up to 20s
+  using Percentile = userver::utils::statistics::Percentile<1000, uint32_t, 190, 100>;
+
+  struct StageTiming
+  {
+    // statistics for the last minute
+    userver::utils::statistics::RecentPeriod<Percentile, Percentile> latency;
+    userver::utils::statistics::RateCounter count;
+  };
+
+  // latencies (ms) for the last minute and the total count of a stage
+  struct StageSnapshot
+  {
+    uint32_t p50{0};
+    uint32_t p90{0};
+    uint32_t p99{0};
+    uint32_t max{0};
+    uint64_t count{0};
+  };
+
+  // measures the time from the creation to the destruction (or stop call) of the object
+  class Timer
+  {
+  public:
+    Timer(StageTimings& timings, const std::size_t stage)
+      : timings_(&timings),
+        stage_(stage),
+        start_(std::chrono::steady_clock::now())
+    {
+    }
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+    ~Timer()
+    {
+      stop();
+    }
+
+    void stop()
+    {
+      if (timings_ == nullptr)
+        return;
+
+      timings_->account(stage_, std::chrono::steady_clock::now() - start_);
+      timings_ = nullptr;
+    }
+
+  private:
+    StageTimings* timings_;
+    std::size_t stage_;
+    std::chrono::steady_clock::time_point start_;
+  };
+
+  [[nodiscard]] Timer measure(const std::size_t stage)
+  {
+    return Timer(*this, stage);
+  }
+
+  void account(const std::size_t stage, const std::chrono::steady_clock::duration duration)
+  {
+    auto& timing = timings_[stage];
+    timing.latency.GetCurrentCounter().Account(std::chrono::duration_cast<std::chrono::milliseconds>(duration).count());
+    ++timing.count;
+  }
+
+  [[nodiscard]] StageSnapshot snapshot(const std::size_t stage) const
+  {
+    const auto& timing = timings_[stage];
+    const auto latency = timing.latency.GetStatsForPeriod();
+    return {
+      .p50 = latency.GetPercentile(50),
+      .p90 = latency.GetPercentile(90),
+      .p99 = latency.GetPercentile(99),
+      .max = latency.GetPercentile(100),
+      .count = timing.count.Load().value};
+  }
+
+  // writes p50/p90/p99/max latencies (ms) and the rate of every stage labeled by the stage name
+  void write(userver::utils::statistics::Writer& writer, const std::array<std::string_view, StageCount>& stage_names,
+    const userver::utils::statistics::LabelView& label) const
+  {
+    for (std::size_t i = 0; i < StageCount; ++i)
+      writer.ValueWithLabels(timings_[i], {label, {"stage", stage_names[i]}});
+  }
+
+  friend void DumpMetric(userver::utils::statistics::Writer& writer, const StageTiming& timing)
+  {
+    const auto latency = timing.latency.GetStatsForPeriod();
+    writer["p50"] = latency.GetPercentile(50);
+    writer["p90"] = latency.GetPercentile(90);
+    writer["p99"] = latency.GetPercentile(99);
+    writer["max"] = latency.GetPercentile(100);
+    writer["count"] = timing.count;
+  }
+
+private:
+  std::array<StageTiming, StageCount> timings_;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+// Association of the objects detected in a frame with the tracks of the previous frames of a stream
+namespace Tracking
+{
+  // intersection over union, zero for empty rectangles
+  inline float iou(const cv::Rect2f& a, const cv::Rect2f& b)
+  {
+    const float intersection = (a & b).area();
+    const float union_area = a.area() + b.area() - intersection;
+    return union_area > 0.0f ? intersection / union_area : 0.0f;
+  }
+
+  // the rectangle moved by the last displacement of the object, a constant velocity prediction for the next frame
+  inline cv::Rect2f predict(const cv::Rect2f& box, const cv::Point2f& velocity)
+  {
+    return {box.x + velocity.x, box.y + velocity.y, box.width, box.height};
+  }
+
+  // Greedy one-to-one association by decreasing IoU: returns the track index of every detection or -1 if it has none.
+  // A pair is acceptable if its IoU is at least min_iou and gate(track_index, detection_index) is true.
+  template <typename Gate>
+  std::vector<int> associate(const std::vector<cv::Rect2f>& tracks, const std::vector<cv::Rect2f>& detections, const float min_iou, Gate&& gate)
+  {
+    std::vector<std::tuple<float, int, int>> pairs;
+    for (size_t t = 0; t < tracks.size(); ++t)
+      for (size_t d = 0; d < detections.size(); ++d)
+        if (const float value = iou(tracks[t], detections[d]); value >= min_iou && gate(t, d))
+          pairs.emplace_back(value, static_cast<int>(t), static_cast<int>(d));
+    std::ranges::sort(pairs, [](const auto& a, const auto& b)
+      {
+        return std::get<0>(a) > std::get<0>(b);
+      });
+
+    std::vector<int> result(detections.size(), -1);
+    std::vector<bool> is_track_taken(tracks.size(), false);
+    for (const auto& [value, t, d] : pairs)
+      if (result[d] < 0 && !is_track_taken[t])
+      {
+        result[d] = t;
+        is_track_taken[t] = true;
+      }
+
+    return result;
+  }
+
+  inline std::vector<int> associate(const std::vector<cv::Rect2f>& tracks, const std::vector<cv::Rect2f>& detections, const float min_iou)
+  {
+    return associate(tracks, detections, min_iou, [](size_t, size_t)
+      {
+        return true;
+      });
+  }
+}  // namespace Tracking
@@ -57,8 +57,11 @@ string_params_common = [
 ]
 
 string_params_vstream = [
+    'dnn-fc-inference-backend',
     'dnn-fc-inference-server',
+    'dnn-fd-inference-backend',
     'dnn-fd-inference-server',
+    'dnn-fr-inference-backend',
     'dnn-fr-inference-server',
     'osd-datetime-format',
 ]